@@ -28,9 +28,11 @@
 #include "catalog/pg_appendonly_fn.h"
 #include "cdb/cdbaocsam.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
+#include "pgstat.h"
 #include "storage/lmgr.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -226,6 +228,12 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	const int	progress_index[] = {
+		PROGRESS_AO_COMPACTION_TUPLES_SCANNED,
+		PROGRESS_AO_COMPACTION_TUPLES_MOVED,
+		PROGRESS_AO_COMPACTION_TUPLES_TOTAL
+	};
+	int64		progress_val[3];
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoCols(aorel));
@@ -275,6 +283,11 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 	estate->es_num_result_relations = 1;
 	estate->es_result_relation_info = resultRelInfo;
 
+	progress_val[0] = 0;
+	progress_val[1] = 0;
+	progress_val[2] = fsinfo->total_tupcount;
+	pgstat_progress_update_multi_param(3, progress_index, progress_val);
+
 	while (aocs_getnext(scanDesc, ForwardScanDirection, slot))
 	{
 		CHECK_FOR_INTERRUPTS();
@@ -300,12 +313,21 @@ AOCSSegmentFileFullCompaction(Relation aorel,
 		 * Check for vacuum delay point after approximatly a var block
 		 */
 		tupleCount++;
-		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
+		if (tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			if (VacuumCostActive)
+				vacuum_delay_point();
+
+			progress_val[0] = tupleCount;
+			progress_val[1] = movedTupleCount;
+			pgstat_progress_update_multi_param(2, progress_index, progress_val);
 		}
 	}
 
+	progress_val[0] = tupleCount;
+	progress_val[1] = movedTupleCount;
+	pgstat_progress_update_multi_param(2, progress_index, progress_val);
+
 	MarkAOCSFileSegInfoAwaitingDrop(aorel, compact_segno);
 
 	AppendOnlyVisimap_DeleteSegmentFile(&visiMap,
@@ -382,6 +404,8 @@ AOCSCompact(Relation aorel,
 		{
 			/* get the insertion segment on first call. */
 			*insert_segno = ChooseSegnoForCompactionWrite(aorel, avoid_segnos);
+			pgstat_progress_update_param(PROGRESS_AO_COMPACTION_INSERT_SEGNO,
+										 *insert_segno);
 		}
 
 		if (*insert_segno != -1)
@@ -87,16 +87,15 @@ open_datumstreamread_segfile(
  * Currently, there is one segment file for each column. This function
  * only opens files for those columns which are in the projection.
  *
- * If blockDirectory is not NULL, the first block info is written to
- * the block directory.
+ * The first blocks are read by aocs_getnext_batch(), so that they can be
+ * skipped like the others.
  */
 static void
 open_all_datumstreamread_segfiles(Relation rel,
 								  AOCSFileSegInfo *segInfo,
 								  DatumStreamRead **ds,
 								  int *proj_atts,
-								  int num_proj_atts,
-								  AppendOnlyBlockDirectory *blockDirectory)
+								  int num_proj_atts)
 {
 	char	   *basepath = relpathbackend(rel->rd_node, rel->rd_backend, MAIN_FORKNUM);
 	int			i;
@@ -108,7 +107,6 @@ open_all_datumstreamread_segfiles(Relation rel,
 		int			attno = proj_atts[i];
 
 		open_datumstreamread_segfile(basepath, rel->rd_node, segInfo, ds[attno], attno);
-		datumstreamread_block(ds[attno], blockDirectory, attno);
 	}
 
 	pfree(basepath);
@@ -267,6 +265,8 @@ aocs_initscan(AOCSScanDesc scan)
 	open_ds_read(scan->aos_rel, scan->ds, scan->relationTupleDesc,
 				 scan->proj_atts, scan->num_proj_atts,
 				 scan->aos_rel->rd_appendonly->checksum);
+	if (scan->readStats != NULL)
+		aocs_set_read_stats(scan, scan->readStats);
 
 	pgstat_count_heap_scan(scan->aos_rel);
 }
@@ -354,8 +354,7 @@ open_next_scan_seg(AOCSScanDesc scan)
 												  curSegInfo,
 												  scan->ds,
 												  scan->proj_atts,
-												  scan->num_proj_atts,
-												  scan->blockDirectory);
+												  scan->num_proj_atts);
 
 				return scan->cur_seg;
 			}
@@ -509,6 +508,8 @@ aocs_beginscan_internal(Relation relation,
 						   AccessShareLock,
 						   appendOnlyMetaDataSnapshot);
 
+	scan->batch = aocs_batch_init(scan, 0);
+
 	return scan;
 }
 
@@ -518,6 +519,81 @@ aocs_rescan(AOCSScanDesc scan)
 	close_cur_scan_seg(scan);
 	close_ds_read(scan->ds, scan->relationTupleDesc->natts);
 	aocs_initscan(scan);
+
+	scan->batch->nrows = 0;
+	scan->batch->next = 0;
+}
+
+/*
+ * aocs_set_read_stats
+ *
+ * Count the i/o of all the columns of the scan in 'stats'.
+ */
+void
+aocs_set_read_stats(AOCSScanDesc scan, BufferedReadStats *stats)
+{
+	int			i;
+
+	scan->readStats = stats;
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		DatumStreamRead *ds = scan->ds[scan->proj_atts[i]];
+
+		if (ds != NULL)
+			BufferedReadSetStats(&ds->ao_read.bufferedRead, stats);
+	}
+}
+
+/*
+ * aocs_set_zone_keys
+ *
+ * Let the scan skip the blocks that can't hold a row satisfying all of
+ * 'keys', according to the min/max zone maps of the block directory. The
+ * columns of the keys must be projected. Does nothing if the relation has
+ * no block directory.
+ */
+void
+aocs_set_zone_keys(AOCSScanDesc scan, AOCSZoneKey *keys, int nkeys)
+{
+	AppendOnlyBlockDirectory *blockDirectory;
+	bool	   *proj;
+	int			natts = scan->relationTupleDesc->natts;
+	int			i;
+
+	Assert(scan->blockDirectory == NULL);
+	Assert(scan->zoneDirectory == NULL);
+
+	if (nkeys == 0)
+		return;
+
+	proj = palloc0(natts * sizeof(bool));
+	for (i = 0; i < nkeys; i++)
+	{
+		Assert(keys[i].attno >= 0 && keys[i].attno < natts);
+		Assert(scan->ds[keys[i].attno] != NULL);
+		proj[keys[i].attno] = true;
+	}
+
+	blockDirectory = palloc0(sizeof(AppendOnlyBlockDirectory));
+	AppendOnlyBlockDirectory_Init_forSearch(blockDirectory,
+											scan->appendOnlyMetaDataSnapshot,
+											(FileSegInfo **) scan->seginfo,
+											scan->total_seg,
+											scan->aos_rel,
+											natts,
+											true,
+											proj);
+	if (blockDirectory->blkdirRel == NULL)
+	{
+		pfree(blockDirectory);
+		pfree(proj);
+		return;
+	}
+
+	scan->zoneDirectory = blockDirectory;
+	scan->zoneKeys = keys;
+	scan->numZoneKeys = nkeys;
 }
 
 void
@@ -530,6 +606,13 @@ aocs_endscan(AOCSScanDesc scan)
 	close_cur_scan_seg(scan);
 	close_ds_read(scan->ds, scan->relationTupleDesc->natts);
 
+	aocs_batch_finish(scan->batch);
+	if (scan->zoneDirectory)
+	{
+		AppendOnlyBlockDirectory_End_forSearch(scan->zoneDirectory);
+		pfree(scan->zoneDirectory->proj);
+		pfree(scan->zoneDirectory);
+	}
 	pfree(scan->proj_atts);
 	pfree(scan->ds);
 
@@ -610,12 +693,6 @@ static void upgrade_datum_impl(DatumStreamRead *ds, int attno, Datum values[],
 	}
 }
 
-static void upgrade_datum_scan(AOCSScanDesc scan, int attno, Datum values[],
-							   bool isnull[], int formatversion)
-{
-	upgrade_datum_impl(scan->ds[attno], attno, values, isnull, formatversion);
-}
-
 static void upgrade_datum_fetch(AOCSFetchDesc fetch, int attno, Datum values[],
 								bool isnull[], int formatversion)
 {
@@ -623,28 +700,249 @@ static void upgrade_datum_fetch(AOCSFetchDesc fetch, int attno, Datum values[],
 					   values, isnull, formatversion);
 }
 
-bool
-aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
+/*
+ * Allocate a batch for the projected columns of 'scan'.  If 'maxrows' is 0,
+ * the batch is sized by AOCS_BATCH_MAX_ROWS and AOCS_BATCH_MAX_BYTES.
+ */
+AOCSColumnBatch *
+aocs_batch_init(AOCSScanDesc scan, int maxrows)
 {
-	int			ncol;
-	Datum	   *d = slot_get_values(slot);
-	bool	   *null = slot_get_isnull(slot);
+	AOCSColumnBatch *batch;
+	int			natts = scan->relationTupleDesc->natts;
+	int			i;
+
+	if (maxrows <= 0)
+	{
+		maxrows = AOCS_BATCH_MAX_BYTES /
+			(Max(scan->num_proj_atts, 1) * (sizeof(Datum) + sizeof(bool)));
+		maxrows = Max(Min(maxrows, AOCS_BATCH_MAX_ROWS), 1);
+	}
+
+	batch = (AOCSColumnBatch *) palloc0(sizeof(AOCSColumnBatch));
+	batch->natts = natts;
+	batch->maxrows = maxrows;
+	batch->values = (Datum **) palloc0(natts * sizeof(Datum *));
+	batch->isnull = (bool **) palloc0(natts * sizeof(bool *));
+	batch->tids = (AOTupleId *) palloc(maxrows * sizeof(AOTupleId));
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		batch->values[attno] = (Datum *) palloc(maxrows * sizeof(Datum));
+		batch->isnull[attno] = (bool *) palloc(maxrows * sizeof(bool));
+	}
+
+	return batch;
+}
+
+void
+aocs_batch_finish(AOCSColumnBatch *batch)
+{
+	int			i;
+
+	for (i = 0; i < batch->natts; i++)
+	{
+		if (batch->values[i])
+		{
+			pfree(batch->values[i]);
+			pfree(batch->isnull[i]);
+		}
+	}
+	pfree(batch->values);
+	pfree(batch->isnull);
+	pfree(batch->tids);
+	pfree(batch);
+}
+
+/*
+ * Can the block whose header was just read for column 'attno' hold a row
+ * satisfying the zone keys of that column?
+ */
+static bool
+aocs_zone_may_match(AOCSScanDesc scan, int attno)
+{
+	DatumStreamRead *ds = scan->ds[attno];
 	AOTupleId	aoTupleId;
-	int64		rowNum = INT64CONST(-1);
-	int			err = 0;
+	AppendOnlyBlockDirectoryEntry directoryEntry;
+	MinipageZone zone;
+	int64		lastRowNum;
 	int			i;
+
+	/* Pre-4.0 blocks don't know their row numbers */
+	if (ds->getBlockInfo.firstRow < 0)
+		return true;
+
+	lastRowNum = ds->blockFirstRowNum + ds->blockRowCount - 1;
+
+	AOTupleIdInit(&aoTupleId, scan->seginfo[scan->cur_seg]->segno,
+				  ds->blockFirstRowNum);
+	if (!AppendOnlyBlockDirectory_GetEntryZone(scan->zoneDirectory, &aoTupleId,
+											   attno, &directoryEntry, &zone))
+		return true;
+
+	/* Only trust a zone that summarizes every row of the block */
+	if (zone.lastRowNum == 0 ||
+		directoryEntry.range.firstRowNum > ds->blockFirstRowNum ||
+		zone.lastRowNum < lastRowNum)
+		return true;
+
+	for (i = 0; i < scan->numZoneKeys; i++)
+	{
+		AOCSZoneKey *key = &scan->zoneKeys[i];
+		bool		match;
+
+		if (key->attno != attno)
+			continue;
+
+		switch (key->strategy)
+		{
+			case BTLessStrategyNumber:
+				match = (zone.minValue < key->value);
+				break;
+			case BTLessEqualStrategyNumber:
+				match = (zone.minValue <= key->value);
+				break;
+			case BTEqualStrategyNumber:
+				match = (zone.minValue <= key->value &&
+						 zone.maxValue >= key->value);
+				break;
+			case BTGreaterEqualStrategyNumber:
+				match = (zone.maxValue >= key->value);
+				break;
+			case BTGreaterStrategyNumber:
+				match = (zone.maxValue > key->value);
+				break;
+			default:
+				match = true;
+				break;
+		}
+		if (!match)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Move column 'attno' past row 'lastRowNum', skipping over whole blocks
+ * without reading them where possible.
+ */
+static void
+aocs_skip_rows(AOCSScanDesc scan, int attno, int64 lastRowNum)
+{
+	DatumStreamRead *ds = scan->ds[attno];
+
+	for (;;)
+	{
+		int			remaining = datumstreamread_remaining(ds);
+
+		if (remaining > 0)
+		{
+			int64		nextRowNum;
+			int64		count;
+
+			nextRowNum = ds->blockFirstRowNum + ds->blockRowCount - remaining;
+			count = Min((int64) remaining, lastRowNum - nextRowNum + 1);
+			if (count <= 0)
+				return;
+
+			datumstreamread_skip(ds, (int) count);
+			if (count < remaining)
+				return;
+		}
+		else
+		{
+			/* At the end of the file, the next read finds it again */
+			if (!datumstreamread_block_header(ds))
+				return;
+
+			if (ds->blockFirstRowNum + ds->blockRowCount - 1 <= lastRowNum)
+				datumstreamread_skip_block(ds);
+			else
+				datumstreamread_block_content(ds);
+		}
+	}
+}
+
+/*
+ * Read the next block of column 'attno'. If the column has zone keys and the
+ * zone map of the block rules it out, skip the block and the same rows of the
+ * other projected columns instead.
+ *
+ * Returns -1 at the end of the segment file, 1 if rows were skipped, and 0
+ * once the column has a block to read from.
+ */
+static int
+aocs_scan_next_block(AOCSScanDesc scan, int attno)
+{
+	DatumStreamRead *ds = scan->ds[attno];
+	int64		lastRowNum;
+	int			i;
+
+	if (scan->zoneDirectory == NULL || !gp_appendonly_zone_maps)
+		return datumstreamread_block(ds, scan->blockDirectory, attno);
+
+	for (i = 0; i < scan->numZoneKeys; i++)
+	{
+		if (scan->zoneKeys[i].attno == attno)
+			break;
+	}
+	if (i == scan->numZoneKeys)
+		return datumstreamread_block(ds, scan->blockDirectory, attno);
+
+	if (!datumstreamread_block_header(ds))
+		return -1;
+
+	if (aocs_zone_may_match(scan, attno))
+	{
+		datumstreamread_block_content(ds);
+		return 0;
+	}
+
+	lastRowNum = ds->blockFirstRowNum + ds->blockRowCount - 1;
+	datumstreamread_skip_block(ds);
+
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		if (scan->proj_atts[i] != attno)
+			aocs_skip_rows(scan, scan->proj_atts[i], lastRowNum);
+	}
+
+	return 1;
+}
+
+/*
+ * aocs_getnext_batch
+ *
+ * Decode the next rows of the scan into 'batch', a column at a time, and
+ * return how many there are.  Returns 0 at the end of the scan.
+ *
+ * A batch never goes past the end of the current block of any projected
+ * column, so pass-by-reference values point into the column's block buffer
+ * and stay valid until the next call.
+ */
+int
+aocs_getnext_batch(AOCSScanDesc scan, ScanDirection direction,
+				   AOCSColumnBatch *batch)
+{
+	int			err = 0;
 	bool		isSnapshotAny = (scan->snapshot == SnapshotAny);
 
 	Assert(ScanDirectionIsForward(direction));
+	Assert(scan->num_proj_atts > 0);
 
-	ncol = slot->tts_tupleDescriptor->natts;
-	Assert(ncol <= scan->relationTupleDesc->natts);
+	batch->nrows = 0;
+	batch->next = 0;
 
-	while (1)
+	while (batch->nrows == 0)
 	{
 		AOCSFileSegInfo *curseginfo;
+		int64		rowNum = INT64CONST(-1);
+		int			nrows;
+		int			i;
+		int			j;
 
-ReadNext:
 		/* If necessary, open next seg */
 		if (scan->cur_seg < 0 || err < 0)
 		{
@@ -652,9 +950,8 @@ ReadNext:
 			if (err < 0)
 			{
 				/* No more seg, we are at the end */
-				ExecClearTuple(slot);
 				scan->cur_seg = -1;
-				return false;
+				return 0;
 			}
 			scan->cur_seg_row = 0;
 		}
@@ -662,77 +959,157 @@ ReadNext:
 		Assert(scan->cur_seg >= 0);
 		curseginfo = scan->seginfo[scan->cur_seg];
 
-		/* Read from cur_seg */
+		/*
+		 * Converted numerics of old format versions are kept in the stream's
+		 * upgrade space, which holds a single value.
+		 */
+		if (PG82NumericConversionNeeded(curseginfo->formatversion))
+			nrows = 1;
+		else
+			nrows = batch->maxrows;
+
+		/*
+		 * Read the next block of the columns whose current block is used up.
+		 * Skipping rows may use up the block of a column already looked at,
+		 * so start over after that.
+		 */
 		for (i = 0; i < scan->num_proj_atts; i++)
 		{
 			int			attno = scan->proj_atts[i];
 
-			err = datumstreamread_advance(scan->ds[attno]);
-			Assert(err >= 0);
-			if (err == 0)
+			if (datumstreamread_remaining(scan->ds[attno]) == 0)
 			{
-				err = datumstreamread_block(scan->ds[attno], scan->blockDirectory, attno);
+				err = aocs_scan_next_block(scan, attno);
 				if (err < 0)
 				{
 					/*
 					 * Ha, cannot read next block, we need to go to next seg
 					 */
 					close_cur_scan_seg(scan);
-					goto ReadNext;
+					break;
 				}
-
-				err = datumstreamread_advance(scan->ds[attno]);
-				Assert(err > 0);
+				if (err > 0)
+				{
+					i = -1;
+					continue;
+				}
+				Assert(datumstreamread_remaining(scan->ds[attno]) > 0);
 			}
+		}
+		if (err < 0)
+			continue;
 
-			/*
-			 * Get the column's datum right here since the data structures
-			 * should still be hot in CPU data cache memory.
-			 */
-			datumstreamread_get(scan->ds[attno], &d[attno], &null[attno]);
+		/* Take no more rows than every column has left in its block */
+		for (i = 0; i < scan->num_proj_atts; i++)
+			nrows = Min(nrows, datumstreamread_remaining(scan->ds[scan->proj_atts[i]]));
+
+		for (i = 0; i < scan->num_proj_atts; i++)
+		{
+			int			attno = scan->proj_atts[i];
+			DatumStreamRead *ds = scan->ds[attno];
+			int			count PG_USED_FOR_ASSERTS_ONLY;
+
+			count = datumstreamread_get_batch(ds, batch->values[attno],
+											  batch->isnull[attno], nrows);
+			Assert(count == nrows);
 
 			/*
-			 * Perform any required upgrades on the Datum we just fetched.
+			 * Perform any required upgrades on the Datums we just fetched.
 			 */
 			if (curseginfo->formatversion < AORelationVersion_GetLatest())
 			{
-				upgrade_datum_scan(scan, attno, d, null,
-								   curseginfo->formatversion);
+				for (j = 0; j < nrows; j++)
+					upgrade_datum_impl(ds, j, batch->values[attno],
+									   batch->isnull[attno],
+									   curseginfo->formatversion);
 			}
 
 			if (rowNum == INT64CONST(-1) &&
-				scan->ds[attno]->blockFirstRowNum != INT64CONST(-1))
+				ds->blockFirstRowNum != INT64CONST(-1))
 			{
-				Assert(scan->ds[attno]->blockFirstRowNum > 0);
-				rowNum = scan->ds[attno]->blockFirstRowNum +
-					datumstreamread_nth(scan->ds[attno]);
+				Assert(ds->blockFirstRowNum > 0);
+				rowNum = ds->blockFirstRowNum +
+					datumstreamread_nth(ds) - (nrows - 1);
 			}
 		}
 
-		scan->cur_seg_row++;
-		if (rowNum == INT64CONST(-1))
-		{
-			AOTupleIdInit(&aoTupleId, curseginfo->segno, scan->cur_seg_row);
-		}
-		else
+		/* Assign the row ids, and squeeze out the rows that aren't visible */
+		for (j = 0; j < nrows; j++)
 		{
-			AOTupleIdInit(&aoTupleId, curseginfo->segno, rowNum);
-		}
+			AOTupleId  *aoTupleId = &batch->tids[batch->nrows];
 
-		if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
-		{
-			rowNum = INT64CONST(-1);
-			goto ReadNext;
+			scan->cur_seg_row++;
+			if (rowNum == INT64CONST(-1))
+			{
+				AOTupleIdInit(aoTupleId, curseginfo->segno, scan->cur_seg_row);
+			}
+			else
+			{
+				AOTupleIdInit(aoTupleId, curseginfo->segno, rowNum + j);
+			}
+
+			if (!isSnapshotAny && !AppendOnlyVisimap_IsVisible(&scan->visibilityMap, aoTupleId))
+				continue;
+
+			if (batch->nrows != j)
+			{
+				for (i = 0; i < scan->num_proj_atts; i++)
+				{
+					int			attno = scan->proj_atts[i];
+
+					batch->values[attno][batch->nrows] = batch->values[attno][j];
+					batch->isnull[attno][batch->nrows] = batch->isnull[attno][j];
+				}
+			}
+			batch->nrows++;
 		}
-		scan->cdb_fake_ctid = *((ItemPointer) &aoTupleId);
+	}
 
-		TupSetVirtualTupleNValid(slot, ncol);
-		slot_set_ctid(slot, &(scan->cdb_fake_ctid));
-		return true;
+	return batch->nrows;
+}
+
+/*
+ * aocs_getnext
+ *
+ * Return the next row of the scan in 'slot'.  Rows are decoded a batch at
+ * a time by aocs_getnext_batch() and handed out from the scan's batch.
+ */
+bool
+aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot)
+{
+	AOCSColumnBatch *batch = scan->batch;
+	int			ncol;
+	Datum	   *d = slot_get_values(slot);
+	bool	   *null = slot_get_isnull(slot);
+	int			row;
+	int			i;
+
+	Assert(ScanDirectionIsForward(direction));
+
+	ncol = slot->tts_tupleDescriptor->natts;
+	Assert(ncol <= scan->relationTupleDesc->natts);
+
+	if (batch->next >= batch->nrows &&
+		aocs_getnext_batch(scan, direction, batch) == 0)
+	{
+		ExecClearTuple(slot);
+		return false;
 	}
 
-	Assert(!"Never here");
-	return false;
+	row = batch->next++;
+	for (i = 0; i < scan->num_proj_atts; i++)
+	{
+		int			attno = scan->proj_atts[i];
+
+		d[attno] = batch->values[attno][row];
+		null[attno] = batch->isnull[attno][row];
+	}
+
+	scan->cdb_fake_ctid = *((ItemPointer) &batch->tids[row]);
+
+	TupSetVirtualTupleNValid(slot, ncol);
+	slot_set_ctid(slot, &(scan->cdb_fake_ctid));
+	return true;
 }
 
 
@@ -38,9 +38,11 @@
 #include "catalog/pg_appendonly_fn.h"
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "executor/executor.h"
 #include "nodes/execnodes.h"
+#include "pgstat.h"
 #include "storage/procarray.h"
 #include "storage/lmgr.h"
 #include "utils/lsyscache.h"
@@ -306,6 +308,37 @@ AppendOnlyMoveTuple(TupleTableSlot *slot,
 						AOTupleIdGet_segmentFileNum(&newAoTupleId), AOTupleIdGet_rowNum(&newAoTupleId))));
 }
 
+/*
+ * Insert the index entries of a tuple whose block was copied verbatim to
+ * the insert segment file. The tuple itself is already there.
+ */
+static void
+AppendOnlyIndexCopiedTuple(TupleTableSlot *slot,
+						   int insert_segno,
+						   int64 rowNumDelta,
+						   EState *estate)
+{
+	AOTupleId  *oldAoTupleId;
+	AOTupleId	newAoTupleId;
+
+	Assert(slot);
+	Assert(estate);
+
+	oldAoTupleId = (AOTupleId *) slot_get_ctid(slot);
+	AOTupleIdInit(&newAoTupleId, insert_segno,
+				  AOTupleIdGet_rowNum(oldAoTupleId) + rowNumDelta);
+
+	ExecInsertIndexTuples(slot, (ItemPointer) &newAoTupleId, estate,
+						  false, NULL, NIL);
+	ResetPerTupleExprContext(estate);
+
+	if (Debug_appendonly_print_compaction)
+		ereport(DEBUG5,
+				(errmsg("Compaction: Copied tuple (%d," INT64_FORMAT ") -> (%d," INT64_FORMAT ")",
+						AOTupleIdGet_segmentFileNum(oldAoTupleId), AOTupleIdGet_rowNum(oldAoTupleId),
+						AOTupleIdGet_segmentFileNum(&newAoTupleId), AOTupleIdGet_rowNum(&newAoTupleId))));
+}
+
 void
 AppendOnlyThrowAwayTuple(Relation rel,
 						 TupleTableSlot *slot,
@@ -358,6 +391,14 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	AOTupleId  *aoTupleId;
 	int64		tupleCount = 0;
 	int64		tuplePerPage = INT_MAX;
+	bool		copyReturnsTuples = false;
+	const int	progress_index[] = {
+		PROGRESS_AO_COMPACTION_TUPLES_SCANNED,
+		PROGRESS_AO_COMPACTION_TUPLES_MOVED,
+		PROGRESS_AO_COMPACTION_TUPLES_TOTAL,
+		PROGRESS_AO_COMPACTION_BLOCKS_COPIED
+	};
+	int64		progress_val[4];
 
 	Assert(Gp_role == GP_ROLE_EXECUTE || Gp_role == GP_ROLE_UTILITY);
 	Assert(RelationIsAoRows(aorel));
@@ -408,6 +449,22 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	estate->es_num_result_relations = 1;
 	estate->es_result_relation_info = resultRelInfo;
 
+	/*
+	 * Blocks without hidden rows are copied verbatim by the scan. We only
+	 * see their rows if we need to make index entries for them.
+	 */
+	if (gp_appendonly_compaction_copy_blocks)
+	{
+		copyReturnsTuples = (resultRelInfo->ri_NumIndices > 0);
+		appendonly_set_block_copy(scanDesc, insertDesc, copyReturnsTuples);
+	}
+
+	progress_val[0] = 0;
+	progress_val[1] = 0;
+	progress_val[2] = fsinfo->total_tupcount;
+	progress_val[3] = 0;
+	pgstat_progress_update_multi_param(4, progress_index, progress_val);
+
 	/*
 	 * Go through all visible tuples and move them to a new segfile.
 	 */
@@ -417,7 +474,16 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		CHECK_FOR_INTERRUPTS();
 
 		aoTupleId = (AOTupleId *) slot_get_ctid(slot);
-		if (AppendOnlyVisimap_IsVisible(&scanDesc->visibilityMap, aoTupleId))
+		if (scanDesc->blockCopied)
+		{
+			/* Already copied with its block, and visible */
+			AppendOnlyIndexCopiedTuple(slot,
+									   insertDesc->cur_segno,
+									   scanDesc->blockCopyRowNumDelta,
+									   estate);
+			movedTupleCount++;
+		}
+		else if (AppendOnlyVisimap_IsVisible(&scanDesc->visibilityMap, aoTupleId))
 		{
 			AppendOnlyMoveTuple(slot,
 								mt_bind,
@@ -438,12 +504,32 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 		 * Check for vacuum delay point after approximately a var block
 		 */
 		tupleCount++;
-		if (VacuumCostActive && tupleCount % tuplePerPage == 0)
+		if (tupleCount % tuplePerPage == 0)
 		{
-			vacuum_delay_point();
+			if (VacuumCostActive)
+				vacuum_delay_point();
+
+			progress_val[0] = tupleCount;
+			progress_val[1] = movedTupleCount;
+			if (!copyReturnsTuples)
+			{
+				progress_val[0] += scanDesc->blockCopyRowCount;
+				progress_val[1] += scanDesc->blockCopyRowCount;
+			}
+			pgstat_progress_update_multi_param(2, progress_index, progress_val);
 		}
 	}
 
+	/* Rows of copied blocks that the scan skipped were moved, too. */
+	if (!copyReturnsTuples)
+	{
+		tupleCount += scanDesc->blockCopyRowCount;
+		movedTupleCount += scanDesc->blockCopyRowCount;
+	}
+	progress_val[0] = tupleCount;
+	progress_val[1] = movedTupleCount;
+	pgstat_progress_update_multi_param(2, progress_index, progress_val);
+
 	MarkFileSegInfoAwaitingDrop(aorel, compact_segno);
 
 	AppendOnlyVisimap_DeleteSegmentFile(&visiMap, compact_segno);
@@ -458,8 +544,9 @@ AppendOnlySegmentFileFullCompaction(Relation aorel,
 	}
 
 	if (Debug_appendonly_print_compaction)
-		elog(LOG, "Finished compaction: AO segfile %d, relation %s, moved tuple count " INT64_FORMAT,
-			 compact_segno, relname, movedTupleCount);
+		elog(LOG, "Finished compaction: AO segfile %d, relation %s, moved tuple count " INT64_FORMAT
+			 ", copied block count " INT64_FORMAT,
+			 compact_segno, relname, movedTupleCount, scanDesc->blockCopyCount);
 
 	AppendOnlyVisimap_Finish(&visiMap, NoLock);
 
@@ -732,6 +819,8 @@ AppendOnlyCompact(Relation aorel,
 		{
 			/* get the insertion segment on first call. */
 			*insert_segno = ChooseSegnoForCompactionWrite(aorel, avoid_segnos);
+			pgstat_progress_update_param(PROGRESS_AO_COMPACTION_INSERT_SEGNO,
+										 *insert_segno);
 		}
 		if (*insert_segno != -1)
 		{
@@ -50,6 +50,8 @@
 #include "cdb/cdbappendonlystorageformat.h"
 #include "cdb/cdbappendonlystoragelayer.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
+#include "commands/vacuum.h"
 #include "fmgr.h"
 #include "miscadmin.h"
 #include "pgstat.h"
@@ -138,6 +140,8 @@ static void AppendOnlyExecutorReadBlock_Finish(
 static void AppendOnlyExecutorReadBlock_ResetCounts(
 										AppendOnlyExecutorReadBlock *executorReadBlock);
 
+static bool copyBlockForCompaction(AppendOnlyScanDesc scan);
+
 /* ----------------
  *		initscan - scan code common to appendonly_beginscan and appendonly_rescan
  * ----------------
@@ -194,6 +198,7 @@ SetNextFileSegForRead(AppendOnlyScanDesc scan)
 								   NameStr(scan->aos_rd->rd_rel->relname),
 								   scan->title,
 								   &scan->storageAttributes);
+		BufferedReadSetStats(&scan->storageRead.bufferedRead, scan->readStats);
 
 		/*
 		 * There is no guarantee that the current memory context will be
@@ -1258,6 +1263,21 @@ getNextBlock(AppendOnlyScanDesc scan)
 											 false);
 	}
 
+	if (scan->blockCopyDesc != NULL)
+	{
+		scan->blockCopied = copyBlockForCompaction(scan);
+		if (scan->blockCopied && !scan->blockCopyReturnTuples)
+		{
+			/*
+			 * Nobody needs the rows; go on to the next block. No tuples
+			 * reach the caller, so honor the vacuum cost delay here.
+			 */
+			AppendOnlyExecutionReadBlock_FinishedScanBlock(&scan->executorReadBlock);
+			vacuum_delay_point();
+			return false;
+		}
+	}
+
 	AppendOnlyExecutorReadBlock_GetContents(
 											&scan->executorReadBlock);
 
@@ -1510,6 +1530,161 @@ finishWriteBlock(AppendOnlyInsertDesc aoInsertDesc)
 	Assert(!AppendOnlyStorageWrite_IsBufferAllocated(&aoInsertDesc->storageWrite));
 }
 
+/*
+ * Copy the current block of a VACUUM compaction scan into the compaction's
+ * insert descriptor as it is stored, without decompressing and
+ * recompressing it.
+ *
+ * Only blocks whose rows are all visible can be copied. Returns false,
+ * leaving the block alone, if the block has hidden rows or cannot be copied
+ * verbatim; the caller then moves its visible rows one at a time.
+ */
+static bool
+copyBlockForCompaction(AppendOnlyScanDesc scan)
+{
+	AppendOnlyExecutorReadBlock *readBlock = &scan->executorReadBlock;
+	AppendOnlyStorageRead *storageRead = &scan->storageRead;
+	AppendOnlyInsertDesc insertDesc = scan->blockCopyDesc;
+	AppendOnlyStorageWrite *storageWrite = &insertDesc->storageWrite;
+	uint8	   *storedContent;
+	int32		storedLen;
+	int64		firstRowNum;
+	int64		rowNum;
+	AOTupleId	aoTupleId;
+
+	/*
+	 * Large rows span several storage blocks, and the tuples of an older
+	 * format version must be converted on the way; move those the regular
+	 * way.
+	 */
+	if (readBlock->isLarge ||
+		storageRead->current.headerKind != AoHeaderKind_SmallContent ||
+		storageRead->formatVersion != storageWrite->formatVersion)
+		return false;
+
+	/*
+	 * The copy always carries a first row number, so its header can be
+	 * longer than the one of the source block.
+	 */
+	storedLen = (readBlock->isCompressed ?
+				 storageRead->current.compressedLen : readBlock->dataLen);
+	if (storedLen > storageWrite->maxBufferLen -
+		AppendOnlyStorageWrite_CompleteHeaderLen(storageWrite,
+												 AoHeaderKind_SmallContent))
+		return false;
+
+	for (rowNum = readBlock->blockFirstRowNum;
+		 rowNum < readBlock->blockFirstRowNum + readBlock->rowCount;
+		 rowNum++)
+	{
+		AOTupleIdInit(&aoTupleId, readBlock->segmentFileNum, rowNum);
+		if (!AppendOnlyVisimap_IsVisible(&scan->visibilityMap, &aoTupleId))
+			return false;
+	}
+
+	storedContent = AppendOnlyStorageRead_GetStoredContent(storageRead,
+														   &storedLen);
+
+	/*
+	 * Finish the varblock being filled with moved rows, so that the copy
+	 * gets the next row numbers.
+	 */
+	finishWriteBlock(insertDesc);
+
+	if (insertDesc->numSequences < readBlock->rowCount)
+	{
+		int64		firstSequence;
+		int64		numSequences;
+
+		numSequences = readBlock->rowCount - insertDesc->numSequences +
+			NUM_FAST_SEQUENCES;
+		firstSequence =
+			GetFastSequences(insertDesc->aoi_rel->rd_appendonly->segrelid,
+							 insertDesc->cur_segno,
+							 insertDesc->lastSequence + insertDesc->numSequences + 1,
+							 numSequences);
+
+		/* The copied block gets these row numbers; don't reuse any */
+		if (firstSequence != insertDesc->lastSequence + insertDesc->numSequences + 1)
+			elog(ERROR, "unexpected first row number " INT64_FORMAT " for segment file %d of relation \"%s\", expected " INT64_FORMAT,
+				 firstSequence, insertDesc->cur_segno,
+				 RelationGetRelationName(insertDesc->aoi_rel),
+				 insertDesc->lastSequence + insertDesc->numSequences + 1);
+		insertDesc->numSequences += numSequences;
+	}
+
+	firstRowNum = insertDesc->lastSequence + 1;
+	AppendOnlyStorageWrite_SetFirstRowNum(storageWrite, firstRowNum);
+	AppendOnlyStorageWrite_CopyStoredContent(storageWrite,
+											 storedContent,
+											 storedLen,
+											 readBlock->dataLen,
+											 readBlock->isCompressed,
+											 readBlock->executorBlockKind,
+											 readBlock->rowCount);
+
+	AppendOnlyBlockDirectory_InsertEntry(&insertDesc->blockDirectory,
+										 0,
+										 firstRowNum,
+										 AppendOnlyStorageWrite_LogicalBlockStartOffset(storageWrite),
+										 readBlock->rowCount,
+										 false);
+
+	insertDesc->lastSequence += readBlock->rowCount;
+	insertDesc->numSequences -= readBlock->rowCount;
+	insertDesc->insertCount += readBlock->rowCount;
+	insertDesc->varblockCount++;
+	insertDesc->bufferCount++;
+	pgstat_count_heap_insert(insertDesc->aoi_rel, readBlock->rowCount);
+
+	if (insertDesc->numSequences == 0)
+	{
+		int64		firstSequence;
+
+		firstSequence =
+			GetFastSequences(insertDesc->aoi_rel->rd_appendonly->segrelid,
+							 insertDesc->cur_segno,
+							 insertDesc->lastSequence + 1,
+							 NUM_FAST_SEQUENCES);
+
+		if (firstSequence != insertDesc->lastSequence + 1)
+			elog(ERROR, "unexpected first row number " INT64_FORMAT " for segment file %d of relation \"%s\", expected " INT64_FORMAT,
+				 firstSequence, insertDesc->cur_segno,
+				 RelationGetRelationName(insertDesc->aoi_rel),
+				 insertDesc->lastSequence + 1);
+		insertDesc->numSequences = NUM_FAST_SEQUENCES;
+	}
+
+	setupNextWriteBlock(insertDesc);
+
+	scan->blockCopyRowNumDelta = firstRowNum - readBlock->blockFirstRowNum;
+	scan->blockCopyCount++;
+	scan->blockCopyRowCount += readBlock->rowCount;
+	pgstat_progress_update_param(PROGRESS_AO_COMPACTION_BLOCKS_COPIED,
+								 scan->blockCopyCount);
+
+#ifdef FAULT_INJECTOR
+	FaultInjector_InjectFaultIfSet(
+								   "appendonly_compaction_copy_block",
+								   DDLNotSpecified,
+								   "", //databaseName
+								   RelationGetRelationName(insertDesc->aoi_rel));
+	/* tableName */
+#endif
+
+	elogif(Debug_appendonly_print_compaction, LOG,
+		   "Compaction: copied block of %d rows of table '%s' "
+		   "(segment file #%d, first row " INT64_FORMAT ") to segment file #%d, first row " INT64_FORMAT,
+		   readBlock->rowCount,
+		   NameStr(insertDesc->aoi_rel->rd_rel->relname),
+		   readBlock->segmentFileNum,
+		   readBlock->blockFirstRowNum,
+		   insertDesc->cur_segno,
+		   firstRowNum);
+
+	return true;
+}
+
 /* ----------------------------------------------------------------
  *					 append-only access method interface
  * ----------------------------------------------------------------
@@ -1722,6 +1897,41 @@ appendonly_rescan(AppendOnlyScanDesc scan,
 	initscan(scan, key);
 }
 
+/* ----------------
+ *		appendonly_set_read_stats - count the i/o of the scan in stats
+ * ----------------
+ */
+void
+appendonly_set_read_stats(AppendOnlyScanDesc scan, BufferedReadStats *stats)
+{
+	scan->readStats = stats;
+
+	if (scan->initedStorageRoutines)
+		BufferedReadSetStats(&scan->storageRead.bufferedRead, stats);
+}
+
+/* ----------------
+ *		appendonly_set_block_copy - copy fully visible blocks for compaction
+ *
+ * Used by VACUUM to compact a segment file: blocks of the scanned segment
+ * file that have no hidden rows are copied verbatim into insertDesc. Set
+ * returnTuples if the caller still needs the rows of copied blocks, e.g.
+ * to insert index entries for them.
+ * ----------------
+ */
+void
+appendonly_set_block_copy(AppendOnlyScanDesc scan,
+						  AppendOnlyInsertDesc insertDesc,
+						  bool returnTuples)
+{
+	Assert(scan->snapshot == SnapshotAny);
+	Assert(scan->aos_nkeys == 0);
+
+	scan->blockCopyDesc = insertDesc;
+	scan->blockCopyReturnTuples = returnTuples;
+	scan->blockCopied = false;
+}
+
 /* ----------------
  *		appendonly_endscan	- end relation scan
  * ----------------
@@ -19,6 +19,7 @@
 #include "access/heapam.h"
 #include "access/genam.h"
 #include "catalog/indexing.h"
+#include "catalog/pg_type.h"
 #include "parser/parse_oper.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
@@ -28,6 +29,7 @@
 
 int			gp_blockdirectory_entry_min_range = 0;
 int			gp_blockdirectory_minipage_size = NUM_MINIPAGE_ENTRIES;
+bool		gp_appendonly_zone_maps = false;
 
 static inline uint32
 minipage_size(uint32 nEntry)
@@ -36,6 +38,15 @@ minipage_size(uint32 nEntry)
 		sizeof(MinipageEntry) * nEntry;
 }
 
+/*
+ * Size of a minipage carrying zones (MINIPAGE_VERSION_ZONES).
+ */
+static inline uint32
+minipage_size_with_zones(uint32 nEntry)
+{
+	return minipage_size(nEntry) + sizeof(MinipageZone) * nEntry;
+}
+
 static void load_last_minipage(
 				   AppendOnlyBlockDirectory *blockDirectory,
 				   int64 lastSequence,
@@ -61,6 +72,7 @@ static bool insert_new_entry(AppendOnlyBlockDirectory *blockDirectory,
 				 int64 firstRowNum,
 				 int64 fileOffset,
 				 int64 rowCount,
+				 const MinipageZone *zone,
 				 bool addColAction);
 
 void
@@ -150,7 +162,9 @@ init_internal(AppendOnlyBlockDirectory *blockDirectory)
 		&blockDirectory->minipages[groupNo];
 
 		minipageInfo->minipage =
-			palloc0(minipage_size(NUM_MINIPAGE_ENTRIES));
+			palloc0(minipage_size_with_zones(NUM_MINIPAGE_ENTRIES));
+		minipageInfo->zones =
+			palloc0(sizeof(MinipageZone) * NUM_MINIPAGE_ENTRIES);
 		minipageInfo->numMinipageEntries = 0;
 	}
 
@@ -644,6 +658,43 @@ AppendOnlyBlockDirectory_GetEntry(
 	return false;
 }
 
+/*
+ * AppendOnlyBlockDirectory_GetEntryZone
+ *
+ * Like AppendOnlyBlockDirectory_GetEntry, but also return the zone of the
+ * directory entry found. zone->lastRowNum is 0 if the entry has no zone.
+ */
+bool
+AppendOnlyBlockDirectory_GetEntryZone(
+									  AppendOnlyBlockDirectory *blockDirectory,
+									  AOTupleId *aoTupleId,
+									  int columnGroupNo,
+									  AppendOnlyBlockDirectoryEntry *directoryEntry,
+									  MinipageZone *zone)
+{
+	MinipagePerColumnGroup *minipageInfo;
+	int			entry_no;
+
+	AppendOnlyBlockDirectory_ZoneReset(zone);
+
+	if (!AppendOnlyBlockDirectory_GetEntry(blockDirectory, aoTupleId,
+										   columnGroupNo, directoryEntry))
+		return false;
+
+	/*
+	 * GetEntry left the minipage holding the entry in memory. Look the entry
+	 * up again by its first row.
+	 */
+	minipageInfo = &blockDirectory->minipages[columnGroupNo];
+	entry_no = find_minipage_entry(minipageInfo->minipage,
+								   minipageInfo->numMinipageEntries,
+								   directoryEntry->range.firstRowNum);
+	if (entry_no != -1)
+		*zone = minipageInfo->zones[entry_no];
+
+	return true;
+}
+
 /*
  * AppendOnlyBlockDirectory_InsertEntry
  *
@@ -673,7 +724,127 @@ AppendOnlyBlockDirectory_InsertEntry(
 									 bool addColAction)
 {
 	return insert_new_entry(blockDirectory, columnGroupNo, firstRowNum,
-							fileOffset, rowCount, addColAction);
+							fileOffset, rowCount, NULL, addColAction);
+}
+
+/*
+ * AppendOnlyBlockDirectory_InsertEntryWithZone
+ *
+ * Like AppendOnlyBlockDirectory_InsertEntry, also recording the zone of the
+ * values in the new block. If the block is folded into the latest existing
+ * entry because of gp_blockdirectory_entry_min_range, the zone is merged into
+ * the zone of that entry.
+ */
+bool
+AppendOnlyBlockDirectory_InsertEntryWithZone(
+											 AppendOnlyBlockDirectory *blockDirectory,
+											 int columnGroupNo,
+											 int64 firstRowNum,
+											 int64 fileOffset,
+											 int64 rowCount,
+											 const MinipageZone *zone,
+											 bool addColAction)
+{
+	return insert_new_entry(blockDirectory, columnGroupNo, firstRowNum,
+							fileOffset, rowCount, zone, addColAction);
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneSupportedType
+ *
+ * Zones are kept for the fixed-length types whose Datums order like signed
+ * integers.
+ */
+bool
+AppendOnlyBlockDirectory_ZoneSupportedType(Oid typid)
+{
+	switch (typid)
+	{
+		case INT2OID:
+		case INT4OID:
+		case INT8OID:
+		case DATEOID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return true;
+		default:
+			return false;
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneValue
+ *
+ * Map a Datum of a type supported by zones to the int64 kept in a zone.
+ */
+int64
+AppendOnlyBlockDirectory_ZoneValue(Oid typid, Datum value)
+{
+	switch (typid)
+	{
+		case INT2OID:
+			return (int64) DatumGetInt16(value);
+		case INT4OID:
+		case DATEOID:
+			return (int64) DatumGetInt32(value);
+		case INT8OID:
+		case TIMEOID:
+		case TIMESTAMPOID:
+		case TIMESTAMPTZOID:
+			return DatumGetInt64(value);
+		default:
+			elog(ERROR, "type %u is not supported by append-only zone maps",
+				 typid);
+			return 0;			/* keep compiler quiet */
+	}
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneReset
+ *
+ * Make the zone empty, i.e. covering no row and no value.
+ */
+void
+AppendOnlyBlockDirectory_ZoneReset(MinipageZone *zone)
+{
+	zone->minValue = PG_INT64_MAX;
+	zone->maxValue = PG_INT64_MIN;
+	zone->lastRowNum = 0;
+}
+
+/*
+ * AppendOnlyBlockDirectory_ZoneAdd
+ *
+ * Add a non-null value to the zone.
+ */
+void
+AppendOnlyBlockDirectory_ZoneAdd(MinipageZone *zone, int64 value)
+{
+	if (value < zone->minValue)
+		zone->minValue = value;
+	if (value > zone->maxValue)
+		zone->maxValue = value;
+}
+
+/*
+ * Merge the zone of a following block into the zone of an entry. A block
+ * without zone makes the whole entry unusable for skipping.
+ */
+static void
+merge_zone(MinipageZone *entryZone, const MinipageZone *zone)
+{
+	if (entryZone->lastRowNum == 0 || zone == NULL || zone->lastRowNum == 0)
+	{
+		entryZone->lastRowNum = 0;
+		return;
+	}
+
+	if (zone->minValue < entryZone->minValue)
+		entryZone->minValue = zone->minValue;
+	if (zone->maxValue > entryZone->maxValue)
+		entryZone->maxValue = zone->maxValue;
+	entryZone->lastRowNum = zone->lastRowNum;
 }
 
 /*
@@ -688,6 +859,7 @@ insert_new_entry(
 				 int64 firstRowNum,
 				 int64 fileOffset,
 				 int64 rowCount,
+				 const MinipageZone *zone,
 				 bool addColAction)
 {
 	MinipageEntry *entry = NULL;
@@ -733,7 +905,10 @@ insert_new_entry(
 
 		if (gp_blockdirectory_entry_min_range > 0 &&
 			fileOffset - entry->fileOffset < gp_blockdirectory_entry_min_range)
+		{
+			merge_zone(&minipageInfo->zones[lastEntryNo], zone);
 			return true;
+		}
 
 		/* Update the rowCount in the latest entry */
 		Assert(entry->rowCount <= firstRowNum - entry->firstRowNum);
@@ -764,6 +939,8 @@ insert_new_entry(
 		 */
 		MemSet(minipageInfo->minipage->entry, 0,
 			   minipageInfo->numMinipageEntries * sizeof(MinipageEntry));
+		MemSet(minipageInfo->zones, 0,
+			   minipageInfo->numMinipageEntries * sizeof(MinipageZone));
 		minipageInfo->numMinipageEntries = 0;
 	}
 
@@ -774,6 +951,12 @@ insert_new_entry(
 	entry->fileOffset = fileOffset;
 	entry->rowCount = rowCount;
 
+	if (zone != NULL)
+		minipageInfo->zones[minipageInfo->numMinipageEntries] = *zone;
+	else
+		MemSet(&minipageInfo->zones[minipageInfo->numMinipageEntries], 0,
+			   sizeof(MinipageZone));
+
 	minipageInfo->numMinipageEntries++;
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -916,7 +1099,7 @@ copy_out_minipage(MinipagePerColumnGroup *minipageInfo,
 	value = (struct varlena *)
 		DatumGetPointer(minipage_value);
 	detoast_value = pg_detoast_datum(value);
-	Assert(VARSIZE(detoast_value) <= minipage_size(NUM_MINIPAGE_ENTRIES));
+	Assert(VARSIZE(detoast_value) <= minipage_size_with_zones(NUM_MINIPAGE_ENTRIES));
 
 	memcpy(minipageInfo->minipage, detoast_value, VARSIZE(detoast_value));
 	if (detoast_value != value)
@@ -925,6 +1108,20 @@ copy_out_minipage(MinipagePerColumnGroup *minipageInfo,
 	Assert(minipageInfo->minipage->nEntry <= NUM_MINIPAGE_ENTRIES);
 
 	minipageInfo->numMinipageEntries = minipageInfo->minipage->nEntry;
+
+	/* Minipages written without zones have none for any of their entries */
+	if (minipageInfo->minipage->version == MINIPAGE_VERSION_ZONES)
+	{
+		Assert(VARSIZE(minipageInfo->minipage) ==
+			   minipage_size_with_zones(minipageInfo->numMinipageEntries));
+		memcpy(minipageInfo->zones,
+			   ((char *) minipageInfo->minipage) +
+			   minipage_size(minipageInfo->numMinipageEntries),
+			   sizeof(MinipageZone) * minipageInfo->numMinipageEntries);
+	}
+	else
+		MemSet(minipageInfo->zones, 0,
+			   sizeof(MinipageZone) * minipageInfo->numMinipageEntries);
 }
 
 
@@ -1141,6 +1338,7 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 	bool	   *nulls = blockDirectory->nulls;
 	Relation	blkdirRel = blockDirectory->blkdirRel;
 	TupleDesc	heapTupleDesc = RelationGetDescr(blkdirRel);
+	uint32		i;
 
 	Assert(minipageInfo->numMinipageEntries > 0);
 
@@ -1160,8 +1358,34 @@ write_minipage(AppendOnlyBlockDirectory *blockDirectory,
 		Int64GetDatum(minipageInfo->minipage->entry[0].firstRowNum);
 	nulls[Anum_pg_aoblkdir_firstrownum - 1] = false;
 
-	SET_VARSIZE(minipageInfo->minipage,
-				minipage_size(minipageInfo->numMinipageEntries));
+	/*
+	 * Only carry the zones if any entry has one, so that the minipages of
+	 * columns without zone maps don't grow. Minipages with zones can't be
+	 * read by servers that predate MINIPAGE_VERSION_ZONES, so they are only
+	 * written when gp_appendonly_zone_maps is on.
+	 */
+	minipageInfo->minipage->version = MINIPAGE_VERSION_ORIGINAL;
+	for (i = 0; gp_appendonly_zone_maps && i < minipageInfo->numMinipageEntries; i++)
+	{
+		if (minipageInfo->zones[i].lastRowNum != 0)
+		{
+			minipageInfo->minipage->version = MINIPAGE_VERSION_ZONES;
+			break;
+		}
+	}
+
+	if (minipageInfo->minipage->version == MINIPAGE_VERSION_ZONES)
+	{
+		memcpy(((char *) minipageInfo->minipage) +
+			   minipage_size(minipageInfo->numMinipageEntries),
+			   minipageInfo->zones,
+			   sizeof(MinipageZone) * minipageInfo->numMinipageEntries);
+		SET_VARSIZE(minipageInfo->minipage,
+					minipage_size_with_zones(minipageInfo->numMinipageEntries));
+	}
+	else
+		SET_VARSIZE(minipageInfo->minipage,
+					minipage_size(minipageInfo->numMinipageEntries));
 	minipageInfo->minipage->nEntry = minipageInfo->numMinipageEntries;
 	values[Anum_pg_aoblkdir_minipage - 1] =
 		PointerGetDatum(minipageInfo->minipage);
@@ -1236,6 +1460,7 @@ AppendOnlyBlockDirectory_End_forInsert(
 		}
 
 		pfree(minipageInfo->minipage);
+		pfree(minipageInfo->zones);
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -1271,7 +1496,10 @@ AppendOnlyBlockDirectory_End_forSearch(
 	for (groupNo = 0; groupNo < blockDirectory->numColumnGroups; groupNo++)
 	{
 		if (blockDirectory->minipages[groupNo].minipage != NULL)
+		{
 			pfree(blockDirectory->minipages[groupNo].minipage);
+			pfree(blockDirectory->minipages[groupNo].zones);
+		}
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -1321,6 +1549,7 @@ AppendOnlyBlockDirectory_End_addCol(
 							  groupNo, minipageInfo->numMinipageEntries)));
 		}
 		pfree(minipageInfo->minipage);
+		pfree(minipageInfo->zones);
 	}
 
 	ereportif(Debug_appendonly_print_blockdirectory, LOG,
@@ -21,14 +21,18 @@
 #include "access/genam.h"
 #include "access/tupdesc.h"
 #include "access/heapam.h"
+#include "access/htup_details.h"
 #include "access/bitmap.h"
 #include "access/transam.h"
+#include "catalog/pg_operator.h"
+#include "catalog/pg_type.h"
 #include "parser/parse_oper.h"
 #include "utils/builtins.h"
 #include "utils/datum.h"
 #include "utils/guc.h"
 #include "utils/lsyscache.h"
 #include "utils/snapmgr.h"
+#include "utils/tuplesort.h"
 
 /*
  * The following structure along with BMTIDBuffer are used to buffer
@@ -95,13 +99,15 @@ static void lshift_header_bits(BM_HRL_WORD *words, uint64 nwords,
 static void insert_newwords(BMTIDBuffer* words, uint32 insertPos,
 							BMTIDBuffer* new_words, BMTIDBuffer* words_left);
 static int16 mergewords(BMTIDBuffer* buf, bool lastWordFill);
-static void buf_make_space(Relation rel,
-					  BMTidBuildBuf *tidLocsBuffer, bool use_wal);
 static void verify_bitmappages(Relation rel, BMLOVItem lovitem);
 static int16 buf_add_tid_with_fill(Relation rel, BMTIDBuffer *buf,
 								   Buffer lovBuffer, OffsetNumber off,
 								   uint64 tidnum, bool use_wal);
 static uint16 buf_extend(BMTIDBuffer *buf);
+static uint16 buf_init_from_lovitem(BMTIDBuffer *buf, Buffer lovbuf,
+									OffsetNumber off);
+static void sort_add_tid(BMBuildState *state, BlockNumber lov_block,
+						 OffsetNumber off, uint64 tidnum);
 static uint16 buf_ensure_head_space(Relation rel, BMTIDBuffer *buf,
 								   Buffer lovBuffer, OffsetNumber off,
 								   bool use_wal);
@@ -1711,10 +1717,6 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 	BMTIDBuffer *buf;
 	BMTIDLOVBuffer *lov_buf = NULL;
 
-	/* If we surpass maintenance_work_mem, free some space from the buffer */
-	if (tids->byte_size >= maintenance_work_mem * 1024L)
-		buf_make_space(rel, tids, state->use_wal);
-
 	/*
 	 * tids is lazily initialized. If we do not have a current LOV block 
 	 * buffer, initialize one.
@@ -1770,26 +1772,12 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 	{
 		/* no pre-existing buffer found, create a new one */
 		Buffer lovbuf;
-		Page page;
-		BMLOVItem lovitem;
 		uint16 bytes_added;
 		
 		buf = (BMTIDBuffer *)palloc0(sizeof(BMTIDBuffer));
 		
 		lovbuf = _bitmap_getbuf(rel, lov_block, BM_WRITE);
-		page = BufferGetPage(lovbuf);
-		lovitem = (BMLOVItem)PageGetItem(page, PageGetItemId(page, off));
-
-		buf->last_tid = lovitem->bm_last_setbit;
-		buf->last_compword = lovitem->bm_last_compword;
-		buf->last_word = lovitem->bm_last_word;
-		buf->is_last_compword_fill = (lovitem->lov_words_header == 2);
-
-		MemSet(buf->hwords, 0, BM_NUM_OF_HEADER_WORDS * sizeof(BM_HRL_WORD));
-
-		bytes_added = buf_extend(buf);
-
-		buf->curword = 0;
+		bytes_added = buf_init_from_lovitem(buf, lovbuf, off);
 
 		buf_add_tid_with_fill(rel, buf, lovbuf, off, tidnum,
 							  state->use_wal);
@@ -1801,6 +1789,33 @@ buf_add_tid(Relation rel, BMTidBuildBuf *tids, uint64 tidnum,
 	}
 }
 
+/*
+ * buf_init_from_lovitem() -- Set up an empty buffer to append to the bitmap
+ * vector of the given LOV item.
+ *
+ * The caller should hold a lock on lovbuf. Returns the number of bytes
+ * allocated.
+ */
+static uint16
+buf_init_from_lovitem(BMTIDBuffer *buf, Buffer lovbuf, OffsetNumber off)
+{
+	Page		page = BufferGetPage(lovbuf);
+	BMLOVItem	lovitem;
+
+	lovitem = (BMLOVItem) PageGetItem(page, PageGetItemId(page, off));
+
+	buf->last_tid = lovitem->bm_last_setbit;
+	buf->last_compword = lovitem->bm_last_compword;
+	buf->last_word = lovitem->bm_last_word;
+	buf->is_last_compword_fill = (lovitem->lov_words_header == 2);
+
+	MemSet(buf->hwords, 0, BM_NUM_OF_HEADER_WORDS * sizeof(BM_HRL_WORD));
+
+	buf->curword = 0;
+
+	return buf_extend(buf);
+}
+
 /*
  * buf_add_tid_with_fill() -- Worker for buf_add_tid().
  *
@@ -2019,50 +2034,6 @@ buf_free_mem_block(Relation rel, BMTIDBuffer *buf, Buffer lovbuf,
 	return _bitmap_free_tidbuf(buf);
 }
 
-/*
- * Spill some data out of the buffer to free up space.
- */
-static void
-buf_make_space(Relation rel, BMTidBuildBuf *locbuf, bool use_wal)
-{
-	ListCell *cell;
-
-	/*
-	 * Now, we could just pull the head of lov_blocks but there'd be no
-	 * guarantee that we'd free up enough space.
-	 */
-	foreach(cell, locbuf->lov_blocks)
-	{
-		int i;
-		BMTIDLOVBuffer *lov_buf = (BMTIDLOVBuffer *)lfirst(cell);
-		BlockNumber lov_block = lov_buf->lov_block;
-
-		for (i = 0; i < BM_MAX_LOVITEMS_PER_PAGE; i++)
-		{
-			BMTIDBuffer *buf = (BMTIDBuffer *)lov_buf->bufs[i];
-			OffsetNumber off;
-
-			/* return if we've freed enough space */
-#ifdef NOT_USED
-			if (locbuf->byte_size < (maintenance_work_mem * 1024L))
-				return;
-#endif
-			if (!buf || buf->num_cwords == 0)
-				continue;
-
-			off = i + 1;
-			locbuf->byte_size -= buf_free_mem(rel, buf, lov_block, off, use_wal);
-
-			if (QueryCancelPending || ProcDiePending)
-				return;
-		}
-#ifdef NOT_USED
-		if (locbuf->byte_size < (maintenance_work_mem * 1024L))
-			return;
-#endif
-	}
-}
-
 /*
  * _bitmap_free_tidbuf() -- release the space.
  */
@@ -2228,6 +2199,123 @@ _bitmap_write_alltids(Relation rel, BMTidBuildBuf *tids,
 	tids->byte_size = 0;
 }
 
+/*
+ * sort_add_tid() -- add a tid location of the bitmap vector of the given LOV
+ * item to the sort.
+ *
+ * The sort is started when the tid buffer first outgrows
+ * maintenance_work_mem, after writing out the buffer. From then on, all tid
+ * locations go through the sort, and _bitmap_write_sortedtids() writes them
+ * out at the end of the build, one bitmap vector at a time.
+ */
+static void
+sort_add_tid(BMBuildState *state, BlockNumber lov_block, OffsetNumber off,
+			 uint64 tidnum)
+{
+	Datum		values[2];
+	bool		isnull[2] = {false, false};
+	HeapTuple	tup;
+
+	if (state->bm_tidsort == NULL)
+	{
+		TupleDesc	desc;
+		AttrNumber	attNums[2] = {1, 2};
+		Oid			sortOperators[2] = {Int8LessOperator, Int8LessOperator};
+		Oid			sortCollations[2] = {InvalidOid, InvalidOid};
+		bool		nullsFirst[2] = {false, false};
+
+		desc = CreateTemplateTupleDesc(2, false);
+		TupleDescInitEntry(desc, (AttrNumber) 1, "lov_item", INT8OID, -1, 0);
+		TupleDescInitEntry(desc, (AttrNumber) 2, "tid_location", INT8OID, -1, 0);
+
+		state->bm_tidsort_desc = desc;
+		state->bm_tidsort = tuplesort_begin_heap(NULL, desc, 2, attNums,
+												 sortOperators, sortCollations,
+												 nullsFirst,
+												 maintenance_work_mem, false);
+	}
+
+	values[0] = Int64GetDatum(((int64) lov_block << 16) | off);
+	values[1] = Int64GetDatum((int64) tidnum);
+	tup = heap_form_tuple(state->bm_tidsort_desc, values, isnull);
+	tuplesort_putheaptuple(state->bm_tidsort, tup);
+	heap_freetuple(tup);
+}
+
+/*
+ * _bitmap_write_sortedtids() -- write all tids in the sort into disk.
+ *
+ * The tid locations come out of the sort grouped by LOV item, in increasing
+ * order. We append each bitmap vector in turn, so that the words are
+ * compressed only once, and the pages of a vector are filled up and
+ * allocated one after another, rather than a few words at a time each time
+ * the tid buffer spills.
+ */
+void
+_bitmap_write_sortedtids(Relation rel, BMBuildState *state)
+{
+	Tuplesortstate *sort = state->bm_tidsort;
+	BMTIDBuffer buf;
+	Buffer		lovbuf = InvalidBuffer;
+	int64		cur_lov_item = -1;
+	HeapTuple	tup;
+	bool		should_free;
+
+	MemSet(&buf, 0, sizeof(buf));
+
+	tuplesort_performsort(sort);
+
+	while ((tup = tuplesort_getheaptuple(sort, true, &should_free)) != NULL)
+	{
+		Datum		values[2];
+		bool		isnull[2];
+		int64		lov_item;
+
+		heap_deform_tuple(tup, state->bm_tidsort_desc, values, isnull);
+		lov_item = DatumGetInt64(values[0]);
+
+		if (lov_item != cur_lov_item)
+		{
+			if (BufferIsValid(lovbuf))
+			{
+				buf_free_mem_block(rel, &buf, lovbuf,
+								   (OffsetNumber) (cur_lov_item & 0xFFFF),
+								   state->use_wal);
+				_bitmap_relbuf(lovbuf);
+			}
+
+			CHECK_FOR_INTERRUPTS();
+
+			cur_lov_item = lov_item;
+			lovbuf = _bitmap_getbuf(rel, (BlockNumber) (lov_item >> 16),
+									BM_WRITE);
+			buf_init_from_lovitem(&buf, lovbuf,
+								  (OffsetNumber) (lov_item & 0xFFFF));
+		}
+
+		buf_add_tid_with_fill(rel, &buf, lovbuf,
+							  (OffsetNumber) (lov_item & 0xFFFF),
+							  (uint64) DatumGetInt64(values[1]),
+							  state->use_wal);
+
+		if (should_free)
+			heap_freetuple(tup);
+	}
+
+	if (BufferIsValid(lovbuf))
+	{
+		buf_free_mem_block(rel, &buf, lovbuf,
+						   (OffsetNumber) (cur_lov_item & 0xFFFF),
+						   state->use_wal);
+		_bitmap_relbuf(lovbuf);
+	}
+
+	tuplesort_end(sort);
+	state->bm_tidsort = NULL;
+	FreeTupleDesc(state->bm_tidsort_desc);
+	state->bm_tidsort_desc = NULL;
+}
+
 /*
  * build_inserttuple() -- insert a new tuple into the bitmap index
  *	during the bitmap index construction.
@@ -2271,8 +2359,6 @@ build_inserttuple(Relation rel, uint64 tidnum,
 		}
 	}
 
-	metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
-	
 	/*
 	 * if the inserting tuple has the value of NULL, then
 	 * the corresponding tid array is the first.
@@ -2315,9 +2401,11 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				 * If the inserting tuple has a new value, then we create a new
 				 * LOV item.
 				 */
+				metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
 				create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, 
 							   nulls, state->bm_lov_heap, state->bm_lov_index,
 							   &lovBlock, &lovOffset, state->use_wal);
+				_bitmap_wrtbuf(metabuf);
 
 				lov = (BMBuildLovData *) (((char*)entry) + state->lovitem_hashKeySize );
 				lov->lov_block = lovBlock;
@@ -2365,15 +2453,30 @@ build_inserttuple(Relation rel, uint64 tidnum,
 				 * If the inserting tuple has a new value, then we create a new
 				 * LOV item.
 				 */
+				metabuf = _bitmap_getbuf(rel, BM_METAPAGE, BM_WRITE);
 				create_lovitem(rel, metabuf, tidnum, tupDesc, attdata, 
 							   nulls, state->bm_lov_heap, state->bm_lov_index,
 							   &lovBlock, &lovOffset, state->use_wal);
+				_bitmap_wrtbuf(metabuf);
 			}
 		}
 	}
 
-	buf_add_tid(rel, tidLocsBuffer, tidnum, state, lovBlock, lovOffset);
-	_bitmap_wrtbuf(metabuf);
+	/*
+	 * As long as the buffered words fit in maintenance_work_mem, append the
+	 * tid location to its buffer directly. Once they don't, write them all
+	 * out and sort the rest instead: spilling the buffers over and over
+	 * would append a few words at a time to every bitmap vector.
+	 */
+	if (state->bm_tidsort == NULL &&
+		tidLocsBuffer->byte_size < maintenance_work_mem * 1024L)
+		buf_add_tid(rel, tidLocsBuffer, tidnum, state, lovBlock, lovOffset);
+	else
+	{
+		if (state->bm_tidsort == NULL)
+			_bitmap_write_alltids(rel, tidLocsBuffer, state->use_wal);
+		sort_add_tid(state, lovBlock, lovOffset, tidnum);
+	}
 
 	CHECK_FOR_INTERRUPTS();
 }
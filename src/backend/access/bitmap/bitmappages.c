@@ -22,7 +22,9 @@
 #include "access/tupdesc.h"
 #include "access/bitmap.h"
 #include "parser/parse_oper.h"
+#include "storage/bufmgr.h"
 #include "storage/lmgr.h"
+#include "storage/smgr.h"
 #include "utils/memutils.h"
 #include "utils/lsyscache.h"
 #include "utils/snapmgr.h"
@@ -173,6 +175,8 @@ _bitmap_init_buildstate(Relation index, BMBuildState *bmstate)
 	bmstate->bm_tidLocsBuffer->byte_size = 0;
 	bmstate->bm_tidLocsBuffer->lov_blocks = NIL;
 	bmstate->bm_tidLocsBuffer->max_lov_block = InvalidBlockNumber;
+	bmstate->bm_tidsort = NULL;
+	bmstate->bm_tidsort_desc = NULL;
 
 	metabuf = _bitmap_getbuf(index, BM_METAPAGE, BM_READ);
 	mp = _bitmap_get_metapage_data(index, metabuf);
@@ -298,11 +302,10 @@ _bitmap_init_buildstate(Relation index, BMBuildState *bmstate)
 
 	/*
 	 * We need to log index creation in WAL iff WAL archiving is enabled
-	 * AND it's not a temp index. Currently, since building an index
-	 * writes page to the shared buffer, we can't disable WAL archiving.
-	 * We will add this shortly.
-	 */	
-	bmstate->use_wal = RelationNeedsWAL(index);
+	 * AND it's not a temp index. If we don't, the index is fsync'd at the
+	 * end of the build instead, see _bitmap_cleanup_buildstate().
+	 */
+	bmstate->use_wal = XLogIsNeeded() && RelationNeedsWAL(index);
 }
 
 /*
@@ -316,6 +319,10 @@ _bitmap_cleanup_buildstate(Relation index, BMBuildState *bmstate)
 	BMTidBuildBuf	*tidLocsBuffer = bmstate->bm_tidLocsBuffer;
 	_bitmap_write_alltids(index, tidLocsBuffer, bmstate->use_wal);
 
+	/* and the ones that were sorted */
+	if (bmstate->bm_tidsort)
+		_bitmap_write_sortedtids(index, bmstate);
+
 	pfree(bmstate->bm_tidLocsBuffer);
 
 	if (cur_bmbuild)
@@ -340,6 +347,17 @@ _bitmap_cleanup_buildstate(Relation index, BMBuildState *bmstate)
 
 	_bitmap_close_lov_heapandindex(bmstate->bm_lov_heap,bmstate->bm_lov_index,
 						 		   RowExclusiveLock);
+
+	/*
+	 * If we didn't WAL-log the index pages, they must be on disk before we
+	 * commit. The pages went through shared buffers, so flush those first.
+	 */
+	if (!bmstate->use_wal && RelationNeedsWAL(index))
+	{
+		FlushRelationBuffers(index);
+		RelationOpenSmgr(index);
+		smgrimmedsync(index->rd_smgr, MAIN_FORKNUM);
+	}
 }
 
 /*
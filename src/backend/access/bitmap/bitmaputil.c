@@ -24,9 +24,186 @@
 #include "access/reloptions.h"
 #include "access/relscan.h"
 
+/*
+ * The OR of literal words is done with 256-bit or 512-bit vector
+ * instructions when the CPU we run on has them.
+ */
+#if defined(__x86_64__) && defined(__GNUC__) && defined(HAVE__GET_CPUID)
+#define USE_BM_X86_SIMD
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
+/*
+ * Bit tricks on bitmap words. Both rightmost_one_pos and leading_zeros are
+ * undefined for a zero word.
+ */
+#if defined(__GNUC__)
+#define bm_rightmost_one_pos(w)		__builtin_ctzll(w)
+#define bm_leading_zeros(w)			__builtin_clzll(w)
+#define bm_popcount(w)				__builtin_popcountll(w)
+#else
+static inline int
+bm_rightmost_one_pos(BM_HRL_WORD w)
+{
+	int			pos = 0;
+
+	while ((w & 1) == 0)
+	{
+		w >>= 1;
+		pos++;
+	}
+	return pos;
+}
+
+static inline int
+bm_leading_zeros(BM_HRL_WORD w)
+{
+	int			n = 0;
+
+	while ((w & ((BM_HRL_WORD) 1 << BM_HRL_WORD_LEFTMOST)) == 0)
+	{
+		w <<= 1;
+		n++;
+	}
+	return n;
+}
+
+static inline int
+bm_popcount(BM_HRL_WORD w)
+{
+	int			n = 0;
+
+	for (; w != 0; w &= w - 1)
+		n++;
+	return n;
+}
+#endif
+
+/*
+ * Only runs of at least this many literal words in every batch take the
+ * vectorized path of _bitmap_union().
+ */
+#define BM_MIN_LITERAL_RUN	4
+
 static void _bitmap_findnextword(BMBatchWords* words, uint64 nextReadNo);
 static void _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo);
 static uint8 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos);
+static uint32 _bitmap_literal_run(const BM_HRL_WORD *hwords, uint32 wordNo,
+								  uint32 maxRun);
+static uint32 _bitmap_union_literals(BMBatchWords **batches, uint32 numBatches,
+									 uint64 nextReadNo, BMBatchWords *result);
+
+static void bm_or_words_scalar(BM_HRL_WORD *dst, const BM_HRL_WORD *src,
+							   uint32 nwords);
+static void bm_or_words_choose(BM_HRL_WORD *dst, const BM_HRL_WORD *src,
+							   uint32 nwords);
+
+/* OR 'nwords' words of 'src' into 'dst'; chosen at the first call */
+static void (*bm_or_words) (BM_HRL_WORD *dst, const BM_HRL_WORD *src,
+							uint32 nwords) = bm_or_words_choose;
+
+static void
+bm_or_words_scalar(BM_HRL_WORD *dst, const BM_HRL_WORD *src, uint32 nwords)
+{
+	uint32		i;
+
+	for (i = 0; i < nwords; i++)
+		dst[i] |= src[i];
+}
+
+#ifdef USE_BM_X86_SIMD
+
+__attribute__((target("avx2")))
+static void
+bm_or_words_avx2(BM_HRL_WORD *dst, const BM_HRL_WORD *src, uint32 nwords)
+{
+	uint32		i = 0;
+
+	for (; i + 4 <= nwords; i += 4)
+	{
+		__m256i		a = _mm256_loadu_si256((const __m256i *) (dst + i));
+		__m256i		b = _mm256_loadu_si256((const __m256i *) (src + i));
+
+		_mm256_storeu_si256((__m256i *) (dst + i), _mm256_or_si256(a, b));
+	}
+	for (; i < nwords; i++)
+		dst[i] |= src[i];
+}
+
+__attribute__((target("avx512f")))
+static void
+bm_or_words_avx512(BM_HRL_WORD *dst, const BM_HRL_WORD *src, uint32 nwords)
+{
+	uint32		i = 0;
+
+	for (; i + 8 <= nwords; i += 8)
+	{
+		__m512i		a = _mm512_loadu_si512((const void *) (dst + i));
+		__m512i		b = _mm512_loadu_si512((const void *) (src + i));
+
+		_mm512_storeu_si512((void *) (dst + i), _mm512_or_si512(a, b));
+	}
+	for (; i < nwords; i++)
+		dst[i] |= src[i];
+}
+
+/*
+ * Which of AVX2 (256-bit) and AVX-512F (512-bit) can we use? Both need the
+ * OS to save the wider registers on context switch, see XGETBV.
+ */
+static void
+bm_x86_simd_available(bool *avx2, bool *avx512)
+{
+	unsigned int eax, ebx, ecx, edx;
+	uint32		xcr0_lo;
+	uint32		xcr0_hi;
+
+	*avx2 = *avx512 = false;
+
+	if (__get_cpuid_max(0, NULL) < 7)
+		return;
+
+	__cpuid(1, eax, ebx, ecx, edx);
+	if ((ecx & (1 << 27)) == 0)		/* OSXSAVE */
+		return;
+
+	__asm__ __volatile__("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+	if ((xcr0_lo & 0x6) != 0x6)		/* XMM and YMM state */
+		return;
+
+	__cpuid_count(7, 0, eax, ebx, ecx, edx);
+	*avx2 = (ebx & (1 << 5)) != 0;
+	*avx512 = (ebx & (1 << 16)) != 0 &&
+		(xcr0_lo & 0xe0) == 0xe0;	/* opmask and ZMM state */
+}
+
+#endif							/* USE_BM_X86_SIMD */
+
+/*
+ * This gets called on the first call. It replaces the function pointer
+ * so that subsequent calls are routed directly to the chosen implementation.
+ */
+static void
+bm_or_words_choose(BM_HRL_WORD *dst, const BM_HRL_WORD *src, uint32 nwords)
+{
+	bm_or_words = bm_or_words_scalar;
+
+#ifdef USE_BM_X86_SIMD
+	{
+		bool		avx2;
+		bool		avx512;
+
+		bm_x86_simd_available(&avx2, &avx512);
+		if (avx512)
+			bm_or_words = bm_or_words_avx512;
+		else if (avx2)
+			bm_or_words = bm_or_words_avx2;
+	}
+#endif
+
+	bm_or_words(dst, src, nwords);
+}
 
 /*
  * _bitmap_formitem() -- construct a LOV entry.
@@ -312,34 +489,42 @@ _bitmap_findnexttids(BMBatchWords *words, BMIterateResult *result,
 		}
 		else
 		{
-			if(oldScanPos == 0)
-				oldScanPos = BM_HRL_WORD_SIZE + 1;
+			/* the tid of bit position 0 of this literal word */
+			uint64		base = result->nextTid - oldScanPos;
+			BM_HRL_WORD	w = word;
 
-			while (oldScanPos != 0 && result->numOfTids < maxTids)
-			{
-				BM_HRL_WORD		w;
+			/* forget the bits returned by the previous call */
+			if (oldScanPos >= BM_HRL_WORD_SIZE)
+				w = 0;
+			else
+				w &= LITERAL_ALL_ONE << oldScanPos;
 
-				if (oldScanPos == BM_HRL_WORD_SIZE + 1)
-					oldScanPos = 0;
+			if (bm_popcount(w) <= maxTids - result->numOfTids)
+			{
+				/* all the remaining bits fit, take them lowest first */
+				for (; w != 0; w &= w - 1)
+					result->nextTids[result->numOfTids++] =
+						base + bm_rightmost_one_pos(w) + 1;
 
-				w = words->cwords[result->lastScanWordNo];
-				result->lastScanPos = _bitmap_find_bitset(w, oldScanPos);
+				/* start scanning a new word */
+				result->nextTid = base + BM_HRL_WORD_SIZE;
+				words->nwords--;
+				result->lastScanWordNo++;
+				result->lastScanPos = 0;
+			}
+			else
+			{
+				/* fill the result, and remember where we stopped */
+				uint8		pos = oldScanPos;
 
-				/* did we fine a bit set in this word? */
-				if (result->lastScanPos != 0)
-				{
-					result->nextTid += (result->lastScanPos - oldScanPos);
-					result->nextTids[result->numOfTids++] = result->nextTid;
-				}
-				else
+				while (result->numOfTids < maxTids)
 				{
-					result->nextTid += BM_HRL_WORD_SIZE - oldScanPos;
-					/* start scanning a new word */
-					words->nwords--;
-					result->lastScanWordNo++;
-					result->lastScanPos = 0;
+					pos = _bitmap_find_bitset(w, pos);
+					Assert(pos != 0);
+					result->nextTids[result->numOfTids++] = base + pos;
 				}
-				oldScanPos = result->lastScanPos;
+				result->nextTid = base + pos;
+				result->lastScanPos = pos;
 			}
 		}
 	}
@@ -585,6 +770,16 @@ _bitmap_union(BMBatchWords **batches, uint32 numBatches, BMBatchWords *result)
 		BM_HRL_WORD orWord = LITERAL_ALL_ZERO;
 		BM_HRL_WORD	word;
 		bool		orWordIsLiteral = true;
+		uint32		nliterals;
+
+		/* OR a run of literal words in all batches in one go, if any */
+		nliterals = _bitmap_union_literals(batches, numBatches, nextReadNo,
+										   result);
+		if (nliterals > 0)
+		{
+			nextReadNo += nliterals;
+			continue;
+		}
 
 		for (batchNo = 0; batchNo < numBatches; batchNo++)
 		{
@@ -680,6 +875,88 @@ _bitmap_union(BMBatchWords **batches, uint32 numBatches, BMBatchWords *result)
 	pfree(prevstarts);
 }
 
+/*
+ * _bitmap_union_literals() -- OR the next words of all batches, as long as
+ *		they are literal words in every batch.
+ *
+ * This is the common case for bitmaps that are neither very sparse nor
+ * very dense, and avoids looking at the header bits of every word. The
+ * first batch is copied to the result and the others are ORed into it with
+ * bm_or_words(). Returns the number of words ORed, 0 if the next words don't
+ * form a run of at least BM_MIN_LITERAL_RUN literal words in every batch.
+ */
+static uint32
+_bitmap_union_literals(BMBatchWords **batches, uint32 numBatches,
+					   uint64 nextReadNo, BMBatchWords *result)
+{
+	uint32		run = result->maxNumOfWords - result->nwords;
+	BM_HRL_WORD *dst = &result->cwords[result->nwords];
+	uint32		batchNo;
+
+	for (batchNo = 0; batchNo < numBatches; batchNo++)
+	{
+		BMBatchWords *bch = batches[batchNo];
+
+		_bitmap_findnextword(bch, nextReadNo);
+		if (bch->nwords == 0)
+			return 0;
+
+		run = _bitmap_literal_run(bch->hwords, bch->startNo,
+								  Min(run, bch->nwords));
+		if (run < BM_MIN_LITERAL_RUN)
+			return 0;
+	}
+
+	memcpy(dst, &batches[0]->cwords[batches[0]->startNo],
+		   run * sizeof(BM_HRL_WORD));
+	for (batchNo = 1; batchNo < numBatches; batchNo++)
+		bm_or_words(dst, &batches[batchNo]->cwords[batches[batchNo]->startNo],
+					run);
+
+	for (batchNo = 0; batchNo < numBatches; batchNo++)
+	{
+		BMBatchWords *bch = batches[batchNo];
+
+		bch->nwordsread += run;
+		bch->startNo += run;
+		bch->nwords -= run;
+	}
+
+	/* the header bits of the result words are already 0, i.e. literal */
+	result->nwords += run;
+
+	return run;
+}
+
+/*
+ * _bitmap_literal_run() -- count the literal words, up to 'maxRun', from
+ *		word 'wordNo' on.
+ *
+ * A literal word has its header bit unset, so this counts the unset header
+ * bits, a header word at a time.
+ */
+static uint32
+_bitmap_literal_run(const BM_HRL_WORD *hwords, uint32 wordNo, uint32 maxRun)
+{
+	uint32		run = 0;
+
+	while (run < maxRun)
+	{
+		uint32		bitNo = (wordNo + run) % BM_HRL_WORD_SIZE;
+		BM_HRL_WORD	h = hwords[(wordNo + run) / BM_HRL_WORD_SIZE] << bitNo;
+
+		/* the header bit of the first word is the leftmost one */
+		if (h != 0)
+		{
+			run += bm_leading_zeros(h);
+			break;
+		}
+		run += BM_HRL_WORD_SIZE - bitNo;
+	}
+
+	return Min(run, maxRun);
+}
+
 /*
  * _bitmap_findnextword() -- Find the next word whose position is
  *        	                'nextReadNo' in an uncompressed format.
@@ -761,24 +1038,15 @@ _bitmap_resetWord(BMBatchWords *words, uint32 prevStartNo)
 static uint8
 _bitmap_find_bitset(BM_HRL_WORD word, uint8 lastPos)
 {
-	uint8 pos = lastPos + 1;
-	BM_HRL_WORD	rightmostBitWord;
-
-	if (pos > BM_HRL_WORD_SIZE)
-	  return 0;
-
-	rightmostBitWord = (((BM_HRL_WORD)1) << (pos-1));
-
-	while (pos <= BM_HRL_WORD_SIZE && (word & rightmostBitWord) == 0)
-	{
-		rightmostBitWord <<= 1;
-		pos++;
-	}
+	if (lastPos >= BM_HRL_WORD_SIZE)
+		return 0;
 
-	if (pos > BM_HRL_WORD_SIZE)
-		pos = 0;
+	/* clear the bits up to and including 'lastPos' */
+	word &= LITERAL_ALL_ONE << lastPos;
+	if (word == 0)
+		return 0;
 
-	return pos;
+	return bm_rightmost_one_pos(word) + 1;
 }
 
 /*
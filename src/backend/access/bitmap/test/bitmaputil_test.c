@@ -0,0 +1,395 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../bitmaputil.c"
+
+#include "portability/instr_time.h"
+#include "utils/memutils.h"
+
+/* number of uncompressed words in the test bitmaps */
+#define NWORDS		8192
+
+/*
+ * Shape of a synthetic bitmap: the chance of a word being all zeros or
+ * all ones, and the chance of each bit being set in the other words.
+ */
+typedef struct BitmapShape
+{
+	const char *name;
+	double		zeroWords;
+	double		oneWords;
+	double		bitDensity;
+} BitmapShape;
+
+static const BitmapShape shapes[] = {
+	{"sparse", 0.9, 0.0, 0.01},
+	{"low", 0.2, 0.0, 0.05},
+	{"medium", 0.0, 0.0, 0.5},
+	{"high", 0.0, 0.1, 0.95},
+	{"runs", 0.45, 0.45, 0.5}
+};
+
+static uint64 rand_state = 42;
+
+static double
+rand_unit(void)
+{
+	/* xorshift64 */
+	rand_state ^= rand_state << 13;
+	rand_state ^= rand_state >> 7;
+	rand_state ^= rand_state << 17;
+	return (rand_state >> 11) * (1.0 / (UINT64CONST(1) << 53));
+}
+
+static void
+make_words(const BitmapShape *shape, BM_HRL_WORD *words, int nwords)
+{
+	int			i;
+	int			bitNo;
+
+	for (i = 0; i < nwords; i++)
+	{
+		double		r = rand_unit();
+
+		if (r < shape->zeroWords)
+			words[i] = LITERAL_ALL_ZERO;
+		else if (r < shape->zeroWords + shape->oneWords)
+			words[i] = LITERAL_ALL_ONE;
+		else
+		{
+			words[i] = 0;
+			for (bitNo = 0; bitNo < BM_HRL_WORD_SIZE; bitNo++)
+				if (rand_unit() < shape->bitDensity)
+					words[i] |= ((BM_HRL_WORD) 1) << bitNo;
+		}
+	}
+}
+
+/*
+ * Compress 'nwords' uncompressed words into 'bch', turning runs of all
+ * zero or all one words into fill words.
+ */
+static void
+encode_words(const BM_HRL_WORD *words, int nwords, BMBatchWords *bch)
+{
+	int			i = 0;
+
+	_bitmap_reset_batchwords(bch);
+	bch->nwordsread = 0;
+	bch->nextread = 1;
+	bch->firstTid = 0;
+
+	while (i < nwords)
+	{
+		if (words[i] == LITERAL_ALL_ZERO || words[i] == LITERAL_ALL_ONE)
+		{
+			int			len = 1;
+
+			while (i + len < nwords && words[i + len] == words[i])
+				len++;
+			bch->hwords[bch->nwords / BM_HRL_WORD_SIZE] |=
+				WORDNO_GET_HEADER_BIT(bch->nwords);
+			bch->cwords[bch->nwords++] =
+				BM_MAKE_FILL_WORD((words[i] == LITERAL_ALL_ONE), len);
+			i += len;
+		}
+		else
+			bch->cwords[bch->nwords++] = words[i++];
+	}
+}
+
+/* The reverse of encode_words(), returns the number of words decoded. */
+static int
+decode_words(BMBatchWords *bch, BM_HRL_WORD *words)
+{
+	int			n = 0;
+	uint32		i;
+
+	for (i = bch->startNo; i < bch->startNo + bch->nwords; i++)
+	{
+		BM_HRL_WORD w = bch->cwords[i];
+
+		if (IS_FILL_WORD(bch->hwords, i))
+		{
+			BM_HRL_WORD len;
+
+			for (len = FILL_LENGTH(w); len > 0; len--)
+				words[n++] = GET_FILL_BIT(w) ? LITERAL_ALL_ONE : LITERAL_ALL_ZERO;
+		}
+		else
+			words[n++] = w;
+	}
+	return n;
+}
+
+/* The tids of the set bits in 'words', the first one being tid 1. */
+static int
+words_to_tids(const BM_HRL_WORD *words, int nwords, uint64 *tids)
+{
+	int			ntids = 0;
+	int			i;
+	int			bitNo;
+
+	for (i = 0; i < nwords; i++)
+		for (bitNo = 0; bitNo < BM_HRL_WORD_SIZE; bitNo++)
+			if (words[i] & (((BM_HRL_WORD) 1) << bitNo))
+				tids[ntids++] = (uint64) i * BM_HRL_WORD_SIZE + bitNo + 1;
+	return ntids;
+}
+
+/* Collect all the tids of 'bch' with _bitmap_findnexttids(). */
+static int
+iterate_tids(BMBatchWords *bch, BMIterateResult *result, uint32 maxTids,
+			 uint64 *tids)
+{
+	int			ntids = 0;
+
+	_bitmap_begin_iterate(bch, result);
+	while (bch->nwords > 0)
+	{
+		_bitmap_findnexttids(bch, result, maxTids);
+		memcpy(&tids[ntids], result->nextTids,
+			   result->numOfTids * sizeof(uint64));
+		ntids += result->numOfTids;
+	}
+	return ntids;
+}
+
+static BMBatchWords *
+make_batch(void)
+{
+	BMBatchWords *bch = palloc0(sizeof(BMBatchWords));
+
+	_bitmap_init_batchwords(bch, NWORDS, CurrentMemoryContext);
+	return bch;
+}
+
+static void
+test__bm_or_words__MatchScalar(void **state)
+{
+	BM_HRL_WORD src[40];
+	BM_HRL_WORD dst[40];
+	BM_HRL_WORD expected[40];
+	uint32		n;
+	uint32		offs;
+
+	make_words(&shapes[2], src, lengthof(src));
+
+	for (offs = 0; offs < 3; offs++)
+	{
+		for (n = 0; n + offs <= lengthof(src); n++)
+		{
+			make_words(&shapes[1], dst, lengthof(dst));
+			memcpy(expected, dst, sizeof(dst));
+
+			bm_or_words_scalar(expected + offs, src + offs, n);
+			bm_or_words(dst + offs, src + offs, n);
+			assert_memory_equal(dst, expected, sizeof(dst));
+		}
+	}
+}
+
+static void
+test___bitmap_find_bitset(void **state)
+{
+	BM_HRL_WORD words[100];
+	int			i;
+	int			lastPos;
+
+	make_words(&shapes[1], words, lengthof(words));
+	words[0] = 0;
+	words[1] = LITERAL_ALL_ONE;
+	words[2] = ((BM_HRL_WORD) 1) << BM_HRL_WORD_LEFTMOST;
+
+	for (i = 0; i < lengthof(words); i++)
+	{
+		for (lastPos = 0; lastPos <= BM_HRL_WORD_SIZE; lastPos++)
+		{
+			int			expected = 0;
+			int			pos;
+
+			for (pos = lastPos + 1; pos <= BM_HRL_WORD_SIZE; pos++)
+			{
+				if (words[i] & (((BM_HRL_WORD) 1) << (pos - 1)))
+				{
+					expected = pos;
+					break;
+				}
+			}
+			assert_int_equal(_bitmap_find_bitset(words[i], lastPos), expected);
+		}
+	}
+}
+
+static void
+test___bitmap_findnexttids(void **state)
+{
+	BM_HRL_WORD *words = palloc(NWORDS * sizeof(BM_HRL_WORD));
+	uint64	   *expected = palloc(NWORDS * BM_HRL_WORD_SIZE * sizeof(uint64));
+	uint64	   *tids = palloc(NWORDS * BM_HRL_WORD_SIZE * sizeof(uint64));
+	BMIterateResult *result = palloc0(sizeof(BMIterateResult));
+	BMBatchWords *bch = make_batch();
+	uint32		maxTids[] = {100, 1000, BM_BATCH_TIDS};
+	int			i;
+	int			j;
+
+	for (i = 0; i < lengthof(shapes); i++)
+	{
+		int			nexpected;
+
+		make_words(&shapes[i], words, NWORDS);
+		nexpected = words_to_tids(words, NWORDS, expected);
+
+		for (j = 0; j < lengthof(maxTids); j++)
+		{
+			encode_words(words, NWORDS, bch);
+			assert_int_equal(iterate_tids(bch, result, maxTids[j], tids),
+							 nexpected);
+			assert_memory_equal(tids, expected, nexpected * sizeof(uint64));
+		}
+	}
+}
+
+static void
+test___bitmap_union(void **state)
+{
+	BM_HRL_WORD *words[3];
+	BM_HRL_WORD *expected = palloc0(NWORDS * sizeof(BM_HRL_WORD));
+	BM_HRL_WORD *unioned = palloc(NWORDS * sizeof(BM_HRL_WORD));
+	BMBatchWords *batches[3];
+	BMBatchWords *result = make_batch();
+	int			i;
+	int			j;
+	int			k;
+
+	for (j = 0; j < lengthof(batches); j++)
+	{
+		words[j] = palloc(NWORDS * sizeof(BM_HRL_WORD));
+		batches[j] = make_batch();
+	}
+
+	/* every combination of shapes, and both OR kernels */
+	for (i = 0; i < lengthof(shapes) * lengthof(shapes) * 2; i++)
+	{
+		bm_or_words = (i % 2) ? bm_or_words_choose : bm_or_words_scalar;
+
+		make_words(&shapes[i / 2 % lengthof(shapes)], words[0], NWORDS);
+		make_words(&shapes[i / 2 / lengthof(shapes)], words[1], NWORDS);
+		make_words(&shapes[(i / 2 + 2) % lengthof(shapes)], words[2], NWORDS);
+
+		memset(expected, 0, NWORDS * sizeof(BM_HRL_WORD));
+		for (j = 0; j < lengthof(batches); j++)
+		{
+			encode_words(words[j], NWORDS, batches[j]);
+			for (k = 0; k < NWORDS; k++)
+				expected[k] |= words[j][k];
+		}
+
+		_bitmap_reset_batchwords(result);
+		_bitmap_union(batches, lengthof(batches), result);
+
+		assert_int_equal(decode_words(result, unioned), NWORDS);
+		assert_memory_equal(unioned, expected, NWORDS * sizeof(BM_HRL_WORD));
+	}
+}
+
+/*
+ * Time _bitmap_union() of three bitmaps, and _bitmap_findnexttids() over
+ * the result, for each bitmap shape.
+ */
+static void
+run_benchmark(int loops)
+{
+	BM_HRL_WORD *words = palloc(NWORDS * sizeof(BM_HRL_WORD));
+	BMBatchWords *encoded[3];
+	BMBatchWords *batches[3];
+	BMBatchWords *result = make_batch();
+	BMIterateResult *iter = palloc0(sizeof(BMIterateResult));
+	int			i;
+	int			j;
+	int			loop;
+
+	for (j = 0; j < lengthof(batches); j++)
+	{
+		encoded[j] = make_batch();
+		batches[j] = make_batch();
+	}
+
+	printf("%-8s %14s %14s %14s\n",
+		   "shape", "union_scalar", "union", "findnexttids");
+
+	for (i = 0; i < lengthof(shapes); i++)
+	{
+		double		elapsed[3];
+		int			kernel;
+
+		for (j = 0; j < lengthof(encoded); j++)
+		{
+			make_words(&shapes[i], words, NWORDS);
+			encode_words(words, NWORDS, encoded[j]);
+		}
+
+		for (kernel = 0; kernel < 2; kernel++)
+		{
+			instr_time	start;
+			instr_time	end;
+			instr_time	unionTime;
+			instr_time	iterTime;
+
+			bm_or_words = kernel ? bm_or_words_choose : bm_or_words_scalar;
+			INSTR_TIME_SET_ZERO(unionTime);
+			INSTR_TIME_SET_ZERO(iterTime);
+
+			for (loop = 0; loop < loops; loop++)
+			{
+				for (j = 0; j < lengthof(batches); j++)
+					_bitmap_copy_batchwords(encoded[j], batches[j]);
+				_bitmap_reset_batchwords(result);
+
+				INSTR_TIME_SET_CURRENT(start);
+				_bitmap_union(batches, lengthof(batches), result);
+				INSTR_TIME_SET_CURRENT(end);
+				INSTR_TIME_ACCUM_DIFF(unionTime, end, start);
+
+				INSTR_TIME_SET_CURRENT(start);
+				_bitmap_begin_iterate(result, iter);
+				while (result->nwords > 0)
+					_bitmap_findnexttids(result, iter, BM_BATCH_TIDS);
+				INSTR_TIME_SET_CURRENT(end);
+				INSTR_TIME_ACCUM_DIFF(iterTime, end, start);
+			}
+
+			elapsed[kernel] = INSTR_TIME_GET_MILLISEC(unionTime) / loops;
+			elapsed[2] = INSTR_TIME_GET_MILLISEC(iterTime) / loops;
+		}
+
+		printf("%-8s %11.3f ms %11.3f ms %11.3f ms\n",
+			   shapes[i].name, elapsed[0], elapsed[1], elapsed[2]);
+	}
+}
+
+int
+main(int argc, char *argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const		UnitTest tests[] = {
+		unit_test(test__bm_or_words__MatchScalar),
+		unit_test(test___bitmap_find_bitset),
+		unit_test(test___bitmap_findnexttids),
+		unit_test(test___bitmap_union)
+	};
+
+	MemoryContextInit();
+
+	/* "bitmaputil.t --bench [loops]" times the scan code instead */
+	if (argc > 1 && strcmp(argv[1], "--bench") == 0)
+	{
+		run_benchmark(argc > 2 ? atoi(argv[2]) : 100);
+		return 0;
+	}
+
+	return run_tests(tests);
+}
@@ -51,21 +51,8 @@ hashint4(PG_FUNCTION_ARGS)
 Datum
 hashint8(PG_FUNCTION_ARGS)
 {
-	/*
-	 * The idea here is to produce a hash value compatible with the values
-	 * produced by hashint4 and hashint2 for logically equal inputs; this is
-	 * necessary to support cross-type hash joins across these input types.
-	 * Since all three types are signed, we can xor the high half of the int8
-	 * value if the sign is positive, or the complement of the high half when
-	 * the sign is negative.
-	 */
-	int64		val = PG_GETARG_INT64(0);
-	uint32		lohalf = (uint32) val;
-	uint32		hihalf = (uint32) (val >> 32);
-
-	lohalf ^= (val >= 0) ? hihalf : ~hihalf;
-
-	return hash_uint32(lohalf);
+	/* See hash_int8_inline() */
+	return UInt32GetDatum(hash_int8_inline(PG_GETARG_INT64(0)));
 }
 
 Datum
@@ -529,15 +516,5 @@ hash_any(register const unsigned char *k, register int keylen)
 Datum
 hash_uint32(uint32 k)
 {
-	register uint32 a,
-				b,
-				c;
-
-	a = b = c = 0x9e3779b9 + (uint32) sizeof(uint32) + 3923095;
-	a += k;
-
-	final(a, b, c);
-
-	/* report the result */
-	return UInt32GetDatum(c);
+	return UInt32GetDatum(hash_uint32_inline(k));
 }
@@ -837,6 +837,40 @@ CREATE VIEW gp_stat_replication AS
          ON G.gp_segment_id = R.gp_segment_id
     );
 
+-- Flow control state (window, RTT), compression and transport of recently
+-- closed UDP interconnect connections, on the master and on all the segments.
+CREATE FUNCTION gp_get_segment_interconnect_conn_stats() RETURNS SETOF RECORD AS
+$$
+    SELECT * FROM pg_catalog.gp_get_interconnect_conn_stats()
+$$
+LANGUAGE SQL EXECUTE ON ALL SEGMENTS;
+
+CREATE VIEW gp_interconnect_conn_stats AS
+    SELECT * FROM pg_catalog.gp_get_interconnect_conn_stats()
+    UNION ALL
+    SELECT * FROM pg_catalog.gp_get_segment_interconnect_conn_stats() AS S
+    (gp_segment_id integer, pid integer, sess_id integer, ic_id integer,
+     motion_id integer, dst_segment_id integer, fc_method text,
+     cwnd float8, srtt bigint, min_rtt bigint, bandwidth float8,
+     packets_sent bigint, retransmits bigint, packets_compressed bigint,
+     bytes_saved bigint, transport text, end_time timestamptz);
+
+-- Packets sent and datagrams received per syscall by the backends of recently
+-- torn down UDP interconnects, on the master and on all the segments.
+CREATE FUNCTION gp_get_segment_interconnect_syscall_stats() RETURNS SETOF RECORD AS
+$$
+    SELECT * FROM pg_catalog.gp_get_interconnect_syscall_stats()
+$$
+LANGUAGE SQL EXECUTE ON ALL SEGMENTS;
+
+CREATE VIEW gp_interconnect_syscall_stats AS
+    SELECT * FROM pg_catalog.gp_get_interconnect_syscall_stats()
+    UNION ALL
+    SELECT * FROM pg_catalog.gp_get_segment_interconnect_syscall_stats() AS S
+    (gp_segment_id integer, pid integer, sess_id integer, ic_id integer,
+     packets_sent bigint, send_calls bigint, datagrams_received bigint,
+     receive_calls bigint, end_time timestamptz);
+
 CREATE VIEW pg_stat_wal_receiver AS
     SELECT
             s.pid,
@@ -1411,6 +1445,17 @@ CREATE VIEW pg_stat_progress_vacuum AS
     FROM pg_stat_get_progress_info('VACUUM') AS S
 		 JOIN pg_database D ON S.datid = D.oid;
 
+CREATE VIEW pg_stat_progress_ao_compaction AS
+	SELECT
+		S.pid AS pid, S.datid AS datid, D.datname AS datname,
+		S.relid AS relid,
+		S.param1 AS segno, S.param2 AS insert_segno,
+		S.param3 AS segfiles_processed,
+		S.param4 AS tuples_total, S.param5 AS tuples_scanned,
+		S.param6 AS tuples_moved, S.param7 AS blocks_copied
+    FROM pg_stat_get_progress_info('AO_COMPACTION') AS S
+		 JOIN pg_database D ON S.datid = D.oid;
+
 CREATE VIEW pg_user_mappings AS
     SELECT
         U.oid       AS umid,
@@ -305,6 +305,10 @@ AppendOnlyStorageRead_FinishOpenFile(AppendOnlyStorageRead *storageRead,
 
 	storageRead->logicalEof = logicalEof;
 
+	/* pick up gp_appendonly_prefetch_size changes between segment files */
+	BufferedReadSetPrefetch(&storageRead->bufferedRead,
+							gp_appendonly_prefetch_size * 1024);
+
 	BufferedReadSetFile(
 						&storageRead->bufferedRead,
 						storageRead->file,
@@ -799,6 +803,7 @@ AppendOnlyStorageRead_ReadNextBlock(AppendOnlyStorageRead *storageRead)
 /*	storageRead->current.isLarge = false; */
 /*	storageRead->current.isCompressed = false; */
 /*	storageRead->current.compressedLen = 0; */
+/*	storageRead->current.blockBuffer = NULL; */
 
 	elogif(Debug_appendonly_print_datumstream, LOG,
 		   "before AppendOnlyStorageRead_PositionToNextBlock, storageRead->current.headerOffsetInFile is" INT64_FORMAT "storageRead->current.overallBlockLen is %d",
@@ -1140,6 +1145,17 @@ AppendOnlyStorageRead_InternalGetBuffer(AppendOnlyStorageRead *storageRead,
 		   storageRead->current.headerKind == AoHeaderKind_NonBulkDenseContent ||
 		   storageRead->current.headerKind == AoHeaderKind_BulkDenseContent);
 
+	/*
+	 * The block may already have been fetched, e.g. when VACUUM copies it
+	 * verbatim and then still decodes it to build index entries.
+	 */
+	if (storageRead->current.blockBuffer != NULL)
+	{
+		*header = storageRead->current.blockBuffer;
+		*content = &((*header)[storageRead->current.contentOffset]);
+		return;
+	}
+
 	/*
 	 * Grow the buffer to the full block length to avoid any unnecessary
 	 * copying by BufferedRead.
@@ -1182,6 +1198,7 @@ AppendOnlyStorageRead_InternalGetBuffer(AppendOnlyStorageRead *storageRead,
 					 errcontext_appendonly_read_storage_block(storageRead)));
 	}
 
+	storageRead->current.blockBuffer = *header;
 	*content = &((*header)[storageRead->current.contentOffset]);
 }
 
@@ -1219,6 +1236,38 @@ AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead)
 	return content;
 }
 
+/*
+ * Get a pointer to the content of the current *small* block as it is
+ * stored, without decompressing it.
+ *
+ * *storedLen is set to the compressed length, or to the content length when
+ * the block is not compressed.  Used by VACUUM to copy a block verbatim into
+ * another segment file.
+ */
+uint8 *
+AppendOnlyStorageRead_GetStoredContent(AppendOnlyStorageRead *storageRead,
+									   int32 *storedLen)
+{
+	uint8	   *header;
+	uint8	   *content;
+
+	Assert(storageRead != NULL);
+	Assert(storageRead->isActive);
+	Assert(storageRead->current.headerKind == AoHeaderKind_SmallContent);
+	Assert(!storageRead->current.isLarge);
+
+	AppendOnlyStorageRead_InternalGetBuffer(storageRead,
+											&header,
+											&content);
+
+	if (storageRead->current.isCompressed)
+		*storedLen = storageRead->current.compressedLen;
+	else
+		*storedLen = storageRead->current.uncompressedLen;
+
+	return content;
+}
+
 /*
  * Copy the large and/or decompressed content out.
  *
@@ -1735,6 +1735,114 @@ AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 	Assert(storageWrite->currentCompleteHeaderLen == 0);
 }
 
+/*
+ * Write a small content block whose content was taken, as stored, from
+ * another segment file of the same relation.
+ *
+ * The content is not decompressed or recompressed; only a new header is
+ * made, so that the block gets the first row number set with
+ * ~_SetFirstRowNum and a fresh checksum.  The caller must make sure the
+ * source block was written with the same format version and storage
+ * attributes as this segment file.
+ *
+ * storedContent	- the content as stored in the source block.
+ * storedLen		- byte length of storedContent.
+ * contentLen		- the uncompressed byte length of the content.
+ * isCompressed		- true if storedContent is compressed.
+ */
+void
+AppendOnlyStorageWrite_CopyStoredContent(AppendOnlyStorageWrite *storageWrite,
+										 uint8 *storedContent,
+										 int32 storedLen,
+										 int32 contentLen,
+										 bool isCompressed,
+										 int executorBlockKind,
+										 int rowCount)
+{
+	uint8	   *header;
+	uint8	   *data;
+	int32		dataRoundedUpLen;
+	int32		bufferLen;
+
+	Assert(storageWrite != NULL);
+	Assert(storageWrite->isActive);
+	Assert(!AppendOnlyStorageWrite_IsBufferAllocated(storageWrite));
+	Assert(isCompressed || storedLen == contentLen);
+
+	storageWrite->getBufferAoHeaderKind = AoHeaderKind_SmallContent;
+	storageWrite->currentCompleteHeaderLen =
+		AppendOnlyStorageWrite_CompleteHeaderLen(storageWrite,
+												 AoHeaderKind_SmallContent);
+
+	if (storedLen >
+		storageWrite->maxBufferLen - storageWrite->currentCompleteHeaderLen)
+		elog(ERROR,
+			 "Append-only copied content too large AO storage block (table '%s', "
+			 "stored length = %d, maximum buffer length %d, complete header length %d)",
+			 storageWrite->relationName,
+			 storedLen,
+			 storageWrite->maxBufferLen,
+			 storageWrite->currentCompleteHeaderLen);
+
+	storageWrite->logicalBlockStartOffset =
+		BufferedAppendNextBufferPosition(&(storageWrite->bufferedAppend));
+
+	header = BufferedAppendGetMaxBuffer(&storageWrite->bufferedAppend);
+	if (header == NULL)
+		ereport(ERROR,
+				(errcode(ERRCODE_INTERNAL_ERROR),
+				 errmsg("We do not expect files to be have a maximum length"),
+				 errcontext_appendonly_write_storage_block(storageWrite)));
+
+	data = &header[storageWrite->currentCompleteHeaderLen];
+	memcpy(data, storedContent, storedLen);
+
+	dataRoundedUpLen = AOStorage_RoundUp(storedLen, storageWrite->formatVersion);
+	AOStorage_ZeroPad(data, storedLen, dataRoundedUpLen);
+
+	/* Make the header and compute the checksum if necessary. */
+	AppendOnlyStorageFormat_MakeSmallContentHeader(header,
+												   storageWrite->storageAttributes.checksum,
+												   storageWrite->isFirstRowNumSet,
+												   storageWrite->formatVersion,
+												   storageWrite->firstRowNum,
+												   executorBlockKind,
+												   rowCount,
+												   contentLen,
+												   (isCompressed ? storedLen : 0));
+
+	if (Debug_appendonly_print_storage_headers)
+	{
+		AppendOnlyStorageWrite_LogBlockHeader(storageWrite,
+											  BufferedAppendCurrentBufferPosition(&storageWrite->bufferedAppend),
+											  header);
+	}
+
+	bufferLen = storageWrite->currentCompleteHeaderLen + dataRoundedUpLen;
+
+	BufferedAppendFinishBuffer(&storageWrite->bufferedAppend,
+							   bufferLen,
+							   (storageWrite->currentCompleteHeaderLen +
+								AOStorage_RoundUp(contentLen, storageWrite->formatVersion) /* non-compressed size */ ),
+							   storageWrite->needsWAL);
+
+	elogif(Debug_appendonly_print_insert, LOG,
+		   "Append-only insert copied block for table '%s' "
+		   "(segment file '%s', stored length = %d, content length %d, item count %d, block count "
+		   INT64_FORMAT ")",
+		   storageWrite->relationName,
+		   storageWrite->segmentFileName,
+		   storedLen,
+		   contentLen,
+		   rowCount,
+		   storageWrite->bufferCount);
+
+	/* Declare it finished. */
+	storageWrite->currentCompleteHeaderLen = 0;
+	storageWrite->currentBuffer = NULL;
+	storageWrite->isFirstRowNumSet = false;
+}
+
 /*----------------------------------------------------------------
  * Optional: Set First Row Number
  *----------------------------------------------------------------
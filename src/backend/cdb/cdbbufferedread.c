@@ -22,6 +22,8 @@
 
 static void BufferedReadIo(
 			   BufferedRead *bufferedRead);
+static void BufferedReadPrefetch(
+					 BufferedRead *bufferedRead);
 static uint8 *BufferedReadUseBeforeBuffer(
 							BufferedRead *bufferedRead,
 							int32 maxReadAheadLen,
@@ -106,6 +108,40 @@ BufferedReadInit(
 	 */
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
+
+	/*
+	 * Read-ahead, off until the caller sets a window.
+	 */
+	bufferedRead->prefetchLen = 0;
+	bufferedRead->prefetchPosition = 0;
+	bufferedRead->stats = NULL;
+}
+
+/*
+ * Set the read-ahead window of BufferedRead.  Zero turns read-ahead off.
+ */
+void
+BufferedReadSetPrefetch(
+						BufferedRead *bufferedRead,
+						int32 prefetchLen)
+{
+	Assert(bufferedRead != NULL);
+	Assert(prefetchLen >= 0);
+
+	bufferedRead->prefetchLen = prefetchLen;
+}
+
+/*
+ * Count the i/o of BufferedRead in stats, which may be NULL.
+ */
+void
+BufferedReadSetStats(
+					 BufferedRead *bufferedRead,
+					 BufferedReadStats *stats)
+{
+	Assert(bufferedRead != NULL);
+
+	bufferedRead->stats = stats;
 }
 
 /*
@@ -139,6 +175,8 @@ BufferedReadSetFile(
 	bufferedRead->haveTemporaryLimitInEffect = false;
 	bufferedRead->temporaryLimitFileLen = 0;
 
+	bufferedRead->prefetchPosition = 0;
+
 	if (fileLen > 0)
 	{
 		/*
@@ -162,6 +200,7 @@ BufferedReadIo(
 	int32		largeReadLen;
 	uint8	   *largeReadMemory;
 	int32		offset;
+	instr_time	startTime;
 
 	largeReadLen = bufferedRead->largeReadLen;
 	Assert(bufferedRead->largeReadLen > 0);
@@ -190,6 +229,9 @@ BufferedReadIo(
 	}
 #endif
 
+	if (bufferedRead->stats != NULL)
+		INSTR_TIME_SET_CURRENT(startTime);
+
 	offset = 0;
 	while (largeReadLen > 0)
 	{
@@ -237,8 +279,78 @@ BufferedReadIo(
 		offset += actualLen;
 	}
 
+	if (bufferedRead->stats != NULL)
+	{
+		instr_time	endTime;
+
+		INSTR_TIME_SET_CURRENT(endTime);
+		INSTR_TIME_ACCUM_DIFF(bufferedRead->stats->stallTime, endTime, startTime);
+		bufferedRead->stats->reads++;
+		bufferedRead->stats->readBytes += bufferedRead->largeReadLen;
+	}
+
 	if (VacuumCostActive)
 		VacuumCostBalance += VacuumCostPageMiss;
+
+	BufferedReadPrefetch(bufferedRead);
+}
+
+/*
+ * Ask the kernel to read ahead the part of the file that follows the current
+ * large read, so that it is in memory by the time we get to it.
+ *
+ * The window is only refilled once less than half of it is left ahead of the
+ * current read, to keep the number of requests down.  A position outside of
+ * the window means we have seeked (e.g. for a temporary range), and the
+ * window starts over from the current read.
+ */
+static void
+BufferedReadPrefetch(
+					 BufferedRead *bufferedRead)
+{
+#ifdef USE_PREFETCH
+	int64		inEffectFileLen;
+	int64		largeReadAfterPos;
+	int64		prefetchAfterPos;
+
+	if (bufferedRead->prefetchLen <= 0)
+		return;
+
+	if (bufferedRead->haveTemporaryLimitInEffect)
+		inEffectFileLen = bufferedRead->temporaryLimitFileLen;
+	else
+		inEffectFileLen = bufferedRead->fileLen;
+
+	largeReadAfterPos = bufferedRead->largeReadPosition +
+		bufferedRead->largeReadLen;
+
+	if (bufferedRead->prefetchPosition < largeReadAfterPos ||
+		bufferedRead->prefetchPosition > largeReadAfterPos + bufferedRead->prefetchLen)
+		bufferedRead->prefetchPosition = largeReadAfterPos;
+	else if (bufferedRead->prefetchPosition - largeReadAfterPos >
+			 bufferedRead->prefetchLen / 2)
+		return;
+
+	prefetchAfterPos = largeReadAfterPos + bufferedRead->prefetchLen;
+	if (prefetchAfterPos > inEffectFileLen)
+		prefetchAfterPos = inEffectFileLen;
+	if (prefetchAfterPos <= bufferedRead->prefetchPosition)
+		return;
+
+	/* A failed request only costs us the read-ahead, so ignore errors */
+	(void) FilePrefetch(bufferedRead->file,
+						bufferedRead->prefetchPosition,
+						(int) (prefetchAfterPos - bufferedRead->prefetchPosition));
+
+	if (bufferedRead->stats != NULL)
+	{
+		bufferedRead->stats->prefetches++;
+		bufferedRead->stats->prefetchBytes +=
+			prefetchAfterPos - bufferedRead->prefetchPosition;
+	}
+
+	bufferedRead->prefetchPosition = prefetchAfterPos;
+#endif
 }
 
 static uint8 *
@@ -440,6 +552,10 @@ BufferedReadSetTemporaryRange(
 
 		bufferedRead->largeReadPosition = beginFileOffset;
 
+		/* Set the limit first, so that read-ahead stays within the range */
+		bufferedRead->haveTemporaryLimitInEffect = true;
+		bufferedRead->temporaryLimitFileLen = afterFileOffset;
+
 		if (bufferedRead->largeReadLen > 0)
 			BufferedReadIo(bufferedRead);
 	}
@@ -675,6 +791,8 @@ BufferedReadCompleteFile(
 
 	bufferedRead->largeReadPosition = 0;
 	bufferedRead->largeReadLen = 0;
+
+	bufferedRead->prefetchPosition = 0;
 }
 
 
@@ -52,6 +52,8 @@ bool gp_use_legacy_hashops = false;
 /* local function declarations */
 static int	ispowof2(int numsegs);
 static inline int32 jump_consistent_hash(uint64 key, int32 num_segments);
+static CdbHashFnKind cdbhash_fnkind_for_func(Oid funcid);
+static inline uint32 cdbhash_datum(CdbHash *h, int attidx, Datum datum);
 
 /*================================================================
  *
@@ -93,6 +95,7 @@ makeCdbHash(int numsegs, int natts, Oid *hashfuncs)
 
 	/* Load hash function info */
 	h->hashfuncs = (FmgrInfo *) palloc(natts * sizeof(FmgrInfo));
+	h->fnkinds = (CdbHashFnKind *) palloc(natts * sizeof(CdbHashFnKind));
 	for (i = 0; i < natts; i++)
 	{
 		Oid			funcid = hashfuncs[i];
@@ -101,6 +104,7 @@ makeCdbHash(int numsegs, int natts, Oid *hashfuncs)
 			is_legacy_hash = true;
 
 		fmgr_info(funcid, &h->hashfuncs[i]);
+		h->fnkinds[i] = cdbhash_fnkind_for_func(funcid);
 	}
 	h->natts = natts;
 	h->is_legacy_hash = is_legacy_hash;
@@ -180,25 +184,7 @@ cdbhash(CdbHash *h, int attno, Datum datum, bool isnull)
 		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
 
 		if (!isnull)
-		{
-			FunctionCallInfoData fcinfo;
-			uint32		hkey;
-
-			InitFunctionCallInfoData(fcinfo, &h->hashfuncs[attno - 1], 1,
-									 InvalidOid,
-									 NULL, NULL);
-
-			fcinfo.arg[0] = datum;
-			fcinfo.argnull[0] = false;
-
-			hkey = DatumGetUInt32(FunctionCallInvoke(&fcinfo));
-
-			/* Check for null result, since caller is clearly not expecting one */
-			if (fcinfo.isnull)
-				elog(ERROR, "function %u returned NULL", fcinfo.flinfo->fn_oid);
-
-			hashkey ^= hkey;
-		}
+			hashkey ^= cdbhash_datum(h, attno - 1, datum);
 	}
 	else
 	{
@@ -290,6 +276,69 @@ cdbhashrandomseg(int numsegs)
 	return random() % numsegs;
 }
 
+/*
+ * Hash one non-NULL attribute value, inline for the common fixed-width hash
+ * functions, or through fmgr otherwise.
+ */
+static inline uint32
+cdbhash_datum(CdbHash *h, int attidx, Datum datum)
+{
+	FunctionCallInfoData fcinfo;
+	uint32		hkey;
+
+	switch (h->fnkinds[attidx])
+	{
+		case CDBHASH_FN_INT2:
+			return hash_uint32_inline((uint32) (int32) DatumGetInt16(datum));
+		case CDBHASH_FN_INT4:
+			return hash_uint32_inline((uint32) DatumGetInt32(datum));
+		case CDBHASH_FN_INT8:
+			return hash_int8_inline(DatumGetInt64(datum));
+		case CDBHASH_FN_OID:
+			return hash_uint32_inline((uint32) DatumGetObjectId(datum));
+		case CDBHASH_FN_GENERIC:
+			break;
+	}
+
+	InitFunctionCallInfoData(fcinfo, &h->hashfuncs[attidx], 1,
+							 InvalidOid,
+							 NULL, NULL);
+
+	fcinfo.arg[0] = datum;
+	fcinfo.argnull[0] = false;
+
+	hkey = DatumGetUInt32(FunctionCallInvoke(&fcinfo));
+
+	/* Check for null result, since caller is clearly not expecting one */
+	if (fcinfo.isnull)
+		elog(ERROR, "function %u returned NULL", fcinfo.flinfo->fn_oid);
+
+	return hkey;
+}
+
+/*
+ * Which inline kernel, if any, computes the same value as the given hash
+ * support function.
+ */
+static CdbHashFnKind
+cdbhash_fnkind_for_func(Oid funcid)
+{
+	switch (funcid)
+	{
+		case F_HASHINT2:
+			return CDBHASH_FN_INT2;
+		case F_HASHINT4:
+			return CDBHASH_FN_INT4;
+		case F_HASHINT8:
+			return CDBHASH_FN_INT8;
+		case F_HASHOID:
+		case F_HASHENUM:
+			return CDBHASH_FN_OID;
+		default:
+			return CDBHASH_FN_GENERIC;
+	}
+}
+
 
 /*================================================================
  *
@@ -15,8 +15,14 @@
 
 #include "postgres.h"
 
+#include "access/hash.h"
+#include "access/htup_details.h"
 #include "cdb/cdbsrlz.h"
+#include "cdb/cdbvars.h"
+#include "funcapi.h"
+#include "lib/ilist.h"
 #include "nodes/nodes.h"
+#include "utils/builtins.h"
 #include "utils/memutils.h"
 
 #ifdef HAVE_LIBZSTD
@@ -30,8 +36,31 @@ static char *uncompress_string(const char *src, int size, int *uncompressed_size
 /* zstandard compression level to use. */
 #define COMPRESS_LEVEL 3
 
+/*
+ * A node serialized by serializeNodeCached(), and its compressed form.
+ */
+typedef struct SerializedNodeCacheEntry
+{
+	dlist_node	node;			/* most recently used first */
+	uint32		hash;			/* of the uncompressed form */
+	int			uncompressed_size;
+	char	   *uncompressed;
+	int			compressed_size;
+	char	   *compressed;
+	Size		size;			/* memory used by the entry */
+} SerializedNodeCacheEntry;
+
+static dlist_head serialized_node_cache = DLIST_STATIC_INIT(serialized_node_cache);
+static MemoryContext SerializedNodeCacheContext = NULL;
+static Size serialized_node_cache_used = 0;
+
 #endif			/* HAVE_LIBZSTD */
 
+/* counters reported by gp_serialized_plan_cache_stats() */
+static uint64 serialized_node_cache_hits = 0;
+static uint64 serialized_node_cache_misses = 0;
+static uint64 serialized_node_cache_evictions = 0;
+
 /*
  * This is used by dispatcher to serialize Plan and Query Trees for
  * dispatching to qExecs.
@@ -64,6 +93,159 @@ serializeNode(Node *node, int *size, int *uncompressed_size_out)
 	return sNode;
 }
 
+/*
+ * Like serializeNode(), for nodes that are serialized again and again
+ * unchanged, like the plan of a prepared statement dispatched for every
+ * execution.  Other nodes should use serializeNode(): they would only
+ * cost a copy in the cache, and push out the nodes that are worth keeping.
+ *
+ * We still have to serialize the node to find out whether it changed, but
+ * the compression, which takes most of the time, is only done the first
+ * time.  The cache is keyed by the serialized node itself rather than by the
+ * plan it came from, because the executor fills in some fields of a cached
+ * plan, like the memory of each operator, before dispatching it.
+ */
+char *
+serializeNodeCached(Node *node, int *size, int *uncompressed_size_out)
+{
+#ifdef HAVE_LIBZSTD
+	Size		limit = (Size) gp_serialized_plan_cache_size * 1024L;
+	SerializedNodeCacheEntry *entry;
+	dlist_iter	iter;
+	char	   *pszNode;
+	char	   *sNode;
+	int			uncompressed_size;
+	uint32		hash;
+
+	if (limit == 0)
+	{
+		/* drop what's left from when the cache was enabled */
+		if (SerializedNodeCacheContext)
+		{
+			MemoryContextDelete(SerializedNodeCacheContext);
+			SerializedNodeCacheContext = NULL;
+			dlist_init(&serialized_node_cache);
+			serialized_node_cache_used = 0;
+		}
+		return serializeNode(node, size, uncompressed_size_out);
+	}
+
+	Assert(node != NULL);
+	Assert(size != NULL);
+
+	pszNode = nodeToBinaryStringFast(node, &uncompressed_size);
+	Assert(pszNode != NULL);
+
+	if (NULL != uncompressed_size_out)
+		*uncompressed_size_out = uncompressed_size;
+
+	hash = DatumGetUInt32(hash_any((const unsigned char *) pszNode,
+								   uncompressed_size));
+
+	dlist_foreach(iter, &serialized_node_cache)
+	{
+		entry = dlist_container(SerializedNodeCacheEntry, node, iter.cur);
+
+		if (entry->hash != hash ||
+			entry->uncompressed_size != uncompressed_size ||
+			memcmp(entry->uncompressed, pszNode, uncompressed_size) != 0)
+			continue;
+
+		dlist_move_head(&serialized_node_cache, &entry->node);
+		serialized_node_cache_hits++;
+		pfree(pszNode);
+
+		sNode = palloc(entry->compressed_size);
+		memcpy(sNode, entry->compressed, entry->compressed_size);
+		*size = entry->compressed_size;
+		return sNode;
+	}
+
+	serialized_node_cache_misses++;
+	sNode = compress_string(pszNode, uncompressed_size, size);
+
+	/* Remember it, dropping the least recently used entries to make room */
+	if (sizeof(SerializedNodeCacheEntry) + uncompressed_size + *size <= limit)
+	{
+		if (!SerializedNodeCacheContext)
+			SerializedNodeCacheContext =
+				AllocSetContextCreate(TopMemoryContext,
+									  "Serialized plan cache",
+									  ALLOCSET_DEFAULT_SIZES);
+
+		entry = MemoryContextAlloc(SerializedNodeCacheContext,
+								   sizeof(SerializedNodeCacheEntry));
+		entry->hash = hash;
+		entry->uncompressed_size = uncompressed_size;
+		entry->uncompressed = MemoryContextAlloc(SerializedNodeCacheContext,
+												 uncompressed_size);
+		memcpy(entry->uncompressed, pszNode, uncompressed_size);
+		entry->compressed_size = *size;
+		entry->compressed = MemoryContextAlloc(SerializedNodeCacheContext,
+											   *size);
+		memcpy(entry->compressed, sNode, *size);
+		entry->size = sizeof(SerializedNodeCacheEntry) + uncompressed_size + *size;
+
+		while (serialized_node_cache_used + entry->size > limit)
+		{
+			SerializedNodeCacheEntry *victim;
+
+			victim = dlist_tail_element(SerializedNodeCacheEntry, node,
+										&serialized_node_cache);
+			dlist_delete(&victim->node);
+			serialized_node_cache_used -= victim->size;
+			pfree(victim->uncompressed);
+			pfree(victim->compressed);
+			pfree(victim);
+			serialized_node_cache_evictions++;
+		}
+
+		dlist_push_head(&serialized_node_cache, &entry->node);
+		serialized_node_cache_used += entry->size;
+	}
+
+	pfree(pszNode);
+	return sNode;
+#else
+	/* nothing to save without compression */
+	return serializeNode(node, size, uncompressed_size_out);
+#endif
+}
+
+/*
+ * Returns the size of the cache of serializeNodeCached(), and how many nodes
+ * were found in it.
+ */
+Datum
+gp_serialized_plan_cache_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[5];
+	bool		nulls[5];
+	int64		entries = 0;
+	int64		used = 0;
+
+#ifdef HAVE_LIBZSTD
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &serialized_node_cache)
+		entries++;
+	used = (int64) serialized_node_cache_used;
+#endif
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(entries);
+	values[1] = Int64GetDatum(used);
+	values[2] = Int64GetDatum((int64) serialized_node_cache_hits);
+	values[3] = Int64GetDatum((int64) serialized_node_cache_misses);
+	values[4] = Int64GetDatum((int64) serialized_node_cache_evictions);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
 /*
  * This is used on the qExecs to deserialize serialized Plan and Query Trees
  * received from the dispatcher.
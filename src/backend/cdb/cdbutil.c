@@ -77,7 +77,8 @@ static CdbComponentDatabases *cdb_component_dbs = NULL;
  * Helper Functions
  */
 static CdbComponentDatabases *getCdbComponentInfo(void);
-static void cleanupComponentIdleQEs(CdbComponentDatabaseInfo *cdi, bool includeWriter);
+static void cleanupComponentIdleQEs(CdbComponentDatabaseInfo *cdi, bool includeWriter,
+						int keepReaders);
 
 static int	CdbComponentDatabaseInfoCompare(const void *p1, const void *p2);
 
@@ -552,10 +553,11 @@ getCdbComponentInfo(void)
 
 /*
  * Helper function to clean up the idle segdbs list of
- * a segment component.
+ * a segment component, but the first 'keepReaders' readers.
  */
 static void
-cleanupComponentIdleQEs(CdbComponentDatabaseInfo *cdi, bool includeWriter)
+cleanupComponentIdleQEs(CdbComponentDatabaseInfo *cdi, bool includeWriter,
+						int keepReaders)
 {
 	SegmentDatabaseDescriptor	*segdbDesc;
 	MemoryContext				oldContext;
@@ -573,8 +575,11 @@ cleanupComponentIdleQEs(CdbComponentDatabaseInfo *cdi, bool includeWriter)
 		nextItem = lnext(curItem);
 		Assert(segdbDesc);
 
-		if (segdbDesc->isWriter && !includeWriter)
+		if (segdbDesc->isWriter ? !includeWriter : keepReaders > 0)
 		{
+			if (!segdbDesc->isWriter)
+				keepReaders--;
+
 			prevItem = curItem;
 			curItem = nextItem;
 			continue;
@@ -609,7 +614,7 @@ cdbcomponent_cleanupIdleQEs(bool includeWriter)
 		for (i = 0; i < cdbs->total_segment_dbs; i++)
 		{
 			CdbComponentDatabaseInfo *cdi = &cdbs->segment_db_info[i];
-			cleanupComponentIdleQEs(cdi, includeWriter);
+			cleanupComponentIdleQEs(cdi, includeWriter, 0);
 		}
 	}
 
@@ -618,13 +623,41 @@ cdbcomponent_cleanupIdleQEs(bool includeWriter)
 		for (i = 0; i < cdbs->total_entry_dbs; i++)
 		{
 			CdbComponentDatabaseInfo *cdi = &cdbs->entry_db_info[i];
-			cleanupComponentIdleQEs(cdi, includeWriter);
+			cleanupComponentIdleQEs(cdi, includeWriter, 0);
 		}
 	}
 
 	return;
 }
 
+/*
+ * Like cdbcomponent_cleanupIdleQEs(false), but keeps up to 'keepReaders' idle
+ * readers on each segment.  The QEs of the entry db are all released.
+ */
+void
+cdbcomponent_trimIdleQEs(int keepReaders)
+{
+	CdbComponentDatabases	*cdbs;
+	int						i;
+
+	cdbs = cdb_component_dbs;
+
+	if (cdbs == NULL)
+		return;
+
+	if (cdbs->segment_db_info != NULL)
+	{
+		for (i = 0; i < cdbs->total_segment_dbs; i++)
+			cleanupComponentIdleQEs(&cdbs->segment_db_info[i], false, keepReaders);
+	}
+
+	if (cdbs->entry_db_info != NULL)
+	{
+		for (i = 0; i < cdbs->total_entry_dbs; i++)
+			cleanupComponentIdleQEs(&cdbs->entry_db_info[i], false, 0);
+	}
+}
+
 /* 
  * This function is called when a transaction is started and the snapshot of
  * segments info will not changed until the end of transaction
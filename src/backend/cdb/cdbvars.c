@@ -88,6 +88,11 @@ int			gp_safefswritesize; /* set for safe AO writes in non-mature fs */
 int			gp_cached_gang_threshold;	/* How many gangs to keep around from
 										 * stmt to stmt. */
 
+int			gp_qe_pool_size = 0;	/* How many reader QEs per segment to
+									 * keep started while idle. */
+int			gp_qe_pool_idle_timeout = 0;	/* How long to keep them, in
+											 * milliseconds; 0 is forever */
+
 bool		Gp_write_shared_snapshot;	/* tell the writer QE to write the
 										 * shared snapshot */
 
@@ -183,6 +188,7 @@ int			Gp_interconnect_fc_method = INTERCONNECT_FC_METHOD_LOSS;
 int			Gp_interconnect_transmit_timeout = 3600;
 int			Gp_interconnect_min_retries_before_timeout = 100;
 int			Gp_interconnect_debug_retry_interval = 10;
+int			gp_interconnect_rx_spin_count = 1000;
 
 int			interconnect_setup_timeout = 7200;
 
@@ -193,6 +199,12 @@ bool		gp_interconnect_aggressive_retry = true;	/* fast-track app-level
 
 bool		gp_interconnect_full_crc = false;	/* sanity check UDP data. */
 
+bool		gp_interconnect_batch_syscalls = false;	/* use sendmmsg/recvmmsg */
+
+bool		gp_interconnect_compression = false;	/* compress UDP data */
+
+bool		gp_interconnect_local_shm = false;	/* shared memory between local QEs */
+
 bool		gp_interconnect_log_stats = false;	/* emit stats at log-level */
 
 bool		gp_interconnect_cache_future_packets = true;
@@ -240,6 +252,10 @@ int			gp_hashagg_groups_per_bucket = 5;
 /* Analyzing aid */
 int			gp_motion_slice_noop = 0;
 
+/* Columnar Motion batches */
+int			gp_motion_batch_size = 0;
+bool		gp_motion_batch_compression = false;
+
 /* Greenplum Database Experimental Feature GUCs */
 bool		gp_enable_explain_allstat = FALSE;
 bool		gp_enable_motion_deadlock_sanity = FALSE;	/* planning time sanity
@@ -262,6 +278,9 @@ int			gp_segworker_relative_priority = PRIO_MAX;
 /* Max size of dispatched plans; 0 if no limit */
 int			gp_max_plan_size = 0;
 
+/* Size of the cache of compressed dispatched plans; 0 disables it */
+int			gp_serialized_plan_cache_size = 1024;
+
 /* Disable setting of tuple hints while reading */
 bool		gp_disable_tuple_hints = false;
 
@@ -503,10 +503,13 @@ AtAbort_DispatcherState(void)
 	if (Gp_role != GP_ROLE_DISPATCH)
 		return;
 
-	if (CurrentGangCreating != NULL)
+	if (CurrentGangsCreating != NIL)
 	{
-		RecycleGang(CurrentGangCreating, true);
-		CurrentGangCreating = NULL;
+		ListCell   *lc;
+
+		foreach(lc, CurrentGangsCreating)
+			RecycleGang((Gang *) lfirst(lc), true);
+		CurrentGangsCreating = NIL;
 	}
 
 	/*
@@ -531,10 +534,13 @@ AtSubAbort_DispatcherState(void)
 	if (Gp_role != GP_ROLE_DISPATCH)
 		return;
 
-	if (CurrentGangCreating != NULL)
+	if (CurrentGangsCreating != NIL)
 	{
-		RecycleGang(CurrentGangCreating, true);
-		CurrentGangCreating = NULL;
+		ListCell   *lc;
+
+		foreach(lc, CurrentGangsCreating)
+			RecycleGang((Gang *) lfirst(lc), true);
+		CurrentGangsCreating = NIL;
 	}
 
 	CdbResourceOwnerWalker(CurrentResourceOwner, cdbdisp_cleanupDispatcherHandle);
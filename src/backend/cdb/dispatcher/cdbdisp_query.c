@@ -27,6 +27,7 @@
 #include "cdb/cdbsrlz.h"
 #include "cdb/tupleremap.h"
 #include "nodes/execnodes.h"
+#include "portability/instr_time.h"
 #include "tcop/tcopprot.h"
 #include "utils/datum.h"
 #include "utils/guc.h"
@@ -614,8 +615,14 @@ cdbdisp_buildPlanQueryParms(struct QueryDesc *queryDesc,
 	 * serialized plan tree. Note that we're called for a single slice tree
 	 * (corresponding to an initPlan or the main plan), so the parameters are
 	 * fixed and we can include them in the prefix.
+	 *
+	 * Only a plan kept in a CachedPlan is likely to be dispatched again
+	 * unchanged, the others are not worth remembering.
 	 */
-	splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
+	if (queryDesc->plan_cached)
+		splan = serializeNodeCached((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
+	else
+		splan = serializeNode((Node *) queryDesc->plannedstmt, &splan_len, &splan_len_uncompressed);
 
 	uint64		plan_size_in_kb = ((uint64) splan_len_uncompressed) / (uint64) 1024;
 
@@ -1041,10 +1048,15 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	CdbDispatcherState *ds;
 	ErrorData *qeError = NULL;
 	DispatchCommandQueryParms *pQueryParms;
+	instr_time	starttime;
+	instr_time	gangtime;
+	instr_time	dispatchtime;
 
 	if (log_dispatch_stats)
 		ResetUsage();
 
+	INSTR_TIME_SET_CURRENT(starttime);
+
 	estate = queryDesc->estate;
 	sliceTbl = estate->es_sliceTable;
 	Assert(sliceTbl != NULL);
@@ -1064,6 +1076,8 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 	 */
 	AssignGangs(ds, queryDesc);
 
+	INSTR_TIME_SET_CURRENT(gangtime);
+
 	/*
 	 * Traverse the slice tree in sliceTbl rooted at rootIdx and build a
 	 * vector of slice indexes specifying the order of [potential] dispatch.
@@ -1160,6 +1174,16 @@ cdbdisp_dispatchX(QueryDesc* queryDesc,
 
 	cdbdisp_waitDispatchFinish(ds);
 
+	if (gp_log_gang >= GPVARS_VERBOSITY_VERBOSE)
+	{
+		INSTR_TIME_SET_CURRENT(dispatchtime);
+		INSTR_TIME_SUBTRACT(dispatchtime, gangtime);
+		INSTR_TIME_SUBTRACT(gangtime, starttime);
+		elog(LOG, "dispatched %d slices: gangs allocated in %.3f ms, plan sent in %.3f ms",
+			 nSlices, INSTR_TIME_GET_MILLISEC(gangtime),
+			 INSTR_TIME_GET_MILLISEC(dispatchtime));
+	}
+
 	/*
 	 * If bailed before completely dispatched, stop QEs and throw error.
 	 */
@@ -18,9 +18,11 @@
 #include "pgstat.h"			/* pgstat_report_sessionid() */
 #include "utils/memutils.h"
 
+#include "access/htup_details.h"
 #include "access/xact.h"
 #include "catalog/namespace.h"
 #include "commands/variable.h"
+#include "funcapi.h"
 #include "nodes/execnodes.h"	/* CdbProcess, Slice, SliceTable */
 #include "postmaster/postmaster.h"
 #include "tcop/tcopprot.h"
@@ -42,6 +44,7 @@
 #include "libpq/libpq-be.h"
 #include "libpq/ip.h"
 
+#include "utils/builtins.h"
 #include "utils/guc_tables.h"
 
 /*
@@ -66,14 +69,18 @@ int			host_segments = 0;
  */
 int			ic_htab_size = 0;
 
-Gang      *CurrentGangCreating = NULL;
+/* gangs being created, destroyed if we error out */
+List	   *CurrentGangsCreating = NIL;
 
-CreateGangFunc pCreateGangFunc = cdbgang_createGang_async;
+QEPoolStats qePoolStats;
+
+CreateGangsFunc pCreateGangsFunc = cdbgang_createGangs_async;
 
 static bool NeedResetSession = false;
 static Oid	OldTempNamespace = InvalidOid;
 
 static void resetSessionForPrimaryGangLoss(void);
+static List *getQEPoolFillerSegments(int ngangs, List **segments);
 
 /*
  * cdbgang_createGang:
@@ -86,9 +93,25 @@ static void resetSessionForPrimaryGangLoss(void);
 Gang *
 cdbgang_createGang(List *segments, SegmentType segmentType)
 {
-	Assert(pCreateGangFunc);
+	Gang	   *newGang;
+
+	cdbgang_createGangs(1, &segments, &segmentType, &newGang);
+
+	return newGang;
+}
+
+/*
+ * cdbgang_createGangs:
+ *
+ * Like cdbgang_createGang(), for several gangs at once.  The QEs of all the
+ * gangs are connected concurrently.
+ */
+void
+cdbgang_createGangs(int ngangs, List **segments, SegmentType *segmentTypes, Gang **gangs)
+{
+	Assert(pCreateGangsFunc);
 
-	return pCreateGangFunc(segments, segmentType);
+	pCreateGangsFunc(ngangs, segments, segmentTypes, gangs);
 }
 
 /*
@@ -98,10 +121,39 @@ cdbgang_createGang(List *segments, SegmentType segmentType)
  */
 Gang *
 AllocateGang(CdbDispatcherState *ds, GangType type, List *segments)
+{
+	Gang	   *newGang;
+
+	if (segments == NIL)
+		return NULL;
+
+	AllocateGangs(ds, 1, &type, &segments, &newGang);
+
+	return newGang;
+}
+
+/*
+ * Like AllocateGang(), for several gangs at once, like the gangs of all the
+ * slices of a plan.  The QEs of all the gangs are connected concurrently,
+ * rather than one gang after another.
+ *
+ * The QEs missing from the pool of gp_qe_pool_size idle readers per segment
+ * are started along with them, and put in the pool right away.
+ *
+ * elog ERROR or fill 'gangs' with non-NULL gangs.
+ */
+void
+AllocateGangs(CdbDispatcherState *ds, int ngangs, GangType *types,
+			  List **segments, Gang **gangs)
 {
 	MemoryContext	oldContext;
-	SegmentType 	segmentType;
+	SegmentType 	*segmentTypes;
+	List			**allSegments;
+	Gang			**allGangs;
+	List			*fillerSegments;
+	int				nallGangs = ngangs;
 	Gang			*newGang = NULL;
+	int				g;
 	int				i;
 
 	ELOG_DISPATCHER_DEBUG("AllocateGang begin.");
@@ -111,47 +163,132 @@ AllocateGang(CdbDispatcherState *ds, GangType type, List *segments)
 		elog(FATAL, "dispatch process called with role %d", Gp_role);
 	}
 
-	if (segments == NIL)
-		return NULL;
-
 	Assert(DispatcherContext);
 	oldContext = MemoryContextSwitchTo(DispatcherContext);
 
-	if (type == GANGTYPE_PRIMARY_WRITER)
-		segmentType = SEGMENTTYPE_EXPLICT_WRITER;
-	/* for extended query like cursor, must specify a reader */
-	else if (ds->isExtendedQuery)
-		segmentType = SEGMENTTYPE_EXPLICT_READER;
-	else
-		segmentType = SEGMENTTYPE_ANY;
+	segmentTypes = palloc(sizeof(SegmentType) * (ngangs + 1));
+	allSegments = palloc(sizeof(List *) * (ngangs + 1));
+	allGangs = palloc(sizeof(Gang *) * (ngangs + 1));
+	for (g = 0; g < ngangs; g++)
+	{
+		Assert(segments[g] != NIL);
+
+		if (types[g] == GANGTYPE_PRIMARY_WRITER)
+			segmentTypes[g] = SEGMENTTYPE_EXPLICT_WRITER;
+		/* for extended query like cursor, must specify a reader */
+		else if (ds->isExtendedQuery)
+			segmentTypes[g] = SEGMENTTYPE_EXPLICT_READER;
+		else
+			segmentTypes[g] = SEGMENTTYPE_ANY;
+		allSegments[g] = segments[g];
+	}
 
-	newGang = cdbgang_createGang(segments, segmentType);
-	newGang->allocated = true;
-	newGang->type = type;
+	/* the QEs to start for the pool go last, as one more gang */
+	fillerSegments = getQEPoolFillerSegments(ngangs, segments);
+	if (fillerSegments != NIL)
+	{
+		segmentTypes[nallGangs] = SEGMENTTYPE_ANY;
+		allSegments[nallGangs] = fillerSegments;
+		nallGangs++;
+	}
 
-	/*
-	 * Push to the head of the allocated list, later in
-	 * cdbdisp_destroyDispatcherState() we should recycle them from the head to
-	 * restore the original order of the idle gangs.
-	 */
-	ds->allocatedGangs = lcons(newGang, ds->allocatedGangs);
-	ds->largestGangSize = Max(ds->largestGangSize, newGang->size);
+	cdbgang_createGangs(nallGangs, allSegments, segmentTypes, allGangs);
 
-	ELOG_DISPATCHER_DEBUG("AllocateGang end.");
+	if (fillerSegments != NIL)
+	{
+		ELOG_DISPATCHER_DEBUG("AllocateGang: started %d QEs for the pool",
+							  list_length(fillerSegments));
+		qePoolStats.prestarted += list_length(fillerSegments);
+		RecycleGang(allGangs[ngangs], false);
+		list_free(fillerSegments);
+	}
 
-	if (type == GANGTYPE_PRIMARY_WRITER)
+	for (g = 0; g < ngangs; g++)
 	{
+		newGang = gangs[g] = allGangs[g];
+		newGang->allocated = true;
+		newGang->type = types[g];
+
 		/*
-		 * set "whoami" for utility statement. non-utility statement will
-		 * overwrite it in function getCdbProcessList.
+		 * Push to the head of the allocated list, later in
+		 * cdbdisp_destroyDispatcherState() we should recycle them from the
+		 * head to restore the original order of the idle gangs.
 		 */
-		for (i = 0; i < newGang->size; i++)
-			cdbconn_setQEIdentifier(newGang->db_descriptors[i], -1);
+		ds->allocatedGangs = lcons(newGang, ds->allocatedGangs);
+		ds->largestGangSize = Max(ds->largestGangSize, newGang->size);
+
+		if (types[g] == GANGTYPE_PRIMARY_WRITER)
+		{
+			/*
+			 * set "whoami" for utility statement. non-utility statement will
+			 * overwrite it in function getCdbProcessList.
+			 */
+			for (i = 0; i < newGang->size; i++)
+				cdbconn_setQEIdentifier(newGang->db_descriptors[i], -1);
+		}
 	}
 
+	pfree(segmentTypes);
+	pfree(allSegments);
+	pfree(allGangs);
+
+	ELOG_DISPATCHER_DEBUG("AllocateGang end.");
+
 	MemoryContextSwitchTo(oldContext);
+}
 
-	return newGang;
+/*
+ * The segments to start QEs on so that, once the given gangs are created,
+ * each segment has a writer and gp_qe_pool_size readers.  A segment is
+ * listed once for each QE to start on it.
+ */
+static List *
+getQEPoolFillerSegments(int ngangs, List **segments)
+{
+	CdbComponentDatabases *cdbs;
+	List	   *result = NIL;
+	ListCell   *lc;
+	int		   *nbatch;
+	int			poolSize;
+	int			g;
+	int			i;
+
+	/* recycled readers beyond gp_cached_gang_threshold would be destroyed */
+	poolSize = Min(gp_qe_pool_size, gp_cached_gang_threshold - 1);
+	if (poolSize <= 0)
+		return NIL;
+
+	cdbs = cdbcomponent_getCdbComponents();
+
+	/* QEs the gangs need on each segment */
+	nbatch = palloc0(sizeof(int) * cdbs->total_segments);
+	for (g = 0; g < ngangs; g++)
+	{
+		foreach(lc, segments[g])
+		{
+			int			contentId = lfirst_int(lc);
+
+			if (contentId >= 0)
+				nbatch[contentId]++;
+		}
+	}
+
+	for (i = 0; i < cdbs->total_segments; i++)
+	{
+		CdbComponentDatabaseInfo *cdbinfo = cdbcomponent_getComponentInfo(i);
+		int			nqes;
+		int			nmissing;
+
+		/* the gangs take the idle QEs first, and start new ones if need be */
+		nqes = cdbinfo->numActiveQEs + Max(cdbinfo->numIdleQEs, nbatch[i]);
+
+		for (nmissing = 1 + poolSize - nqes; nmissing > 0; nmissing--)
+			result = lappend_int(result, i);
+	}
+
+	pfree(nbatch);
+
+	return result;
 }
 
 /*
@@ -644,12 +781,15 @@ DisconnectAndDestroyAllGangs(bool resetSession)
 
 	ELOG_DISPATCHER_DEBUG("DisconnectAndDestroyAllGangs");
 
-    /* Destroy CurrentGangCreating before GangContext is reset */
-    if (CurrentGangCreating != NULL)
-    {
-        RecycleGang(CurrentGangCreating, true);
-        CurrentGangCreating = NULL;
-    }
+	/* Destroy CurrentGangsCreating before GangContext is reset */
+	if (CurrentGangsCreating != NIL)
+	{
+		ListCell   *lc;
+
+		foreach(lc, CurrentGangsCreating)
+			RecycleGang((Gang *) lfirst(lc), true);
+		CurrentGangsCreating = NIL;
+	}
 
 	/* cleanup all out bound dispatcher state */
 	CdbResourceOwnerWalker(CurrentResourceOwner, cdbdisp_cleanupDispatcherHandle);
@@ -670,11 +810,18 @@ DisconnectAndDestroyAllGangs(bool resetSession)
  * If we are not in a transaction and we do not have a TempNamespace, destroy
  * writer QEs as well.
  *
+ * If keepPool is true and gp_qe_pool_size is set, keep the writer QEs and
+ * that many reader QEs per segment.
+ *
  * call only from an idle session.
  */
-void DisconnectAndDestroyUnusedQEs(void)
+void DisconnectAndDestroyUnusedQEs(bool keepPool)
 {
-	if (IsTransactionOrTransactionBlock() || TempNamespaceOidIsValid())
+	if (keepPool && gp_qe_pool_size > 0)
+	{
+		cdbcomponent_trimIdleQEs(Min(gp_qe_pool_size, gp_cached_gang_threshold - 1));
+	}
+	else if (IsTransactionOrTransactionBlock() || TempNamespaceOidIsValid())
 	{
 		/*
 		 * If we are in a transaction, we can't release the writer gang,
@@ -867,6 +1014,35 @@ RecycleGang(Gang *gp, bool forceDestroy)
 	}
 }
 
+/*
+ * Returns the number of idle QEs of this session, and how many QEs were
+ * taken from the idle ones or started.
+ */
+Datum
+gp_qe_pool_stats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[6];
+	bool		nulls[6];
+	CdbComponentDatabases *cdbs = NULL;
+
+	if (cdbcomponent_qesExist())
+		cdbs = cdbcomponent_getCdbComponents();
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	MemSet(nulls, 0, sizeof(nulls));
+	values[0] = Int32GetDatum(cdbs ? cdbs->numIdleQEs : 0);
+	values[1] = Int64GetDatum(qePoolStats.reused);
+	values[2] = Int64GetDatum(qePoolStats.started);
+	values[3] = Int64GetDatum(qePoolStats.prestarted);
+	values[4] = Int64GetDatum(qePoolStats.allocations);
+	values[5] = Float8GetDatum(qePoolStats.allocation_time);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
 void
 ResetAllGangs(void)
 {
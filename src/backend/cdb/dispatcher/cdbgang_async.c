@@ -22,6 +22,7 @@
 #include <sys/poll.h>
 #endif
 
+#include "portability/instr_time.h"
 #include "storage/ipc.h"		/* For proc_exit_inprogress  */
 #include "tcop/tcopprot.h"
 #include "libpq-fe.h"
@@ -33,53 +34,104 @@
 #include "cdb/cdbvars.h"
 #include "miscadmin.h"
 
+/* How far the connection to a QE went, for the gang creation timings */
+typedef enum QEConnPhase
+{
+	QE_CONN_WAIT_WRITER,		/* not started, the writer is starting */
+	QE_CONN_CONNECTING,
+	QE_CONN_AUTHENTICATING,
+	QE_CONN_STARTING_UP,
+	QE_CONN_DONE				/* established, or in recovery mode */
+} QEConnPhase;
+
 static int	getPollTimeout(const struct timeval *startTS);
+static void startConnection(SegmentDatabaseDescriptor *segdbDesc,
+				char *options, int totalSegs);
+static QEConnPhase getConnPhase(SegmentDatabaseDescriptor *segdbDesc);
 
 /*
- * Creates a new gang by logging on a session to each segDB involved.
+ * Creates new gangs by logging on a session to each segDB involved.
+ *
+ * The QEs of all the gangs are connected at the same time, rather than one
+ * gang after another, so that a plan with many slices doesn't wait for the
+ * sum of the startup times of its gangs.  A reader only needs the writer of
+ * its segment to be up, so each reader is started as soon as the writer of
+ * its segment, if it's being started too, is ready.
  *
  * call this function in GangContext memory context.
- * elog ERROR or return a non-NULL gang.
+ * elog ERROR or fill 'gangs' with non-NULL gangs.
  */
-Gang *
-cdbgang_createGang_async(List *segments, SegmentType segmentType)
+void
+cdbgang_createGangs_async(int ngangs, List **segments, SegmentType *segmentTypes,
+						  Gang **gangs)
 {
 	PostgresPollingStatusType	*pollingStatus = NULL;
 	SegmentDatabaseDescriptor	*segdbDesc = NULL;
+	SegmentDatabaseDescriptor	**segdbDescs;
 	struct timeval	startTS;
-	Gang	*newGangDefinition;
+	instr_time	allocstarttime;
+	instr_time	allocendtime;
+	instr_time	starttime;
+	instr_time	phasetime[QE_CONN_DONE + 1];
+	int		nreused = 0;
 	int		create_gang_retry_counter = 0;
 	int		in_recovery_mode_count = 0;
 	int		successful_connections = 0;
 	int		poll_timeout = 0;
 	int		i = 0;
+	int		g;
 	int		size = 0;
 	bool	retry = false;
 	int		totalSegs = 0;
+	char   *options;
 
 	/*
-	 * true means connection status is confirmed, either established or in
-	 * recovery mode
+	 * How far the connection to each QE went.  QE_CONN_DONE means the
+	 * connection status is confirmed, either established or in recovery mode.
 	 */
-	bool	   *connStatusDone = NULL;
+	QEConnPhase *connPhase = NULL;
+
+	/* writers being started, by segindex + 1 */
+	bool	   *writerPending;
+
+	Assert(CurrentGangsCreating == NIL);
 
-	size = list_length(segments);
+	INSTR_TIME_SET_CURRENT(allocstarttime);
 
-	ELOG_DISPATCHER_DEBUG("createGang size = %d, segment type = %d", size, segmentType);
+	/* allocate and initialize the gang structures */
+	for (g = 0; g < ngangs; g++)
+	{
+		ELOG_DISPATCHER_DEBUG("createGang size = %d, segment type = %d",
+							  list_length(segments[g]), segmentTypes[g]);
+
+		gangs[g] = buildGangDefinition(segments[g], segmentTypes[g]);
+		CurrentGangsCreating = lappend(CurrentGangsCreating, gangs[g]);
+		size += gangs[g]->size;
+	}
 
-	Assert(CurrentGangCreating == NULL);
+	/* flatten the QEs of all the gangs */
+	segdbDescs = palloc(sizeof(SegmentDatabaseDescriptor *) * size);
+	i = 0;
+	for (g = 0; g < ngangs; g++)
+	{
+		memcpy(&segdbDescs[i], gangs[g]->db_descriptors,
+			   sizeof(SegmentDatabaseDescriptor *) * gangs[g]->size);
+		i += gangs[g]->size;
+	}
 
-	/* If we're in a retry, we may need to reset our initial state, a bit */
-	newGangDefinition = NULL;
-	/* allocate and initialize a gang structure */
-	newGangDefinition = buildGangDefinition(segments, segmentType);
-	CurrentGangCreating = newGangDefinition;
 	totalSegs = getgpsegmentCount();
 	Assert(totalSegs > 0);
 
+	options = makeOptions();
+
+	/* count the QEs taken from the idle ones */
+	for (i = 0; i < size; i++)
+	{
+		if (segdbDescs[i]->conn != NULL && !cdbconn_isBadConnection(segdbDescs[i]))
+			nreused++;
+	}
+
 create_gang_retry:
-	Assert(newGangDefinition != NULL);
-	Assert(newGangDefinition->size == size);
 	successful_connections = 0;
 	in_recovery_mode_count = 0;
 	retry = false;
@@ -89,7 +141,8 @@ create_gang_retry:
 	 * when gang is destroyed
 	 */
 	pollingStatus = palloc(sizeof(PostgresPollingStatusType) * size);
-	connStatusDone = palloc(sizeof(bool) * size);
+	connPhase = palloc(sizeof(QEConnPhase) * size);
+	writerPending = palloc0(sizeof(bool) * (totalSegs + 1));
 
 	struct pollfd *fds;
 
@@ -97,52 +150,38 @@ create_gang_retry:
 	{
 		for (i = 0; i < size; i++)
 		{
-			bool		ret;
-			char		gpqeid[100];
-			char	   *options;
-
-			/*
-			 * Create the connection requests.	If we find a segment without a
-			 * valid segdb we error out.  Also, if this segdb is invalid, we
-			 * must fail the connection.
-			 */
-			segdbDesc = newGangDefinition->db_descriptors[i];
+			segdbDesc = segdbDescs[i];
 
 			/* if it's a cached QE, skip */
 			if (segdbDesc->conn != NULL && !cdbconn_isBadConnection(segdbDesc))
 			{
-				connStatusDone[i] = true;
+				connPhase[i] = QE_CONN_DONE;
 				successful_connections++;
 				continue;
 			}
 
-			/*
-			 * Build the connection string.  Writer-ness needs to be processed
-			 * early enough now some locks are taken before command line
-			 * options are recognized.
-			 */
-			ret = build_gpqeid_param(gpqeid, sizeof(gpqeid),
-									 segdbDesc->isWriter,
-									 segdbDesc->identifier,
-									 segdbDesc->segment_database_info->hostSegs,
-									 totalSegs * 2);
-
-			if (!ret)
-				ereport(ERROR,
-						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-						 errmsg("failed to construct connectionstring")));
-
-			options = makeOptions();
+			if (segdbDesc->isWriter)
+			{
+				Assert(segdbDesc->segindex >= 0 && segdbDesc->segindex < totalSegs);
+				writerPending[segdbDesc->segindex + 1] = true;
+			}
+			connPhase[i] = QE_CONN_WAIT_WRITER;
+		}
 
-			/* start connection in asynchronous way */
-			cdbconn_doConnectStart(segdbDesc, gpqeid, options);
+		/*
+		 * Start the connection requests, those of the readers whose writer
+		 * is being started too are started once the writer is ready.
+		 */
+		for (i = 0; i < size; i++)
+		{
+			segdbDesc = segdbDescs[i];
 
-			if (cdbconn_isBadConnection(segdbDesc))
-				ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-								errmsg("failed to acquire resources on one or more segments"),
-								errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
+			if (connPhase[i] != QE_CONN_WAIT_WRITER ||
+				(!segdbDesc->isWriter && writerPending[segdbDesc->segindex + 1]))
+				continue;
 
-			connStatusDone[i] = false;
+			startConnection(segdbDesc, options, totalSegs);
+			connPhase[i] = QE_CONN_CONNECTING;
 
 			/*
 			 * If connection status is not CONNECTION_BAD after
@@ -153,31 +192,46 @@ create_gang_retry:
 		}
 
 		/*
-		 * Ok, we've now launched all the connection attempts. Start the
-		 * timeout clock (= get the start timestamp), and poll until they're
-		 * all completed or we reach timeout.
+		 * Ok, we've now launched the connection attempts. Start the timeout
+		 * clock (= get the start timestamp), and poll until they're all
+		 * completed or we reach timeout.
 		 */
 		gettimeofday(&startTS, NULL);
+		INSTR_TIME_SET_CURRENT(starttime);
+		for (i = 0; i <= QE_CONN_DONE; i++)
+			phasetime[i] = starttime;
 		fds = (struct pollfd *) palloc0(sizeof(struct pollfd) * size);
 
 		for (;;)
 		{
 			int			nready;
 			int			nfds = 0;
+			bool		writerReady = false;
 
 			poll_timeout = getPollTimeout(&startTS);
 
 			for (i = 0; i < size; i++)
 			{
-				segdbDesc = newGangDefinition->db_descriptors[i];
+				segdbDesc = segdbDescs[i];
 
 				/*
 				 * Skip established connections and in-recovery-mode
 				 * connections
 				 */
-				if (connStatusDone[i])
+				if (connPhase[i] == QE_CONN_DONE)
 					continue;
 
+				if (connPhase[i] == QE_CONN_WAIT_WRITER)
+				{
+					if (writerPending[segdbDesc->segindex + 1])
+						continue;
+
+					/* the writer is ready, go */
+					startConnection(segdbDesc, options, totalSegs);
+					connPhase[i] = QE_CONN_CONNECTING;
+					pollingStatus[i] = PGRES_POLLING_WRITING;
+				}
+
 				switch (pollingStatus[i])
 				{
 					case PGRES_POLLING_OK:
@@ -187,7 +241,15 @@ create_gang_retry:
 											errmsg("failed to acquire resources on one or more segments"),
 											errdetail("Internal error: No motion listener port (%s)", segdbDesc->whoami)));
 						successful_connections++;
-						connStatusDone[i] = true;
+						connPhase[i] = QE_CONN_DONE;
+						INSTR_TIME_SET_CURRENT(phasetime[QE_CONN_DONE]);
+
+						/* the readers of the segment can go now */
+						if (segdbDesc->isWriter)
+						{
+							writerPending[segdbDesc->segindex + 1] = false;
+							writerReady = true;
+						}
 
 						continue;
 
@@ -207,7 +269,7 @@ create_gang_retry:
 						if (segment_failure_due_to_recovery(PQerrorMessage(segdbDesc->conn)))
 						{
 							in_recovery_mode_count++;
-							connStatusDone[i] = true;
+							connPhase[i] = QE_CONN_DONE;
 							elog(LOG, "segment is in recovery mode (%s)", segdbDesc->whoami);
 						}
 						else
@@ -233,8 +295,16 @@ create_gang_retry:
 									errdetail("timeout expired\n (%s)", segdbDesc->whoami)));
 			}
 
+			/*
+			 * Nothing to wait for. But the readers before a writer that got
+			 * ready in this pass were skipped, go around again to start them.
+			 */
 			if (nfds == 0)
+			{
+				if (writerReady)
+					continue;
 				break;
+			}
 
 			SIMPLE_FAULT_INJECTOR("create_gang_in_progress");
 
@@ -260,8 +330,11 @@ create_gang_retry:
 
 				for (i = 0; i < size; i++)
 				{
-					segdbDesc = newGangDefinition->db_descriptors[i];
-					if (connStatusDone[i])
+					QEConnPhase phase;
+
+					segdbDesc = segdbDescs[i];
+					if (connPhase[i] == QE_CONN_DONE ||
+						connPhase[i] == QE_CONN_WAIT_WRITER)
 						continue;
 
 					Assert(PQsocket(segdbDesc->conn) > 0);
@@ -269,17 +342,53 @@ create_gang_retry:
 
 					if (fds[currentFdNumber].revents & fds[currentFdNumber].events ||
 						fds[currentFdNumber].revents & (POLLERR | POLLHUP | POLLNVAL))
+					{
 						pollingStatus[i] = PQconnectPoll(segdbDesc->conn);
 
+						/* note when the last QE got past each phase */
+						phase = getConnPhase(segdbDesc);
+						while (connPhase[i] < phase)
+						{
+							INSTR_TIME_SET_CURRENT(phasetime[connPhase[i]]);
+							connPhase[i]++;
+						}
+					}
+
 					currentFdNumber++;
 
 				}
 			}
 		}
 
+		/*
+		 * Readers still waiting for their writer are in recovery mode like
+		 * the writer.
+		 */
+		for (i = 0; i < size; i++)
+		{
+			if (connPhase[i] == QE_CONN_WAIT_WRITER)
+			{
+				in_recovery_mode_count++;
+				connPhase[i] = QE_CONN_DONE;
+			}
+		}
+
 		ELOG_DISPATCHER_DEBUG("createGang: %d processes requested; %d successful connections %d in recovery",
 							  size, successful_connections, in_recovery_mode_count);
 
+		if (gp_log_gang >= GPVARS_VERBOSITY_VERBOSE)
+		{
+			for (i = 0; i <= QE_CONN_DONE; i++)
+				INSTR_TIME_SUBTRACT(phasetime[i], starttime);
+
+			elog(LOG, "createGang: %d gangs, %d processes: "
+				 "connected in %.3f ms, authenticated in %.3f ms, ready in %.3f ms",
+				 ngangs, size,
+				 INSTR_TIME_GET_MILLISEC(phasetime[QE_CONN_CONNECTING]),
+				 INSTR_TIME_GET_MILLISEC(phasetime[QE_CONN_AUTHENTICATING]),
+				 INSTR_TIME_GET_MILLISEC(phasetime[QE_CONN_DONE]));
+		}
+
 		/* some segments are in recovery mode */
 		if (successful_connections != size)
 		{
@@ -300,7 +409,7 @@ create_gang_retry:
 	{
 		FtsNotifyProber();
 		/* FTS shows some segment DBs are down */
-		if (FtsTestSegmentDBIsDown(newGangDefinition->db_descriptors, size))
+		if (FtsTestSegmentDBIsDown(segdbDescs, size))
 		{
 			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
 							errmsg("failed to acquire resources on one or more segments"),
@@ -323,11 +432,96 @@ create_gang_retry:
 		goto create_gang_retry;
 	}
 
-	CurrentGangCreating = NULL;
+	list_free(CurrentGangsCreating);
+	CurrentGangsCreating = NIL;
+
+	qePoolStats.reused += nreused;
+	qePoolStats.started += size - nreused;
+	qePoolStats.allocations++;
+	INSTR_TIME_SET_CURRENT(allocendtime);
+	INSTR_TIME_SUBTRACT(allocendtime, allocstarttime);
+	qePoolStats.allocation_time += INSTR_TIME_GET_MILLISEC(allocendtime);
+}
+
+/*
+ * Creates a new gang by logging on a session to each segDB involved.
+ *
+ * call this function in GangContext memory context.
+ * elog ERROR or return a non-NULL gang.
+ */
+Gang *
+cdbgang_createGang_async(List *segments, SegmentType segmentType)
+{
+	Gang	   *newGangDefinition;
+
+	cdbgang_createGangs_async(1, &segments, &segmentType, &newGangDefinition);
 
 	return newGangDefinition;
 }
 
+/*
+ * Start connecting to a QE in asynchronous way.
+ */
+static void
+startConnection(SegmentDatabaseDescriptor *segdbDesc, char *options, int totalSegs)
+{
+	bool		ret;
+	char		gpqeid[100];
+
+	/*
+	 * Create the connection request.  If we find a segment without a valid
+	 * segdb we error out.  Also, if this segdb is invalid, we must fail the
+	 * connection.
+	 *
+	 * Build the connection string.  Writer-ness needs to be processed early
+	 * enough now some locks are taken before command line options are
+	 * recognized.
+	 */
+	ret = build_gpqeid_param(gpqeid, sizeof(gpqeid),
+							 segdbDesc->isWriter,
+							 segdbDesc->identifier,
+							 segdbDesc->segment_database_info->hostSegs,
+							 totalSegs * 2);
+
+	if (!ret)
+		ereport(ERROR,
+				(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+				 errmsg("failed to construct connectionstring")));
+
+	/* start connection in asynchronous way */
+	cdbconn_doConnectStart(segdbDesc, gpqeid, options);
+
+	if (cdbconn_isBadConnection(segdbDesc))
+		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						errmsg("failed to acquire resources on one or more segments"),
+						errdetail("%s (%s)", PQerrorMessage(segdbDesc->conn), segdbDesc->whoami)));
+}
+
+/*
+ * Which phase of the startup is the connection to a QE in?
+ */
+static QEConnPhase
+getConnPhase(SegmentDatabaseDescriptor *segdbDesc)
+{
+	switch (PQstatus(segdbDesc->conn))
+	{
+		case CONNECTION_STARTED:
+		case CONNECTION_NEEDED:
+			return QE_CONN_CONNECTING;
+
+		case CONNECTION_MADE:
+		case CONNECTION_AWAITING_RESPONSE:
+			return QE_CONN_AUTHENTICATING;
+
+		default:
+			/*
+			 * Authenticated, the QE is initializing.  The connection is only
+			 * done once cdbconn_doConnectComplete() was called on it.
+			 */
+			return QE_CONN_STARTING_UP;
+	}
+}
+
 static int
 getPollTimeout(const struct timeval *startTS)
 {
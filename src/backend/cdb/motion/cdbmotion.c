@@ -74,7 +74,19 @@ static void statChunksProcessed(MotionLayerState *mlStates, MotionNodeEntry *pMN
 static void statNewTupleArrived(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry);
 static void statRecvTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry);
 static bool ShouldSendRecordCache(MotionConn *conn, SerTupInfo *pSerInfo);
+static SendReturnCode SendTupleBatched(MotionLayerState *mlStates,
+				 ChunkTransportState *transportStates,
+				 MotionNodeEntry *pMNEntry,
+				 int16 motNodeID,
+				 TupleTableSlot *slot,
+				 int16 targetRoute);
+static bool FlushTupleBatch(MotionLayerState *mlStates,
+				ChunkTransportState *transportStates,
+				MotionNodeEntry *pMNEntry,
+				int16 motNodeID,
+				int batchIdx);
 static void UpdateSentRecordCache(MotionConn *conn);
+static void DestroyTupleBatches(MotionNodeEntry *pMNEntry, List *batches);
 
 
 
@@ -98,7 +110,28 @@ reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRem
 	clearTCList(NULL, &pCSEntry->chunk_list);
 
 	if (!tup)
+	{
+		/*
+		 * Either a record cache, or a batch of tuples.  Tuples in a batch
+		 * never contain record types, so there's nothing to remap.  The rows
+		 * stay in columns until RecvTupleFrom() stores them into a slot.
+		 */
+		TupleBatch *batch = TakeReceivedTupleBatch(pSerInfo);
+
+		if (batch != NULL)
+		{
+			int			i;
+
+			if (pMNEntry->preserve_order)
+				pCSEntry->ready_batches = lappend(pCSEntry->ready_batches, batch);
+			else
+				pMNEntry->ready_batches = lappend(pMNEntry->ready_batches, batch);
+
+			for (i = 0; i < batch->nrows; i++)
+				statNewTupleArrived(pMNEntry, pCSEntry);
+		}
 		return;
+	}
 
 	tup = TRCheckAndRemap(remapper, pSerInfo->tupdesc, tup);
 
@@ -108,6 +141,19 @@ reconstructTuple(MotionNodeEntry *pMNEntry, ChunkSorterEntry *pCSEntry, TupleRem
 	statNewTupleArrived(pMNEntry, pCSEntry);
 }
 
+/*
+ * Free a list of received columnar batches.
+ */
+static void
+DestroyTupleBatches(MotionNodeEntry *pMNEntry, List *batches)
+{
+	ListCell   *lc;
+
+	foreach(lc, batches)
+		DestroyTupleBatch(&pMNEntry->ser_tup_info, (TupleBatch *) lfirst(lc));
+	list_free(batches);
+}
+
 /*
  * FUNCTION DEFINITIONS
  */
@@ -269,6 +315,9 @@ UpdateMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool preserve
 	pEntry->preserve_order = preserveOrder;
 	pEntry->tuple_desc = CreateTupleDescCopy(tupDesc);
 	InitSerTupInfo(pEntry->tuple_desc, &pEntry->ser_tup_info);
+	pEntry->send_batches = NULL;
+	pEntry->num_send_batches = 0;
+	pEntry->ready_batches = NIL;
 
 	if (!preserveOrder)
 	{
@@ -456,6 +505,15 @@ SendTuple(MotionLayerState *mlStates,
 	 */
 	pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
 
+	/*
+	 * If all the columns are fixed-width, buffer the tuple into a columnar
+	 * batch for the route instead of sending it right away.
+	 */
+	if (pMNEntry->send_batches != NULL ||
+		(gp_motion_batch_size > 0 && pMNEntry->ser_tup_info.batchable))
+		return SendTupleBatched(mlStates, transportStates, pMNEntry,
+								motNodeID, slot, targetRoute);
+
 #ifdef AMS_VERBOSE_LOGGING
 	elog(DEBUG5, "Serializing HeapTuple for sending.");
 #endif
@@ -517,6 +575,115 @@ SendTuple(MotionLayerState *mlStates,
 	return rc;
 }
 
+/*
+ * Add a tuple to the columnar batch for 'targetRoute', and send the batch
+ * if it is full.
+ */
+static SendReturnCode
+SendTupleBatched(MotionLayerState *mlStates,
+				 ChunkTransportState *transportStates,
+				 MotionNodeEntry *pMNEntry,
+				 int16 motNodeID,
+				 TupleTableSlot *slot,
+				 int16 targetRoute)
+{
+	MemoryContext oldCtxt;
+	TupleBatch *batch;
+	int			batchIdx;
+	bool		full;
+
+	oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+
+	if (pMNEntry->send_batches == NULL)
+	{
+		ChunkTransportStateEntry *pEntry = NULL;
+
+		getChunkTransportState(transportStates, motNodeID, &pEntry);
+
+		/* One batch per connection, plus one for broadcasts. */
+		pMNEntry->num_send_batches = pEntry->numConns + 1;
+		pMNEntry->send_batches = (TupleBatch **)
+			palloc0(pMNEntry->num_send_batches * sizeof(TupleBatch *));
+	}
+
+	if (targetRoute == BROADCAST_SEGIDX)
+		batchIdx = pMNEntry->num_send_batches - 1;
+	else
+		batchIdx = targetRoute;
+
+	if (batchIdx < 0 || batchIdx >= pMNEntry->num_send_batches)
+		elog(ERROR, "invalid target route %d for motion node %d",
+			 targetRoute, motNodeID);
+
+	batch = pMNEntry->send_batches[batchIdx];
+	if (batch == NULL)
+	{
+		batch = CreateTupleBatch(&pMNEntry->ser_tup_info,
+								 Max(gp_motion_batch_size, 1));
+		pMNEntry->send_batches[batchIdx] = batch;
+	}
+
+	full = AddTupleToBatch(batch, slot, &pMNEntry->ser_tup_info);
+
+	MemoryContextSwitchTo(oldCtxt);
+
+	if (full &&
+		!FlushTupleBatch(mlStates, transportStates, pMNEntry, motNodeID, batchIdx))
+	{
+		pMNEntry->stopped = true;
+		return STOP_SENDING;
+	}
+
+	return SEND_COMPLETE;
+}
+
+/*
+ * Send the rows buffered in a columnar batch, if any.
+ *
+ * Returns false if the receiver doesn't want any more tuples.
+ */
+static bool
+FlushTupleBatch(MotionLayerState *mlStates,
+				ChunkTransportState *transportStates,
+				MotionNodeEntry *pMNEntry,
+				int16 motNodeID,
+				int batchIdx)
+{
+	TupleBatch *batch = pMNEntry->send_batches[batchIdx];
+	TupleChunkListData tcList;
+	MemoryContext oldCtxt;
+	int16		targetRoute;
+	int			nrows;
+	bool		ok;
+
+	if (batch == NULL || batch->nrows == 0)
+		return true;
+
+	if (batchIdx == pMNEntry->num_send_batches - 1)
+		targetRoute = BROADCAST_SEGIDX;
+	else
+		targetRoute = batchIdx;
+
+	nrows = batch->nrows;
+
+	oldCtxt = MemoryContextSwitchTo(mlStates->motion_layer_mctx);
+	SerializeTupleBatch(batch, &pMNEntry->ser_tup_info, &tcList);
+	MemoryContextSwitchTo(oldCtxt);
+
+	ok = SendTupleChunkToAMS(mlStates, transportStates, motNodeID, targetRoute, tcList.p_first);
+	if (ok)
+	{
+		/* update stats, counting each row in the batch as one send */
+		statSendTuple(mlStates, pMNEntry, &tcList);
+		pMNEntry->stat_total_sends += nrows - 1;
+	}
+
+	/* cleanup */
+	clearTCList(&pMNEntry->ser_tup_info.chunkCache, &tcList);
+
+	return ok;
+}
+
 TupleChunkListItem
 get_eos_tuplechunklist(void)
 {
@@ -541,6 +708,21 @@ SendEndOfStream(MotionLayerState *mlStates,
 	 */
 	pMNEntry = getMotionNodeEntry(mlStates, motNodeID);
 
+	/* Send any rows still sitting in columnar batches ahead of the EOS. */
+	if (pMNEntry->send_batches != NULL && !pMNEntry->stopped)
+	{
+		int			i;
+
+		for (i = 0; i < pMNEntry->num_send_batches; i++)
+		{
+			if (!FlushTupleBatch(mlStates, transportStates, pMNEntry, motNodeID, i))
+			{
+				pMNEntry->stopped = true;
+				break;
+			}
+		}
+	}
+
 	transportStates->SendEos(transportStates, motNodeID, s_eos_chunk_data);
 
 	/*
@@ -553,17 +735,25 @@ SendEndOfStream(MotionLayerState *mlStates,
 	statSendEOS(mlStates, pMNEntry);
 }
 
-/* An unordered receiver will call this with srcRoute == ANY_ROUTE */
-GenericTuple
+/*
+ * An unordered receiver will call this with srcRoute == ANY_ROUTE
+ *
+ * The tuple is stored into 'slot'.  Rows of a columnar batch are stored as
+ * virtual tuples, without forming a heap tuple.
+ */
+TupleTableSlot *
 RecvTupleFrom(MotionLayerState *mlStates,
 			  ChunkTransportState *transportStates,
 			  int16 motNodeID,
-			  int16 srcRoute)
+			  int16 srcRoute,
+			  TupleTableSlot *slot)
 {
 	MotionNodeEntry *pMNEntry;
 	ChunkSorterEntry *pCSEntry;
 	htup_fifo	ReadyList;
+	List	  **ReadyBatches;
 	GenericTuple tuple = NULL;
+	bool		found = false;
 
 #ifdef AMS_VERBOSE_LOGGING
 	elog(DEBUG5, "RecvTupleFrom( motNodeID = %d, srcRoute = %d )", motNodeID, srcRoute);
@@ -577,6 +767,7 @@ RecvTupleFrom(MotionLayerState *mlStates,
 		pCSEntry = NULL;
 
 		ReadyList = pMNEntry->ready_tuples;
+		ReadyBatches = &pMNEntry->ready_batches;
 	}
 	else
 	{
@@ -588,14 +779,36 @@ RecvTupleFrom(MotionLayerState *mlStates,
 		 */
 		pCSEntry = getChunkSorterEntry(mlStates, pMNEntry, srcRoute);
 		ReadyList = pCSEntry->ready_tuples;
+		ReadyBatches = &pCSEntry->ready_batches;
 	}
 
 	for (;;)
 	{
+		/* Get the next row of the oldest received batch, if there is one. */
+		while (*ReadyBatches != NIL)
+		{
+			TupleBatch *batch = (TupleBatch *) linitial(*ReadyBatches);
+
+			if (StoreNextBatchedTuple(batch, slot, &pMNEntry->ser_tup_info))
+			{
+				found = true;
+				break;
+			}
+
+			*ReadyBatches = list_delete_first(*ReadyBatches);
+			DestroyTupleBatch(&pMNEntry->ser_tup_info, batch);
+		}
+		if (found)
+			break;
+
 		/* Get the next tuple from the FIFO, if one is available. */
 		tuple = htfifo_gettuple(ReadyList);
 		if (tuple)
+		{
+			ExecStoreGenericTuple(tuple, slot, true /* shouldFree */ );
+			found = true;
 			break;
+		}
 
 		/*
 		 * We need to get more chunks before we have a full tuple to return. Loop
@@ -615,11 +828,13 @@ RecvTupleFrom(MotionLayerState *mlStates,
 		processIncomingChunks(mlStates, transportStates, pMNEntry, motNodeID, srcRoute);
 	}
 
+	if (!found)
+		return NULL;
+
 	/* Stats */
-	if (tuple)
-		statRecvTuple(pMNEntry, pCSEntry);
+	statRecvTuple(pMNEntry, pCSEntry);
 
-	return tuple;
+	return slot;
 }
 
 
@@ -782,7 +997,11 @@ EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLa
 			 */
 			clearTCList(&pMNEntry->ser_tup_info.chunkCache, &pCSEntry->chunk_list);
 			if (pMNEntry->preserve_order)	/* Clean up the tuple-store. */
+			{
 				htfifo_destroy(pCSEntry->ready_tuples);
+				DestroyTupleBatches(pMNEntry, pCSEntry->ready_batches);
+				pCSEntry->ready_batches = NIL;
+			}
 		}
 	}
 	pMNEntry->cleanedUp = true;
@@ -819,6 +1038,21 @@ EndMotionLayerNode(MotionLayerState *mlStates, int16 motNodeID, bool flushCommLa
 		}
 	}
 
+	/* Free the columnar batches of the sender and of the receiver. */
+	if (pMNEntry->send_batches != NULL)
+	{
+		for (i = 0; i < pMNEntry->num_send_batches; i++)
+		{
+			if (pMNEntry->send_batches[i] != NULL)
+				DestroyTupleBatch(&pMNEntry->ser_tup_info, pMNEntry->send_batches[i]);
+		}
+		pfree(pMNEntry->send_batches);
+		pMNEntry->send_batches = NULL;
+		pMNEntry->num_send_batches = 0;
+	}
+	DestroyTupleBatches(pMNEntry, pMNEntry->ready_batches);
+	pMNEntry->ready_batches = NIL;
+
 	CleanupSerTupInfo(&pMNEntry->ser_tup_info);
 	FreeTupleDesc(pMNEntry->tuple_desc);
 	if (!pMNEntry->preserve_order)
@@ -902,6 +1136,7 @@ getChunkSorterEntry(MotionLayerState *mlStates,
 	chunkSorterEntry->chunk_list.p_first = NULL;
 	chunkSorterEntry->chunk_list.p_last = NULL;
 	chunkSorterEntry->end_of_stream = false;
+	chunkSorterEntry->ready_batches = NIL;
 	chunkSorterEntry->init = true;
 
 	/*
@@ -511,6 +511,114 @@ DeregisterReadInterest(ChunkTransportState *transportStates,
 	return;
 }
 
+/*
+ * Sum up the received payload sizes over the connections of a motion node.
+ */
+void
+GetMotionCompressionStats(ChunkTransportState *transportStates,
+						  int16 motNodeID,
+						  uint64 *rawBytes,
+						  uint64 *wireBytes)
+{
+	ChunkTransportStateEntry *pEntry;
+	int			i;
+
+	*rawBytes = 0;
+	*wireBytes = 0;
+
+	if (!transportStates || !transportStates->activated ||
+		motNodeID <= 0 || motNodeID > transportStates->size)
+		return;
+
+	pEntry = &transportStates->states[motNodeID - 1];
+	if (!pEntry->valid || pEntry->motNodeId != motNodeID)
+		return;
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		*rawBytes += pEntry->conns[i].stat_raw_bytes;
+		*wireBytes += pEntry->conns[i].stat_wire_bytes;
+	}
+}
+
+/*
+ * Send a runtime filter to all the senders of a motion node.  A filter is
+ * only an optimization: if the transport can't deliver it to a sender, that
+ * sender just doesn't filter.
+ */
+void
+SendMotionRuntimeFilter(ChunkTransportState *transportStates,
+						int16 motNodeID,
+						const char *data, int len)
+{
+	Assert(len <= MAX_RUNTIME_FILTER_MSG_SIZE);
+
+	if (transportStates != NULL && transportStates->activated &&
+		transportStates->doSendRuntimeFilter != NULL)
+		transportStates->doSendRuntimeFilter(transportStates, motNodeID,
+											 data, len);
+}
+
+int
+GetMotionRuntimeFilterCount(ChunkTransportState *transportStates,
+							int16 motNodeID, int *numRoutes)
+{
+	ChunkTransportStateEntry *pEntry;
+
+	*numRoutes = 0;
+
+	if (!transportStates || !transportStates->activated ||
+		motNodeID <= 0 || motNodeID > transportStates->size)
+		return 0;
+
+	pEntry = &transportStates->states[motNodeID - 1];
+	if (!pEntry->valid || pEntry->motNodeId != motNodeID)
+		return 0;
+
+	*numRoutes = pEntry->numConns;
+	return pEntry->numRuntimeFilters;
+}
+
+const char *
+GetMotionRuntimeFilter(ChunkTransportState *transportStates,
+					   int16 motNodeID, int route, int *len)
+{
+	ChunkTransportStateEntry *pEntry;
+	int			numRoutes;
+
+	*len = 0;
+
+	if (GetMotionRuntimeFilterCount(transportStates, motNodeID, &numRoutes) == 0 ||
+		route < 0 || route >= numRoutes)
+		return NULL;
+
+	pEntry = &transportStates->states[motNodeID - 1];
+
+	*len = pEntry->conns[route].runtimeFilterLen;
+	return pEntry->conns[route].runtimeFilter;
+}
+
+/*
+ * Keep a runtime filter received on a connection.  A filter sent again
+ * replaces the first one.
+ */
+void
+SaveMotionRuntimeFilter(ChunkTransportStateEntry *pEntry, MotionConn *conn,
+						const char *data, int len)
+{
+	if (len <= 0 || len > MAX_RUNTIME_FILTER_MSG_SIZE)
+		return;
+
+	if (conn->runtimeFilter == NULL)
+		pEntry->numRuntimeFilters++;
+	else
+		pfree(conn->runtimeFilter);
+
+	conn->runtimeFilter = MemoryContextAlloc(InterconnectContext, len);
+	memcpy(conn->runtimeFilter, data, len);
+	conn->runtimeFilterLen = len;
+}
+
 void
 SetupInterconnect(EState *estate)
 {
@@ -631,6 +739,9 @@ createChunkTransportState(ChunkTransportState *transportStates,
 	pEntry->motNodeId = motNodeID;
 	pEntry->numConns = numConns;
 	pEntry->scanStart = 0;
+	pEntry->readyRing = NULL;
+	pEntry->numShmConns = 0;
+	pEntry->numRuntimeFilters = 0;
 	pEntry->sendSlice = sendSlice;
 	pEntry->recvSlice = recvSlice;
 
@@ -651,6 +762,12 @@ createChunkTransportState(ChunkTransportState *transportStates,
 		conn->cdbProc = NULL;
 		conn->sent_record_typmod = 0;
 		conn->remapper = NULL;
+		conn->shmRing = NULL;
+		conn->runtimeFilter = NULL;
+		conn->runtimeFilterLen = 0;
+		conn->runtimeFilterMsg = NULL;
+		conn->runtimeFilterMsgLen = 0;
+		conn->runtimeFilterMsgDone = 0;
 	}
 
 	return pEntry;
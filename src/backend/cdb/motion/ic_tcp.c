@@ -22,6 +22,7 @@
 #include "libpq/ip.h"
 #include "postmaster/postmaster.h"
 #include "utils/builtins.h"
+#include "utils/memutils.h"
 
 #include "cdb/cdbselect.h"
 #include "cdb/tupchunklist.h"
@@ -63,6 +64,9 @@ static inline int timeCmp(struct timeval *t1, struct timeval *t2);
 #define CONNECT_RETRY_MS	4000
 #define CONNECT_AGGRESSIVERETRY_MS	500
 
+/* a runtime filter message starts with an 'F' and the length of the filter */
+#define RUNTIME_FILTER_MSG_HDR_SIZE (1 + sizeof(uint32))
+
 /* listener backlog is calculated at listener-creation time */
 int			listenerBacklog = 128;
 
@@ -115,6 +119,12 @@ static bool flushBuffer(ChunkTransportState *transportStates,
 			ChunkTransportStateEntry *pEntry, MotionConn *conn, int16 motionId);
 
 static void doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID);
+static void doSendRuntimeFilterTCP(ChunkTransportState *transportStates, int16 motNodeID,
+					   const char *data, int len);
+static void sendRuntimeFilterMsg(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+static void sendPendingRuntimeFilters(ChunkTransportStateEntry *pEntry);
+static void discardRuntimeFilterMsg(MotionConn *conn);
+static bool readReceiverMessages(ChunkTransportStateEntry *pEntry, MotionConn *conn);
 
 #ifdef AMS_VERBOSE_LOGGING
 static void dumpEntryConnections(int elevel, ChunkTransportStateEntry *pEntry);
@@ -1257,6 +1267,7 @@ SetupTCPInterconnect(EState *estate)
 	interconnect_context->SendEos = SendEosTCP;
 	interconnect_context->SendChunk = SendChunkTCP;
 	interconnect_context->doSendStopMessage = doSendStopMessageTCP;
+	interconnect_context->doSendRuntimeFilter = doSendRuntimeFilterTCP;
 
 	mySlice = &interconnect_context->sliceTable->slices[sliceTable->localSlice];
 
@@ -1955,6 +1966,9 @@ TeardownTCPInterconnect(ChunkTransportState *transportStates, bool hasErrors)
 		{
 			conn = pEntry->conns + i;
 
+			/* the sender has no use for the rest of a runtime filter */
+			discardRuntimeFilterMsg(conn);
+
 			if (conn->sockfd >= 0)
 			{
 				flushIncomingData(conn->sockfd);
@@ -2309,6 +2323,10 @@ waitOnOutbound(ChunkTransportStateEntry *pEntry)
 				int			count;
 				char		buf;
 
+				/* runtime filters that came too late */
+				if (!readReceiverMessages(pEntry, conn))
+					continue;
+
 				/* ready to read. */
 				count = recv(conn->sockfd, &buf, sizeof(buf), 0);
 
@@ -2364,6 +2382,28 @@ doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID)
 	{
 		conn = pEntry->conns + i;
 
+		if (conn->sockfd >= 0 &&
+			MPP_FD_ISSET(conn->sockfd, &pEntry->readSet) &&
+			conn->runtimeFilterMsg != NULL)
+		{
+			/*
+			 * The stop message can't go in the middle of a runtime filter
+			 * message.  If the socket buffer doesn't take the rest of it, shut
+			 * down our side of the connection instead: the sender takes that
+			 * as a stop message too.
+			 */
+			sendRuntimeFilterMsg(pEntry, conn);
+			if (conn->runtimeFilterMsg != NULL)
+			{
+				discardRuntimeFilterMsg(conn);
+				pEntry->numRuntimeFilters--;
+				shutdown(conn->sockfd, SHUT_WR);
+				DeregisterReadInterest(transportStates, motNodeID, i,
+									   "no more input needed");
+				continue;
+			}
+		}
+
 		if (conn->sockfd >= 0 &&
 			MPP_FD_ISSET(conn->sockfd, &pEntry->readSet))
 		{
@@ -2394,6 +2434,212 @@ doSendStopMessageTCP(ChunkTransportState *transportStates, int16 motNodeID)
 	}
 }
 
+/*
+ * Send a runtime filter to the senders we still read from.  The message is
+ * an 'F', the length of the filter and the filter.  It is written without
+ * waiting for the senders: what the socket buffer of a connection doesn't
+ * take is kept on the connection, and sendPendingRuntimeFilters() writes it
+ * as we go on receiving.
+ */
+static void
+doSendRuntimeFilterTCP(ChunkTransportState *transportStates, int16 motNodeID,
+					   const char *data, int len)
+{
+	ChunkTransportStateEntry *pEntry = NULL;
+	uint32		len32 = len;
+	int			i;
+
+	getChunkTransportState(transportStates, motNodeID, &pEntry);
+	Assert(pEntry);
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *conn = pEntry->conns + i;
+		int			pending;
+		char	   *msg;
+
+		if (conn->sockfd < 0 ||
+			!MPP_FD_ISSET(conn->sockfd, &pEntry->readSet))
+			continue;
+
+		/* a filter sent again goes after the rest of the previous one */
+		pending = conn->runtimeFilterMsgLen - conn->runtimeFilterMsgDone;
+		msg = MemoryContextAlloc(InterconnectContext,
+								 pending + RUNTIME_FILTER_MSG_HDR_SIZE + len);
+		if (conn->runtimeFilterMsg != NULL)
+		{
+			memcpy(msg, conn->runtimeFilterMsg + conn->runtimeFilterMsgDone,
+				   pending);
+			pfree(conn->runtimeFilterMsg);
+		}
+		else
+			pEntry->numRuntimeFilters++;
+
+		msg[pending] = 'F';
+		memcpy(msg + pending + 1, &len32, sizeof(len32));
+		memcpy(msg + pending + RUNTIME_FILTER_MSG_HDR_SIZE, data, len);
+
+		conn->runtimeFilterMsg = msg;
+		conn->runtimeFilterMsgLen = pending + RUNTIME_FILTER_MSG_HDR_SIZE + len;
+		conn->runtimeFilterMsgDone = 0;
+
+		sendRuntimeFilterMsg(pEntry, conn);
+	}
+}
+
+/*
+ * Write as much as the socket buffer takes of the runtime filter message
+ * kept on a connection.  The message is discarded once it is all written,
+ * or if the sender went away.
+ */
+static void
+sendRuntimeFilterMsg(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	while (conn->runtimeFilterMsgDone < conn->runtimeFilterMsgLen)
+	{
+		ssize_t		n;
+
+		n = send(conn->sockfd, conn->runtimeFilterMsg + conn->runtimeFilterMsgDone,
+				 conn->runtimeFilterMsgLen - conn->runtimeFilterMsgDone, 0);
+		if (n > 0)
+		{
+			conn->runtimeFilterMsgDone += n;
+			continue;
+		}
+
+		if (n < 0 && errno == EINTR)
+			continue;
+
+		/* the rest goes when the sender has read some of what it got */
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return;
+
+		/* the sender is gone; it has no use for the filter */
+		elog(LOG, "SendRuntimeFilter: failed on write.  %m");
+		break;
+	}
+
+	discardRuntimeFilterMsg(conn);
+	pEntry->numRuntimeFilters--;
+}
+
+/*
+ * Called by a receiver, to go on writing the runtime filter messages that
+ * didn't fit in the socket buffers.  The senders that are done don't need
+ * theirs anymore.
+ */
+static void
+sendPendingRuntimeFilters(ChunkTransportStateEntry *pEntry)
+{
+	int			i;
+
+	for (i = 0; i < pEntry->numConns && pEntry->numRuntimeFilters > 0; i++)
+	{
+		MotionConn *conn = pEntry->conns + i;
+
+		if (conn->runtimeFilterMsg == NULL)
+			continue;
+
+		if (conn->sockfd < 0 ||
+			!MPP_FD_ISSET(conn->sockfd, &pEntry->readSet))
+		{
+			discardRuntimeFilterMsg(conn);
+			pEntry->numRuntimeFilters--;
+		}
+		else
+			sendRuntimeFilterMsg(pEntry, conn);
+	}
+}
+
+/*
+ * Forget the runtime filter message being written by a receiver, or read by
+ * a sender, on a connection.  Receivers, which count the messages they still
+ * have to write in numRuntimeFilters, take it off the count themselves.
+ */
+static void
+discardRuntimeFilterMsg(MotionConn *conn)
+{
+	if (conn->runtimeFilterMsg == NULL)
+		return;
+
+	pfree(conn->runtimeFilterMsg);
+	conn->runtimeFilterMsg = NULL;
+	conn->runtimeFilterMsgLen = 0;
+	conn->runtimeFilterMsgDone = 0;
+}
+
+/*
+ * Called by a sender when its connection is readable.  Reads what has
+ * arrived of the runtime filter messages the receiver sent, without waiting
+ * for the rest, and keeps the filters that are complete.  Returns true if
+ * there is something else: a stop message, or the receiver has torn down the
+ * interconnect.  Those are left unread.
+ */
+static bool
+readReceiverMessages(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	for (;;)
+	{
+		ssize_t		n;
+
+		if (conn->runtimeFilterMsg == NULL)
+		{
+			char		m;
+
+			n = recv(conn->sockfd, &m, sizeof(m), MSG_PEEK);
+			if (n < 0 && errno == EINTR)
+				continue;
+			if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+				return false;
+			if (n != sizeof(m) || m != 'F')
+				return true;
+
+			/* read the header first, to learn the length of the filter */
+			conn->runtimeFilterMsg =
+				MemoryContextAlloc(InterconnectContext,
+								   RUNTIME_FILTER_MSG_HDR_SIZE + MAX_RUNTIME_FILTER_MSG_SIZE);
+			conn->runtimeFilterMsgLen = RUNTIME_FILTER_MSG_HDR_SIZE;
+			conn->runtimeFilterMsgDone = 0;
+		}
+
+		n = recv(conn->sockfd, conn->runtimeFilterMsg + conn->runtimeFilterMsgDone,
+				 conn->runtimeFilterMsgLen - conn->runtimeFilterMsgDone, 0);
+		if (n < 0 && errno == EINTR)
+			continue;
+		if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+			return false;
+		if (n <= 0)
+		{
+			/* the receiver went away in the middle of the message */
+			discardRuntimeFilterMsg(conn);
+			return true;
+		}
+
+		conn->runtimeFilterMsgDone += n;
+		if (conn->runtimeFilterMsgDone < conn->runtimeFilterMsgLen)
+			continue;
+
+		if (conn->runtimeFilterMsgLen == RUNTIME_FILTER_MSG_HDR_SIZE)
+		{
+			uint32		len;
+
+			memcpy(&len, conn->runtimeFilterMsg + 1, sizeof(len));
+			if (len == 0 || len > MAX_RUNTIME_FILTER_MSG_SIZE)
+			{
+				discardRuntimeFilterMsg(conn);
+				return true;
+			}
+			conn->runtimeFilterMsgLen += len;
+			continue;
+		}
+
+		SaveMotionRuntimeFilter(pEntry, conn,
+								conn->runtimeFilterMsg + RUNTIME_FILTER_MSG_HDR_SIZE,
+								conn->runtimeFilterMsgLen - RUNTIME_FILTER_MSG_HDR_SIZE);
+		discardRuntimeFilterMsg(conn);
+	}
+}
+
 static TupleChunkListItem
 RecvTupleChunkFromTCP(ChunkTransportState *transportStates,
 					  int16 motNodeID,
@@ -2412,6 +2658,9 @@ RecvTupleChunkFromTCP(ChunkTransportState *transportStates,
 	getChunkTransportState(transportStates, motNodeID, &pEntry);
 	conn = pEntry->conns + srcRoute;
 
+	if (pEntry->numRuntimeFilters > 0)
+		sendPendingRuntimeFilters(pEntry);
+
 	return RecvTupleChunk(conn, transportStates);
 }
 
@@ -2455,6 +2704,9 @@ RecvTupleChunkFromAnyTCP(ChunkTransportState *transportStates,
 		/* make sure we check for these. */
 		ML_CHECK_FOR_INTERRUPTS(transportStates->teardownActive);
 
+		if (pEntry->numRuntimeFilters > 0)
+			sendPendingRuntimeFilters(pEntry);
+
 		memcpy(&rset, &pEntry->readSet, sizeof(mpp_fd_set));
 
 		/*
@@ -2634,7 +2886,8 @@ flushBuffer(ChunkTransportState *transportStates,
 		 */
 		n = select(conn->sockfd + 1, (fd_set *) &rset, NULL, NULL, &timeout);
 		/* handle errors at the write call, below */
-		if (n > 0 && MPP_FD_ISSET(conn->sockfd, &rset))
+		if (n > 0 && MPP_FD_ISSET(conn->sockfd, &rset) &&
+			readReceiverMessages(pEntry, conn))
 		{
 #ifdef AMS_VERBOSE_LOGGING
 			print_connection(transportStates, conn->sockfd, "stop from");
@@ -2689,11 +2942,14 @@ flushBuffer(ChunkTransportState *transportStates,
 					}
 
 					/*
-					 * as a sender... if there is something to read... it must
-					 * mean its a StopSendingMessage or receiver has teared down
-					 * the interconnect, we don't even bother to read it.
+					 * as a sender... if there is something to read other than
+					 * a runtime filter... it must mean its a
+					 * StopSendingMessage or receiver has teared down the
+					 * interconnect, we don't even bother to read it.
 					 */
-					if (MPP_FD_ISSET(conn->sockfd, &rset) || transportStates->teardownActive)
+					if (transportStates->teardownActive ||
+						(MPP_FD_ISSET(conn->sockfd, &rset) &&
+						 readReceiverMessages(pEntry, conn)))
 					{
 #ifdef AMS_VERBOSE_LOGGING
 						print_connection(transportStates, conn->sockfd, "stop from");
@@ -2701,6 +2957,10 @@ flushBuffer(ChunkTransportState *transportStates,
 						conn->stillActive = false;
 						return false;
 					}
+
+					/* a runtime filter came in while we wait for room */
+					if (MPP_FD_ISSET(conn->sockfd, &rset))
+						SIMPLE_FAULT_INJECTOR("interconnect_tcp_filter_while_blocked");
 				} while (n < 1);
 			}
 			else
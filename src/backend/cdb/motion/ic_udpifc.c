@@ -28,6 +28,7 @@
 
 #include "access/transam.h"
 #include "access/xact.h"
+#include "funcapi.h"
 #include "nodes/execnodes.h"
 #include "nodes/pg_list.h"
 #include "nodes/print.h"
@@ -36,13 +37,21 @@
 #include "libpq/ip.h"
 #include "port/atomics.h"
 #include "port/pg_crc32c.h"
+#include "portability/mem.h"
 #include "postmaster/postmaster.h"
+#include "storage/dsm_impl.h"
+#include "storage/fd.h"
 #include "storage/latch.h"
 #include "storage/pmsignal.h"
+#include "storage/s_lock.h"
+#include "storage/shmem.h"
+#include "storage/spin.h"
 #include "utils/builtins.h"
 #include "utils/guc.h"
 #include "utils/memutils.h"
 #include "utils/faultinjector.h"
+#include "utils/timestamp.h"
+#include "utils/tuplestore.h"
 
 #include "cdb/tupchunklist.h"
 #include "cdb/ml_ipc.h"
@@ -56,6 +65,14 @@
 #include <unistd.h>
 #include <arpa/inet.h>
 #include <netinet/in.h>
+#ifndef WIN32
+#include <sys/mman.h>
+#endif
+#include <sys/stat.h>
+
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+#endif
 
 #ifdef WIN32
 #define WIN32_LEAN_AND_MEAN
@@ -138,6 +155,21 @@ int
 /* 1/4 sec in msec */
 #define RX_THREAD_POLL_TIMEOUT (250)
 
+/*
+ * Batched packet I/O.
+ *
+ * When gp_interconnect_batch_syscalls is on, and the platform provides
+ * sendmmsg()/recvmmsg() (MSG_WAITFORONE is defined together with them),
+ * sendBuffers() hands the packets it drains from a send queue to the kernel
+ * with one sendmmsg() call, and the rx thread reads up to MMSG_BATCH_SIZE
+ * datagrams per recvmmsg() call.
+ */
+#if defined(MSG_WAITFORONE) && !defined(WIN32)
+#define HAVE_UDPIFC_MMSG
+#endif
+
+#define MMSG_BATCH_SIZE (32)
+
 /*
  * Flags definitions for flag-field of UDP-messages
  *
@@ -151,6 +183,35 @@ int
 #define UDPIC_FLAGS_DISORDER    		(32)
 #define UDPIC_FLAGS_DUPLICATE   		(64)
 #define UDPIC_FLAGS_CAPACITY    		(128)
+#define UDPIC_FLAGS_COMPRESSED			(256)
+#define UDPIC_FLAGS_SHM_WAKEUP			(512)
+#define UDPIC_FLAGS_RUNTIME_FILTER		(1024)
+#define UDPIC_FLAGS_SHM_OFFER			(2048)
+
+/*
+ * Size of the control packets that carry a runtime filter, from a receiver
+ * to a sender.  The buffer senders read acks into must hold them.
+ */
+#define RUNTIME_FILTER_PACKET_SIZE \
+	(sizeof(icpkthdr) + MAX_RUNTIME_FILTER_MSG_SIZE)
+
+/*
+ * Data packet compression (gp_interconnect_compression).
+ *
+ * The payload of a data packet, everything after the icpkthdr, is replaced
+ * by a zstd frame and the packet is marked with UDPIC_FLAGS_COMPRESSED.  The
+ * receiver decompresses it in place before parsing chunks out of it.
+ *
+ * Packets with a payload smaller than COMPRESS_MIN_PAYLOAD are sent as is.
+ * If compressing a packet saves less than 1/COMPRESS_MIN_SAVING_FRACTION of
+ * its payload, the connection sends the next packets uncompressed, doubling
+ * that number each time up to COMPRESS_MAX_BACKOFF, so that streams of
+ * incompressible data spend little CPU on it.
+ */
+#define COMPRESS_LEVEL					(1)
+#define COMPRESS_MIN_PAYLOAD			(256)
+#define COMPRESS_MIN_SAVING_FRACTION	(8)
+#define COMPRESS_MAX_BACKOFF			(64)
 
 /*
  * ConnHtabBin
@@ -258,6 +319,113 @@ struct ThreadWaitingState
 	int			waitingQuery;
 };
 
+/*
+ * ICReadyRing
+ *
+ * Lock-free single-producer/single-consumer ring of routes, one per
+ * receiving motion node.  The rx thread is the only producer: it pushes a
+ * connection's route when a packet lands at the head of that connection's
+ * packet queue.  The main thread is the only consumer: a non-directed
+ * receive pops routes from it to find a connection with data, without
+ * taking ic_control_info.lock or scanning all the connections.
+ *
+ * Entries are only hints.  A route can be stale by the time it is popped
+ * (its packet consumed by a directed receive, say), and the producer drops
+ * new entries when the ring is full.  The consumer therefore checks the
+ * connection's queue head itself, and falls back to the locked scan when the
+ * ring yields nothing.
+ */
+typedef struct ICReadyRing ICReadyRing;
+struct ICReadyRing
+{
+	pg_atomic_uint32 head;		/* next slot to pop, advanced by main thread */
+	pg_atomic_uint32 tail;		/* next slot to push, advanced by rx thread */
+	uint32		mask;			/* capacity - 1, capacity is a power of 2 */
+	uint16		routes[FLEXIBLE_ARRAY_MEMBER];
+};
+
+#define READY_RING_MIN_CAPACITY (16)
+
+/*
+ * ICShmRing
+ *
+ * Single-producer/single-consumer ring of data packets in POSIX shared
+ * memory, used instead of the socket for a connection whose sender and
+ * receiver run on the same host (gp_interconnect_local_shm).  Each slot holds
+ * one packet, laid out exactly as it would have been sent with sendto().  The
+ * receiver queues pointers to the slots in the connection's pkt_q, so that
+ * the packets are parsed in place, and hands a slot back by advancing head
+ * when the buffer is released.  There is no CRC, ack or retransmission, and
+ * the packets are never compressed.
+ *
+ * The segments of a host run under different postmasters, so the ring can't
+ * be a DSM segment, those are registered in one postmaster's control
+ * segment.  The sender alone decides to use a ring: it creates the shm object
+ * with O_EXCL, under a name prefixed with its postmaster's pid, and offers it
+ * with a header-only UDPIC_FLAGS_SHM_OFFER packet that carries that pid.  The
+ * receiver's rx thread maps the object and moves state from IC_SHM_OFFERED to
+ * IC_SHM_ACCEPTED, or answers with an UDPIC_FLAGS_SHM_OFFER ack to decline.
+ * A sender that is declined, or hears nothing within IC_SHM_OFFER_TIMEOUT_MS,
+ * moves state to IC_SHM_DECLINED itself.  Either way the compare-and-swap
+ * settles who won, and nothing is written into the ring before that, so a
+ * connection that falls back to the socket hasn't lost any packets.  A
+ * freshly sized object is zero-filled, which is an empty ring in the
+ * IC_SHM_OFFERED state.  The geometry comes from GUCs that must agree between
+ * sender and receiver anyway, the receiver declines a ring of another size.
+ *
+ * An end that is about to sleep sets its *Waiting flag and looks at the ring
+ * once more.  The other end clears the flag after making progress and sends
+ * a header-only UDPIC_FLAGS_SHM_WAKEUP packet: to the receiver's listener,
+ * where the rx thread sets the latch, or to the sender's ack socket.
+ *
+ * The receiver unlinks the object as soon as it has accepted it, the sender
+ * when it withdraws the offer.  Objects left behind by a crash in between are
+ * removed by ICShmRingCleanup() when the postmaster (re)initializes shared
+ * memory.
+ */
+#if defined(USE_DSM_POSIX) && !defined(PG_HAVE_ATOMIC_U32_SIMULATION)
+#define IC_SHM_TRANSPORT
+#endif
+
+typedef struct ICShmRing ICShmRing;
+struct ICShmRing
+{
+	/* IC_SHM_OFFERED, IC_SHM_ACCEPTED or IC_SHM_DECLINED */
+	pg_atomic_uint32 state;
+
+	/* written by the sender */
+	pg_atomic_uint32 tail;				/* packets published */
+	pg_atomic_uint32 receiverWaiting;	/* cleared by the sender */
+
+	/* keep tail and head on different cache lines */
+	char		pad[PG_CACHE_LINE_SIZE];
+
+	/* written by the receiver */
+	pg_atomic_uint32 head;				/* packets released */
+	pg_atomic_uint32 received;			/* packets moved into pkt_q */
+	pg_atomic_uint32 stopRequested;
+	pg_atomic_uint32 senderWaiting;		/* cleared by the receiver */
+};
+
+#define IC_SHM_RING_SLOTS \
+	(Gp_interconnect_queue_depth + Gp_interconnect_snd_queue_depth)
+#define IC_SHM_RING_HEADER_SIZE CACHELINEALIGN(sizeof(ICShmRing))
+#define IC_SHM_RING_SLOT_SIZE MAXALIGN(Gp_max_packet_size)
+
+#define IC_SHM_OFFERED	(0)
+#define IC_SHM_ACCEPTED	(1)
+#define IC_SHM_DECLINED	(2)
+
+/* name of the shm object, as it is listed in IC_SHM_DIR */
+#define IC_SHM_PREFIX "gpic."
+#define IC_SHM_DIR "/dev/shm"
+
+/* how long to sleep at most, in case a wakeup packet is lost */
+#define IC_SHM_WAIT_TIMEOUT_MS (10)
+
+/* how long a sender waits for its offer to be taken up */
+#define IC_SHM_OFFER_TIMEOUT_MS (1000)
+
 /*
  * ReceiveControlInfo
  *
@@ -277,6 +445,11 @@ struct ReceiveControlInfo
 	 */
 	icpkthdr   *disorderBuffer;
 
+	/*
+	 * Buffer used by the main thread to assemble runtime filter messages.
+	 */
+	icpkthdr   *runtimeFilterBuffer;
+
 	/* The last interconnect instance id which is torn down. */
 	uint32		lastTornIcId;
 
@@ -383,6 +556,72 @@ struct SendControlInfo
  */
 static SendControlInfo snd_control_info;
 
+/*
+ * ICConnStatsEntry
+ *
+ * The flow control and compression state of an outgoing connection, and the
+ * transport it ended up using, recorded when its sending motion is torn down.  Shown by the gp_interconnect_conn_stats view.
+ */
+typedef struct ICConnStatsEntry
+{
+	int32		pid;
+	int32		sessionId;
+	int32		icId;
+	int32		motNodeId;
+	int32		dstContentId;
+	int32		fcMethod;
+	float		cwnd;			/* negative if the method has no window */
+	uint64		srtt;
+	uint64		minRtt;			/* bbr only */
+	float		bw;				/* bbr only */
+	uint64		sentPkts;
+	uint64		retransmits;
+	uint64		compressedPkts;
+	uint64		compressSavedBytes;
+	bool		shm;			/* went through a shared memory ring */
+	TimestampTz endTime;
+} ICConnStatsEntry;
+
+/*
+ * ICSyscallStatsEntry
+ *
+ * The send and receive syscalls of a backend for one interconnect instance,
+ * recorded when it is torn down.  Shown by the gp_interconnect_syscall_stats
+ * view, to tell how many packets gp_interconnect_batch_syscalls handled per
+ * syscall.
+ */
+typedef struct ICSyscallStatsEntry
+{
+	int32		pid;
+	int32		sessionId;
+	int32		icId;
+	uint64		sentPkts;		/* data packets handed to send syscalls */
+	uint64		sendCalls;
+	uint64		rxDatagrams;	/* datagrams read by the rx thread */
+	uint64		rxCalls;
+	TimestampTz endTime;
+} ICSyscallStatsEntry;
+
+/*
+ * ICConnStatsShmem
+ *
+ * Rings of the most recently closed outgoing connections, and of the most
+ * recent syscall counts, of all the backends, in shared memory.
+ */
+#define IC_CONN_STATS_SLOTS (1024)
+#define IC_SYSCALL_STATS_SLOTS (1024)
+
+typedef struct ICConnStatsShmem
+{
+	slock_t		mutex;
+	uint64		count;			/* number of entries ever recorded */
+	ICConnStatsEntry entries[IC_CONN_STATS_SLOTS];
+	uint64		syscallCount;	/* number of syscall entries ever recorded */
+	ICSyscallStatsEntry syscallEntries[IC_SYSCALL_STATS_SLOTS];
+} ICConnStatsShmem;
+
+static ICConnStatsShmem *ic_conn_stats = NULL;
+
 /*
  * ICGlobalControlInfo
  *
@@ -524,6 +763,46 @@ static ICGlobalControlInfo ic_control_info;
 
 #define MAX_SEQS_IN_DISORDER_ACK (4)
 
+/*
+ * Loss based and bbr flow control both put the unacked packets into the unack
+ * queue ring, and retransmit them when they expire there.  They differ in how
+ * the sending rate is limited.
+ */
+#define UNACK_QUEUE_RING_ENABLED() \
+	(Gp_interconnect_fc_method != INTERCONNECT_FC_METHOD_CAPACITY)
+
+/*
+ * BBR flow control
+ *
+ * For each connection, the sender estimates the bottleneck bandwidth (the max
+ * delivery rate seen in the last IC_BBR_BW_FILTER_ROUNDS round trips) and the
+ * minimal RTT (the min RTT seen in the last BBR_MIN_RTT_WINDOW).  Packets are
+ * paced out at pacingGain times the bandwidth, and at most cwnd packets,
+ * cwnd being a multiple of the bandwidth-delay product, are in flight.
+ *
+ * STARTUP doubles the sending rate each round trip, until the bandwidth
+ * stops growing by 25% for 3 rounds.  DRAIN then empties the queue that
+ * built up, and PROBE_BW cycles the pacing gain around 1 to probe for more
+ * bandwidth and to give it back.  Packet losses don't change the rate, they
+ * are only retransmitted.
+ */
+#define BBR_STARTUP (0)
+#define BBR_DRAIN (1)
+#define BBR_PROBE_BW (2)
+
+#define BBR_HIGH_GAIN (2.885f)	/* 2/ln(2) */
+#define BBR_DRAIN_GAIN (1.0f / BBR_HIGH_GAIN)
+#define BBR_CWND_GAIN (2.0f)
+#define BBR_GAIN_CYCLE_LEN (8)
+#define BBR_FULL_BW_THRESHOLD (1.25f)
+#define BBR_FULL_BW_ROUNDS (3)
+#define BBR_MIN_CWND (4)
+#define BBR_MIN_RTT_WINDOW (10 * USECS_PER_SECOND)	/* 10s */
+
+static const float bbrPacingGainCycle[BBR_GAIN_CYCLE_LEN] = {
+	1.25f, 0.75f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f, 1.0f
+};
+
 /*
  * UnackQueueRing
  *
@@ -609,6 +888,10 @@ typedef struct AckSendParam
  * duplicatedPktNum          - duplicate packet number.
  * recvAckNum                - the number of Acks received.
  * statusQueryMsgNum         - the number of status query messages sent.
+ * sndSyscallNum             - the number of syscalls used to send data packets.
+ * sndSyscallPktNum          - the number of data packets sent with sndSyscallNum syscalls.
+ * rxDatagramNum             - the number of datagrams read by the rx thread.
+ * rxSyscallNum              - the number of syscalls used to read rxDatagramNum datagrams.
  *
  */
 typedef struct ICStatistics
@@ -630,11 +913,33 @@ typedef struct ICStatistics
 	int32		duplicatedPktNum;
 	int32		recvAckNum;
 	int32		statusQueryMsgNum;
+	int32		sndSyscallNum;
+	int32		sndSyscallPktNum;
+	int32		rxDatagramNum;
+	int32		rxSyscallNum;
 } ICStatistics;
 
 /* Statistics for UDP interconnect. */
 static ICStatistics ic_statistics;
 
+#ifdef HAVE_UDPIFC_MMSG
+/*
+ * SendBatch
+ *
+ * Packets collected by sendBuffers() for a single sendmmsg() call. All the
+ * packets of a batch belong to the same connection. Only used by the main
+ * thread.
+ */
+typedef struct SendBatch
+{
+	int			count;
+	struct iovec iov[MMSG_BATCH_SIZE];
+	struct mmsghdr msgs[MMSG_BATCH_SIZE];
+} SendBatch;
+
+static SendBatch snd_batch;
+#endif
+
 /*=========================================================================
  * STATIC FUNCTIONS declarations
  */
@@ -708,6 +1013,30 @@ static void TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportSt
 static void freeDisorderedPackets(MotionConn *conn);
 
 static void prepareRxConnForRead(MotionConn *conn);
+static ICReadyRing *createReadyRing(int numConns);
+static inline void readyRingPush(ICReadyRing *ring, uint16 route);
+static inline int readyRingPop(ICReadyRing *ring);
+static MotionConn *popReadyConn(ChunkTransportStateEntry *pEntry);
+static bool isLocalAddress(const struct sockaddr_storage *addr);
+static bool createShmRing(MotionConn *conn);
+static bool acceptShmRing(MotionConn *conn, int postmasterPid);
+static void detachShmRing(MotionConn *conn);
+static void pumpShmConn(MotionConn *conn);
+static MotionConn *pumpShmConns(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+static bool shmConnsReady(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+static void setShmReceiverWaiting(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+static void releaseShmPacket(MotionConn *conn, AckSendParam *param);
+static void wakeShmSender(MotionConn *conn, AckSendParam *param);
+static bool waitShmRing(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+						MotionConn *conn, bool drain, bool *gotStops);
+static bool sendShmPacket(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+						  MotionConn *conn, bool *gotStops);
+static void awaitShmAccept(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+						   MotionConn *conn, bool *gotStops);
+static void sendShmMessage(ChunkTransportStateEntry *pEntry, MotionConn *conn,
+						   int32 flags, uint32 extraSeq);
+static void handleShmWakeup(icpkthdr *pkt, struct sockaddr_storage *peer, socklen_t peerlen);
+static void handleShmOffer(icpkthdr *pkt, struct sockaddr_storage *peer, socklen_t peerlen);
 static TupleChunkListItem RecvTupleChunkFromAnyUDPIFC(ChunkTransportState *transportStates,
 							int16 motNodeID,
 							int16 *srcRoute);
@@ -724,11 +1053,16 @@ static bool SendChunkUDPIFC(ChunkTransportState *transportStates,
 				ChunkTransportStateEntry *pEntry, MotionConn *conn, TupleChunkListItem tcItem, int16 motionId);
 
 static void doSendStopMessageUDPIFC(ChunkTransportState *transportStates, int16 motNodeID);
+static void doSendRuntimeFilterUDPIFC(ChunkTransportState *transportStates, int16 motNodeID,
+						  const char *data, int len);
+static void sendRuntimeFilter(MotionConn *conn);
+static void sendPendingRuntimeFilters(ChunkTransportStateEntry *pEntry);
 static bool dispatcherAYT(void);
 static void checkQDConnectionAlive(void);
 
 
 static void *rxThreadFunc(void *arg);
+static bool handleRxPacket(icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t peerlen);
 
 static bool handleMismatch(icpkthdr *pkt, struct sockaddr_storage *peer, int peer_len);
 static void handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now);
@@ -740,11 +1074,23 @@ static bool handleAckForDuplicatePkt(MotionConn *conn, icpkthdr *pkt);
 static bool handleAckForDisorderPkt(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn, icpkthdr *pkt);
 
 static inline void prepareXmit(MotionConn *conn);
+static void compressPacket(MotionConn *conn);
+static void decompressRxPacket(MotionConn *conn);
 static inline void addCRC(icpkthdr *pkt);
 static inline bool checkCRC(icpkthdr *pkt);
 static void sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn);
 static void sendOnce(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+#ifdef HAVE_UDPIFC_MMSG
+static void addToSendBatch(ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn);
+static void flushSendBatch(ChunkTransportStateEntry *pEntry, MotionConn *conn);
+#endif
 static inline uint64 computeExpirationPeriod(MotionConn *conn, uint32 retry);
+static void bbrInit(MotionConn *conn);
+static inline bool bbrCanSend(MotionConn *conn, uint64 now);
+static inline void bbrOnSend(MotionConn *conn, ICBuffer *buf, uint64 now);
+static void bbrOnAck(MotionConn *conn, ICBuffer *buf, uint64 ackTime, uint64 now);
+static void recordConnStats(MotionConn *conn);
+static void recordSyscallStats(int icId);
 
 static ICBuffer *getSndBuffer(MotionConn *conn);
 static void initSndBufferPool();
@@ -886,6 +1232,12 @@ dumpTransProtoStats()
 	FILE	   *ofile = fopen(tmpbuf, "w+");
 
 	pthread_mutex_lock(&trans_proto_stats.lock);
+
+	/* packets per syscall, see gp_interconnect_batch_syscalls */
+	fprintf(ofile, "snd pkts %d syscalls %d rx pkts %d syscalls %d\n",
+			ic_statistics.sndPktNum, ic_statistics.sndSyscallNum,
+			ic_statistics.rxDatagramNum, ic_statistics.rxSyscallNum);
+
 	while (trans_proto_stats.head)
 	{
 		TransProtoStatEntry *cur = NULL;
@@ -1452,6 +1804,7 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 
 	/* allocate a buffer for sending disorder messages */
 	rx_control_info.disorderBuffer = palloc0(MIN_PACKET_SIZE);
+	rx_control_info.runtimeFilterBuffer = palloc0(RUNTIME_FILTER_PACKET_SIZE);
 	rx_control_info.lastDXatId = InvalidTransactionId;
 	rx_control_info.lastTornIcId = 0;
 	initCursorICHistoryTable(&rx_control_info.cursorHistoryTable);
@@ -1464,7 +1817,7 @@ InitMotionUDPIFC(int *listenerSocketFd, uint16 *listenerPort)
 	/* Initialize send control data */
 	snd_control_info.cwnd = 0;
 	snd_control_info.minCwnd = 0;
-	snd_control_info.ackBuffer = palloc0(MIN_PACKET_SIZE);
+	snd_control_info.ackBuffer = palloc0(RUNTIME_FILTER_PACKET_SIZE);
 
 	MemoryContextSwitchTo(old);
 
@@ -1535,6 +1888,8 @@ CleanupMotionUDPIFC(void)
 	/* free the disorder buffer */
 	pfree(rx_control_info.disorderBuffer);
 	rx_control_info.disorderBuffer = NULL;
+	pfree(rx_control_info.runtimeFilterBuffer);
+	rx_control_info.runtimeFilterBuffer = NULL;
 
 	/* free the buffer for acks */
 	pfree(snd_control_info.ackBuffer);
@@ -1946,6 +2301,12 @@ putRxBufferAndSendAck(MotionConn *conn, AckSendParam *param)
 		elog(FATAL, "putRxBufferAndSendAck: buffer is NULL");
 	}
 
+	if (conn->shmRing != NULL)
+	{
+		releaseShmPacket(conn, param);
+		return;
+	}
+
 	seq = buf->seq;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -2794,6 +3155,7 @@ void
 setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn)
 {
 	CdbProcess *cdbProc = conn->cdbProc;
+	bool		useShm;
 
 	Assert(conn->state == mcsSetupOutgoingConnection);
 	Assert(conn->cdbProc);
@@ -2801,6 +3163,11 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 	conn->wakeup_ms = 0;
 	conn->remoteContentId = cdbProc->contentid;
 	conn->stat_min_ack_time = ~((uint64) 0);
+	conn->compress_skip = 0;
+	conn->compress_backoff = 0;
+	conn->stat_compressed_pkts = 0;
+	conn->stat_compress_saved_bytes = 0;
+	bbrInit(conn);
 
 	/* Save the information for the error message if getaddrinfo fails */
 	if (strchr(cdbProc->listenerAddr, ':') != 0)
@@ -2814,6 +3181,7 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 	 * Get socketaddr to connect to.
 	 */
 	getSockAddr(&conn->peer, &conn->peer_len, cdbProc->listenerAddr, cdbProc->listenerPort);
+	useShm = gp_interconnect_local_shm && isLocalAddress(&conn->peer);
 
 	/* Save the destination IP address */
 	format_sockaddr(&conn->peer, conn->remoteHostAndPort,
@@ -2930,6 +3298,10 @@ setupOutgoingUDPConnection(ChunkTransportState *transportStates, ChunkTransportS
 
 	connAddHash(&ic_control_info.connHtab, conn);
 
+	/* the receiver is on this host, offer it a ring */
+	if (useShm && createShmRing(conn))
+		sendShmMessage(pEntry, conn, UDPIC_FLAGS_SHM_OFFER, PostmasterPid);
+
 	/*
 	 * No need to get the connection lock here, since background rx thread
 	 * will never access send connections.
@@ -3058,6 +3430,7 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 	interconnect_context->SendEos = SendEosUDPIFC;
 	interconnect_context->SendChunk = SendChunkUDPIFC;
 	interconnect_context->doSendStopMessage = doSendStopMessageUDPIFC;
+	interconnect_context->doSendRuntimeFilter = doSendRuntimeFilterUDPIFC;
 
 	mySlice = &interconnect_context->sliceTable->slices[sliceTable->localSlice];
 
@@ -3114,6 +3487,8 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 		Assert(pEntry);
 		Assert(pEntry->valid);
 
+		pEntry->readyRing = createReadyRing(pEntry->numConns);
+
 		for (i = 0; i < pEntry->numConns; i++)
 		{
 			conn = &pEntry->conns[i];
@@ -3131,9 +3506,7 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 
 				SIMPLE_FAULT_INJECTOR("interconnect_setup_palloc");
 				conn->pkt_q = (uint8 **) palloc0(conn->pkt_q_capacity * sizeof(uint8 *));
-
-				/* update the max buffer count of our rx buffer pool.  */
-				rx_buffer_pool.maxCount += conn->pkt_q_capacity;
+				conn->readyRing = pEntry->readyRing;
 
 
 				/*
@@ -3164,6 +3537,13 @@ SetupUDPIFCInterconnect_Internal(SliceTable *sliceTable)
 				conn->conn_info.icId = gp_interconnect_id;
 				conn->conn_info.flags = UDPIC_FLAGS_RECEIVER_TO_SENDER;
 
+				/*
+				 * Update the max buffer count of our rx buffer pool, even if
+				 * the sender is going to offer a shared memory ring.
+				 */
+				rx_buffer_pool.maxCount += conn->pkt_q_capacity;
+				conn->shmConnCount = &pEntry->numShmConns;
+
 				connAddHash(&ic_control_info.connHtab, conn);
 			}
 		}
@@ -3273,6 +3653,8 @@ SetupUDPIFCInterconnect(EState *estate)
 				conn = trash->conn;
 				/* Get trash at first as trash will be pfree-ed in connDelHash. */
 				trash = trash->next;
+				if (conn->shmRing != NULL)
+					detachShmRing(conn);
 				connDelHash(ht, conn);
 			}
 		}
@@ -3476,10 +3858,14 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 					/* compute some statistics */
 					computeNetworkStatistics(conn->rtt, &minRtt, &maxRtt, &avgRtt);
 					computeNetworkStatistics(conn->dev, &minDev, &maxDev, &avgDev);
+					recordConnStats(conn);
 
 					icBufferListReturn(&conn->sndQueue, false);
 					icBufferListReturn(&conn->unackQueue, Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_CAPACITY ? false : true);
 
+					if (conn->shmRing != NULL)
+						detachShmRing(conn);
+
 					connDelHash(&ic_control_info.connHtab, conn);
 				}
 				avgRtt = avgRtt / pEntry->numConns;
@@ -3561,6 +3947,9 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 						putRxBufferAndSendAck(conn, NULL);
 					}
 
+					if (conn->shmRing != NULL)
+						detachShmRing(conn);
+
 					/* we also need to clear all the out-of-order packets */
 					freeDisorderedPackets(conn);
 
@@ -3575,6 +3964,12 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 				pfree(pEntry->conns);
 				pEntry->conns = NULL;
 			}
+
+			if (pEntry->readyRing)
+			{
+				pfree(pEntry->readyRing);
+				pEntry->readyRing = NULL;
+			}
 		}
 	}
 
@@ -3622,7 +4017,8 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 " freebuf_avg %f "
 		 "mismatch_pkt_num %d disordered_pkt_num %d duplicated_pkt_num %d"
 		 " rtt/dev [" UINT64_FORMAT "/" UINT64_FORMAT ", %f/%f, " UINT64_FORMAT "/" UINT64_FORMAT "] "
-		 " cwnd %f status_query_msg_num %d",
+		 " cwnd %f status_query_msg_num %d"
+		 " snd_syscall_num %d rx_datagram_num %d rx_syscall_num %d",
 		 ic_control_info.isSender, isReceiver,
 		 Gp_interconnect_snd_queue_depth, Gp_interconnect_queue_depth, Gp_max_packet_size,
 		 UNACK_QUEUE_RING_SLOTS_NUM, TIMER_SPAN, DEFAULT_RTT,
@@ -3635,7 +4031,10 @@ TeardownUDPIFCInterconnect_Internal(ChunkTransportState *transportStates,
 		 (double) ((double) ic_statistics.totalBuffers) / ((double) ic_statistics.bufferCountingTime),
 		 ic_statistics.mismatchNum, ic_statistics.disorderedPktNum, ic_statistics.duplicatedPktNum,
 		 (minRtt == ~((uint64) 0) ? 0 : minRtt), (minDev == ~((uint64) 0) ? 0 : minDev), avgRtt, avgDev, maxRtt, maxDev,
-		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum);
+		 snd_control_info.cwnd, ic_statistics.statusQueryMsgNum,
+		 ic_statistics.sndSyscallNum, ic_statistics.rxDatagramNum, ic_statistics.rxSyscallNum);
+
+	recordSyscallStats(transportStates->sliceTable->ic_instance_id);
 
 	ic_control_info.isSender = false;
 	memset(&ic_statistics, 0, sizeof(ICStatistics));
@@ -3692,7 +4091,7 @@ TeardownUDPIFCInterconnect(ChunkTransportState *transportStates,
  * prepareRxConnForRead
  * 		Prepare the receive connection for reading.
  *
- * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ * MUST BE CALLED WITH ic_control_info.lock LOCKED, or from popReadyConn().
  */
 static void
 prepareRxConnForRead(MotionConn *conn)
@@ -3707,156 +4106,1129 @@ prepareRxConnForRead(MotionConn *conn)
 }
 
 /*
- * receiveChunksUDPIFC
- * 		Receive chunks from the senders
+ * createReadyRing
+ * 		Allocate the ready ring for a receiving motion node.
  *
- * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ * A connection has at most one packet at its queue head, so twice the number
+ * of connections leaves room for stale entries before hints get dropped.
  */
-static TupleChunkListItem
-receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEntry *pEntry,
-					int16 motNodeID, int16 *srcRoute, MotionConn *conn)
+static ICReadyRing *
+createReadyRing(int numConns)
 {
-	int			retries = 0;
-	bool		directed = false;
-	MotionConn *rxconn = NULL;
-	TupleChunkListItem tcItem = NULL;
-
-#ifdef AMS_VERBOSE_LOGGING
-	elog(DEBUG5, "receivechunksUDP: motnodeid %d", motNodeID);
-#endif
-
-	Assert(pTransportStates);
-	Assert(pTransportStates->sliceTable);
+	ICReadyRing *ring;
+	uint32		capacity = READY_RING_MIN_CAPACITY;
 
-	if (conn != NULL)
-	{
-		directed = true;
-		*srcRoute = conn->route;
-		setMainThreadWaiting(&rx_control_info.mainWaitingState, motNodeID, conn->route,
-							 pTransportStates->sliceTable->ic_instance_id);
-	}
-	else
-	{
-		/* non-directed receive */
-		setMainThreadWaiting(&rx_control_info.mainWaitingState, motNodeID, ANY_ROUTE,
-							 pTransportStates->sliceTable->ic_instance_id);
-	}
+	while (capacity < (uint32) numConns * 2)
+		capacity <<= 1;
 
-	/* we didn't have any data, so we've got to read it from the network. */
-	for (;;)
-	{
-		/* 1. Do we have data ready */
-		if (rx_control_info.mainWaitingState.reachRoute != ANY_ROUTE)
-		{
-			rxconn = pEntry->conns + rx_control_info.mainWaitingState.reachRoute;
+	ring = (ICReadyRing *) palloc0(offsetof(ICReadyRing, routes) +
+								   capacity * sizeof(uint16));
+	pg_atomic_init_u32(&ring->head, 0);
+	pg_atomic_init_u32(&ring->tail, 0);
+	ring->mask = capacity - 1;
 
-			prepareRxConnForRead(rxconn);
+	return ring;
+}
 
-			elog(DEBUG2, "receiveChunksUDPIFC: non-directed rx woke on route %d", rx_control_info.mainWaitingState.reachRoute);
-			resetMainThreadWaiting(&rx_control_info.mainWaitingState);
-		}
+/*
+ * readyRingPush
+ * 		Push a route onto the ready ring.  Called by rx thread only.
+ *
+ * The packet must be stored in the connection's queue before this is called,
+ * the write barrier makes it visible before the new tail.
+ */
+static inline void
+readyRingPush(ICReadyRing *ring, uint16 route)
+{
+	uint32		tail = pg_atomic_read_u32(&ring->tail);
 
-		aggregateStatistics(pEntry);
+	/* ring full, drop the hint; the main thread falls back to scanning */
+	if (tail - pg_atomic_read_u32(&ring->head) > ring->mask)
+		return;
 
-		if (rxconn != NULL)
-		{
-			Assert(rxconn->pBuff);
+	ring->routes[tail & ring->mask] = route;
+	pg_write_barrier();
+	pg_atomic_write_u32(&ring->tail, tail + 1);
+}
 
-			pthread_mutex_unlock(&ic_control_info.lock);
+/*
+ * readyRingPop
+ * 		Pop a route from the ready ring.  Called by main thread only.
+ *
+ * Returns -1 if the ring is empty.
+ */
+static inline int
+readyRingPop(ICReadyRing *ring)
+{
+	uint32		head = pg_atomic_read_u32(&ring->head);
+	int			route;
 
-			elog(DEBUG2, "got data with length %d", rxconn->recvBytes);
-			/* successfully read into this connection's buffer. */
-			tcItem = RecvTupleChunk(rxconn, pTransportStates);
+	if (head == pg_atomic_read_u32(&ring->tail))
+		return -1;
 
-			if (!directed)
-				*srcRoute = rxconn->route;
+	pg_read_barrier();
+	route = ring->routes[head & ring->mask];
 
-			return tcItem;
-		}
+	/* the slot must be read before the producer may reuse it */
+	pg_memory_barrier();
+	pg_atomic_write_u32(&ring->head, head + 1);
 
-		retries++;
+	return route;
+}
 
-		/*
-		 * Ok, we've processed all the items currently in the queue. Arm the
-		 * latch (before releasing the mutex), and wait for more messages to
-		 * arrive. The RX thread will wake us up using the latch.
-		 */
-		ResetLatch(&ic_control_info.latch);
-		pthread_mutex_unlock(&ic_control_info.lock);
+/*
+ * popReadyConn
+ * 		Find a connection with a packet at its queue head using the ready ring.
+ *
+ * Returns the connection, prepared for reading, or NULL if the ring had no
+ * usable entry.  Does not need ic_control_info.lock: only the main thread
+ * moves pkt_q_head or clears the queue head slot, and the rx thread fills a
+ * queue head slot before pushing its route.
+ */
+static MotionConn *
+popReadyConn(ChunkTransportStateEntry *pEntry)
+{
+	int			route;
 
-		/*
-		 * Wait for data to become ready.
-		 *
-		 * In the QD, also wake up immediately if one of the QEs report an
-		 * error through the main QD-QE libpq connection. For that, ask
-		 * the dispatcher for a file descriptor to wait on for that.
-		 *
-		 * XXX: We currently only get a single FD to wait on. That catches
-		 * the common case that *all* the QEs report the same error more or
-		 * less at the same time. WaitLatchOrSocket doesn't allow waiting for
-		 * more than one socket at a time. PostgreSQL 9.6 introduces a more
-		 * flexible "wait event" API for the latches, so once we merge with
-		 * that, we could improve this.
-		 */
-		int			wakeEvents = WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH;
-		int			waitFd = PGINVALID_SOCKET;
+	if (pEntry->readyRing == NULL)
+		return NULL;
 
-		if (Gp_role == GP_ROLE_DISPATCH)
-			waitFd = cdbdisp_getWaitSocketFd(pTransportStates->estate->dispatcherState);
-		if (waitFd != PGINVALID_SOCKET)
-			wakeEvents |= WL_SOCKET_READABLE;
+	while ((route = readyRingPop(pEntry->readyRing)) >= 0)
+	{
+		MotionConn *conn;
 
-		if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
-		{
-			elog(DEBUG5, "waiting (timed) on route %d %s", rx_control_info.mainWaitingState.waitingRoute,
-				 (rx_control_info.mainWaitingState.waitingRoute == ANY_ROUTE ? "(any route)" : ""));
-		}
-		(void) WaitLatchOrSocket(&ic_control_info.latch,
-								 wakeEvents, waitFd,
-								 MAIN_THREAD_COND_TIMEOUT_MS);
+		if (route >= pEntry->numConns)
+			continue;
 
-		/* check the potential errors in rx thread. */
-		checkRxThreadError();
+		conn = pEntry->conns + route;
 
-		/* do not check interrupts when holding the lock */
-		ML_CHECK_FOR_INTERRUPTS(pTransportStates->teardownActive);
+		/* stale hint, the packet has been consumed already */
+		if (((volatile MotionConn *) conn)->pkt_q[conn->pkt_q_head] == NULL)
+			continue;
 
-		/* check to see if the dispatcher should cancel */
-		if (Gp_role == GP_ROLE_DISPATCH)
-		{
-			checkForCancelFromQD(pTransportStates);
-		}
+		prepareRxConnForRead(conn);
+		return conn;
+	}
 
-		/*
-		 * 1. NIC on master (and thus the QD connection) may become bad, check
-		 * it. 2. Postmaster may become invalid, check it
-		 */
-		if ((retries & 0x3f) == 0)
-		{
-			checkQDConnectionAlive();
+	return NULL;
+}
 
-			if (!PostmasterIsAlive())
-				ereport(FATAL,
-						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-						 errmsg("interconnect failed to recv chunks"),
-						 errdetail("Postmaster is not alive.")));
-		}
+/*
+ * Addresses of the network interfaces of this host, collected on first use.
+ */
+static List *localAddrs = NIL;
+static bool localAddrsCollected = false;
 
-		pthread_mutex_lock(&ic_control_info.lock);
+static void
+collectLocalAddress(struct sockaddr *addr, struct sockaddr *netmask, void *cb_data)
+{
+	struct sockaddr_storage *copy;
 
-	}							/* for (;;) */
+	if (addr->sa_family == AF_INET)
+	{
+		copy = palloc0(sizeof(struct sockaddr_storage));
+		memcpy(copy, addr, sizeof(struct sockaddr_in));
+	}
+#ifdef HAVE_IPV6
+	else if (addr->sa_family == AF_INET6)
+	{
+		copy = palloc0(sizeof(struct sockaddr_storage));
+		memcpy(copy, addr, sizeof(struct sockaddr_in6));
+	}
+#endif
+	else
+		return;
 
-	/* We either got data, or get cancelled. We never make it out to here. */
-	return NULL;				/* make GCC behave */
+	localAddrs = lappend(localAddrs, copy);
 }
 
 /*
- * RecvTupleChunkFromAnyUDPIFC_Internal
- * 		Receive tuple chunks from any route (connections)
+ * isLocalAddress
+ * 		Is the address one of this host's?
+ *
+ * If the interfaces can't be listed, nothing is, and senders just don't offer
+ * shared memory rings.
  */
-static inline TupleChunkListItem
-RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
-									 int16 motNodeID,
+static bool
+isLocalAddress(const struct sockaddr_storage *addr)
+{
+	ListCell   *lc;
+
+	if (!localAddrsCollected)
+	{
+		MemoryContext oldContext = MemoryContextSwitchTo(TopMemoryContext);
+
+		if (pg_foreach_ifaddr(collectLocalAddress, NULL) < 0)
+			ereport(LOG,
+					(errmsg("interconnect could not get the network interfaces of this host: %m")));
+		MemoryContextSwitchTo(oldContext);
+		localAddrsCollected = true;
+	}
+
+	foreach(lc, localAddrs)
+	{
+		struct sockaddr_storage *local = (struct sockaddr_storage *) lfirst(lc);
+
+		if (local->ss_family != addr->ss_family)
+			continue;
+
+		if (addr->ss_family == AF_INET &&
+			memcmp(&((const struct sockaddr_in *) addr)->sin_addr,
+				   &((struct sockaddr_in *) local)->sin_addr,
+				   sizeof(struct in_addr)) == 0)
+			return true;
+#ifdef HAVE_IPV6
+		if (addr->ss_family == AF_INET6 &&
+			memcmp(&((const struct sockaddr_in6 *) addr)->sin6_addr,
+				   &((struct sockaddr_in6 *) local)->sin6_addr,
+				   sizeof(struct in6_addr)) == 0)
+			return true;
+#endif
+	}
+
+	return false;
+}
+
+/*
+ * shmRingName
+ * 		Name of the shm object of a connection.
+ *
+ * Prefixed with the pid of the sender's postmaster, see ICShmRingCleanup().
+ */
+static void
+shmRingName(char *name, size_t len, int postmasterPid, icpkthdr *connInfo)
+{
+	snprintf(name, len, "/" IC_SHM_PREFIX "%d.%d.%u.%d.%d.%d",
+			 postmasterPid, connInfo->sessionId, connInfo->icId,
+			 connInfo->motNodeId, connInfo->srcPid, connInfo->dstPid);
+}
+
+static inline Size
+shmRingSize(uint32 slots)
+{
+	return IC_SHM_RING_HEADER_SIZE + (Size) slots * IC_SHM_RING_SLOT_SIZE;
+}
+
+static inline icpkthdr *
+shmRingSlot(MotionConn *conn, uint32 pos)
+{
+	return (icpkthdr *) ((char *) conn->shmRing + IC_SHM_RING_HEADER_SIZE +
+						 (Size) (pos % conn->shmSlots) * IC_SHM_RING_SLOT_SIZE);
+}
+
+/*
+ * createShmRing
+ * 		Create the shared memory ring of an outgoing connection, to offer it
+ * 		to the receiver.
+ *
+ * conn->conn_info must be filled in.  Returns false if the ring can't be
+ * created, the connection then uses the socket.
+ */
+static bool
+createShmRing(MotionConn *conn)
+{
+#ifdef IC_SHM_TRANSPORT
+	char		name[64];
+	Size		size;
+	int			fd;
+	int			rc;
+	void	   *address;
+
+	conn->shmSlots = IC_SHM_RING_SLOTS;
+	size = shmRingSize(conn->shmSlots);
+	shmRingName(name, sizeof(name), PostmasterPid, &conn->conn_info);
+
+	/* a leftover of the same name is not ours to reuse */
+	fd = shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if (fd < 0)
+	{
+		ereport(LOG,
+				(errmsg("interconnect could not create shared memory segment \"%s\": %m",
+						name)));
+		return false;
+	}
+
+	rc = ftruncate(fd, size);
+#if defined(HAVE_POSIX_FALLOCATE) && defined(__linux__)
+	/* see dsm_impl_posix_resize(), fail now rather than SIGBUS later */
+	if (rc == 0)
+	{
+		do
+		{
+			rc = posix_fallocate(fd, 0, size);
+		} while (rc == EINTR && !(ProcDiePending || QueryCancelPending));
+		errno = rc;
+	}
+#endif
+	if (rc != 0)
+	{
+		int			save_errno = errno;
+
+		close(fd);
+		shm_unlink(name);
+		errno = save_errno;
+		ereport(LOG,
+				(errmsg("interconnect could not resize shared memory segment \"%s\" to %zu bytes: %m",
+						name, size)));
+		return false;
+	}
+
+	address = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_HASSEMAPHORE | MAP_NOSYNC, fd, 0);
+	if (address == MAP_FAILED)
+	{
+		int			save_errno = errno;
+
+		close(fd);
+		shm_unlink(name);
+		errno = save_errno;
+		ereport(LOG,
+				(errmsg("interconnect could not map shared memory segment \"%s\": %m",
+						name)));
+		return false;
+	}
+	close(fd);
+
+	conn->shmRing = (ICShmRing *) address;
+	conn->shmAccepted = false;
+	conn->shmDeclined = false;
+
+	if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		elog(DEBUG1, "Interconnect offering shared memory segment \"%s\" for node %d route %d",
+			 name, conn->conn_info.motNodeId, conn->route);
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+ * acceptShmRing
+ * 		Called by rx thread to take up the ring a sender offers.
+ *
+ * Returns false if the offer has to be declined.  Same restrictions as
+ * handleRxPacket(), and MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ */
+static bool
+acceptShmRing(MotionConn *conn, int postmasterPid)
+{
+#ifdef IC_SHM_TRANSPORT
+	char		name[64];
+	uint32		slots = IC_SHM_RING_SLOTS;
+	Size		size = shmRingSize(slots);
+	struct stat st;
+	int			fd;
+	void	   *address;
+	ICShmRing  *ring;
+	uint32		state = IC_SHM_OFFERED;
+
+	shmRingName(name, sizeof(name), postmasterPid, &conn->conn_info);
+
+	/* ENOENT: a late copy of an offer that has been withdrawn */
+	fd = shm_open(name, O_RDWR, 0);
+	if (fd < 0)
+	{
+		if (errno != ENOENT)
+			write_log("Interconnect could not open shared memory segment \"%s\": errno %d",
+					  name, errno);
+		return false;
+	}
+
+	if (fstat(fd, &st) != 0 || (Size) st.st_size != size)
+	{
+		write_log("Interconnect declined shared memory segment \"%s\": expected %zu bytes, "
+				  "gp_interconnect_queue_depth, gp_interconnect_snd_queue_depth and "
+				  "gp_max_packet_size must be the same on all segments", name, size);
+		close(fd);
+		return false;
+	}
+
+	address = mmap(NULL, size, PROT_READ | PROT_WRITE,
+				   MAP_SHARED | MAP_HASSEMAPHORE | MAP_NOSYNC, fd, 0);
+	close(fd);
+	if (address == MAP_FAILED)
+	{
+		write_log("Interconnect could not map shared memory segment \"%s\": errno %d",
+				  name, errno);
+		return false;
+	}
+
+	ring = (ICShmRing *) address;
+	if (!pg_atomic_compare_exchange_u32(&ring->state, &state, IC_SHM_ACCEPTED))
+	{
+		/* the sender has given up on us */
+		munmap(address, size);
+		return false;
+	}
+
+	/* both ends have it mapped, the name has served its purpose */
+	if (shm_unlink(name) != 0 && errno != ENOENT)
+		write_log("Interconnect could not remove shared memory segment \"%s\": errno %d",
+				  name, errno);
+
+	conn->shmSlots = slots;
+	conn->shmNext = 0;
+
+	/* the main thread looks at shmRing without the lock */
+	pg_write_barrier();
+	conn->shmRing = ring;
+	(*conn->shmConnCount)++;
+
+	return true;
+#else
+	return false;
+#endif
+}
+
+/*
+ * detachShmRing
+ * 		Unmap the shared memory ring of a connection.
+ *
+ * A receiver leaves a stop request in the ring, for a sender that is still
+ * running.  A sender whose offer is still open withdraws it, and removes the
+ * object.  Must not throw, it's called in error cleanup.
+ */
+static void
+detachShmRing(MotionConn *conn)
+{
+#ifdef IC_SHM_TRANSPORT
+	ICShmRing  *ring = conn->shmRing;
+
+	if (conn->conn_info.flags & UDPIC_FLAGS_RECEIVER_TO_SENDER)
+	{
+		pg_atomic_write_u32(&ring->stopRequested, 1);
+		wakeShmSender(conn, NULL);
+	}
+	else if (!conn->shmAccepted)
+	{
+		uint32		state = IC_SHM_OFFERED;
+
+		if (pg_atomic_compare_exchange_u32(&ring->state, &state, IC_SHM_DECLINED) ||
+			state == IC_SHM_DECLINED)
+		{
+			char		name[64];
+
+			shmRingName(name, sizeof(name), PostmasterPid, &conn->conn_info);
+			if (shm_unlink(name) != 0 && errno != ENOENT)
+				elog(LOG, "could not remove shared memory segment \"%s\": %m", name);
+		}
+	}
+
+	if (munmap(ring, shmRingSize(conn->shmSlots)) != 0)
+		elog(LOG, "could not unmap interconnect shared memory segment: %m");
+#endif
+
+	conn->shmRing = NULL;
+}
+
+/*
+ * ICShmRingCleanup
+ * 		Remove the shared memory rings left behind by crashed backends.
+ *
+ * Called by the postmaster whenever it (re)initializes shared memory.  The
+ * rings of our own postmaster can't be in use at that point, nor can those of
+ * a postmaster that is gone.  Other postmasters on the host keep theirs.
+ * Where shm objects aren't listed in IC_SHM_DIR, there is nothing to do.
+ */
+void
+ICShmRingCleanup(void)
+{
+#ifdef IC_SHM_TRANSPORT
+	DIR		   *dir;
+	struct dirent *dent;
+
+	if ((dir = AllocateDir(IC_SHM_DIR)) == NULL)
+		return;
+
+	while ((dent = ReadDir(dir, IC_SHM_DIR)) != NULL)
+	{
+		char		name[MAXPGPATH];
+		int			pid;
+
+		if (strncmp(dent->d_name, IC_SHM_PREFIX, strlen(IC_SHM_PREFIX)) != 0 ||
+			sscanf(dent->d_name + strlen(IC_SHM_PREFIX), "%d.", &pid) != 1)
+			continue;
+
+		if (pid != PostmasterPid && (kill(pid, 0) == 0 || errno != ESRCH))
+			continue;
+
+		snprintf(name, sizeof(name), "/%s", dent->d_name);
+		elog(DEBUG2, "removing shared memory segment \"%s\"", name);
+		if (shm_unlink(name) != 0 && errno != ENOENT)
+			elog(LOG, "could not remove shared memory segment \"%s\": %m", name);
+	}
+
+	FreeDir(dir);
+#endif
+}
+
+/*
+ * pumpShmConn
+ * 		Queue the packets the sender has published in a connection's ring.
+ *
+ * The receiver of a shared memory connection does the rx thread's job
+ * itself: the slots go into pkt_q in order, as far as it has room.  After a
+ * stop request, what arrives is dropped until the sender's EOS.
+ *
+ * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ */
+static void
+pumpShmConn(MotionConn *conn)
+{
+	ICShmRing  *ring = conn->shmRing;
+	uint32		tail = pg_atomic_read_u32(&ring->tail);
+	uint32		start = conn->shmNext;
+
+	if (start == tail)
+		return;
+
+	/* don't read the slots before the tail that covers them */
+	pg_read_barrier();
+
+	if (conn->stopRequested)
+	{
+		/* doSendStopMessageUDPIFC() emptied pkt_q, so head == shmNext */
+		Assert(conn->pkt_q_size == 0);
+
+		for (; conn->shmNext != tail; conn->shmNext++)
+		{
+			if (shmRingSlot(conn, conn->shmNext)->flags & UDPIC_FLAGS_EOS)
+				conn->stillActive = false;
+		}
+		pg_memory_barrier();
+		pg_atomic_write_u32(&ring->head, tail);
+	}
+	else
+	{
+		while (conn->shmNext != tail && conn->pkt_q_size < conn->pkt_q_capacity)
+		{
+			icpkthdr   *pkt = shmRingSlot(conn, conn->shmNext);
+
+			conn->pkt_q[conn->pkt_q_tail] = (uint8 *) pkt;
+			conn->pkt_q_tail = (conn->pkt_q_tail + 1) % conn->pkt_q_capacity;
+			conn->pkt_q_size++;
+			conn->conn_info.seq++;
+			conn->shmNext++;
+
+			if (pkt->flags & UDPIC_FLAGS_EOS)
+				conn->conn_info.flags |= UDPIC_FLAGS_EOS;
+		}
+	}
+
+	if (conn->shmNext != start)
+	{
+		ic_statistics.recvPktNum += conn->shmNext - start;
+		pg_atomic_write_u32(&ring->received, conn->shmNext);
+		wakeShmSender(conn, NULL);
+	}
+}
+
+/*
+ * pumpShmConns
+ * 		Pump the shared memory connections of a receiving motion node.
+ *
+ * Returns the given connection, or with conn == NULL any connection, if it
+ * has a packet queued, NULL otherwise.
+ *
+ * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ */
+static MotionConn *
+pumpShmConns(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	int			i;
+
+	if (conn != NULL)
+	{
+		if (conn->shmRing == NULL)
+			return NULL;
+		pumpShmConn(conn);
+		return conn->pkt_q_size > 0 ? conn : NULL;
+	}
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *c = pEntry->conns + i;
+
+		if (c->shmRing == NULL)
+			continue;
+		pumpShmConn(c);
+		if (c->pkt_q_size > 0)
+			return c;
+	}
+
+	return NULL;
+}
+
+/*
+ * shmConnsReady
+ * 		Has a sender published packets we haven't queued yet?
+ *
+ * Only looks at the given connection, or at all of them if conn is NULL.
+ * Doesn't need the lock, shmNext is only used by the main thread.
+ */
+static bool
+shmConnsReady(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	int			i;
+
+	if (conn != NULL)
+		return conn->shmRing != NULL &&
+			pg_atomic_read_u32(&conn->shmRing->tail) != conn->shmNext;
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *c = pEntry->conns + i;
+
+		if (c->shmRing != NULL &&
+			pg_atomic_read_u32(&c->shmRing->tail) != c->shmNext)
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * setShmReceiverWaiting
+ * 		Ask the senders of our shared memory connections for a wakeup.
+ *
+ * The caller must look at the rings again before it sleeps.
+ */
+static void
+setShmReceiverWaiting(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	int			i;
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *c = pEntry->conns + i;
+
+		if (c->shmRing != NULL && (conn == NULL || c == conn))
+			pg_atomic_write_u32(&c->shmRing->receiverWaiting, 1);
+	}
+	pg_memory_barrier();
+}
+
+/*
+ * releaseShmPacket
+ * 		Hand the slot at the head of pkt_q back to the sender.
+ *
+ * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ */
+static void
+releaseShmPacket(MotionConn *conn, AckSendParam *param)
+{
+	ICShmRing  *ring = conn->shmRing;
+
+	conn->pkt_q[conn->pkt_q_head] = NULL;
+	conn->pBuff = NULL;
+	conn->pkt_q_head = (conn->pkt_q_head + 1) % conn->pkt_q_capacity;
+	conn->pkt_q_size--;
+
+	/* we must be done reading the slot before the sender may reuse it */
+	pg_memory_barrier();
+	pg_atomic_write_u32(&ring->head, pg_atomic_read_u32(&ring->head) + 1);
+
+	wakeShmSender(conn, param);
+}
+
+/*
+ * wakeShmSender
+ * 		Wake up the sender of a shared memory connection, if it is waiting.
+ *
+ * The offer of the ring has told us the sender's address.  With param, the
+ * wakeup is only prepared, for the caller to send after releasing the lock.
+ */
+static void
+wakeShmSender(MotionConn *conn, AckSendParam *param)
+{
+	ICShmRing  *ring = conn->shmRing;
+	int32		flags = UDPIC_FLAGS_RECEIVER_TO_SENDER | UDPIC_FLAGS_SHM_WAKEUP;
+
+	pg_memory_barrier();
+	if (pg_atomic_read_u32(&ring->senderWaiting) == 0 ||
+		pg_atomic_exchange_u32(&ring->senderWaiting, 0) == 0)
+		return;
+
+	if (conn->peer_len == 0)
+		return;
+
+	if (param != NULL)
+		setAckSendParam(param, conn, flags, 0, 0);
+	else
+		sendAck(conn, flags, 0, 0);
+}
+
+/*
+ * sendShmMessage
+ * 		Send a wakeup or an offer to the receiver of a shared memory
+ * 		connection.
+ */
+static void
+sendShmMessage(ChunkTransportStateEntry *pEntry, MotionConn *conn,
+			   int32 flags, uint32 extraSeq)
+{
+	icpkthdr	msg;
+
+	memcpy(&msg, &conn->conn_info, sizeof(msg));
+	msg.flags = flags;
+	msg.seq = 0;
+	msg.extraSeq = extraSeq;
+	msg.len = sizeof(msg);
+
+	sendControlMessage(&msg, pEntry->txfd, (struct sockaddr *) &conn->peer, conn->peer_len);
+}
+
+static inline bool
+shmRingReady(MotionConn *conn, bool drain)
+{
+	ICShmRing  *ring = conn->shmRing;
+	uint32		tail = pg_atomic_read_u32(&ring->tail);
+
+	if (drain)
+		return pg_atomic_read_u32(&ring->received) == tail;
+
+	return tail - pg_atomic_read_u32(&ring->head) < conn->shmSlots;
+}
+
+/*
+ * waitShmRing
+ * 		Wait until the receiver of a shared memory connection has freed a
+ * 		slot, or with drain, until it has queued all the packets published.
+ *
+ * Returns false if the receiver asked us to stop instead.  Acks for the
+ * socket connections of the motion node are handled in the meantime, and
+ * *gotStops is set if there were stop messages among them.
+ */
+static bool
+waitShmRing(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+			MotionConn *conn, bool drain, bool *gotStops)
+{
+	ICShmRing  *ring = conn->shmRing;
+	int			retry = 0;
+
+	for (;;)
+	{
+		if (pg_atomic_read_u32(&ring->stopRequested) != 0)
+		{
+			if (!conn->stopRequested)
+			{
+				conn->stopRequested = true;
+				conn->conn_info.flags |= UDPIC_FLAGS_STOP;
+				*gotStops = true;
+			}
+			return false;
+		}
+
+		if (shmRingReady(conn, drain))
+			return true;
+
+		/* announce that we are going to sleep, then look again */
+		pg_atomic_write_u32(&ring->senderWaiting, 1);
+		pg_memory_barrier();
+		if (shmRingReady(conn, drain) ||
+			pg_atomic_read_u32(&ring->stopRequested) != 0)
+			continue;
+
+		if (pollAcks(transportStates, pEntry->txfd, IC_SHM_WAIT_TIMEOUT_MS))
+		{
+			if (handleAcks(transportStates, pEntry))
+				*gotStops = true;
+		}
+		else
+		{
+			/*
+			 * Nobody woke us up, a wakeup may have got lost.  Nudge the
+			 * receiver.
+			 */
+			sendShmMessage(pEntry, conn, UDPIC_FLAGS_SHM_WAKEUP, 0);
+		}
+
+		ML_CHECK_FOR_INTERRUPTS(transportStates->teardownActive);
+
+		if ((retry & 0x3f) == 2)
+		{
+			checkRxThreadError();
+			checkQDConnectionAlive();
+
+			if (!PostmasterIsAlive())
+				ereport(FATAL,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("interconnect failed to send chunks"),
+						 errdetail("Postmaster is not alive.")));
+
+			/* a receiver that goes away normally leaves a stop request */
+			if (kill(conn->cdbProc->pid, 0) != 0 && errno == ESRCH)
+				ereport(ERROR,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("interconnect error: receiving process %d on %s is gone",
+								conn->cdbProc->pid, conn->remoteHostAndPort)));
+		}
+		retry++;
+	}
+}
+
+/*
+ * awaitShmAccept
+ * 		Wait until the receiver has taken up the ring we offered, or fall back
+ * 		to the socket.
+ *
+ * Called before the first packet of the connection is prepared, nothing has
+ * been written into the ring yet.  The offer is repeated in case it got lost,
+ * or came before the receiver had set up the connection.  See waitShmRing()
+ * for gotStops.
+ */
+static void
+awaitShmAccept(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+			   MotionConn *conn, bool *gotStops)
+{
+	ICShmRing  *ring = conn->shmRing;
+	uint64		start = getCurrentTime();
+	int			retry = 0;
+
+	for (;;)
+	{
+		uint32		state = pg_atomic_read_u32(&ring->state);
+
+		/* withdraw the offer, unless the receiver takes it up right now */
+		if (state == IC_SHM_OFFERED &&
+			(conn->shmDeclined || conn->stopRequested ||
+			 getCurrentTime() - start > IC_SHM_OFFER_TIMEOUT_MS * 1000) &&
+			pg_atomic_compare_exchange_u32(&ring->state, &state, IC_SHM_DECLINED))
+			state = IC_SHM_DECLINED;
+
+		if (state == IC_SHM_ACCEPTED)
+		{
+			conn->shmAccepted = true;
+			return;
+		}
+
+		if (state == IC_SHM_DECLINED)
+		{
+			if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+				elog(DEBUG1, "Interconnect shared memory segment for node %d route %d %s, using the socket",
+					 conn->conn_info.motNodeId, conn->route,
+					 conn->shmDeclined ? "declined" : "not taken up");
+			detachShmRing(conn);
+			return;
+		}
+
+		if (pollAcks(transportStates, pEntry->txfd, IC_SHM_WAIT_TIMEOUT_MS))
+		{
+			if (handleAcks(transportStates, pEntry))
+				*gotStops = true;
+		}
+		else
+			sendShmMessage(pEntry, conn, UDPIC_FLAGS_SHM_OFFER, PostmasterPid);
+
+		ML_CHECK_FOR_INTERRUPTS(transportStates->teardownActive);
+
+		if ((retry & 0x3f) == 2)
+		{
+			checkRxThreadError();
+			checkQDConnectionAlive();
+
+			if (!PostmasterIsAlive())
+				ereport(FATAL,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("interconnect failed to send chunks"),
+						 errdetail("Postmaster is not alive.")));
+		}
+		retry++;
+	}
+}
+
+/*
+ * sendShmPacket
+ * 		Publish the packet prepared in conn->pBuff in the connection's ring.
+ *
+ * Returns false, without publishing, if the receiver asked us to stop.  See
+ * waitShmRing() for gotStops.
+ */
+static bool
+sendShmPacket(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry,
+			  MotionConn *conn, bool *gotStops)
+{
+	ICShmRing  *ring = conn->shmRing;
+	icpkthdr   *pkt = (icpkthdr *) conn->pBuff;
+	uint32		tail;
+
+	if (!waitShmRing(transportStates, pEntry, conn, false, gotStops))
+		return false;
+
+	tail = pg_atomic_read_u32(&ring->tail);
+	memcpy(shmRingSlot(conn, tail), pkt, pkt->len);
+
+	/* the packet must be in place before the new tail */
+	pg_write_barrier();
+	pg_atomic_write_u32(&ring->tail, tail + 1);
+
+	conn->sentSeq = pkt->seq;
+	ic_statistics.sndPktNum++;
+
+	/* and the tail must be visible before we look at the flag */
+	pg_memory_barrier();
+	if (pg_atomic_read_u32(&ring->receiverWaiting) != 0 &&
+		pg_atomic_exchange_u32(&ring->receiverWaiting, 0) != 0)
+		sendShmMessage(pEntry, conn, UDPIC_FLAGS_SHM_WAKEUP, 0);
+
+	return true;
+}
+
+/*
+ * handleShmWakeup
+ * 		Called by rx thread for a wakeup from the sender of a shared memory
+ * 		connection.
+ *
+ * Remember where the sender is, so that we can wake it up in turn, and wake
+ * up the main thread.  Same restrictions as handleRxPacket().
+ */
+static void
+handleShmWakeup(icpkthdr *pkt, struct sockaddr_storage *peer, socklen_t peerlen)
+{
+	MotionConn *conn;
+
+	pthread_mutex_lock(&ic_control_info.lock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+	if (conn != NULL && conn->shmRing != NULL && conn->peer_len == 0)
+	{
+		memcpy(&conn->peer, peer, peerlen);
+		conn->peer_len = peerlen;
+	}
+	pthread_mutex_unlock(&ic_control_info.lock);
+
+	SetLatch(&ic_control_info.latch);
+}
+
+/*
+ * handleShmOffer
+ * 		Called by rx thread for the offer of a shared memory ring.
+ *
+ * The sender waits for the ring to be accepted, which the wakeup tells it,
+ * or declined.  A connection that is being stopped stays on the socket.  If
+ * the connection isn't set up yet, the sender offers again.  Same
+ * restrictions as handleRxPacket().
+ */
+static void
+handleShmOffer(icpkthdr *pkt, struct sockaddr_storage *peer, socklen_t peerlen)
+{
+	MotionConn *conn;
+	AckSendParam param;
+	bool		accepted = false;
+
+	memset(&param, 0, sizeof(AckSendParam));
+
+	pthread_mutex_lock(&ic_control_info.lock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+	if (conn == NULL || conn->shmRing != NULL)
+	{
+		pthread_mutex_unlock(&ic_control_info.lock);
+		return;
+	}
+
+	if (conn->peer_len == 0)
+	{
+		memcpy(&conn->peer, peer, peerlen);
+		conn->peer_len = peerlen;
+	}
+
+	if (conn->stillActive && !conn->stopRequested)
+		accepted = acceptShmRing(conn, (int) pkt->extraSeq);
+
+	setAckSendParam(&param, conn,
+					UDPIC_FLAGS_RECEIVER_TO_SENDER |
+					(accepted ? UDPIC_FLAGS_SHM_WAKEUP : UDPIC_FLAGS_SHM_OFFER),
+					0, 0);
+	pthread_mutex_unlock(&ic_control_info.lock);
+
+	sendAckWithParam(&param);
+
+	if (accepted)
+		SetLatch(&ic_control_info.latch);
+}
+
+/*
+ * receiveChunksUDPIFC
+ * 		Receive chunks from the senders
+ *
+ * MUST BE CALLED WITH ic_control_info.lock LOCKED.
+ */
+static TupleChunkListItem
+receiveChunksUDPIFC(ChunkTransportState *pTransportStates, ChunkTransportStateEntry *pEntry,
+					int16 motNodeID, int16 *srcRoute, MotionConn *conn)
+{
+	int			retries = 0;
+	int			spins;
+	bool		directed = false;
+	MotionConn *rxconn = NULL;
+	TupleChunkListItem tcItem = NULL;
+
+#ifdef AMS_VERBOSE_LOGGING
+	elog(DEBUG5, "receivechunksUDP: motnodeid %d", motNodeID);
+#endif
+
+	Assert(pTransportStates);
+	Assert(pTransportStates->sliceTable);
+
+	if (conn != NULL)
+	{
+		directed = true;
+		*srcRoute = conn->route;
+		setMainThreadWaiting(&rx_control_info.mainWaitingState, motNodeID, conn->route,
+							 pTransportStates->sliceTable->ic_instance_id);
+	}
+	else
+	{
+		/* non-directed receive */
+		setMainThreadWaiting(&rx_control_info.mainWaitingState, motNodeID, ANY_ROUTE,
+							 pTransportStates->sliceTable->ic_instance_id);
+	}
+
+	/* we didn't have any data, so we've got to read it from the network. */
+	for (;;)
+	{
+		/* 1. Do we have data ready */
+		if (rx_control_info.mainWaitingState.reachRoute != ANY_ROUTE)
+		{
+			rxconn = pEntry->conns + rx_control_info.mainWaitingState.reachRoute;
+
+			prepareRxConnForRead(rxconn);
+
+			elog(DEBUG2, "receiveChunksUDPIFC: non-directed rx woke on route %d", rx_control_info.mainWaitingState.reachRoute);
+			resetMainThreadWaiting(&rx_control_info.mainWaitingState);
+		}
+		else if (pEntry->numShmConns > 0 &&
+				 (rxconn = pumpShmConns(pEntry, conn)) != NULL)
+		{
+			prepareRxConnForRead(rxconn);
+			resetMainThreadWaiting(&rx_control_info.mainWaitingState);
+		}
+
+		aggregateStatistics(pEntry);
+
+		if (rxconn != NULL)
+		{
+			Assert(rxconn->pBuff);
+
+			pthread_mutex_unlock(&ic_control_info.lock);
+
+			decompressRxPacket(rxconn);
+
+			elog(DEBUG2, "got data with length %d", rxconn->recvBytes);
+			/* successfully read into this connection's buffer. */
+			tcItem = RecvTupleChunk(rxconn, pTransportStates);
+
+			if (!directed)
+				*srcRoute = rxconn->route;
+
+			return tcItem;
+		}
+
+		retries++;
+
+		/*
+		 * Ok, we've processed all the items currently in the queue. Arm the
+		 * latch (before releasing the mutex), and wait for more messages to
+		 * arrive. The RX thread will wake us up using the latch.
+		 */
+		ResetLatch(&ic_control_info.latch);
+		pthread_mutex_unlock(&ic_control_info.lock);
+
+		/*
+		 * Spin for a little while before going to sleep.  With many senders
+		 * the next packet tends to arrive within microseconds; catching the
+		 * latch being set here saves both the poll() and the rx thread's
+		 * self-pipe write, which SetLatch() only does for a sleeping waiter.
+		 */
+		for (spins = 0; spins < gp_interconnect_rx_spin_count; spins++)
+		{
+			if (((volatile Latch *) &ic_control_info.latch)->is_set)
+				break;
+			if (pEntry->numShmConns > 0 && shmConnsReady(pEntry, conn))
+				break;
+			pg_spin_delay();
+		}
+
+		/* senders on this host don't set the latch unless asked to */
+		if (pEntry->numShmConns > 0)
+			setShmReceiverWaiting(pEntry, conn);
+
+		/*
+		 * Wait for data to become ready.
+		 *
+		 * In the QD, also wake up immediately if one of the QEs report an
+		 * error through the main QD-QE libpq connection. For that, ask
+		 * the dispatcher for a file descriptor to wait on for that.
+		 *
+		 * XXX: We currently only get a single FD to wait on. That catches
+		 * the common case that *all* the QEs report the same error more or
+		 * less at the same time. WaitLatchOrSocket doesn't allow waiting for
+		 * more than one socket at a time. PostgreSQL 9.6 introduces a more
+		 * flexible "wait event" API for the latches, so once we merge with
+		 * that, we could improve this.
+		 */
+		int			wakeEvents = WL_LATCH_SET | WL_TIMEOUT | WL_POSTMASTER_DEATH;
+		int			waitFd = PGINVALID_SOCKET;
+
+		if (Gp_role == GP_ROLE_DISPATCH)
+			waitFd = cdbdisp_getWaitSocketFd(pTransportStates->estate->dispatcherState);
+		if (waitFd != PGINVALID_SOCKET)
+			wakeEvents |= WL_SOCKET_READABLE;
+
+		if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+		{
+			elog(DEBUG5, "waiting (timed) on route %d %s", rx_control_info.mainWaitingState.waitingRoute,
+				 (rx_control_info.mainWaitingState.waitingRoute == ANY_ROUTE ? "(any route)" : ""));
+		}
+		if (!((volatile Latch *) &ic_control_info.latch)->is_set &&
+			!(pEntry->numShmConns > 0 && shmConnsReady(pEntry, conn)))
+			(void) WaitLatchOrSocket(&ic_control_info.latch,
+									 wakeEvents, waitFd,
+									 pEntry->numShmConns > 0 ? IC_SHM_WAIT_TIMEOUT_MS :
+									 MAIN_THREAD_COND_TIMEOUT_MS);
+
+		/* check the potential errors in rx thread. */
+		checkRxThreadError();
+
+		/* do not check interrupts when holding the lock */
+		ML_CHECK_FOR_INTERRUPTS(pTransportStates->teardownActive);
+
+		/* check to see if the dispatcher should cancel */
+		if (Gp_role == GP_ROLE_DISPATCH)
+		{
+			checkForCancelFromQD(pTransportStates);
+		}
+
+		/*
+		 * 1. NIC on master (and thus the QD connection) may become bad, check
+		 * it. 2. Postmaster may become invalid, check it
+		 */
+		if ((retries & 0x3f) == 0)
+		{
+			checkQDConnectionAlive();
+
+			if (!PostmasterIsAlive())
+				ereport(FATAL,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("interconnect failed to recv chunks"),
+						 errdetail("Postmaster is not alive.")));
+		}
+
+		pthread_mutex_lock(&ic_control_info.lock);
+
+	}							/* for (;;) */
+
+	/* We either got data, or get cancelled. We never make it out to here. */
+	return NULL;				/* make GCC behave */
+}
+
+/*
+ * RecvTupleChunkFromAnyUDPIFC_Internal
+ * 		Receive tuple chunks from any route (connections)
+ */
+static inline TupleChunkListItem
+RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
+									 int16 motNodeID,
 									 int16 *srcRoute)
 {
 	ChunkTransportStateEntry *pEntry = NULL;
@@ -3878,6 +5250,20 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 
 	getChunkTransportState(transportStates, motNodeID, &pEntry);
 
+	if (pEntry->numRuntimeFilters > 0)
+		sendPendingRuntimeFilters(pEntry);
+
+	/* Try the ready ring first, it doesn't need the lock. */
+	conn = popReadyConn(pEntry);
+	if (conn != NULL)
+	{
+		decompressRxPacket(conn);
+
+		tcItem = RecvTupleChunk(conn, transportStates);
+		*srcRoute = conn->route;
+		return tcItem;
+	}
+
 	index = pEntry->scanStart;
 
 	pthread_mutex_lock(&ic_control_info.lock);
@@ -3892,6 +5278,9 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 		if (conn->stillActive)
 			activeCount++;
 
+		if (conn->shmRing != NULL)
+			pumpShmConn(conn);
+
 		ic_statistics.totalRecvQueueSize += conn->pkt_q_size;
 		ic_statistics.recvQueueSizeCountingTime++;
 
@@ -3907,6 +5296,8 @@ RecvTupleChunkFromAnyUDPIFC_Internal(ChunkTransportState *transportStates,
 	{
 		pthread_mutex_unlock(&ic_control_info.lock);
 
+		decompressRxPacket(conn);
+
 		tcItem = RecvTupleChunk(conn, transportStates);
 		*srcRoute = conn->route;
 		pEntry->scanStart = index + 1;
@@ -3997,6 +5388,9 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 	getChunkTransportState(transportStates, motNodeID, &pEntry);
 	conn = pEntry->conns + srcRoute;
 
+	if (pEntry->numRuntimeFilters > 0)
+		sendPendingRuntimeFilters(pEntry);
+
 #ifdef AMS_VERBOSE_LOGGING
 	if (!conn->stillActive)
 	{
@@ -4012,6 +5406,9 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 		return NULL;
 	}
 
+	if (conn->shmRing != NULL)
+		pumpShmConn(conn);
+
 	ic_statistics.totalRecvQueueSize += conn->pkt_q_size;
 	ic_statistics.recvQueueSizeCountingTime++;
 
@@ -4021,6 +5418,8 @@ RecvTupleChunkFromUDPIFC_Internal(ChunkTransportState *transportStates,
 
 		pthread_mutex_unlock(&ic_control_info.lock);
 
+		decompressRxPacket(conn);
+
 		TupleChunkListItem tcItem = NULL;
 
 		tcItem = RecvTupleChunk(conn, transportStates);
@@ -4139,6 +5538,150 @@ logPkt(char *prefix, icpkthdr *pkt)
 			  pkt->flags);
 }
 
+/*
+ * bbrInit
+ * 		Reset the bbr flow control state of an outgoing connection.
+ */
+static void
+bbrInit(MotionConn *conn)
+{
+	ICBbrState *bbr = &conn->bbr;
+
+	memset(bbr, 0, sizeof(ICBbrState));
+	bbr->mode = BBR_STARTUP;
+	bbr->pacingGain = BBR_HIGH_GAIN;
+	bbr->cwnd = Max(BBR_MIN_CWND, Gp_interconnect_snd_queue_depth);
+	bbr->minRtt = ~((uint64) 0);
+}
+
+/*
+ * bbrCanSend
+ * 		Whether the connection's window and pacing allow to send a packet now.
+ */
+static inline bool
+bbrCanSend(MotionConn *conn, uint64 now)
+{
+	if (icBufferListLength(&conn->unackQueue) >= conn->bbr.cwnd)
+		return false;
+
+	return now >= conn->bbr.nextSendTime;
+}
+
+/*
+ * bbrOnSend
+ * 		Called by sender after a packet has been queued for sending.
+ *
+ * Snapshots the delivery state into the buffer, for the rate sample taken when
+ * it is acked, and computes when the next packet may go out.
+ */
+static inline void
+bbrOnSend(MotionConn *conn, ICBuffer *buf, uint64 now)
+{
+	ICBbrState *bbr = &conn->bbr;
+
+	if (bbr->deliveredTime == 0)
+		bbr->deliveredTime = now;
+
+	buf->delivered = bbr->delivered;
+	buf->deliveredTime = bbr->deliveredTime;
+
+	/* no bandwidth estimate yet, the window alone limits the rate */
+	if (bbr->bw > 0)
+		bbr->nextSendTime = Max(bbr->nextSendTime, now) +
+			(uint64) (USECS_PER_SECOND / (bbr->pacingGain * bbr->bw));
+}
+
+/*
+ * bbrOnAck
+ * 		Update the bbr model of a connection with an acked packet.
+ *
+ * Only called for packets that were not retransmitted, so that ackTime is a
+ * valid RTT sample.
+ */
+static void
+bbrOnAck(MotionConn *conn, ICBuffer *buf, uint64 ackTime, uint64 now)
+{
+	ICBbrState *bbr = &conn->bbr;
+	uint64		interval;
+	float		bdp;
+	int			i;
+
+	bbr->delivered++;
+	bbr->deliveredTime = now;
+
+	/* min RTT filter, the old minimum expires after BBR_MIN_RTT_WINDOW */
+	ackTime = Max(ackTime, MIN_RTT);
+	if (ackTime <= bbr->minRtt || now - bbr->minRttStamp > BBR_MIN_RTT_WINDOW)
+	{
+		bbr->minRtt = ackTime;
+		bbr->minRttStamp = now;
+	}
+
+	/* a round trip ends when a packet sent after its start is acked */
+	if (buf->delivered >= bbr->nextRoundDelivered)
+	{
+		bbr->nextRoundDelivered = bbr->delivered;
+		bbr->round++;
+		bbr->bwSamples[bbr->round % IC_BBR_BW_FILTER_ROUNDS] = 0;
+
+		if (bbr->mode == BBR_STARTUP && bbr->bw > 0)
+		{
+			if (bbr->bw >= bbr->fullBw * BBR_FULL_BW_THRESHOLD)
+			{
+				bbr->fullBw = bbr->bw;
+				bbr->fullBwCount = 0;
+			}
+			else if (++bbr->fullBwCount >= BBR_FULL_BW_ROUNDS)
+			{
+				bbr->mode = BBR_DRAIN;
+				bbr->pacingGain = BBR_DRAIN_GAIN;
+			}
+		}
+	}
+
+	/*
+	 * Delivery rate sample: packets delivered since this one was sent, over
+	 * the longer of the send and the ack intervals.
+	 */
+	interval = Max(now - buf->deliveredTime, ackTime);
+	if (interval > 0)
+	{
+		float		sample = (float) (bbr->delivered - buf->delivered) *
+			USECS_PER_SECOND / interval;
+		int			slot = bbr->round % IC_BBR_BW_FILTER_ROUNDS;
+
+		bbr->bwSamples[slot] = Max(bbr->bwSamples[slot], sample);
+	}
+
+	bbr->bw = 0;
+	for (i = 0; i < IC_BBR_BW_FILTER_ROUNDS; i++)
+		bbr->bw = Max(bbr->bw, bbr->bwSamples[i]);
+
+	bdp = bbr->bw * bbr->minRtt / USECS_PER_SECOND;
+
+	if (bbr->mode == BBR_DRAIN && icBufferListLength(&conn->unackQueue) <= bdp)
+	{
+		bbr->mode = BBR_PROBE_BW;
+		bbr->cycleIndex = 0;
+		bbr->cycleStamp = now;
+		bbr->pacingGain = bbrPacingGainCycle[0];
+	}
+	else if (bbr->mode == BBR_PROBE_BW && now - bbr->cycleStamp > bbr->minRtt)
+	{
+		bbr->cycleIndex = (bbr->cycleIndex + 1) % BBR_GAIN_CYCLE_LEN;
+		bbr->cycleStamp = now;
+		bbr->pacingGain = bbrPacingGainCycle[bbr->cycleIndex];
+	}
+
+	if (bbr->bw > 0)
+	{
+		float		gain = (bbr->mode == BBR_PROBE_BW) ? BBR_CWND_GAIN : BBR_HIGH_GAIN;
+
+		/* the send buffer pool bounds the packets in flight anyway */
+		bbr->cwnd = Max(gain * bdp, BBR_MIN_CWND);
+	}
+}
+
 /*
  * handleAckedPacket
  * 		Called by sender to process acked packet.
@@ -4174,7 +5717,7 @@ handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now)
 
 	buf = icBufferListDelete(&ackConn->unackQueue, buf);
 
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+	if (UNACK_QUEUE_RING_ENABLED())
 	{
 		buf = icBufferListDelete(&unack_queue_ring.slots[buf->unackQueueRingSlot], buf);
 		unack_queue_ring.numOutStanding--;
@@ -4206,11 +5749,16 @@ handleAckedPacket(MotionConn *ackConn, ICBuffer *buf, uint64 now)
 				buf->conn->dev = newDEV;
 
 				/* adjust the congestion control window. */
-				if (snd_control_info.cwnd < snd_control_info.ssthresh)
-					snd_control_info.cwnd += 1;
+				if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_BBR)
+					bbrOnAck(buf->conn, buf, ackTime, now);
 				else
-					snd_control_info.cwnd += 1 / snd_control_info.cwnd;
-				snd_control_info.cwnd = Min(snd_control_info.cwnd, snd_buffer_pool.maxCount);
+				{
+					if (snd_control_info.cwnd < snd_control_info.ssthresh)
+						snd_control_info.cwnd += 1;
+					else
+						snd_control_info.cwnd += 1 / snd_control_info.cwnd;
+					snd_control_info.cwnd = Min(snd_control_info.cwnd, snd_buffer_pool.maxCount);
+				}
 			}
 		}
 	}
@@ -4269,7 +5817,7 @@ handleAcks(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntr
 
 		/* ready to read on our socket ? */
 		peerlen = sizeof(peer);
-		n = recvfrom(pEntry->txfd, (char *) pkt, MIN_PACKET_SIZE, 0,
+		n = recvfrom(pEntry->txfd, (char *) pkt, RUNTIME_FILTER_PACKET_SIZE, 0,
 					 (struct sockaddr *) &peer, &peerlen);
 
 		if (n < 0)
@@ -4338,6 +5886,26 @@ handleAcks(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntr
 				continue;
 			}
 
+			/* the receiver of a shared memory connection made room */
+			if (pkt->flags & UDPIC_FLAGS_SHM_WAKEUP)
+				continue;
+
+			/* the receiver declined our shared memory ring */
+			if (pkt->flags & UDPIC_FLAGS_SHM_OFFER)
+			{
+				ackConn->shmDeclined = true;
+				continue;
+			}
+
+			/* the receiver sent back a runtime filter */
+			if (pkt->flags & UDPIC_FLAGS_RUNTIME_FILTER)
+			{
+				SaveMotionRuntimeFilter(pEntry, ackConn,
+										(char *) pkt + sizeof(icpkthdr),
+										pkt->len - sizeof(icpkthdr));
+				continue;
+			}
+
 			ackConn->stat_count_acks++;
 			ic_statistics.recvAckNum++;
 
@@ -4522,10 +6090,14 @@ prepareXmit(MotionConn *conn)
 
 	memcpy(conn->pBuff, &conn->conn_info, sizeof(conn->conn_info));
 
+	/* packets through shared memory are neither compressed nor checksummed */
+	if (gp_interconnect_compression && conn->shmRing == NULL)
+		compressPacket(conn);
+
 	/* increase the sequence no */
 	conn->conn_info.seq++;
 
-	if (gp_interconnect_full_crc)
+	if (gp_interconnect_full_crc && conn->shmRing == NULL)
 	{
 		icpkthdr   *pkt = (icpkthdr *) conn->pBuff;
 
@@ -4533,6 +6105,144 @@ prepareXmit(MotionConn *conn)
 	}
 }
 
+/*
+ * compressPacket
+ * 		Compress the payload of the packet being prepared in conn->pBuff,
+ * 		if it is worth it.
+ *
+ * Called from prepareXmit(), after the header has been copied into the
+ * packet.
+ */
+static void
+compressPacket(MotionConn *conn)
+{
+#ifdef HAVE_LIBZSTD
+	static ZSTD_CCtx *cctx = NULL;
+	static char *scratch = NULL;
+	static size_t scratchlen = 0;
+
+	icpkthdr   *pkt = (icpkthdr *) conn->pBuff;
+	char	   *payload = (char *) conn->pBuff + sizeof(icpkthdr);
+	int			rawlen = pkt->len - sizeof(icpkthdr);
+	size_t		clen;
+
+	if (rawlen < COMPRESS_MIN_PAYLOAD)
+		return;
+
+	if (conn->compress_skip > 0)
+	{
+		conn->compress_skip--;
+		return;
+	}
+
+	if (cctx == NULL)
+	{
+		cctx = ZSTD_createCCtx();
+		if (cctx == NULL)
+			elog(ERROR, "out of memory");
+	}
+	if (scratchlen < ZSTD_compressBound(rawlen))
+	{
+		size_t		newlen = ZSTD_compressBound(Max(rawlen, Gp_max_packet_size));
+
+		if (scratch)
+			pfree(scratch);
+		scratch = MemoryContextAlloc(TopMemoryContext, newlen);
+		scratchlen = newlen;
+	}
+
+	clen = ZSTD_compressCCtx(cctx, scratch, scratchlen, payload, rawlen,
+							 COMPRESS_LEVEL);
+	if (ZSTD_isError(clen))
+		elog(ERROR, "interconnect compression failed: %s",
+			 ZSTD_getErrorName(clen));
+
+	if (clen > rawlen - rawlen / COMPRESS_MIN_SAVING_FRACTION)
+	{
+		/* Not worth it.  Back off for a while before trying again. */
+		conn->compress_backoff = Min(Max(conn->compress_backoff * 2, 1),
+									 COMPRESS_MAX_BACKOFF);
+		conn->compress_skip = conn->compress_backoff;
+		return;
+	}
+
+	conn->compress_backoff = 0;
+	conn->stat_compressed_pkts++;
+	conn->stat_compress_saved_bytes += rawlen - clen;
+
+	memcpy(payload, scratch, clen);
+	pkt->len = sizeof(icpkthdr) + clen;
+	pkt->flags |= UDPIC_FLAGS_COMPRESSED;
+#endif							/* HAVE_LIBZSTD */
+}
+
+/*
+ * decompressRxPacket
+ * 		Decompress the packet that prepareRxConnForRead() made current, in
+ * 		place, and account for its size.
+ *
+ * Must be called by the main thread without ic_control_info.lock held, as
+ * it may ereport().
+ */
+static void
+decompressRxPacket(MotionConn *conn)
+{
+	icpkthdr   *pkt = (icpkthdr *) conn->pBuff;
+	int			wirelen = pkt->len - sizeof(icpkthdr);
+
+	if (pkt->flags & UDPIC_FLAGS_COMPRESSED)
+	{
+#ifdef HAVE_LIBZSTD
+		static ZSTD_DCtx *dctx = NULL;
+		static char *scratch = NULL;
+		static int	scratchlen = 0;
+		char	   *payload = (char *) conn->pBuff + sizeof(icpkthdr);
+		size_t		rawlen;
+
+		if (dctx == NULL)
+		{
+			dctx = ZSTD_createDCtx();
+			if (dctx == NULL)
+				elog(ERROR, "out of memory");
+		}
+		if (scratchlen < wirelen)
+		{
+			if (scratch)
+				pfree(scratch);
+			scratch = MemoryContextAlloc(TopMemoryContext, Gp_max_packet_size);
+			scratchlen = Gp_max_packet_size;
+		}
+
+		/*
+		 * The rx buffer is Gp_max_packet_size bytes, which is enough for the
+		 * original packet.  Move the compressed data aside and decompress it
+		 * back into the buffer.
+		 */
+		memcpy(scratch, payload, wirelen);
+		rawlen = ZSTD_decompressDCtx(dctx, payload,
+									 Gp_max_packet_size - sizeof(icpkthdr),
+									 scratch, wirelen);
+		if (ZSTD_isError(rawlen))
+			ereport(ERROR,
+					(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+					 errmsg("interconnect error: could not decompress packet from seg%d: %s",
+							conn->remoteContentId, ZSTD_getErrorName(rawlen))));
+
+		pkt->len = sizeof(icpkthdr) + rawlen;
+		pkt->flags &= ~UDPIC_FLAGS_COMPRESSED;
+		conn->msgSize = pkt->len;
+		conn->recvBytes = pkt->len;
+#else
+		ereport(ERROR,
+				(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+				 errmsg("interconnect error: received a compressed packet, but zstd is not supported by this build")));
+#endif							/* HAVE_LIBZSTD */
+	}
+
+	conn->stat_wire_bytes += wirelen;
+	conn->stat_raw_bytes += pkt->len - sizeof(icpkthdr);
+}
+
 /*
  * sendOnce
  * 		Send a packet.
@@ -4560,47 +6270,159 @@ xmit_retry:
 		if (errno == EINTR)
 			goto xmit_retry;
 
-		if (errno == EAGAIN)	/* no space ? not an error. */
-			return;
+		if (errno == EAGAIN)	/* no space ? not an error. */
+			return;
+
+		/*
+		 * If Linux iptables (nf_conntrack?) drops an outgoing packet, it may
+		 * return an EPERM to the application. This might be simply because of
+		 * traffic shaping or congestion, so ignore it.
+		 */
+		if (errno == EPERM)
+		{
+			ereport(LOG,
+					(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+					 errmsg("Interconnect error writing an outgoing packet: %m"),
+					 errdetail("error during sendto() for Remote Connection: contentId=%d at %s",
+							   conn->remoteContentId, conn->remoteHostAndPort)));
+			return;
+		}
+
+		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						errmsg("Interconnect error writing an outgoing packet: %m"),
+						errdetail("error during sendto() call (error:%d).\n"
+								  "For Remote Connection: contentId=%d at %s",
+								  errno, conn->remoteContentId,
+								  conn->remoteHostAndPort)));
+		/* not reached */
+	}
+
+	if (n != buf->pkt->len)
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendto() call."
+					  "For Remote Connection: contentId=%d at %s", buf->pkt->seq, buf->pkt->len, n,
+					  conn->remoteContentId,
+					  conn->remoteHostAndPort);
+#ifdef AMS_VERBOSE_LOGGING
+		logPkt("PKT DETAILS ", buf->pkt);
+#endif
+	}
+
+	return;
+}
+
+#ifdef HAVE_UDPIFC_MMSG
+/*
+ * addToSendBatch
+ * 		Queue a packet for the next sendmmsg() call, flushing the batch if
+ * 		it is full.
+ *
+ * The caller must flush the batch with flushSendBatch() before processing
+ * anything that may release the queued buffers.
+ */
+static void
+addToSendBatch(ChunkTransportStateEntry *pEntry, ICBuffer *buf, MotionConn *conn)
+{
+	struct mmsghdr *msg;
+
+#ifdef USE_ASSERT_CHECKING
+	if (testmode_inject_fault(gp_udpic_dropxmit_percent))
+	{
+#ifdef AMS_VERBOSE_LOGGING
+		write_log("THROW PKT with seq %d srcpid %d despid %d", buf->pkt->seq, buf->pkt->srcPid, buf->pkt->dstPid);
+#endif
+		return;
+	}
+#endif
+
+	Assert(snd_batch.count < MMSG_BATCH_SIZE);
+
+	snd_batch.iov[snd_batch.count].iov_base = buf->pkt;
+	snd_batch.iov[snd_batch.count].iov_len = buf->pkt->len;
+
+	msg = &snd_batch.msgs[snd_batch.count];
+	memset(msg, 0, sizeof(*msg));
+	msg->msg_hdr.msg_name = &conn->peer;
+	msg->msg_hdr.msg_namelen = conn->peer_len;
+	msg->msg_hdr.msg_iov = &snd_batch.iov[snd_batch.count];
+	msg->msg_hdr.msg_iovlen = 1;
+
+	snd_batch.count++;
+
+	if (snd_batch.count == MMSG_BATCH_SIZE)
+		flushSendBatch(pEntry, conn);
+}
+
+/*
+ * flushSendBatch
+ * 		Send the packets queued by addToSendBatch().
+ *
+ * The error handling follows sendOnce(): the packets are already in the
+ * unack queue, so the ones we fail to send with EAGAIN or EPERM are simply
+ * left to the retransmission logic.
+ */
+static void
+flushSendBatch(ChunkTransportStateEntry *pEntry, MotionConn *conn)
+{
+	int			first = 0;
+	int			n;
+	int			i;
+
+	while (first < snd_batch.count)
+	{
+		n = sendmmsg(pEntry->txfd, &snd_batch.msgs[first], snd_batch.count - first, 0);
+		ic_statistics.sndSyscallNum++;
+		if (n > 0)
+			ic_statistics.sndSyscallPktNum += n;
+
+		if (n < 0)
+		{
+			if (errno == EINTR)
+				continue;
+
+			if (errno == EAGAIN)	/* no space ? not an error. */
+				break;
 
-		/*
-		 * If Linux iptables (nf_conntrack?) drops an outgoing packet, it may
-		 * return an EPERM to the application. This might be simply because of
-		 * traffic shaping or congestion, so ignore it.
-		 */
-		if (errno == EPERM)
-		{
-			ereport(LOG,
-					(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-					 errmsg("Interconnect error writing an outgoing packet: %m"),
-					 errdetail("error during sendto() for Remote Connection: contentId=%d at %s",
-							   conn->remoteContentId, conn->remoteHostAndPort)));
-			return;
+			/* See sendOnce(). Skip the packet the kernel refused. */
+			if (errno == EPERM)
+			{
+				ereport(LOG,
+						(errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+						 errmsg("Interconnect error writing an outgoing packet: %m"),
+						 errdetail("error during sendmmsg() for Remote Connection: contentId=%d at %s",
+								   conn->remoteContentId, conn->remoteHostAndPort)));
+				first++;
+				continue;
+			}
+
+			snd_batch.count = 0;
+			ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
+							errmsg("Interconnect error writing an outgoing packet: %m"),
+							errdetail("error during sendmmsg() call (error:%d).\n"
+									  "For Remote Connection: contentId=%d at %s",
+									  errno, conn->remoteContentId,
+									  conn->remoteHostAndPort)));
+			/* not reached */
 		}
 
-		ereport(ERROR, (errcode(ERRCODE_GP_INTERCONNECTION_ERROR),
-						errmsg("Interconnect error writing an outgoing packet: %m"),
-						errdetail("error during sendto() call (error:%d).\n"
-								  "For Remote Connection: contentId=%d at %s",
-								  errno, conn->remoteContentId,
-								  conn->remoteHostAndPort)));
-		/* not reached */
-	}
+		for (i = first; i < first + n; i++)
+		{
+			icpkthdr   *pkt = (icpkthdr *) snd_batch.iov[i].iov_base;
 
-	if (n != buf->pkt->len)
-	{
-		if (DEBUG1 >= log_min_messages)
-			write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendto() call."
-					  "For Remote Connection: contentId=%d at %s", buf->pkt->seq, buf->pkt->len, n,
-					  conn->remoteContentId,
-					  conn->remoteHostAndPort);
-#ifdef AMS_VERBOSE_LOGGING
-		logPkt("PKT DETAILS ", buf->pkt);
-#endif
+			if (snd_batch.msgs[i].msg_len != pkt->len && DEBUG1 >= log_min_messages)
+				write_log("Interconnect error writing an outgoing packet [seq %d]: short transmit (given %d sent %d) during sendmmsg() call."
+						  "For Remote Connection: contentId=%d at %s", pkt->seq, pkt->len, snd_batch.msgs[i].msg_len,
+						  conn->remoteContentId,
+						  conn->remoteHostAndPort);
+		}
+
+		first += n;
 	}
 
-	return;
+	snd_batch.count = 0;
 }
+#endif							/* HAVE_UDPIFC_MMSG */
 
 
 /*
@@ -4707,10 +6529,19 @@ handleStopMsgs(ChunkTransportState *transportStates, ChunkTransportStateEntry *p
  *
  * After sending a buffer, the buffer will be placed into both the unack queue and
  * the corresponding queue in the unack queue ring.
+ *
+ * With gp_interconnect_batch_syscalls, the buffers are handed to the kernel
+ * in batches after they have been queued, see addToSendBatch().
  */
 static void
 sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEntry, MotionConn *conn)
 {
+#ifdef HAVE_UDPIFC_MMSG
+	bool		batched = gp_interconnect_batch_syscalls;
+
+	snd_batch.count = 0;
+#endif
+
 	while (conn->capacity > 0 && icBufferListLength(&conn->sndQueue) > 0)
 	{
 		ICBuffer   *buf = NULL;
@@ -4720,6 +6551,11 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 			 unack_queue_ring.numSharedOutStanding >= (snd_control_info.cwnd - snd_control_info.minCwnd)))
 			break;
 
+		if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_BBR &&
+			icBufferListLength(&conn->unackQueue) > 0 &&
+			!bbrCanSend(conn, getCurrentTime()))
+			break;
+
 		/* for connection setup, we only allow one outstanding packet. */
 		if (conn->state == mcsSetupOutgoingConnection && icBufferListLength(&conn->unackQueue) >= 1)
 			break;
@@ -4736,7 +6572,10 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		icBufferListAppend(&conn->unackQueue, buf);
 
-		if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+		if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_BBR)
+			bbrOnSend(conn, buf, now);
+
+		if (UNACK_QUEUE_RING_ENABLED())
 		{
 			unack_queue_ring.numOutStanding++;
 			if (icBufferListLength(&conn->unackQueue) > 1)
@@ -4760,7 +6599,16 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 		updateStats(TPE_DATA_PKT_SEND, conn, buf->pkt);
 #endif
 
-		sendOnce(transportStates, pEntry, buf, conn);
+#ifdef HAVE_UDPIFC_MMSG
+		if (batched)
+			addToSendBatch(pEntry, buf, conn);
+		else
+#endif
+		{
+			sendOnce(transportStates, pEntry, buf, conn);
+			ic_statistics.sndSyscallNum++;
+			ic_statistics.sndSyscallPktNum++;
+		}
 		ic_statistics.sndPktNum++;
 
 #ifdef AMS_VERBOSE_LOGGING
@@ -4769,6 +6617,11 @@ sendBuffers(ChunkTransportState *transportStates, ChunkTransportStateEntry *pEnt
 
 		buf->conn->sentSeq = buf->pkt->seq;
 	}
+
+#ifdef HAVE_UDPIFC_MMSG
+	if (batched && snd_batch.count > 0)
+		flushSendBatch(pEntry, conn);
+#endif
 }
 
 /*
@@ -4912,7 +6765,7 @@ handleAckForDisorderPkt(ChunkTransportState *transportStates,
 			/* this is a lost packet, retransmit */
 
 			buf->nRetry++;
-			if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+			if (UNACK_QUEUE_RING_ENABLED())
 			{
 				buf = icBufferListDelete(&unack_queue_ring.slots[buf->unackQueueRingSlot], buf);
 				putIntoUnackQueueRing(&unack_queue_ring, buf,
@@ -5148,7 +7001,7 @@ checkExpiration(ChunkTransportState *transportStates,
 	 * deal with case when there is a long time this function is not called.
 	 */
 	unack_queue_ring.currentTime = now - (now % TIMER_SPAN);
-	if (retransmits > 0)
+	if (retransmits > 0 && Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
 	{
 		snd_control_info.ssthresh = Max(snd_control_info.cwnd / 2, snd_control_info.minCwnd);
 		snd_control_info.cwnd = snd_control_info.minCwnd;
@@ -5327,7 +7180,7 @@ checkExceptions(ChunkTransportState *transportStates,
 		checkExpirationCapacityFC(transportStates, pEntry, conn, timeout);
 	}
 
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+	if (UNACK_QUEUE_RING_ENABLED())
 	{
 		uint64		now = getCurrentTime();
 
@@ -5338,6 +7191,11 @@ checkExceptions(ChunkTransportState *transportStates,
 		}
 	}
 
+	/* packets held back by pacing are not clocked out by acks */
+	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_BBR &&
+		icBufferListLength(&conn->sndQueue) > 0)
+		sendBuffers(transportStates, pEntry, conn);
+
 	if ((retry & 0x3) == 2)
 	{
 		checkDeadlock(pEntry, conn);
@@ -5380,7 +7238,19 @@ computeTimeout(MotionConn *conn, int retry)
 	if (buf->nRetry == 0 && retry == 0)
 		return 0;
 
-	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_LOSS)
+	/* wake up in time to send the next paced packet */
+	if (Gp_interconnect_fc_method == INTERCONNECT_FC_METHOD_BBR &&
+		icBufferListLength(&conn->sndQueue) > 0 &&
+		icBufferListLength(&conn->unackQueue) < conn->bbr.cwnd)
+	{
+		uint64		now = getCurrentTime();
+
+		if (conn->bbr.nextSendTime > now)
+			return Min(TIMER_CHECKING_PERIOD,
+					   (int) ((conn->bbr.nextSendTime - now + 999) / 1000));
+	}
+
+	if (UNACK_QUEUE_RING_ENABLED())
 		return TIMER_CHECKING_PERIOD;
 
 	/* for capacity based flow control */
@@ -5433,8 +7303,41 @@ SendChunkUDPIFC(ChunkTransportState *transportStates,
 
 	/* try to send it */
 
+	if (conn->shmRing != NULL && !conn->shmAccepted)
+	{
+		awaitShmAccept(transportStates, pEntry, conn, &gotStops);
+		if (gotStops)
+		{
+			handleStopMsgs(transportStates, pEntry, motionId);
+			if (!conn->stillActive)
+				return true;
+			gotStops = false;
+		}
+	}
+
 	prepareXmit(conn);
 
+	if (conn->shmRing != NULL)
+	{
+		if (!sendShmPacket(transportStates, pEntry, conn, &gotStops) || gotStops)
+		{
+			handleStopMsgs(transportStates, pEntry, motionId);
+			if (!conn->stillActive)
+				return true;
+		}
+
+		/* the packet has been copied into the ring, reuse the buffer */
+		conn->tupleCount = 0;
+		conn->msgSize = sizeof(conn->conn_info);
+
+		memcpy(conn->pBuff + conn->msgSize, tcItem->chunk_data, tcItem->chunk_length);
+		conn->msgSize += length;
+
+		conn->tupleCount++;
+
+		return true;
+	}
+
 	icBufferListAppend(&conn->sndQueue, conn->curBuff);
 	sendBuffers(transportStates, pEntry, conn);
 
@@ -5564,11 +7467,29 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 			if (pEntry->sendingEos)
 				conn->conn_info.flags |= UDPIC_FLAGS_EOS;
 
+			if (conn->shmRing != NULL && !conn->shmAccepted)
+			{
+				bool		gotStops = false;
+
+				awaitShmAccept(transportStates, pEntry, conn, &gotStops);
+			}
+
 			prepareXmit(conn);
 
-			/* place it into the send queue */
-			icBufferListAppend(&conn->sndQueue, conn->curBuff);
-			sendBuffers(transportStates, pEntry, conn);
+			if (conn->shmRing != NULL)
+			{
+				bool		gotStops = false;
+
+				/* a stopped receiver doesn't need the EOS */
+				(void) sendShmPacket(transportStates, pEntry, conn, &gotStops);
+				icBufferListAppend(&snd_buffer_pool.freeList, conn->curBuff);
+			}
+			else
+			{
+				/* place it into the send queue */
+				icBufferListAppend(&conn->sndQueue, conn->curBuff);
+				sendBuffers(transportStates, pEntry, conn);
+			}
 
 			conn->tupleCount = 0;
 			conn->msgSize = sizeof(conn->conn_info);
@@ -5597,7 +7518,17 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 		{
 			conn = pEntry->conns + i;
 
-			if (conn->stillActive)
+			if (conn->stillActive && conn->shmRing != NULL)
+			{
+				bool		gotStops = false;
+
+				/* wait until the receiver has queued everything */
+				(void) waitShmRing(transportStates, pEntry, conn, true, &gotStops);
+
+				conn->state = mcsEosSent;
+				conn->stillActive = false;
+			}
+			else if (conn->stillActive)
 			{
 				retry = 0;
 				ic_control_info.lastPacketSendTime = 0;
@@ -5633,6 +7564,113 @@ SendEosUDPIFC(ChunkTransportState *transportStates,
 		elog(DEBUG1, "SendEosUDPIFC leaving, activeCount %d", activeCount);
 }
 
+/*
+ * doSendRuntimeFilterUDPIFC
+ * 		Send a runtime filter to all senders.
+ *
+ * The filter goes in a control packet, like acks, to the address the data
+ * packets of the sender come from.  Where no packet came yet, it is kept
+ * and sent once one does.  Lost filters aren't resent: the sender just
+ * doesn't filter then.
+ */
+static void
+doSendRuntimeFilterUDPIFC(ChunkTransportState *transportStates, int16 motNodeID,
+						  const char *data, int len)
+{
+	ChunkTransportStateEntry *pEntry = NULL;
+	char	   *filter;
+	int			i;
+
+	if (!transportStates->activated)
+		return;
+
+	getChunkTransportState(transportStates, motNodeID, &pEntry);
+	Assert(pEntry);
+
+	filter = MemoryContextAlloc(InterconnectContext, len);
+	memcpy(filter, data, len);
+
+	pthread_mutex_lock(&ic_control_info.lock);
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *conn = pEntry->conns + i;
+
+		if (!conn->stillActive)
+			continue;
+
+		conn->runtimeFilter = filter;
+		conn->runtimeFilterLen = len;
+
+		if (conn->peer_len != 0)
+			sendRuntimeFilter(conn);
+		else
+			pEntry->numRuntimeFilters++;
+	}
+
+	pthread_mutex_unlock(&ic_control_info.lock);
+}
+
+/*
+ * sendRuntimeFilter
+ * 		Send the runtime filter kept for a connection to its sender.
+ *
+ * The caller holds ic_control_info.lock.
+ */
+static void
+sendRuntimeFilter(MotionConn *conn)
+{
+	icpkthdr   *pkt = rx_control_info.runtimeFilterBuffer;
+
+	memcpy(pkt, (char *) &conn->conn_info, sizeof(icpkthdr));
+	pkt->flags = UDPIC_FLAGS_RECEIVER_TO_SENDER | UDPIC_FLAGS_RUNTIME_FILTER;
+	pkt->seq = 0;
+	pkt->extraSeq = 0;
+	pkt->len = sizeof(icpkthdr) + conn->runtimeFilterLen;
+	memcpy((char *) pkt + sizeof(icpkthdr), conn->runtimeFilter,
+		   conn->runtimeFilterLen);
+
+	sendControlMessage(pkt, UDP_listenerFd, (struct sockaddr *) &conn->peer, conn->peer_len);
+
+	/* the filter is shared by the connections, and freed at teardown */
+	conn->runtimeFilter = NULL;
+	conn->runtimeFilterLen = 0;
+}
+
+/*
+ * sendPendingRuntimeFilters
+ * 		Send the runtime filters kept for the senders we now know.
+ */
+static void
+sendPendingRuntimeFilters(ChunkTransportStateEntry *pEntry)
+{
+	int			i;
+
+	pthread_mutex_lock(&ic_control_info.lock);
+
+	for (i = 0; i < pEntry->numConns; i++)
+	{
+		MotionConn *conn = pEntry->conns + i;
+
+		if (conn->runtimeFilter == NULL)
+			continue;
+
+		if (!conn->stillActive)
+		{
+			conn->runtimeFilter = NULL;
+			conn->runtimeFilterLen = 0;
+		}
+		else if (conn->peer_len != 0)
+			sendRuntimeFilter(conn);
+		else
+			continue;
+
+		pEntry->numRuntimeFilters--;
+	}
+
+	pthread_mutex_unlock(&ic_control_info.lock);
+}
+
 /*
  * doSendStopMessageUDPIFC
  * 		Send stop messages to all senders.
@@ -5687,6 +7725,26 @@ doSendStopMessageUDPIFC(ChunkTransportState *transportStates, int16 motNodeID)
 					putRxBufferAndSendAck(conn, NULL);
 				}
 			}
+			else if (conn->shmRing != NULL)
+			{
+				conn->stopRequested = true;
+				conn->conn_info.flags |= UDPIC_FLAGS_STOP;
+
+				/*
+				 * Drop what is queued, pumpShmConn() drops the rest, and
+				 * leave the request in the ring.
+				 */
+				while (conn->pkt_q_size > 0)
+				{
+					putRxBufferAndSendAck(conn, NULL);
+				}
+				pg_atomic_write_u32(&conn->shmRing->stopRequested, 1);
+				wakeShmSender(conn, NULL);
+
+				if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
+					elog(DEBUG1, "sent stop request through shared memory. node %d route %d",
+						 motNodeID, i);
+			}
 			else
 			{
 				conn->stopRequested = true;
@@ -6033,6 +8091,9 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 			write_log("SAVE pkt at QUEUE HEAD [seq %d] for node %d route %d, queue head seq %d, queue size %d, queue head %d queue tail %d", pkt->seq, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 #endif
 			toWakeup = true;
+
+			if (conn->readyRing != NULL)
+				readyRingPush(conn->readyRing, conn->route);
 		}
 
 		if (pos == conn->pkt_q_tail)
@@ -6053,60 +8114,197 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 					write_log("RX_THREAD: the packet with EOS flag is available for access in the queue for route %d", conn->route);
 			}
 
-			/* ack data packet */
-			setAckSendParam(param, conn, UDPIC_FLAGS_CAPACITY | UDPIC_FLAGS_ACK | conn->conn_info.flags, conn->conn_info.seq - 1, conn->conn_info.extraSeq);
+			/* ack data packet */
+			setAckSendParam(param, conn, UDPIC_FLAGS_CAPACITY | UDPIC_FLAGS_ACK | conn->conn_info.flags, conn->conn_info.seq - 1, conn->conn_info.extraSeq);
+
+#ifdef AMS_VERBOSE_LOGGING
+			write_log("SAVE conn %p pkt at QUEUE TAIL [seq %d] at pos [%d] for node %d route %d, [head seq] %d, queue size %d, queue head %d queue tail %d", conn, pkt->seq, pos, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
+#endif
+		}
+		else					/* deal with out-of-order packet */
+		{
+			if (DEBUG1 >= log_min_messages)
+				write_log("SAVE conn %p OUT-OF-ORDER pkt [seq %d] at pos [%d] for node %d route %d, [head seq] %d, queue size %d, queue head %d queue tail %d", conn, pkt->seq, pos, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
+
+			/* send an ack for out-of-order packet */
+			ic_statistics.disorderedPktNum++;
+			handleDisorderPacket(conn, pos, headSeq + conn->pkt_q_size, pkt);
+		}
+	}
+	else						/* duplicate pkt */
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("DUPLICATE pkt [seq %d], [head seq] %d, queue size %d, queue head %d queue tail %d", pkt->seq, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
+
+		setAckSendParam(param, conn, UDPIC_FLAGS_DUPLICATE | conn->conn_info.flags, pkt->seq, conn->conn_info.seq - 1);
+		ic_statistics.duplicatedPktNum++;
+		return false;
+	}
+
+	/* Was the main thread waiting for something ? */
+	if (rx_control_info.mainWaitingState.waiting &&
+		rx_control_info.mainWaitingState.waitingNode == pkt->motNodeId &&
+		rx_control_info.mainWaitingState.waitingQuery == pkt->icId && toWakeup)
+	{
+		if (rx_control_info.mainWaitingState.waitingRoute == ANY_ROUTE)
+		{
+			if (rx_control_info.mainWaitingState.reachRoute == ANY_ROUTE)
+				rx_control_info.mainWaitingState.reachRoute = conn->route;
+		}
+		else if (rx_control_info.mainWaitingState.waitingRoute == conn->route)
+		{
+			if (DEBUG2 >= log_min_messages)
+				write_log("rx thread: main_waiting waking it route %d", rx_control_info.mainWaitingState.waitingRoute);
+			rx_control_info.mainWaitingState.reachRoute = conn->route;
+		}
+		/* WAKE MAIN THREAD HERE */
+		*wakeup_mainthread = true;
+	}
+
+	return true;
+}
+
+/*
+ * handleRxPacket
+ * 		Called by rx thread to process a datagram read from the listener socket.
+ *
+ * Returns true if the packet buffer has been taken over (queued on a
+ * connection or cached), false if the caller can reuse it.
+ *
+ * NOTE: This function MUST NOT contain elog or ereport statements.
+ * elog is NOT thread-safe.  Developers should instead use something like:
+ *
+ *	if (DEBUG3 >= log_min_messages)
+ *		write_log("my brilliant log statement here.");
+ *
+ * NOTE: In threads, we cannot use palloc/pfree, because it's not thread safe.
+ */
+static bool
+handleRxPacket(icpkthdr *pkt, int read_count, struct sockaddr_storage *peer, socklen_t peerlen)
+{
+	MotionConn *conn = NULL;
+	bool		consumed = false;
+	bool		wakeup_mainthread = false;
+	AckSendParam param;
+
+	if (read_count < sizeof(icpkthdr))
+	{
+		if (DEBUG1 >= log_min_messages)
+			write_log("Interconnect error: short conn receive (%d)", read_count);
+		return false;
+	}
+
+	/* length must be >= 0 */
+	if (pkt->len < 0)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound with negative length");
+		return false;
+	}
+
+	if (pkt->len != read_count)
+	{
+		if (DEBUG3 >= log_min_messages)
+			write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
+		return false;
+	}
+
+	/*
+	 * check the CRC of the payload.
+	 */
+	if (gp_interconnect_full_crc)
+	{
+		if (!checkCRC(pkt))
+		{
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
+			if (DEBUG2 >= log_min_messages)
+				write_log("received network data error, dropping bad packet, user data unaffected.");
+			return false;
+		}
+	}
 
 #ifdef AMS_VERBOSE_LOGGING
-			write_log("SAVE conn %p pkt at QUEUE TAIL [seq %d] at pos [%d] for node %d route %d, [head seq] %d, queue size %d, queue head %d queue tail %d", conn, pkt->seq, pos, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
+	logPkt("GOT MESSAGE", pkt);
 #endif
-		}
-		else					/* deal with out-of-order packet */
-		{
-			if (DEBUG1 >= log_min_messages)
-				write_log("SAVE conn %p OUT-OF-ORDER pkt [seq %d] at pos [%d] for node %d route %d, [head seq] %d, queue size %d, queue head %d queue tail %d", conn, pkt->seq, pos, pkt->motNodeId, conn->route, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
 
-			/* send an ack for out-of-order packet */
-			ic_statistics.disorderedPktNum++;
-			handleDisorderPacket(conn, pos, headSeq + conn->pkt_q_size, pkt);
-		}
-	}
-	else						/* duplicate pkt */
+	if (pkt->flags & UDPIC_FLAGS_SHM_WAKEUP)
 	{
-		if (DEBUG1 >= log_min_messages)
-			write_log("DUPLICATE pkt [seq %d], [head seq] %d, queue size %d, queue head %d queue tail %d", pkt->seq, headSeq, conn->pkt_q_size, conn->pkt_q_head, conn->pkt_q_tail);
+		handleShmWakeup(pkt, peer, peerlen);
+		return false;
+	}
 
-		setAckSendParam(param, conn, UDPIC_FLAGS_DUPLICATE | conn->conn_info.flags, pkt->seq, conn->conn_info.seq - 1);
-		ic_statistics.duplicatedPktNum++;
+	if (pkt->flags & UDPIC_FLAGS_SHM_OFFER)
+	{
+		handleShmOffer(pkt, peer, peerlen);
 		return false;
 	}
 
-	/* Was the main thread waiting for something ? */
-	if (rx_control_info.mainWaitingState.waiting &&
-		rx_control_info.mainWaitingState.waitingNode == pkt->motNodeId &&
-		rx_control_info.mainWaitingState.waitingQuery == pkt->icId && toWakeup)
+	memset(&param, 0, sizeof(AckSendParam));
+
+	/*
+	 * Get the connection for the pkt.
+	 *
+	 * The connection hash table should be locked until finishing the
+	 * processing of the packet to avoid the connection addition/removal from
+	 * the hash table during the mean time.
+	 */
+
+	pthread_mutex_lock(&ic_control_info.lock);
+	conn = findConnByHeader(&ic_control_info.connHtab, pkt);
+
+	if (conn != NULL)
 	{
-		if (rx_control_info.mainWaitingState.waitingRoute == ANY_ROUTE)
-		{
-			if (rx_control_info.mainWaitingState.reachRoute == ANY_ROUTE)
-				rx_control_info.mainWaitingState.reachRoute = conn->route;
-		}
-		else if (rx_control_info.mainWaitingState.waitingRoute == conn->route)
+		/* Handling a regular packet */
+		if (handleDataPacket(conn, pkt, peer, &peerlen, &param, &wakeup_mainthread))
+			consumed = true;
+		ic_statistics.recvPktNum++;
+	}
+	else
+	{
+		/*
+		 * There may have two kinds of Mismatched packets: a) Past packets
+		 * from previous command after I was torn down b) Future packets from
+		 * current command before my connections are built.
+		 *
+		 * The handling logic is to "Ack the past and Nak the future".
+		 */
+		if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
 		{
-			if (DEBUG2 >= log_min_messages)
-				write_log("rx thread: main_waiting waking it route %d", rx_control_info.mainWaitingState.waitingRoute);
-			rx_control_info.mainWaitingState.reachRoute = conn->route;
+			if (DEBUG1 >= log_min_messages)
+				write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
+
+#ifdef AMS_VERBOSE_LOGGING
+			logPkt("Got a Mismatched Packet", pkt);
+#endif
+
+			if (handleMismatch(pkt, peer, peerlen))
+				consumed = true;
+			ic_statistics.mismatchNum++;
 		}
-		/* WAKE MAIN THREAD HERE */
-		*wakeup_mainthread = true;
 	}
+	pthread_mutex_unlock(&ic_control_info.lock);
 
-	return true;
+	if (wakeup_mainthread)
+		SetLatch(&ic_control_info.latch);
+
+	/*
+	 * real ack sending is after lock release to decrease the lock holding
+	 * time.
+	 */
+	if (param.msg.len != 0)
+		sendAckWithParam(&param);
+
+	return consumed;
 }
 
 /*
  * rxThreadFunc
  * 		Main function of the receive background thread.
  *
+ * The thread keeps up to MMSG_BATCH_SIZE receive buffers at hand, so that it
+ * can read several datagrams with one recvmmsg() call when
+ * gp_interconnect_batch_syscalls is on. Otherwise only the first one is used.
+ *
  * NOTE: This function MUST NOT contain elog or ereport statements.
  * elog is NOT thread-safe.  Developers should instead use something like:
  *
@@ -6118,14 +8316,24 @@ handleDataPacket(MotionConn *conn, icpkthdr *pkt, struct sockaddr_storage *peer,
 static void *
 rxThreadFunc(void *arg)
 {
-	icpkthdr   *pkt = NULL;
+	icpkthdr   *pkts[MMSG_BATCH_SIZE];
+	struct sockaddr_storage peers[MMSG_BATCH_SIZE];
+#ifdef HAVE_UDPIFC_MMSG
+	struct iovec iov[MMSG_BATCH_SIZE];
+	struct mmsghdr msgs[MMSG_BATCH_SIZE];
+#endif
 	bool		skip_poll = false;
 	uint32		expected = 1;
+	int			i;
+
+	memset(pkts, 0, sizeof(pkts));
 
 	for (;;)
 	{
 		struct pollfd nfd;
 		int			n;
+		int			batchSize = 1;
+		int			nbufs;
 
 		/* check shutdown condition */
 		expected = 1;
@@ -6138,14 +8346,40 @@ rxThreadFunc(void *arg)
 			break;
 		}
 
-		/* Try to get a buffer */
-		if (pkt == NULL)
+#ifdef HAVE_UDPIFC_MMSG
+		if (gp_interconnect_batch_syscalls)
+			batchSize = MMSG_BATCH_SIZE;
+#endif
+
+		/*
+		 * Try to get buffers. The buffers left over from the previous round
+		 * are moved to the front, so that pkts[0 .. nbufs - 1] are usable.
+		 */
+		nbufs = 0;
+		for (i = 0; i < MMSG_BATCH_SIZE; i++)
+		{
+			if (pkts[i] != NULL)
+			{
+				pkts[nbufs] = pkts[i];
+				if (i != nbufs)
+					pkts[i] = NULL;
+				nbufs++;
+			}
+		}
+
+		if (nbufs < batchSize)
 		{
 			pthread_mutex_lock(&ic_control_info.lock);
-			pkt = getRxBuffer(&rx_buffer_pool);
+			while (nbufs < batchSize)
+			{
+				pkts[nbufs] = getRxBuffer(&rx_buffer_pool);
+				if (pkts[nbufs] == NULL)
+					break;
+				nbufs++;
+			}
 			pthread_mutex_unlock(&ic_control_info.lock);
 
-			if (pkt == NULL)
+			if (nbufs == 0)
 			{
 				setRxThreadError(ENOMEM);
 				continue;
@@ -6196,15 +8430,36 @@ rxThreadFunc(void *arg)
 			/* we've got something interesting to read */
 			/* handle incoming */
 			/* ready to read on our socket */
-			MotionConn *conn = NULL;
 			int			read_count = 0;
-
-			struct sockaddr_storage peer;
 			socklen_t	peerlen;
 
-			peerlen = sizeof(peer);
-			read_count = recvfrom(UDP_listenerFd, (char *) pkt, Gp_max_packet_size, 0,
-								  (struct sockaddr *) &peer, &peerlen);
+#ifdef HAVE_UDPIFC_MMSG
+			if (batchSize > 1 && nbufs > 1)
+			{
+				for (i = 0; i < nbufs; i++)
+				{
+					iov[i].iov_base = pkts[i];
+					iov[i].iov_len = Gp_max_packet_size;
+
+					memset(&msgs[i], 0, sizeof(msgs[i]));
+					msgs[i].msg_hdr.msg_name = &peers[i];
+					msgs[i].msg_hdr.msg_namelen = sizeof(peers[i]);
+					msgs[i].msg_hdr.msg_iov = &iov[i];
+					msgs[i].msg_hdr.msg_iovlen = 1;
+				}
+
+				/* the socket is non-blocking, this returns what is queued */
+				read_count = recvmmsg(UDP_listenerFd, msgs, nbufs, 0, NULL);
+				n = read_count;
+			}
+			else
+#endif
+			{
+				peerlen = sizeof(peers[0]);
+				read_count = recvfrom(UDP_listenerFd, (char *) pkts[0], Gp_max_packet_size, 0,
+									  (struct sockaddr *) &peers[0], &peerlen);
+				n = 1;
+			}
 
 			expected = 1;
 			if (pg_atomic_compare_exchange_u32((pg_atomic_uint32 *) &ic_control_info.shutdown, &expected, 0))
@@ -6240,12 +8495,8 @@ rxThreadFunc(void *arg)
 				continue;
 			}
 
-			if (read_count < sizeof(icpkthdr))
-			{
-				if (DEBUG1 >= log_min_messages)
-					write_log("Interconnect error: short conn receive (%d)", read_count);
-				continue;
-			}
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.rxSyscallNum, 1);
+			pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.rxDatagramNum, n);
 
 			/*
 			 * when we get a "good" recvfrom() result, we can skip poll()
@@ -6253,110 +8504,37 @@ rxThreadFunc(void *arg)
 			 */
 			skip_poll = true;
 
-			/* length must be >= 0 */
-			if (pkt->len < 0)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound with negative length");
-				continue;
-			}
-
-			if (pkt->len != read_count)
-			{
-				if (DEBUG3 >= log_min_messages)
-					write_log("received inbound packet [%d], short: read %d bytes, pkt->len %d", pkt->seq, read_count, pkt->len);
-				continue;
-			}
-
-			/*
-			 * check the CRC of the payload.
-			 */
-			if (gp_interconnect_full_crc)
+#ifdef HAVE_UDPIFC_MMSG
+			if (batchSize > 1 && nbufs > 1)
 			{
-				if (!checkCRC(pkt))
+				for (i = 0; i < n; i++)
 				{
-					pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &ic_statistics.crcErrors, 1);
-					if (DEBUG2 >= log_min_messages)
-						write_log("received network data error, dropping bad packet, user data unaffected.");
-					continue;
+					if (handleRxPacket(pkts[i], msgs[i].msg_len, &peers[i],
+									   msgs[i].msg_hdr.msg_namelen))
+						pkts[i] = NULL;
 				}
+				continue;
 			}
-
-#ifdef AMS_VERBOSE_LOGGING
-			logPkt("GOT MESSAGE", pkt);
-#endif
-
-			bool		wakeup_mainthread = false;
-			AckSendParam param;
-
-			memset(&param, 0, sizeof(AckSendParam));
-
-			/*
-			 * Get the connection for the pkt.
-			 *
-			 * The connection hash table should be locked until finishing the
-			 * processing of the packet to avoid the connection
-			 * addition/removal from the hash table during the mean time.
-			 */
-
-			pthread_mutex_lock(&ic_control_info.lock);
-			conn = findConnByHeader(&ic_control_info.connHtab, pkt);
-
-			if (conn != NULL)
-			{
-				/* Handling a regular packet */
-				if (handleDataPacket(conn, pkt, &peer, &peerlen, &param, &wakeup_mainthread))
-					pkt = NULL;
-				ic_statistics.recvPktNum++;
-			}
-			else
-			{
-				/*
-				 * There may have two kinds of Mismatched packets: a) Past
-				 * packets from previous command after I was torn down b)
-				 * Future packets from current command before my connections
-				 * are built.
-				 *
-				 * The handling logic is to "Ack the past and Nak the future".
-				 */
-				if ((pkt->flags & UDPIC_FLAGS_RECEIVER_TO_SENDER) == 0)
-				{
-					if (DEBUG1 >= log_min_messages)
-						write_log("mismatched packet received, seq %d, srcpid %d, dstpid %d, icid %d, sid %d", pkt->seq, pkt->srcPid, pkt->dstPid, pkt->icId, pkt->sessionId);
-
-#ifdef AMS_VERBOSE_LOGGING
-					logPkt("Got a Mismatched Packet", pkt);
 #endif
 
-					if (handleMismatch(pkt, &peer, peerlen))
-						pkt = NULL;
-					ic_statistics.mismatchNum++;
-				}
-			}
-			pthread_mutex_unlock(&ic_control_info.lock);
-
-			if (wakeup_mainthread)
-				SetLatch(&ic_control_info.latch);
-
-			/*
-			 * real ack sending is after lock release to decrease the lock
-			 * holding time.
-			 */
-			if (param.msg.len != 0)
-				sendAckWithParam(&param);
+			if (handleRxPacket(pkts[0], read_count, &peers[0], peerlen))
+				pkts[0] = NULL;
 		}
 
 		/* pthread_yield(); */
 	}
 
-	/* Before return, we release the packet. */
-	if (pkt)
+	/* Before return, we release the packets. */
+	pthread_mutex_lock(&ic_control_info.lock);
+	for (i = 0; i < MMSG_BATCH_SIZE; i++)
 	{
-		pthread_mutex_lock(&ic_control_info.lock);
-		freeRxBuffer(&rx_buffer_pool, pkt);
-		pkt = NULL;
-		pthread_mutex_unlock(&ic_control_info.lock);
+		if (pkts[i])
+		{
+			freeRxBuffer(&rx_buffer_pool, pkts[i]);
+			pkts[i] = NULL;
+		}
 	}
+	pthread_mutex_unlock(&ic_control_info.lock);
 
 	/* nothing to return */
 	return NULL;
@@ -6966,3 +9144,306 @@ getActiveMotionConns(void)
 {
 	return ic_statistics.activeConnectionsNum;
 }
+
+/*
+ * ICConnStatsShmemSize
+ * 		Size of the shared memory rings of interconnect statistics.
+ */
+Size
+ICConnStatsShmemSize(void)
+{
+	return sizeof(ICConnStatsShmem);
+}
+
+/*
+ * ICConnStatsShmemInit
+ * 		Allocate and initialize the shared memory rings of interconnect statistics.
+ */
+void
+ICConnStatsShmemInit(void)
+{
+	bool		found;
+
+	ic_conn_stats = (ICConnStatsShmem *)
+		ShmemInitStruct("Interconnect Connection Stats", ICConnStatsShmemSize(), &found);
+
+	if (!found)
+	{
+		SpinLockInit(&ic_conn_stats->mutex);
+		ic_conn_stats->count = 0;
+		ic_conn_stats->syscallCount = 0;
+	}
+}
+
+/*
+ * recordConnStats
+ * 		Record the flow control state of an outgoing connection being closed.
+ *
+ * Called with ic_control_info.lock held, so no elog here.
+ */
+static void
+recordConnStats(MotionConn *conn)
+{
+	ICConnStatsEntry entry;
+
+	if (ic_conn_stats == NULL)
+		return;
+
+	entry.pid = MyProcPid;
+	entry.sessionId = gp_session_id;
+	entry.icId = conn->conn_info.icId;
+	entry.motNodeId = conn->conn_info.motNodeId;
+	entry.dstContentId = conn->conn_info.dstContentId;
+	entry.fcMethod = Gp_interconnect_fc_method;
+	entry.srtt = conn->rtt;
+	entry.sentPkts = conn->sentSeq;
+	entry.retransmits = conn->stat_count_resent;
+	entry.compressedPkts = conn->stat_compressed_pkts;
+	entry.compressSavedBytes = conn->stat_compress_saved_bytes;
+	entry.shm = conn->shmRing != NULL && conn->shmAccepted;
+	entry.endTime = GetCurrentTimestamp();
+
+	switch (Gp_interconnect_fc_method)
+	{
+		case INTERCONNECT_FC_METHOD_BBR:
+			entry.cwnd = conn->bbr.cwnd;
+			entry.minRtt = conn->bbr.minRtt == ~((uint64) 0) ? 0 : conn->bbr.minRtt;
+			entry.bw = conn->bbr.bw;
+			break;
+		case INTERCONNECT_FC_METHOD_LOSS:
+			/* the loss based window is shared by all the connections */
+			entry.cwnd = snd_control_info.cwnd;
+			entry.minRtt = 0;
+			entry.bw = 0;
+			break;
+		default:
+			entry.cwnd = -1;
+			entry.minRtt = 0;
+			entry.bw = 0;
+			break;
+	}
+
+	SpinLockAcquire(&ic_conn_stats->mutex);
+	ic_conn_stats->entries[ic_conn_stats->count % IC_CONN_STATS_SLOTS] = entry;
+	ic_conn_stats->count++;
+	SpinLockRelease(&ic_conn_stats->mutex);
+}
+
+/*
+ * recordSyscallStats
+ * 		Record the send and receive syscalls of this backend for the
+ * 		interconnect instance being torn down.
+ *
+ * Called with ic_control_info.lock held, so no elog here.
+ */
+static void
+recordSyscallStats(int icId)
+{
+	ICSyscallStatsEntry entry;
+
+	if (ic_conn_stats == NULL)
+		return;
+
+	if (ic_statistics.sndSyscallNum == 0 && ic_statistics.rxSyscallNum == 0)
+		return;
+
+	entry.pid = MyProcPid;
+	entry.sessionId = gp_session_id;
+	entry.icId = icId;
+	entry.sentPkts = ic_statistics.sndSyscallPktNum;
+	entry.sendCalls = ic_statistics.sndSyscallNum;
+	entry.rxDatagrams = ic_statistics.rxDatagramNum;
+	entry.rxCalls = ic_statistics.rxSyscallNum;
+	entry.endTime = GetCurrentTimestamp();
+
+	SpinLockAcquire(&ic_conn_stats->mutex);
+	ic_conn_stats->syscallEntries[ic_conn_stats->syscallCount % IC_SYSCALL_STATS_SLOTS] = entry;
+	ic_conn_stats->syscallCount++;
+	SpinLockRelease(&ic_conn_stats->mutex);
+}
+
+/*
+ * gp_get_interconnect_conn_stats
+ * 		Return the recently closed outgoing UDP interconnect connections of
+ * 		this segment, with their flow control state.
+ */
+Datum
+gp_get_interconnect_conn_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	ICConnStatsEntry *entries;
+	uint64		count;
+	int			nentries;
+	int			i;
+
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (ic_conn_stats == NULL)
+		return (Datum) 0;
+
+	/* copy the ring out, not to hold the spinlock while building tuples */
+	entries = palloc(sizeof(ICConnStatsEntry) * IC_CONN_STATS_SLOTS);
+
+	SpinLockAcquire(&ic_conn_stats->mutex);
+	count = ic_conn_stats->count;
+	nentries = Min(count, IC_CONN_STATS_SLOTS);
+	for (i = 0; i < nentries; i++)
+		entries[i] = ic_conn_stats->entries[(count - nentries + i) % IC_CONN_STATS_SLOTS];
+	SpinLockRelease(&ic_conn_stats->mutex);
+
+	for (i = 0; i < nentries; i++)
+	{
+		ICConnStatsEntry *entry = &entries[i];
+		Datum		values[17];
+		bool		nulls[17];
+		const char *method;
+
+		MemSet(nulls, false, sizeof(nulls));
+
+		switch (entry->fcMethod)
+		{
+			case INTERCONNECT_FC_METHOD_CAPACITY:
+				method = "capacity";
+				break;
+			case INTERCONNECT_FC_METHOD_LOSS:
+				method = "loss";
+				break;
+			case INTERCONNECT_FC_METHOD_BBR:
+				method = "bbr";
+				break;
+			default:
+				method = "unknown";
+				break;
+		}
+
+		values[0] = Int32GetDatum(GpIdentity.segindex);
+		values[1] = Int32GetDatum(entry->pid);
+		values[2] = Int32GetDatum(entry->sessionId);
+		values[3] = Int32GetDatum(entry->icId);
+		values[4] = Int32GetDatum(entry->motNodeId);
+		values[5] = Int32GetDatum(entry->dstContentId);
+		values[6] = CStringGetTextDatum(method);
+		values[7] = Float8GetDatum(entry->cwnd);
+		nulls[7] = entry->cwnd < 0;
+		values[8] = Int64GetDatum(entry->srtt);
+		values[9] = Int64GetDatum(entry->minRtt);
+		nulls[9] = entry->fcMethod != INTERCONNECT_FC_METHOD_BBR || entry->minRtt == 0;
+		values[10] = Float8GetDatum(entry->bw);
+		nulls[10] = entry->fcMethod != INTERCONNECT_FC_METHOD_BBR;
+		values[11] = Int64GetDatum(entry->sentPkts);
+		values[12] = Int64GetDatum(entry->retransmits);
+		values[13] = Int64GetDatum(entry->compressedPkts);
+		values[14] = Int64GetDatum(entry->compressSavedBytes);
+		values[15] = CStringGetTextDatum(entry->shm ? "shm" : "udp");
+		values[16] = TimestampTzGetDatum(entry->endTime);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(entries);
+
+	return (Datum) 0;
+}
+
+/*
+ * gp_get_interconnect_syscall_stats
+ * 		Return the send and receive syscall counts of the recently torn down
+ * 		interconnect instances of the backends of this segment.
+ */
+Datum
+gp_get_interconnect_syscall_stats(PG_FUNCTION_ARGS)
+{
+	ReturnSetInfo *rsinfo = (ReturnSetInfo *) fcinfo->resultinfo;
+	TupleDesc	tupdesc;
+	Tuplestorestate *tupstore;
+	MemoryContext per_query_ctx;
+	MemoryContext oldcontext;
+	ICSyscallStatsEntry *entries;
+	uint64		count;
+	int			nentries;
+	int			i;
+
+	if (rsinfo == NULL || !IsA(rsinfo, ReturnSetInfo))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("set-valued function called in context that cannot accept a set")));
+	if (!(rsinfo->allowedModes & SFRM_Materialize))
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("materialize mode required, but it is not allowed in this context")));
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+
+	per_query_ctx = rsinfo->econtext->ecxt_per_query_memory;
+	oldcontext = MemoryContextSwitchTo(per_query_ctx);
+
+	tupstore = tuplestore_begin_heap(true, false, work_mem);
+	rsinfo->returnMode = SFRM_Materialize;
+	rsinfo->setResult = tupstore;
+	rsinfo->setDesc = tupdesc;
+
+	MemoryContextSwitchTo(oldcontext);
+
+	if (ic_conn_stats == NULL)
+		return (Datum) 0;
+
+	/* copy the ring out, not to hold the spinlock while building tuples */
+	entries = palloc(sizeof(ICSyscallStatsEntry) * IC_SYSCALL_STATS_SLOTS);
+
+	SpinLockAcquire(&ic_conn_stats->mutex);
+	count = ic_conn_stats->syscallCount;
+	nentries = Min(count, IC_SYSCALL_STATS_SLOTS);
+	for (i = 0; i < nentries; i++)
+		entries[i] = ic_conn_stats->syscallEntries[(count - nentries + i) % IC_SYSCALL_STATS_SLOTS];
+	SpinLockRelease(&ic_conn_stats->mutex);
+
+	for (i = 0; i < nentries; i++)
+	{
+		ICSyscallStatsEntry *entry = &entries[i];
+		Datum		values[9];
+		bool		nulls[9];
+
+		MemSet(nulls, false, sizeof(nulls));
+
+		values[0] = Int32GetDatum(GpIdentity.segindex);
+		values[1] = Int32GetDatum(entry->pid);
+		values[2] = Int32GetDatum(entry->sessionId);
+		values[3] = Int32GetDatum(entry->icId);
+		values[4] = Int64GetDatum(entry->sentPkts);
+		values[5] = Int64GetDatum(entry->sendCalls);
+		values[6] = Int64GetDatum(entry->rxDatagrams);
+		values[7] = Int64GetDatum(entry->rxCalls);
+		values[8] = TimestampTzGetDatum(entry->endTime);
+
+		tuplestore_putvalues(tupstore, tupdesc, values, nulls);
+	}
+
+	pfree(entries);
+
+	return (Datum) 0;
+}
@@ -33,6 +33,16 @@
 #include "utils/syscache.h"
 #include "utils/typcache.h"
 
+#ifdef HAVE_LIBZSTD
+#include <zstd.h>
+
+/*
+ * zstd compression level for tuple batches.  Motion throughput matters more
+ * than ratio here, so use the fastest level.
+ */
+#define BATCH_COMPRESS_LEVEL 1
+#endif
+
 /*
  * Transient record types table is sent to upsteam via a specially constructed
  * tuple, on receiving side it can distinguish it from real tuples by checking
@@ -45,6 +55,19 @@
 #define RECORD_CACHE_MAGIC_NATTS	0xffff
 #define RECORD_CACHE_MAGIC_INFOMASK	0xffff
 
+/*
+ * A columnar batch of tuples is sent the same way, with BATCH_MAGIC_NATTS
+ * and BATCH_MAGIC_INFOMASK in the header.  The header is followed by a
+ * TupBatchHeader and then the payload, which holds for each attribute in
+ * turn a null bitmap of BITMAPLEN(nrows) bytes followed by nrows values of
+ * typlen bytes each.  The payload is zstd-compressed if TUPBATCH_COMPRESSED
+ * is set.
+ */
+#define BATCH_MAGIC_NATTS			0xfffe
+#define BATCH_MAGIC_INFOMASK		0xfffe
+
+#define TUPBATCH_COMPRESSED			0x0001
+
 /* A MemoryContext used within the tuple serialize code, so that freeing of
  * space is SUPAFAST.  It is initialized in the first call to InitSerTupInfo()
  * since that must be called before any tuple serialization or deserialization
@@ -53,6 +76,7 @@
 static MemoryContext s_tupSerMemCtxt = NULL;
 
 static void addByteStringToChunkList(TupleChunkList tcList, char *data, int datalen, TupleChunkListCache *cache);
+static void DeserializeTupleBatch(SerTupInfo *pSerInfo, char *data, int datalen);
 
 #define addCharToChunkList(tcList, x, c)							\
 	do															\
@@ -109,6 +133,7 @@ InitSerTupInfo(TupleDesc tupdesc, SerTupInfo *pSerInfo)
 	pSerInfo->chunkCache.items = NULL;
 
 	pSerInfo->has_record_types = false;
+	pSerInfo->batchable = false;
 
 	/*
 	 * If we have some attributes, go ahead and prepare the information for
@@ -123,6 +148,9 @@ InitSerTupInfo(TupleDesc tupdesc, SerTupInfo *pSerInfo)
 	pSerInfo->values = (Datum *) palloc(numAttrs * sizeof(Datum));
 	pSerInfo->nulls = (bool *) palloc(numAttrs * sizeof(bool));
 
+	/* Cleared below if we find an attribute that can't be batched */
+	pSerInfo->batchable = !tupdesc->tdhasoid;
+
 	for (i = 0; i < numAttrs; i++)
 	{
 		SerAttrInfo *attrInfo = pSerInfo->myinfo + i;
@@ -164,6 +192,9 @@ InitSerTupInfo(TupleDesc tupdesc, SerTupInfo *pSerInfo)
 			attrInfo->typlen = pt->typlen;
 			attrInfo->typbyval = pt->typbyval;
 
+			if (!attrInfo->typbyval || attrInfo->typlen <= 0)
+				pSerInfo->batchable = false;
+
 			ReleaseSysCache(typeTuple);
 		}
 	}
@@ -181,6 +212,10 @@ CleanupSerTupInfo(SerTupInfo *pSerInfo)
 	 *
 	 * NOTE:  This works because data-structure was bzero()ed in init call.
 	 */
+	if (pSerInfo->recv_batch != NULL)
+		DestroyTupleBatch(pSerInfo, pSerInfo->recv_batch);
+	pSerInfo->recv_batch = NULL;
+
 	if (pSerInfo->myinfo != NULL)
 		pfree(pSerInfo->myinfo);
 	pSerInfo->myinfo = NULL;
@@ -195,6 +230,7 @@ CleanupSerTupInfo(SerTupInfo *pSerInfo)
 
 	pSerInfo->tupdesc = NULL;
 
+
 	while (pSerInfo->chunkCache.items != NULL)
 	{
 		TupleChunkListItem item;
@@ -273,6 +309,14 @@ typedef struct TupSerHeader
 	uint16		infomask;		/* various flag bits */
 } TupSerHeader;
 
+typedef struct TupBatchHeader
+{
+	uint32		nrows;
+	uint16		natts;
+	uint16		flags;			/* TUPBATCH_* flag bits */
+	uint32		rawlen;			/* length of the uncompressed payload */
+} TupBatchHeader;
+
 /*
  * Convert RecordCache into a byte-sequence, and store it directly
  * into a chunklist for transmission.
@@ -365,6 +409,464 @@ SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 	return;
 }
 
+/*
+ * Store a pass-by-value Datum of the given length into a batch column.  The
+ * column is not aligned, so go through a local variable of the right width.
+ */
+static inline void
+store_batch_value(char *dst, int16 typlen, Datum value)
+{
+	switch (typlen)
+	{
+		case sizeof(char):
+			*dst = DatumGetChar(value);
+			break;
+		case sizeof(int16):
+			{
+				int16		v = DatumGetInt16(value);
+
+				memcpy(dst, &v, sizeof(v));
+			}
+			break;
+		case sizeof(int32):
+			{
+				int32		v = DatumGetInt32(value);
+
+				memcpy(dst, &v, sizeof(v));
+			}
+			break;
+#if SIZEOF_DATUM == 8
+		case sizeof(Datum):
+			memcpy(dst, &value, sizeof(Datum));
+			break;
+#endif
+		default:
+			elog(ERROR, "unsupported byval length: %d", (int) typlen);
+	}
+}
+
+/* The inverse of store_batch_value() */
+static inline Datum
+fetch_batch_value(const char *src, int16 typlen)
+{
+	switch (typlen)
+	{
+		case sizeof(char):
+			return CharGetDatum(*src);
+		case sizeof(int16):
+			{
+				int16		v;
+
+				memcpy(&v, src, sizeof(v));
+				return Int16GetDatum(v);
+			}
+		case sizeof(int32):
+			{
+				int32		v;
+
+				memcpy(&v, src, sizeof(v));
+				return Int32GetDatum(v);
+			}
+#if SIZEOF_DATUM == 8
+		case sizeof(Datum):
+			{
+				Datum		v;
+
+				memcpy(&v, src, sizeof(v));
+				return v;
+			}
+#endif
+		default:
+			elog(ERROR, "unsupported byval length: %d", (int) typlen);
+			return (Datum) 0;	/* keep compiler quiet */
+	}
+}
+
+/*
+ * Create an empty TupleBatch that can hold up to 'maxrows' rows of the
+ * tuple descriptor in 'pSerInfo', which must be batchable.
+ *
+ * The batch is allocated in the current memory context.
+ */
+TupleBatch *
+CreateTupleBatch(SerTupInfo *pSerInfo, int maxrows)
+{
+	TupleBatch *batch;
+	int			natts = pSerInfo->tupdesc->natts;
+	int			i;
+
+	AssertArg(pSerInfo->batchable);
+	AssertArg(maxrows > 0);
+
+	batch = (TupleBatch *) palloc(sizeof(TupleBatch));
+	batch->nrows = 0;
+	batch->maxrows = maxrows;
+	batch->next = 0;
+	batch->values = (char **) palloc(natts * sizeof(char *));
+	batch->nulls = (bits8 **) palloc(natts * sizeof(bits8 *));
+
+	for (i = 0; i < natts; i++)
+	{
+		batch->values[i] = palloc(maxrows * pSerInfo->myinfo[i].typlen);
+		batch->nulls[i] = (bits8 *) palloc(BITMAPLEN(maxrows));
+	}
+
+	return batch;
+}
+
+/* Free a TupleBatch created by CreateTupleBatch() */
+void
+DestroyTupleBatch(SerTupInfo *pSerInfo, TupleBatch *batch)
+{
+	int			natts = pSerInfo->tupdesc->natts;
+	int			i;
+
+	for (i = 0; i < natts; i++)
+	{
+		pfree(batch->values[i]);
+		pfree(batch->nulls[i]);
+	}
+	pfree(batch->values);
+	pfree(batch->nulls);
+	pfree(batch);
+}
+
+/*
+ * Append the tuple in 'slot' to the batch.
+ *
+ * Returns true if the batch is full, and must be sent with
+ * SerializeTupleBatch() before any more rows are added.
+ */
+bool
+AddTupleToBatch(TupleBatch *batch, TupleTableSlot *slot, SerTupInfo *pSerInfo)
+{
+	int			natts = pSerInfo->tupdesc->natts;
+	int			row = batch->nrows;
+	int			byte = row / BITS_PER_BYTE;
+	bits8		bit = 1 << (row % BITS_PER_BYTE);
+	Datum	   *values;
+	bool	   *isnull;
+	int			i;
+
+	Assert(row < batch->maxrows);
+
+	slot_getallattrs(slot);
+	values = slot_get_values(slot);
+	isnull = slot_get_isnull(slot);
+
+	for (i = 0; i < natts; i++)
+	{
+		int16		typlen = pSerInfo->myinfo[i].typlen;
+		char	   *dst = batch->values[i] + row * typlen;
+
+		if (bit == 1)
+			batch->nulls[i][byte] = 0;
+
+		if (isnull[i])
+		{
+			/* keep the column deterministic, it compresses better */
+			memset(dst, 0, typlen);
+			continue;
+		}
+
+		batch->nulls[i][byte] |= bit;
+		store_batch_value(dst, typlen, values[i]);
+	}
+
+	batch->nrows++;
+
+	return batch->nrows >= batch->maxrows;
+}
+
+/*
+ * Convert the rows buffered in a TupleBatch into a byte-sequence, and store
+ * it into a chunklist for transmission.  The batch is left empty.
+ */
+void
+SerializeTupleBatch(TupleBatch *batch, SerTupInfo *pSerInfo, TupleChunkList tcList)
+{
+	TupleChunkListItem tcItem;
+	MemoryContext oldCtxt;
+	TupSerHeader tsh;
+	TupBatchHeader tbh;
+	int			natts = pSerInfo->tupdesc->natts;
+	int			nrows = batch->nrows;
+	int			nullslen = BITMAPLEN(nrows);
+	int			rawlen;
+	int			payloadlen;
+	char	   *payload;
+	char	   *pos;
+	int			i;
+
+	AssertArg(tcList != NULL);
+	AssertArg(nrows > 0);
+
+	/* get ready to go */
+	tcList->p_first = NULL;
+	tcList->p_last = NULL;
+	tcList->num_chunks = 0;
+	tcList->serialized_data_length = 0;
+	tcList->max_chunk_length = Gp_max_tuple_chunk_size;
+
+	tcItem = getChunkFromCache(&pSerInfo->chunkCache);
+
+	/* assume that we'll take a single chunk */
+	SetChunkType(tcItem->chunk_data, TC_WHOLE);
+	tcItem->chunk_length = TUPLE_CHUNK_HEADER_SIZE;
+	appendChunkToTCList(tcList, tcItem);
+
+	AssertState(s_tupSerMemCtxt != NULL);
+
+	rawlen = 0;
+	for (i = 0; i < natts; i++)
+		rawlen += nullslen + nrows * pSerInfo->myinfo[i].typlen;
+
+	oldCtxt = MemoryContextSwitchTo(s_tupSerMemCtxt);
+
+	payload = palloc(rawlen);
+	pos = payload;
+	for (i = 0; i < natts; i++)
+	{
+		int			collen = nrows * pSerInfo->myinfo[i].typlen;
+
+		memcpy(pos, batch->nulls[i], nullslen);
+		pos += nullslen;
+		memcpy(pos, batch->values[i], collen);
+		pos += collen;
+	}
+	payloadlen = rawlen;
+
+	tbh.nrows = nrows;
+	tbh.natts = natts;
+	tbh.flags = 0;
+	tbh.rawlen = rawlen;
+
+#ifdef HAVE_LIBZSTD
+	if (gp_motion_batch_compression)
+	{
+		static ZSTD_CCtx *cxt = NULL;
+		size_t		bound = ZSTD_compressBound(rawlen);
+		size_t		clen;
+		char	   *cbuf;
+
+		if (!cxt)
+		{
+			cxt = ZSTD_createCCtx();
+			if (!cxt)
+				elog(ERROR, "out of memory");
+		}
+
+		cbuf = palloc(bound);
+		clen = ZSTD_compressCCtx(cxt, cbuf, bound, payload, rawlen,
+								 BATCH_COMPRESS_LEVEL);
+		if (ZSTD_isError(clen))
+			elog(ERROR, "compression of tuple batch failed: %s",
+				 ZSTD_getErrorName(clen));
+
+		/* Only send it compressed if that actually saves something */
+		if (clen < rawlen)
+		{
+			payload = cbuf;
+			payloadlen = clen;
+			tbh.flags |= TUPBATCH_COMPRESSED;
+		}
+	}
+#endif
+
+	MemoryContextSwitchTo(oldCtxt);
+
+	tsh.tuplen = sizeof(TupSerHeader) + sizeof(TupBatchHeader) + payloadlen;
+	tsh.natts = BATCH_MAGIC_NATTS;
+	tsh.infomask = BATCH_MAGIC_INFOMASK;
+
+	addByteStringToChunkList(tcList, (char *) &tsh, sizeof(TupSerHeader),
+							 &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, (char *) &tbh, sizeof(TupBatchHeader),
+							 &pSerInfo->chunkCache);
+	addByteStringToChunkList(tcList, payload, payloadlen,
+							 &pSerInfo->chunkCache);
+
+	MemoryContextReset(s_tupSerMemCtxt);
+
+	if (tcList->num_chunks > 1)
+	{
+		SetChunkType(tcList->p_first->chunk_data, TC_PARTIAL_START);
+		SetChunkType(tcList->p_last->chunk_data, TC_PARTIAL_END);
+	}
+
+	batch->nrows = 0;
+}
+
+/*
+ * Decode a received tuple batch into pSerInfo->recv_batch, from where
+ * the caller collects it with TakeReceivedTupleBatch().
+ *
+ * The columns are kept as they are, the rows are only formed when
+ * StoreNextBatchedTuple() puts them into a slot.
+ */
+static void
+DeserializeTupleBatch(SerTupInfo *pSerInfo, char *data, int datalen)
+{
+	TupBatchHeader tbh;
+	int			natts = pSerInfo->tupdesc->natts;
+	int			nullslen;
+	int			expectedlen;
+	char	   *payload;
+	char	   *decompressed = NULL;
+	TupleBatch *batch;
+	int			i;
+
+	if (datalen < (int) sizeof(TupBatchHeader))
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("truncated tuple batch")));
+
+	/* copy because the serialized buffer is not aligned */
+	memcpy(&tbh, data, sizeof(TupBatchHeader));
+	data += sizeof(TupBatchHeader);
+	datalen -= sizeof(TupBatchHeader);
+
+	if (!pSerInfo->batchable || tbh.natts != natts ||
+		tbh.nrows == 0 || tbh.nrows > MAX_MOTION_BATCH_SIZE)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("unexpected tuple batch with %u rows of %u attributes",
+						tbh.nrows, (unsigned int) tbh.natts)));
+
+	nullslen = BITMAPLEN(tbh.nrows);
+	expectedlen = 0;
+	for (i = 0; i < natts; i++)
+		expectedlen += nullslen + tbh.nrows * pSerInfo->myinfo[i].typlen;
+
+	if (tbh.rawlen != expectedlen)
+		ereport(ERROR,
+				(errcode(ERRCODE_PROTOCOL_VIOLATION),
+				 errmsg("tuple batch length %u does not match its shape (%d expected)",
+						tbh.rawlen, expectedlen)));
+
+	if (tbh.flags & TUPBATCH_COMPRESSED)
+	{
+#ifdef HAVE_LIBZSTD
+		static ZSTD_DCtx *cxt = NULL;
+		size_t		dlen;
+
+		if (!cxt)
+		{
+			cxt = ZSTD_createDCtx();
+			if (!cxt)
+				elog(ERROR, "out of memory");
+		}
+
+		decompressed = palloc(expectedlen);
+		dlen = ZSTD_decompressDCtx(cxt, decompressed, expectedlen, data, datalen);
+		if (ZSTD_isError(dlen))
+			elog(ERROR, "decompression of tuple batch failed: %s",
+				 ZSTD_getErrorName(dlen));
+		if (dlen != expectedlen)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("tuple batch decompressed to %zu bytes, %d expected",
+							dlen, expectedlen)));
+		payload = decompressed;
+#else
+		ereport(ERROR,
+				(errcode(ERRCODE_FEATURE_NOT_SUPPORTED),
+				 errmsg("received a compressed tuple batch, but zstd is not supported by this build")));
+		payload = NULL;			/* keep compiler quiet */
+#endif
+	}
+	else
+	{
+		if (datalen != expectedlen)
+			ereport(ERROR,
+					(errcode(ERRCODE_PROTOCOL_VIOLATION),
+					 errmsg("tuple batch length %d does not match its shape (%d expected)",
+							datalen, expectedlen)));
+		payload = data;
+	}
+
+	Assert(pSerInfo->recv_batch == NULL);
+
+	/* Copy the columns out of the payload */
+	batch = CreateTupleBatch(pSerInfo, tbh.nrows);
+	for (i = 0; i < natts; i++)
+	{
+		int			collen = tbh.nrows * pSerInfo->myinfo[i].typlen;
+
+		memcpy(batch->nulls[i], payload, nullslen);
+		payload += nullslen;
+		memcpy(batch->values[i], payload, collen);
+		payload += collen;
+	}
+	batch->nrows = tbh.nrows;
+
+	pSerInfo->recv_batch = batch;
+
+	if (decompressed)
+		pfree(decompressed);
+}
+
+/*
+ * Return the batch decoded by the last CvtChunksToTup() call, and hand its
+ * ownership to the caller.  NULL if the last call didn't receive a batch.
+ */
+TupleBatch *
+TakeReceivedTupleBatch(SerTupInfo *pSerInfo)
+{
+	TupleBatch *batch = pSerInfo->recv_batch;
+
+	pSerInfo->recv_batch = NULL;
+
+	return batch;
+}
+
+/*
+ * Store the next row of a received batch into 'slot', as a virtual tuple.
+ *
+ * All the columns of a batch are pass-by-value, so the slot's values don't
+ * point into the batch, and no tuple is formed.  Returns false once all the
+ * rows have been returned.
+ */
+bool
+StoreNextBatchedTuple(TupleBatch *batch, TupleTableSlot *slot, SerTupInfo *pSerInfo)
+{
+	int			natts = pSerInfo->tupdesc->natts;
+	int			row = batch->next;
+	int			byte = row / BITS_PER_BYTE;
+	bits8		bit = 1 << (row % BITS_PER_BYTE);
+	Datum	   *values;
+	bool	   *isnull;
+	int			i;
+
+	if (row >= batch->nrows)
+		return false;
+
+	ExecClearTuple(slot);
+	values = slot_get_values(slot);
+	isnull = slot_get_isnull(slot);
+
+	for (i = 0; i < natts; i++)
+	{
+		int16		typlen = pSerInfo->myinfo[i].typlen;
+
+		if (batch->nulls[i][byte] & bit)
+		{
+			values[i] = fetch_batch_value(batch->values[i] + row * typlen, typlen);
+			isnull[i] = false;
+		}
+		else
+		{
+			values[i] = (Datum) 0;
+			isnull[i] = true;
+		}
+	}
+
+	ExecStoreVirtualTuple(slot);
+	batch->next++;
+
+	return true;
+}
+
 static bool
 CandidateForSerializeDirect(int16 targetRoute, struct directTransportBuffer *b)
 {
@@ -772,6 +1274,29 @@ CvtChunksToTup(TupleChunkList tcList, SerTupInfo *pSerInfo, TupleRemapper *remap
 			return NULL;
 		}
 
+		if (!(tsh.tuplen & MEMTUP_LEAD_BIT) &&
+			tsh.natts == BATCH_MAGIC_NATTS &&
+			tsh.infomask == BATCH_MAGIC_INFOMASK)
+		{
+			if (tsh.tuplen < sizeof(TupSerHeader) || tsh.tuplen > serData.len)
+				ereport(ERROR,
+						(errcode(ERRCODE_PROTOCOL_VIOLATION),
+						 errmsg("tuple batch length %u exceeds received data length %d",
+								tsh.tuplen, serData.len)));
+
+			/*
+			 * A columnar batch of tuples.  Decode it now, the caller
+			 * collects it with TakeReceivedTupleBatch().
+			 */
+			DeserializeTupleBatch(pSerInfo, pos + sizeof(TupSerHeader),
+								  tsh.tuplen - sizeof(TupSerHeader));
+
+			if (serDataMustFree)
+				pfree(serData.data);
+
+			return NULL;
+		}
+
 		if ((tsh.tuplen & MEMTUP_LEAD_BIT) != 0)
 		{
 			uint32		tuplen = memtuple_size_from_uint32(tsh.tuplen);
@@ -0,0 +1,88 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include "cmockery.h"
+
+#include "../cdbhash.c"
+
+#include "utils/memutils.h"
+
+/* The value of a single attribute key, as cdbhash() computes it */
+static uint32
+cdbhash_one(CdbHash *h, Datum datum)
+{
+	cdbhashinit(h);
+	cdbhash(h, 1, datum, false);
+	return h->hash;
+}
+
+static void
+test__cdbhash__InlineKernelsMatchFmgr(void **state)
+{
+	int64		vals[] = {0, 1, -1, 42, 65535, -65536, PG_INT32_MAX, PG_INT32_MIN,
+						  PG_INT64_MAX, PG_INT64_MIN};
+	Oid			funcids[] = {F_HASHINT2, F_HASHINT4, F_HASHINT8, F_HASHOID, F_HASHENUM};
+	int			i;
+	int			j;
+
+	for (j = 0; j < lengthof(funcids); j++)
+	{
+		CdbHash    *h = makeCdbHash(3, 1, &funcids[j]);
+
+		assert_true(h->fnkinds[0] != CDBHASH_FN_GENERIC);
+
+		for (i = 0; i < lengthof(vals); i++)
+		{
+			Datum		datum;
+			uint32		inlineHash;
+
+			switch (funcids[j])
+			{
+				case F_HASHINT2:
+					datum = Int16GetDatum((int16) vals[i]);
+					break;
+				case F_HASHINT4:
+					datum = Int32GetDatum((int32) vals[i]);
+					break;
+				case F_HASHINT8:
+					datum = Int64GetDatum(vals[i]);
+					break;
+				default:
+					datum = ObjectIdGetDatum((Oid) vals[i]);
+					break;
+			}
+
+			h->fnkinds[0] = cdbhash_fnkind_for_func(funcids[j]);
+			inlineHash = cdbhash_one(h, datum);
+
+			h->fnkinds[0] = CDBHASH_FN_GENERIC;
+			assert_int_equal(inlineHash, cdbhash_one(h, datum));
+		}
+	}
+}
+
+static void
+test__hash_uint32_inline__MatchesHashAny(void **state)
+{
+	uint32		vals[] = {0, 1, 42, 65535, PG_UINT32_MAX};
+	int			i;
+
+	for (i = 0; i < lengthof(vals); i++)
+		assert_int_equal(hash_uint32_inline(vals[i]),
+						 DatumGetUInt32(hash_any((unsigned char *) &vals[i], sizeof(uint32))));
+}
+
+int
+main(int argc, char* argv[])
+{
+	cmockery_parse_arguments(argc, argv);
+
+	const UnitTest tests[] = {
+		unit_test(test__cdbhash__InlineKernelsMatchFmgr),
+		unit_test(test__hash_uint32_inline__MatchesHashAny)
+	};
+
+	MemoryContextInit();
+
+	return run_tests(tests);
+}
@@ -123,6 +123,7 @@
 #include "cdb/cdbappendonlyam.h"
 #include "cdb/cdbtm.h"
 #include "cdb/cdbvars.h"
+#include "commands/progress.h"
 #include "commands/vacuum.h"
 #include "pgstat.h"
 #include "postmaster/autovacuum.h"
@@ -283,6 +284,7 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 	Snapshot	appendOnlyMetaDataSnapshot = RegisterSnapshot(GetCatalogSnapshot(InvalidOid));
 	char	   *relname;
 	int			elevel;
+	int64		segfiles_processed = 0;
 
 	/*
 	 * This should run in a distributed transaction. But also allow utility
@@ -309,6 +311,15 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 					get_namespace_name(RelationGetNamespace(onerel)),
 					relname)));
 
+	/*
+	 * Report progress in pg_stat_progress_ao_compaction. The per-segfile
+	 * counters are kept by AppendOnlyCompact() and AOCSCompact().
+	 */
+	pgstat_progress_start_command(PROGRESS_COMMAND_AO_COMPACTION,
+								  RelationGetRelid(onerel));
+	pgstat_progress_update_param(PROGRESS_AO_COMPACTION_SEGNO, -1);
+	pgstat_progress_update_param(PROGRESS_AO_COMPACTION_INSERT_SEGNO, -1);
+
 	/*
 	 * Compact all the segfiles. Repeat as many times as required.
 	 *
@@ -334,6 +345,9 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 		if (Debug_appendonly_print_compaction)
 			elog(LOG, "compacting segno %d of %s", compaction_segno, relname);
 
+		pgstat_progress_update_param(PROGRESS_AO_COMPACTION_SEGNO,
+									 compaction_segno);
+
 		if (RelationIsAoRows(onerel))
 			AppendOnlyCompact(onerel,
 							  compaction_segno,
@@ -354,6 +368,9 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 			compacted_and_inserted_segments = list_append_unique_int(compacted_and_inserted_segments,
 																	 insert_segno);
 
+		pgstat_progress_update_param(PROGRESS_AO_COMPACTION_SEGFILES_PROCESSED,
+									 ++segfiles_processed);
+
 		/*
 		 * AppendOnlyCompact() updates pg_aoseg. Increment the command counter, so
 		 * that we can update the insertion target pg_aoseg row again.
@@ -364,6 +381,8 @@ ao_vacuum_rel_compact(Relation onerel, int options, VacuumParams *params,
 	if (insertDesc)
 		appendonly_insert_finish(insertDesc);
 
+	pgstat_progress_end_command();
+
 	UnregisterSnapshot(appendOnlyMetaDataSnapshot);
 }
 
@@ -117,7 +117,7 @@ typedef enum InputRecordType
 static SpillSet *createSpillSet(unsigned branching_factor, unsigned parent_hash_bit);
 static int closeSpillFile(AggState *aggstate, SpillSet *spill_set, int file_no);
 static int closeSpillFiles(AggState *aggstate, SpillSet *spill_set);
-static int suspendSpillFiles(SpillSet *spill_set);
+static int suspendSpillFiles(AggState *aggstate, SpillSet *spill_set);
 static int32 writeHashEntry(AggState *aggstate,
 							BatchFileInfo *file_info,
 							HashAggEntry *entry);
@@ -1041,7 +1041,7 @@ agg_hash_initial_pass(AggState *aggstate)
 		 * any more.
 		 */
 		spill_hash_table(aggstate);
-		freed_size = suspendSpillFiles(hashtable->spill_set);
+		freed_size = suspendSpillFiles(aggstate, hashtable->spill_set);
 		hashtable->mem_for_metadata -= freed_size;
 
 		Assert(hashtable->mem_for_metadata > 0);
@@ -1169,8 +1169,9 @@ getSpillFile(workfile_set *work_set, SpillSet *set, int file_no, int *p_alloc_si
  * can have more space for the hash table.
  */
 static int
-suspendSpillFiles(SpillSet *spill_set)
+suspendSpillFiles(AggState *aggstate, SpillSet *spill_set)
 {
+	HashAggTable *hashtable = aggstate->hhashtable;
 	int file_no;
 	int freed_size = 0;
 	
@@ -1189,6 +1190,10 @@ suspendSpillFiles(SpillSet *spill_set)
 
 			freed_size += FREEABLE_BATCHFILE_METADATA;
 
+			/* All of the file has been written now; count it for EXPLAIN */
+			hashtable->spill_bytes += BufFileGetSize(spill_file->file_info->wfile);
+			hashtable->spill_disk_bytes += BufFileGetDiskSize(spill_file->file_info->wfile);
+
 			elog(HHA_MSG_LVL, "HashAgg: %s contains " INT64_FORMAT " entries ("
 				 INT64_FORMAT " bytes)",
 				 BufFileGetFilename(spill_file->file_info->wfile),
@@ -1976,7 +1981,7 @@ agg_hash_reload(AggState *aggstate)
 		 * any more.
 		 */
 		spill_hash_table(aggstate);
-        freed_size = suspendSpillFiles(hashtable->curr_spill_file->spill_set);
+        freed_size = suspendSpillFiles(aggstate, hashtable->curr_spill_file->spill_set);
         hashtable->mem_for_metadata -= freed_size;
         elog(gp_workfile_caching_loglevel, "loaded hashtable from file %s and then respilled. we should delete file from work_set now",
 			 BufFileGetFilename(hashtable->curr_spill_file->file_info->wfile));
@@ -2229,6 +2234,19 @@ agg_hash_explain(AggState *aggstate)
 				hashtable->num_overflows,
 				hashtable->num_spill_groups);
 
+		if (hashtable->spill_bytes > 0)
+		{
+			appendStringInfo(hbuf,
+					"; %.0fK bytes spilled",
+					ceil((double) hashtable->spill_bytes / 1024));
+
+			/* The spill files were compressed */
+			if (hashtable->spill_disk_bytes != hashtable->spill_bytes)
+				appendStringInfo(hbuf,
+						" (%.0fK bytes compressed)",
+						ceil((double) hashtable->spill_disk_bytes / 1024));
+		}
+
 		appendStringInfo(hbuf, ".\n");
 	}
 
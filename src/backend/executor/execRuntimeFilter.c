@@ -0,0 +1,680 @@
+/*-------------------------------------------------------------------------
+ *
+ * execRuntimeFilter.c
+ *	  Runtime filters built from the inner side of a hash join, and checked
+ *	  by the scan or Motion feeding the outer side.
+ *
+ * When most outer rows of a hash join find no match, like the fact table
+ * rows in a join with a filtered dimension table, it is much cheaper to
+ * reject them in the scan than to pass them up the plan to the join.  The
+ * Hash node builds a bloom filter of the hash values of the inner tuples,
+ * and the range of the inner keys, while it builds the hash table; the
+ * outer scan checks its rows against them before they are projected.
+ *
+ * A filter is pushed to a SeqScan in the same slice, found by following
+ * the outer keys of the join down the outer side of the plan.  The joins in
+ * between must pass their outer rows up unchanged, or drop them, for the
+ * rows rejected in the scan not to change their results.
+ *
+ * If the outer keys come from a receiving Motion instead, the filter is
+ * serialized and sent back to the sending slice through the interconnect,
+ * once the hash table is built.  A redistributing sender checks each row
+ * against the filter of the segment the row goes to; a broadcasting one
+ * against the union of the filters of all the receivers.  The filter is
+ * only a hint there: the rows sent before it arrives, or if it never does,
+ * are just not filtered.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/backend/executor/execRuntimeFilter.c
+ *
+ *-------------------------------------------------------------------------
+ */
+#include "postgres.h"
+
+#include "access/hash.h"
+#include "catalog/pg_type.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
+#include "cdb/ml_ipc.h"
+#include "executor/execRuntimeFilter.h"
+#include "executor/executor.h"
+#include "executor/nodeMotion.h"
+#include "nodes/nodeFuncs.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
+
+/*
+ * Size of the bloom filters.  The filter is sized for the estimated number
+ * of inner rows, and not used if many more rows were inserted than it was
+ * sized for.
+ */
+#define RUNTIME_FILTER_BITS_PER_ROW		16
+#define RUNTIME_FILTER_MIN_ROW_BITS		8
+#define RUNTIME_FILTER_MIN_BITS			(1 << 13)
+#define RUNTIME_FILTER_MAX_BITS			(1 << 25)
+#define RUNTIME_FILTER_NUM_PROBES		3
+
+/*
+ * A filter sent to the senders of a Motion must fit in one interconnect
+ * message, see MAX_RUNTIME_FILTER_MSG_SIZE.
+ */
+#define RUNTIME_FILTER_MOTION_MAX_BITS	(1 << 16)
+
+/*
+ * A filter that rejects less than 1 / RUNTIME_FILTER_MIN_SELECTIVITY of the
+ * first RUNTIME_FILTER_SAMPLE_ROWS rows it checks is turned off.
+ */
+#define RUNTIME_FILTER_SAMPLE_ROWS		10000
+#define RUNTIME_FILTER_MIN_SELECTIVITY	10
+
+bool		gp_enable_runtime_filter = false;
+
+/*
+ * Serialized form of a filter: the header, the keys, then the bloom filter
+ * words.  The sender and receiver of a Motion run the same binary.
+ */
+typedef struct RuntimeFilterMsgHeader
+{
+	int32		nkeys;
+	uint32		nbits;			/* of the bloom filter, 0 if none */
+} RuntimeFilterMsgHeader;
+
+typedef struct RuntimeFilterMsgKey
+{
+	int64		minValue;
+	int64		maxValue;
+	Oid			hashfn;
+	Oid			outerType;
+	AttrNumber	attno;
+	bool		strict;
+	bool		hasRange;
+} RuntimeFilterMsgKey;
+
+static PlanState *RuntimeFilterFindTarget(PlanState *join, Expr *expr,
+						AttrNumber *attno);
+static bool RuntimeFilterRangeTypes(Oid innerType, Oid outerType);
+static void RuntimeFilterFoldBloom(RuntimeFilter *filter, uint32 nbits);
+
+/*
+ * Create the runtime filter of a hash join, and hand it to the scan or the
+ * receiving Motion on the outer side.  Returns NULL if the join can't have
+ * one.
+ */
+RuntimeFilter *
+ExecHashJoinCreateRuntimeFilter(HashJoinState *hjstate)
+{
+	RuntimeFilter *filter;
+	PlanState  *target = NULL;
+	ListCell   *lco;
+	ListCell   *lci;
+	ListCell   *lcop;
+	bool		allKeys = true;
+	bool		anyRange = false;
+	int			nkeys;
+
+	if (!gp_enable_runtime_filter || hjstate->hj_nonequijoin)
+		return NULL;
+
+	/*
+	 * Only joins that drop the outer rows without a match.
+	 */
+	if (hjstate->js.jointype != JOIN_INNER &&
+		hjstate->js.jointype != JOIN_SEMI &&
+		hjstate->js.jointype != JOIN_RIGHT)
+		return NULL;
+
+	nkeys = list_length(hjstate->hj_OuterHashKeys);
+	filter = palloc0(sizeof(RuntimeFilter));
+	filter->keys = palloc0(nkeys * sizeof(RuntimeFilterKey));
+
+	forthree(lco, hjstate->hj_OuterHashKeys,
+			 lci, hjstate->hj_InnerHashKeys,
+			 lcop, hjstate->hj_HashOperators)
+	{
+		ExprState  *outerKey = (ExprState *) lfirst(lco);
+		ExprState  *innerKey = (ExprState *) lfirst(lci);
+		Oid			hashop = lfirst_oid(lcop);
+		RuntimeFilterKey *key = &filter->keys[filter->nkeys];
+		PlanState  *keyTarget;
+		AttrNumber	attno;
+		Oid			left_hashfn;
+		Oid			right_hashfn;
+
+		keyTarget = RuntimeFilterFindTarget((PlanState *) hjstate,
+											outerKey->expr, &attno);
+		if (keyTarget == NULL || (target != NULL && keyTarget != target))
+		{
+			allKeys = false;
+			continue;
+		}
+		target = keyTarget;
+
+		if (!get_op_hash_functions(hashop, &left_hashfn, &right_hashfn))
+			elog(ERROR, "could not find hash function for hash operator %u",
+				 hashop);
+
+		key->attno = attno;
+		fmgr_info(left_hashfn, &key->hashfn);
+		key->strict = op_strict(hashop);
+
+		key->innerExpr = innerKey;
+		key->innerType = exprType((Node *) innerKey->expr);
+		key->outerType = exprType((Node *) outerKey->expr);
+		key->hasRange = key->strict &&
+			RuntimeFilterRangeTypes(key->innerType, key->outerType);
+		anyRange |= key->hasRange;
+
+		filter->nkeys++;
+	}
+
+	if (target == NULL || (!allKeys && !anyRange))
+	{
+		pfree(filter->keys);
+		pfree(filter);
+		return NULL;
+	}
+
+	/*
+	 * The bloom filter is over the hash value of all the join keys, so the
+	 * scan must have them all.
+	 */
+	if (allKeys)
+	{
+		double		rows = innerPlanState(hjstate)->plan->plan_rows;
+		uint32		nbits = RUNTIME_FILTER_MIN_BITS;
+		uint32		maxbits = RUNTIME_FILTER_MAX_BITS;
+
+		if (IsA(target, MotionState))
+			maxbits = RUNTIME_FILTER_MOTION_MAX_BITS;
+
+		while (nbits < maxbits &&
+			   nbits < rows * RUNTIME_FILTER_BITS_PER_ROW)
+			nbits <<= 1;
+
+		filter->bloom = palloc0(nbits / 8);
+		filter->bloomMask = nbits - 1;
+	}
+
+	ExecRuntimeFilterReset(filter);
+
+	if (IsA(target, MotionState))
+	{
+		filter->motion = (MotionState *) target;
+		filter->motion->runtimeFilter = filter;
+	}
+	else
+	{
+		SeqScanState *scan = (SeqScanState *) target;
+
+		scan->ss_runtimefilters = lappend(scan->ss_runtimefilters, filter);
+	}
+
+	return filter;
+}
+
+/*
+ * Follow an outer key of a join down the outer side of the plan, to the
+ * column of a SeqScan, or of a receiving Motion.  Returns NULL if it isn't
+ * a plain column of either, or if a join in between could return outer
+ * rows that the scan would reject (a right or full join returns inner rows
+ * whose match is gone).
+ *
+ * A Motion takes a single filter, so that its senders check each row once;
+ * the first hash join to find it gets it.  An explicit redistribute Motion
+ * is left alone, it feeds DML.
+ */
+static PlanState *
+RuntimeFilterFindTarget(PlanState *join, Expr *expr, AttrNumber *attno)
+{
+	for (;;)
+	{
+		PlanState  *child = outerPlanState(join);
+		Var		   *var = (Var *) expr;
+		TargetEntry *tle;
+
+		if (child == NULL || !IsA(var, Var) || var->varno != OUTER_VAR ||
+			var->varattno <= 0 ||
+			var->varattno > list_length(child->plan->targetlist))
+			return NULL;
+
+		tle = (TargetEntry *) list_nth(child->plan->targetlist,
+									   var->varattno - 1);
+		expr = tle->expr;
+
+		switch (nodeTag(child))
+		{
+			case T_SeqScanState:
+				var = (Var *) expr;
+				if (!IsA(child->plan, SeqScan) || !IsA(var, Var) ||
+					var->varno != ((Scan *) child->plan)->scanrelid ||
+					var->varlevelsup != 0 || var->varattno <= 0)
+					return NULL;
+
+				*attno = var->varattno;
+				return child;
+
+			case T_MotionState:
+				{
+					MotionState *motion = (MotionState *) child;
+
+					if (motion->mstype != MOTIONSTATE_RECV ||
+						motion->runtimeFilter != NULL)
+						return NULL;
+
+					switch (((Motion *) child->plan)->motionType)
+					{
+						case MOTIONTYPE_HASH:
+						case MOTIONTYPE_BROADCAST:
+						case MOTIONTYPE_GATHER:
+						case MOTIONTYPE_GATHER_SINGLE:
+							break;
+						default:
+							return NULL;
+					}
+
+					/* The Motion passes the rows of its sender as they are */
+					*attno = var->varattno;
+					return child;
+				}
+
+			case T_HashJoinState:
+			case T_NestLoopState:
+			case T_MergeJoinState:
+				switch (((JoinState *) child)->jointype)
+				{
+					case JOIN_INNER:
+					case JOIN_LEFT:
+					case JOIN_SEMI:
+					case JOIN_ANTI:
+					case JOIN_LASJ_NOTIN:
+						break;
+					default:
+						return NULL;
+				}
+				join = child;
+				break;
+
+			default:
+				return NULL;
+		}
+	}
+}
+
+/*
+ * Can the range of the inner keys be compared with the outer values?
+ */
+static bool
+RuntimeFilterRangeTypes(Oid innerType, Oid outerType)
+{
+	if (!AppendOnlyBlockDirectory_ZoneSupportedType(innerType) ||
+		!AppendOnlyBlockDirectory_ZoneSupportedType(outerType))
+		return false;
+
+	if (innerType == outerType)
+		return true;
+
+	return ((innerType == INT2OID || innerType == INT4OID || innerType == INT8OID) &&
+			(outerType == INT2OID || outerType == INT4OID || outerType == INT8OID));
+}
+
+/*
+ * Forget the contents of the filter, before the hash table is (re)built.
+ * The scan doesn't use the filter until it is built again.
+ */
+void
+ExecRuntimeFilterReset(RuntimeFilter *filter)
+{
+	int			i;
+
+	filter->ready = false;
+	filter->useBloom = false;
+	filter->ninserted = 0;
+
+	if (filter->bloom)
+		memset(filter->bloom, 0, (filter->bloomMask / 8) + 1);
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		filter->keys[i].minValue = PG_INT64_MAX;
+		filter->keys[i].maxValue = PG_INT64_MIN;
+	}
+}
+
+/*
+ * Add a tuple inserted in the hash table to the filter.  The tuple is in
+ * econtext->ecxt_innertuple, and hashvalue is its hash value.
+ */
+void
+ExecRuntimeFilterInsert(RuntimeFilter *filter, ExprContext *econtext,
+						uint32 hashvalue)
+{
+	int			i;
+
+	if (filter->bloom)
+	{
+		uint32		h2 = DatumGetUInt32(hash_uint32(hashvalue));
+
+		for (i = 0; i < RUNTIME_FILTER_NUM_PROBES; i++)
+		{
+			uint32		bit = (hashvalue + i * h2) & filter->bloomMask;
+
+			filter->bloom[bit / 64] |= UINT64CONST(1) << (bit % 64);
+		}
+	}
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		RuntimeFilterKey *key = &filter->keys[i];
+		MemoryContext oldContext;
+		Datum		value;
+		bool		isNull;
+		int64		v;
+
+		if (!key->hasRange)
+			continue;
+
+		oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+		value = ExecEvalExpr(key->innerExpr, econtext, &isNull, NULL);
+		MemoryContextSwitchTo(oldContext);
+
+		if (isNull)
+			continue;
+
+		v = AppendOnlyBlockDirectory_ZoneValue(key->innerType, value);
+		if (v < key->minValue)
+			key->minValue = v;
+		if (v > key->maxValue)
+			key->maxValue = v;
+	}
+
+	filter->ninserted++;
+}
+
+/*
+ * The whole inner side is in the filter; the scan may use it, or the
+ * senders of the Motion once it is sent to them.
+ */
+void
+ExecRuntimeFilterFinish(RuntimeFilter *filter)
+{
+	/* A bloom filter much fuller than planned rejects little */
+	filter->useBloom = (filter->bloom != NULL &&
+						filter->ninserted <=
+						((int64) filter->bloomMask + 1) / RUNTIME_FILTER_MIN_ROW_BITS);
+	filter->ready = true;
+
+	/*
+	 * The senders can't take it back, so it is only sent for the first
+	 * build of the hash table.  A Motion can't be rescanned anyway.
+	 */
+	if (filter->motion && !filter->sent)
+	{
+		ExecMotionSendRuntimeFilter(filter->motion, filter);
+		filter->sent = true;
+	}
+}
+
+/*
+ * Can the row in slot find a match in the hash join?  Returns false if it
+ * surely can't.
+ */
+bool
+ExecRuntimeFilterCheck(RuntimeFilter *filter, TupleTableSlot *slot)
+{
+	uint32		hashkey = 0;
+	int			i;
+
+	if (!filter->ready || filter->disabled)
+		return true;
+
+	if (filter->nprobed == RUNTIME_FILTER_SAMPLE_ROWS &&
+		filter->nrejected < filter->nprobed / RUNTIME_FILTER_MIN_SELECTIVITY)
+	{
+		filter->disabled = true;
+		return true;
+	}
+
+	filter->nprobed++;
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		RuntimeFilterKey *key = &filter->keys[i];
+		Datum		value;
+		bool		isNull;
+
+		/* Same as ExecHashGetHashValue() */
+		hashkey = (hashkey << 1) | ((hashkey & 0x80000000) ? 1 : 0);
+
+		value = slot_getattr(slot, key->attno, &isNull);
+		if (isNull)
+		{
+			if (key->strict)
+				goto reject;
+			continue;
+		}
+
+		if (key->hasRange)
+		{
+			int64		v = AppendOnlyBlockDirectory_ZoneValue(key->outerType, value);
+
+			if (v < key->minValue || v > key->maxValue)
+				goto reject;
+		}
+
+		if (filter->useBloom)
+			hashkey ^= DatumGetUInt32(FunctionCall1(&key->hashfn, value));
+	}
+
+	if (filter->useBloom)
+	{
+		uint32		h2 = DatumGetUInt32(hash_uint32(hashkey));
+
+		for (i = 0; i < RUNTIME_FILTER_NUM_PROBES; i++)
+		{
+			uint32		bit = (hashkey + i * h2) & filter->bloomMask;
+
+			if ((filter->bloom[bit / 64] & (UINT64CONST(1) << (bit % 64))) == 0)
+				goto reject;
+		}
+	}
+
+	return true;
+
+reject:
+	filter->nrejected++;
+	return false;
+}
+
+/*
+ * Fold the bloom filter down to nbits bits.  The probes are the low bits of
+ * the hash, so the bits of the bigger filter map to the smaller one by
+ * masking, i.e. by OR-ing its words together.
+ */
+static void
+RuntimeFilterFoldBloom(RuntimeFilter *filter, uint32 nbits)
+{
+	uint32		nwords = (filter->bloomMask + 1) / 64;
+	uint32		newwords = nbits / 64;
+	uint32		w;
+
+	Assert(nbits >= 64 && nbits <= filter->bloomMask + 1);
+
+	for (w = newwords; w < nwords; w++)
+		filter->bloom[w % newwords] |= filter->bloom[w];
+
+	filter->bloomMask = nbits - 1;
+}
+
+/*
+ * Serialize a built filter into buf, to send it to the senders of a Motion.
+ * The bloom filter is folded until the message fits in
+ * MAX_RUNTIME_FILTER_MSG_SIZE.  Returns false if the filter can't reject
+ * anything, and isn't worth sending.
+ */
+bool
+ExecRuntimeFilterSerialize(RuntimeFilter *filter, StringInfo buf)
+{
+	RuntimeFilterMsgHeader hdr;
+	bool		anyRange = false;
+	uint32		nbits = 0;
+	int			i;
+
+	Assert(filter->ready);
+
+	for (i = 0; i < filter->nkeys; i++)
+		anyRange |= filter->keys[i].hasRange;
+
+	if (filter->useBloom)
+	{
+		int			fixed = sizeof(hdr) + filter->nkeys * sizeof(RuntimeFilterMsgKey);
+
+		nbits = filter->bloomMask + 1;
+		while (nbits > 64 && fixed + nbits / 8 > MAX_RUNTIME_FILTER_MSG_SIZE)
+			nbits >>= 1;
+		if (fixed + nbits / 8 > MAX_RUNTIME_FILTER_MSG_SIZE)
+			nbits = 0;
+		else if (nbits < filter->bloomMask + 1)
+			RuntimeFilterFoldBloom(filter, nbits);
+	}
+
+	if (nbits == 0 && !anyRange)
+		return false;
+
+	hdr.nkeys = filter->nkeys;
+	hdr.nbits = nbits;
+	appendBinaryStringInfo(buf, (char *) &hdr, sizeof(hdr));
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		RuntimeFilterKey *key = &filter->keys[i];
+		RuntimeFilterMsgKey mkey;
+
+		memset(&mkey, 0, sizeof(mkey));
+		mkey.minValue = key->minValue;
+		mkey.maxValue = key->maxValue;
+		mkey.hashfn = key->hashfn.fn_oid;
+		mkey.outerType = key->outerType;
+		mkey.attno = key->attno;
+		mkey.strict = key->strict;
+		mkey.hasRange = key->hasRange;
+		appendBinaryStringInfo(buf, (char *) &mkey, sizeof(mkey));
+	}
+
+	if (nbits > 0)
+		appendBinaryStringInfo(buf, (char *) filter->bloom, nbits / 8);
+
+	return true;
+}
+
+/*
+ * Rebuild a filter sent by a receiver of a Motion, ready to be checked.
+ * Returns NULL if the message is malformed.
+ */
+RuntimeFilter *
+ExecRuntimeFilterDeserialize(const char *data, int len)
+{
+	RuntimeFilterMsgHeader hdr;
+	RuntimeFilter *filter;
+	int			i;
+
+	if (len < sizeof(hdr))
+		return NULL;
+	memcpy(&hdr, data, sizeof(hdr));
+
+	if (hdr.nkeys <= 0 || hdr.nkeys > MAX_RUNTIME_FILTER_MSG_SIZE ||
+		(hdr.nbits != 0 && (hdr.nbits < 64 || (hdr.nbits & (hdr.nbits - 1)) != 0)) ||
+		len != sizeof(hdr) + hdr.nkeys * sizeof(RuntimeFilterMsgKey) + hdr.nbits / 8)
+		return NULL;
+	data += sizeof(hdr);
+
+	filter = palloc0(sizeof(RuntimeFilter));
+	filter->nkeys = hdr.nkeys;
+	filter->keys = palloc0(hdr.nkeys * sizeof(RuntimeFilterKey));
+
+	for (i = 0; i < hdr.nkeys; i++)
+	{
+		RuntimeFilterKey *key = &filter->keys[i];
+		RuntimeFilterMsgKey mkey;
+
+		memcpy(&mkey, data, sizeof(mkey));
+		data += sizeof(mkey);
+
+		key->attno = mkey.attno;
+		fmgr_info(mkey.hashfn, &key->hashfn);
+		key->strict = mkey.strict;
+		key->hasRange = mkey.hasRange;
+		key->outerType = mkey.outerType;
+		key->minValue = mkey.minValue;
+		key->maxValue = mkey.maxValue;
+	}
+
+	if (hdr.nbits > 0)
+	{
+		filter->bloom = palloc(hdr.nbits / 8);
+		memcpy(filter->bloom, data, hdr.nbits / 8);
+		filter->bloomMask = hdr.nbits - 1;
+		filter->useBloom = true;
+	}
+
+	filter->ready = true;
+
+	return filter;
+}
+
+/*
+ * Widen filter to also pass the rows other passes, for a Motion that
+ * broadcasts each row to all the receivers.  Returns false if the two
+ * filters are not over the same keys.
+ */
+bool
+ExecRuntimeFilterMerge(RuntimeFilter *filter, RuntimeFilter *other)
+{
+	int			i;
+
+	if (filter->nkeys != other->nkeys)
+		return false;
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		RuntimeFilterKey *key = &filter->keys[i];
+		RuntimeFilterKey *okey = &other->keys[i];
+
+		if (key->attno != okey->attno ||
+			key->hashfn.fn_oid != okey->hashfn.fn_oid ||
+			key->strict != okey->strict)
+			return false;
+	}
+
+	for (i = 0; i < filter->nkeys; i++)
+	{
+		RuntimeFilterKey *key = &filter->keys[i];
+		RuntimeFilterKey *okey = &other->keys[i];
+
+		if (!okey->hasRange)
+			key->hasRange = false;
+		if (okey->minValue < key->minValue)
+			key->minValue = okey->minValue;
+		if (okey->maxValue > key->maxValue)
+			key->maxValue = okey->maxValue;
+	}
+
+	if (filter->useBloom && other->useBloom)
+	{
+		uint32		nbits = Min(filter->bloomMask, other->bloomMask) + 1;
+		uint32		w;
+
+		if (nbits < filter->bloomMask + 1)
+			RuntimeFilterFoldBloom(filter, nbits);
+
+		for (w = 0; w < (other->bloomMask + 1) / 64; w++)
+			filter->bloom[w % (nbits / 64)] |= other->bloom[w];
+	}
+	else
+		filter->useBloom = false;
+
+	filter->ninserted += other->ninserted;
+
+	return true;
+}
@@ -1424,7 +1424,7 @@ sliceRunsOnQE(ExecSlice *slice)
 }
 
 /* Forward declarations */
-static void InventorySliceTree(CdbDispatcherState *ds, SliceTable *sliceTable, int sliceIndex);
+static void InventorySliceTree(SliceTable *sliceTable, int sliceIndex, List **slices);
 
 /*
  * Function AssignGangs runs on the QD and finishes construction of the
@@ -1449,25 +1449,69 @@ AssignGangs(CdbDispatcherState *ds, QueryDesc *queryDesc)
 	SliceTable	*sliceTable;
 	EState		*estate;
 	int			rootIdx;
+	List		*slices = NIL;
+	GangType	*types;
+	List		**segments;
+	Gang		**gangs;
+	ListCell	*lc;
+	int			ngangs;
+	int			i;
 
 	estate = queryDesc->estate;
 	sliceTable = estate->es_sliceTable;
 	rootIdx = RootSliceIndex(queryDesc->estate);
 
 	/* cleanup processMap because initPlan and main Plan share the same slice table */
-	for (int i = 0; i < sliceTable->numSlices; i++)
+	for (i = 0; i < sliceTable->numSlices; i++)
 		sliceTable->slices[i].processesMap = NULL;
 
-	InventorySliceTree(ds, sliceTable, rootIdx);
+	InventorySliceTree(sliceTable, rootIdx, &slices);
+
+	/*
+	 * Allocate the gangs of all the slices at once, so that their QEs are
+	 * connected concurrently.
+	 */
+	ngangs = list_length(slices);
+	if (ngangs == 0)
+		return;
+
+	types = palloc(sizeof(GangType) * ngangs);
+	segments = palloc(sizeof(List *) * ngangs);
+	gangs = palloc(sizeof(Gang *) * ngangs);
+	i = 0;
+	foreach(lc, slices)
+	{
+		ExecSlice  *slice = (ExecSlice *) lfirst(lc);
+
+		types[i] = slice->gangType;
+		segments[i] = slice->segments;
+		i++;
+	}
+
+	AllocateGangs(ds, ngangs, types, segments, gangs);
+
+	i = 0;
+	foreach(lc, slices)
+	{
+		ExecSlice  *slice = (ExecSlice *) lfirst(lc);
+
+		slice->primaryGang = gangs[i++];
+		setupCdbProcessList(slice);
+	}
+
+	pfree(types);
+	pfree(segments);
+	pfree(gangs);
+	list_free(slices);
 }
 
 /*
  * Helper for AssignGangs takes a simple inventory of the gangs required
- * by a slice tree.  Recursive.  Closely coupled with AssignGangs.	Not
- * generally useful.
+ * by a slice tree, and collects the slices that need one into *slices.
+ * Recursive.  Closely coupled with AssignGangs.	Not generally useful.
  */
 static void
-InventorySliceTree(CdbDispatcherState *ds, SliceTable *sliceTable, int sliceIndex)
+InventorySliceTree(SliceTable *sliceTable, int sliceIndex, List **slices)
 {
 	ExecSlice *slice = &sliceTable->slices[sliceIndex];
 	ListCell *cell;
@@ -1480,15 +1524,14 @@ InventorySliceTree(CdbDispatcherState *ds, SliceTable *sliceTable, int sliceInde
 	else
 	{
 		Assert(slice->segments != NIL);
-		slice->primaryGang = AllocateGang(ds, slice->gangType, slice->segments);
-		setupCdbProcessList(slice);
+		*slices = lappend(*slices, slice);
 	}
 
 	foreach(cell, slice->children)
 	{
 		int			childIndex = lfirst_int(cell);
 
-		InventorySliceTree(ds, sliceTable, childIndex);
+		InventorySliceTree(sliceTable, childIndex, slices);
 	}
 }
 
@@ -31,6 +31,7 @@
 #include "catalog/pg_statistic.h"
 #include "commands/tablespace.h"
 #include "executor/execdebug.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/hashjoin.h"
 #include "executor/nodeHash.h"
 #include "executor/nodeHashjoin.h"
@@ -112,6 +113,9 @@ MultiExecHash(HashState *node)
 
 	SIMPLE_FAULT_INJECTOR("multi_exec_hash_large_vmem");
 
+	if (node->hs_runtimefilter)
+		ExecRuntimeFilterReset(node->hs_runtimefilter);
+
 	/*
 	 * get all inner tuples and insert into the hash table (or temp files)
 	 */
@@ -145,6 +149,10 @@ MultiExecHash(HashState *node)
 				ExecHashTableInsert(node, hashtable, slot, hashvalue);
 			}
 			hashtable->totalTuples += 1;
+
+			if (node->hs_runtimefilter)
+				ExecRuntimeFilterInsert(node->hs_runtimefilter, econtext,
+										hashvalue);
 		}
 
 		if (hashkeys_null)
@@ -161,6 +169,10 @@ MultiExecHash(HashState *node)
 	/* Now we have set up all the initial batches & primary overflow batches. */
 	hashtable->nbatch_outstart = hashtable->nbatch;
 
+	/* The outer scan may use the runtime filter now */
+	if (node->hs_runtimefilter)
+		ExecRuntimeFilterFinish(node->hs_runtimefilter);
+
 	/* resize the hash table if needed (NTUP_PER_BUCKET exceeded) */
 	if (hashtable->nbuckets != hashtable->nbuckets_optimal)
 		ExecHashIncreaseNumBuckets(hashtable);
@@ -19,6 +19,7 @@
 
 #include "access/htup_details.h"
 #include "executor/executor.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/hashjoin.h"
 #include "executor/instrument.h"	/* Instrumentation */
 #include "executor/nodeHash.h"
@@ -733,6 +734,10 @@ ExecInitHashJoin(HashJoin *node, EState *estate, int eflags)
 	/* child Hash node needs to evaluate inner hash keys, too */
 	((HashState *) innerPlanState(hjstate))->hashkeys = rclauses;
 
+	/* Let the Hash node filter the outer scan, if we can */
+	((HashState *) innerPlanState(hjstate))->hs_runtimefilter =
+		ExecHashJoinCreateRuntimeFilter(hjstate);
+
 	hjstate->hj_JoinState = HJ_BUILD_HASHTABLE;
 	hjstate->hj_MatchedOuter = false;
 	hjstate->hj_OuterNotEmpty = false;
@@ -1238,13 +1243,16 @@ ExecReScanHashJoin(HashJoinState *node)
 		}
 		else
 		{
+			HashState  *hashState = (HashState *) innerPlanState(node);
+
 			/* must destroy and rebuild hash table */
 			if (!node->hj_HashTable->eagerlyReleased)
-			{
-				HashState  *hashState = (HashState *) innerPlanState(node);
-
 				ExecHashTableDestroy(hashState, node->hj_HashTable);
-			}
+
+			/* and the outer scan must not use the old runtime filter */
+			if (hashState->hs_runtimefilter)
+				ExecRuntimeFilterReset(hashState->hs_runtimefilter);
+
 			pfree(node->hj_HashTable);
 			node->hj_HashTable = NULL;
 			node->hj_JoinState = HJ_BUILD_HASHTABLE;
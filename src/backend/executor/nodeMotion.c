@@ -23,11 +23,13 @@
 #include "cdb/cdbhash.h"
 #include "executor/executor.h"
 #include "executor/execdebug.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/execUtils.h"
 #include "executor/nodeMotion.h"
 #include "lib/binaryheap.h"
 #include "utils/tuplesort.h"
 #include "miscadmin.h"
+#include "utils/faultinjector.h"
 #include "utils/memutils.h"
 
 
@@ -56,7 +58,9 @@ static int	CdbMergeComparator(Datum lhs, Datum rhs, void *context);
 static uint32 evalHashKey(ExprContext *econtext, List *hashkeys, CdbHash *h);
 
 static void doSendEndOfStream(Motion *motion, MotionState *node);
+static void ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 static void doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot);
+static RuntimeFilter *getRuntimeFilter(Motion *motion, MotionState *node, int16 targetRoute);
 
 
 /*=========================================================================
@@ -283,7 +287,22 @@ execMotionSender(MotionState *node)
 #endif
 	}
 
-	Assert(node->stopRequested || node->numTuplesFromChild == node->numTuplesToAMS);
+	Assert(node->stopRequested ||
+		   node->numTuplesFromChild == node->numTuplesToAMS + node->numTuplesFiltered);
+
+	/*
+	 * CDB: EXPLAIN ANALYZE shows the rows the receivers' runtime filters
+	 * rejected with the child, this node belongs to the receiving slice.
+	 */
+	if (node->numRuntimeFiltersSeen > 0 && node->ps.instrument &&
+		(node->ps.state->es_instrument & INSTRUMENT_CDB))
+	{
+		if (outerNode->cdbexplainbuf == NULL)
+			outerNode->cdbexplainbuf = makeStringInfo();
+		appendStringInfo(outerNode->cdbexplainbuf,
+						 "Runtime filters from the receivers rejected %d of %d rows.",
+						 node->numTuplesFiltered, node->numTuplesFromChild);
+	}
 
 	/* nothing else to send out, so we return NULL up the tree. */
 	return NULL;
@@ -295,7 +314,6 @@ execMotionUnsortedReceiver(MotionState *node)
 {
 	/* RECEIVER LOGIC */
 	TupleTableSlot *slot;
-	GenericTuple tuple;
 	Motion	   *motion = (Motion *) node->ps.plan;
 
 	AssertState(motion->motionType == MOTIONTYPE_GATHER ||
@@ -315,11 +333,13 @@ execMotionUnsortedReceiver(MotionState *node)
 		return NULL;
 	}
 
-	tuple = RecvTupleFrom(node->ps.state->motionlayer_context,
-						  node->ps.state->interconnect_context,
-						  motion->motionID, ANY_ROUTE);
+	/* receive into our result slot and return it. */
+	slot = RecvTupleFrom(node->ps.state->motionlayer_context,
+						 node->ps.state->interconnect_context,
+						 motion->motionID, ANY_ROUTE,
+						 node->ps.ps_ResultTupleSlot);
 
-	if (!tuple)
+	if (!slot)
 	{
 #ifdef CDB_MOTION_DEBUG
 		if (gp_log_interconnect >= GPVARS_VERBOSITY_DEBUG)
@@ -334,10 +354,6 @@ execMotionUnsortedReceiver(MotionState *node)
 	node->numTuplesFromAMS++;
 	node->numTuplesToParent++;
 
-	/* store it in our result slot and return this. */
-	slot = node->ps.ps_ResultTupleSlot;
-	slot = ExecStoreGenericTuple(tuple, slot, true /* shouldFree */ );
-
 #ifdef CDB_MOTION_DEBUG
 	if (node->numTuplesToParent <= 20)
 	{
@@ -395,7 +411,6 @@ execMotionSortedReceiver(MotionState *node)
 {
 	TupleTableSlot *slot;
 	binaryheap *hp = node->tupleheap;
-	GenericTuple inputTuple;
 	Motion	   *motion = (Motion *) node->ps.plan;
 	EState	   *estate = node->ps.state;
 
@@ -418,7 +433,6 @@ execMotionSortedReceiver(MotionState *node)
 	 */
 	if (!node->tupleheapReady)
 	{
-		GenericTuple inputTuple;
 		binaryheap *hp = node->tupleheap;
 		Motion	   *motion = (Motion *) node->ps.plan;
 		int			iSegIdx;
@@ -434,18 +448,11 @@ execMotionSortedReceiver(MotionState *node)
 			if (lfirst(lcProcess) == NULL)
 				continue;			/* skip this one: we are not receiving from it */
 
-			inputTuple = RecvTupleFrom(node->ps.state->motionlayer_context,
-									   node->ps.state->interconnect_context,
-									   motion->motionID, iSegIdx);
-
-			if (!inputTuple)
-				continue;			/* skip this one: received nothing */
-
 			/*
-			 * Make a slot to hold this tuple. We will reuse it to hold any
-			 * future tuples from the same sender. We initialized the result
-			 * tuple slot with the correct type earlier, so make the new slot
-			 * have the same type.
+			 * Make a slot to hold this sender's tuples. We will reuse it to
+			 * hold any future tuples from the same sender. We initialized the
+			 * result tuple slot with the correct type earlier, so make the
+			 * new slot have the same type.
 			 */
 			oldcxt = MemoryContextSwitchTo(estate->es_query_cxt);
 			node->slots[iSegIdx] = MakeTupleTableSlot();
@@ -453,15 +460,20 @@ execMotionSortedReceiver(MotionState *node)
 								  node->ps.ps_ResultTupleSlot->tts_tupleDescriptor);
 			MemoryContextSwitchTo(oldcxt);
 
+			if (!RecvTupleFrom(node->ps.state->motionlayer_context,
+							   node->ps.state->interconnect_context,
+							   motion->motionID, iSegIdx,
+							   node->slots[iSegIdx]))
+				continue;			/* skip this one: received nothing */
+
 			/*
-			 * Store the tuple in the slot, and add it to the heap.
+			 * Add the tuple to the heap.
 			 *
 			 * Use slot_getsomeattrs() to materialize the columns we need for
 			 * the comparisons in the tts_values/isnull arrays. The comparator
 			 * can then peek directly into the arrays, which is cheaper than
 			 * calling slot_getattr() all the time.
 			 */
-			ExecStoreGenericTuple(inputTuple, node->slots[iSegIdx], true);
 			slot_getsomeattrs(node->slots[iSegIdx], node->lastSortColIdx);
 			binaryheap_add_unordered(hp, iSegIdx);
 
@@ -505,15 +517,15 @@ execMotionSortedReceiver(MotionState *node)
 		Assert(DatumGetInt32(binaryheap_first(hp)) == node->routeIdNext);
 
 		/* Receive the successor of the tuple that we returned last time. */
-		inputTuple = RecvTupleFrom(node->ps.state->motionlayer_context,
-								   node->ps.state->interconnect_context,
-								   motion->motionID,
-								   node->routeIdNext);
+		slot = RecvTupleFrom(node->ps.state->motionlayer_context,
+							 node->ps.state->interconnect_context,
+							 motion->motionID,
+							 node->routeIdNext,
+							 node->slots[node->routeIdNext]);
 
 		/* Substitute it in the pq for its predecessor. */
-		if (inputTuple)
+		if (slot)
 		{
-			ExecStoreGenericTuple(inputTuple, node->slots[node->routeIdNext], true);
 			slot_getsomeattrs(node->slots[node->routeIdNext], node->lastSortColIdx);
 			binaryheap_replace_first(hp, Int32GetDatum(node->routeIdNext));
 
@@ -697,12 +709,20 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 
 	motionstate->numTuplesFromChild = 0;
 	motionstate->numTuplesToAMS = 0;
+	motionstate->numTuplesFiltered = 0;
 	motionstate->numTuplesFromAMS = 0;
 	motionstate->numTuplesToParent = 0;
 
 	motionstate->stopRequested = false;
 	motionstate->numInputSegs = list_length(sendSlice->segments);
 
+	/*
+	 * CDB: Offer extra info for EXPLAIN ANALYZE.
+	 */
+	if (motionstate->mstype == MOTIONSTATE_RECV &&
+		estate->es_instrument && (estate->es_instrument & INSTRUMENT_CDB))
+		motionstate->ps.cdbexplainfun = ExecMotionExplainEnd;
+
 	/*
 	 * Miscellaneous initialization
 	 *
@@ -848,6 +868,35 @@ ExecInitMotion(Motion *node, EState *estate, int eflags)
 	return motionstate;
 }
 
+/*
+ * ExecMotionExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ *
+ * Reports how much the interconnect compressed the data received by this
+ * Motion, if it did.
+ */
+static void
+ExecMotionExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	Motion	   *motion = (Motion *) planstate->plan;
+	EState	   *estate = planstate->state;
+	uint64		rawBytes;
+	uint64		wireBytes;
+
+	if (!estate->es_interconnect_is_setup)
+		return;
+
+	GetMotionCompressionStats(estate->interconnect_context, motion->motionID,
+							  &rawBytes, &wireBytes);
+
+	if (wireBytes < rawBytes)
+		appendStringInfo(buf,
+						 "Interconnect compressed " UINT64_FORMAT " bytes to "
+						 UINT64_FORMAT " bytes (%.1f%%).",
+						 rawBytes, wireBytes,
+						 100.0 * (double) wireBytes / (double) rawBytes);
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndMotion(node)
  * ----------------------------------------------------------------
@@ -1172,6 +1221,29 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 	else
 		elog(ERROR, "unknown motion type %d", motion->motionType);
 
+	/* Drop the rows that the hash join of the receiver would reject */
+	if (gp_enable_runtime_filter && motion->motionType != MOTIONTYPE_EXPLICIT)
+	{
+		RuntimeFilter *filter = getRuntimeFilter(motion, node, targetRoute);
+
+		if (filter)
+		{
+			MemoryContext oldContext;
+			bool		pass;
+
+			ResetExprContext(econtext);
+			oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+			pass = ExecRuntimeFilterCheck(filter, outerTupleSlot);
+			MemoryContextSwitchTo(oldContext);
+
+			if (!pass)
+			{
+				node->numTuplesFiltered++;
+				return;
+			}
+		}
+	}
+
 	CheckAndSendRecordCache(node->ps.state->motionlayer_context,
 							node->ps.state->interconnect_context,
 							motion->motionID,
@@ -1208,6 +1280,128 @@ doSendTuple(Motion *motion, MotionState *node, TupleTableSlot *outerTupleSlot)
 }
 
 
+/*
+ * Get the runtime filter the rows sent on targetRoute must pass, if the
+ * receivers sent one.  The filters are picked up as they arrive; for a
+ * broadcast, only once all the receivers sent theirs.
+ */
+static RuntimeFilter *
+getRuntimeFilter(Motion *motion, MotionState *node, int16 targetRoute)
+{
+	EState	   *estate = node->ps.state;
+	int			count;
+	int			numRoutes;
+
+	count = GetMotionRuntimeFilterCount(estate->interconnect_context,
+										motion->motionID, &numRoutes);
+
+	if (count != node->numRuntimeFiltersSeen)
+	{
+		MemoryContext oldContext = MemoryContextSwitchTo(estate->es_query_cxt);
+		int			route;
+
+		if (node->runtimeFilters == NULL)
+		{
+			node->numRoutes = numRoutes;
+			node->runtimeFilters = palloc0(numRoutes * sizeof(RuntimeFilter *));
+		}
+
+		for (route = 0; route < node->numRoutes; route++)
+		{
+			const char *data;
+			int			len;
+
+			if (node->runtimeFilters[route] != NULL)
+				continue;
+
+			data = GetMotionRuntimeFilter(estate->interconnect_context,
+										  motion->motionID, route, &len);
+			if (data == NULL)
+				continue;
+
+			node->runtimeFilters[route] = ExecRuntimeFilterDeserialize(data, len);
+			if (node->runtimeFilters[route] == NULL)
+				elog(LOG, "ignoring malformed runtime filter for motion %d",
+					 motion->motionID);
+		}
+
+		if (motion->motionType == MOTIONTYPE_BROADCAST &&
+			count == node->numRoutes)
+		{
+			RuntimeFilter *merged = NULL;
+
+			for (route = 0; route < node->numRoutes; route++)
+			{
+				RuntimeFilter *filter = node->runtimeFilters[route];
+
+				if (filter == NULL)
+				{
+					merged = NULL;
+					break;
+				}
+
+				if (merged == NULL)
+				{
+					const char *data;
+					int			len;
+
+					/* a copy of the first one, to widen with the others */
+					data = GetMotionRuntimeFilter(estate->interconnect_context,
+												  motion->motionID, route, &len);
+					merged = ExecRuntimeFilterDeserialize(data, len);
+				}
+				else if (!ExecRuntimeFilterMerge(merged, filter))
+				{
+					merged = NULL;
+					break;
+				}
+			}
+			node->broadcastFilter = merged;
+		}
+
+		node->numRuntimeFiltersSeen = count;
+		MemoryContextSwitchTo(oldContext);
+	}
+
+	if (node->runtimeFilters == NULL)
+		return NULL;
+
+	if (motion->motionType == MOTIONTYPE_BROADCAST)
+		return node->broadcastFilter;
+
+	if (targetRoute < 0 || targetRoute >= node->numRoutes)
+		return NULL;
+
+	return node->runtimeFilters[targetRoute];
+}
+
+/*
+ * ExecMotionSendRuntimeFilter
+ *
+ * Send the runtime filter of a hash join above this receiving Motion back
+ * to its senders, for them not to send the rows the join would reject.
+ */
+void
+ExecMotionSendRuntimeFilter(MotionState *node, RuntimeFilter *filter)
+{
+	Motion	   *motion = (Motion *) node->ps.plan;
+	EState	   *estate = node->ps.state;
+	StringInfoData buf;
+
+	Assert(node->mstype == MOTIONSTATE_RECV);
+
+	if (!estate->es_interconnect_is_setup || node->stopRequested)
+		return;
+
+	SIMPLE_FAULT_INJECTOR("motion_send_runtime_filter");
+
+	initStringInfo(&buf);
+	if (ExecRuntimeFilterSerialize(filter, &buf))
+		SendMotionRuntimeFilter(estate->interconnect_context, motion->motionID,
+								buf.data, buf.len);
+	pfree(buf.data);
+}
+
 /*
  * ExecReScanMotion
  *
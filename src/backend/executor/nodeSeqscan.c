@@ -29,8 +29,12 @@
 #include "postgres.h"
 
 #include "access/relscan.h"
+#include "catalog/pg_type.h"
 #include "executor/execdebug.h"
+#include "executor/execRuntimeFilter.h"
 #include "executor/nodeSeqscan.h"
+#include "utils/lsyscache.h"
+#include "utils/memutils.h"
 #include "utils/rel.h"
 
 #include "cdb/cdbappendonlyam.h"
@@ -41,6 +45,9 @@ static void InitScanRelation(SeqScanState *node, EState *estate, int eflags, Rel
 static TupleTableSlot *SeqNext(SeqScanState *node);
 
 static void InitAOCSScanOpaque(SeqScanState *scanState, Relation currentRelation);
+static void SetAOCSZoneKeys(SeqScanState *scanState, Relation currentRelation);
+static bool SeqScanRuntimeFiltersPass(SeqScanState *node, TupleTableSlot *slot);
+static void ExecSeqScanExplainEnd(PlanState *planstate, struct StringInfoData *buf);
 
 /* ----------------------------------------------------------------
  *						Scan Support
@@ -97,12 +104,17 @@ SeqNext(SeqScanState *node)
 				node->ss.ps.state->es_snapshot,
 				appendOnlyMetaDataSnapshot,
 				0, NULL);
+
+			if (node->ss_ao_readstats)
+				appendonly_set_read_stats(node->ss_currentScanDesc_ao,
+										  node->ss_ao_readstats);
 		}
 		else if (RelationIsAoCols(currentRelation))
 		{
 			Snapshot appendOnlyMetaDataSnapshot;
 
-			InitAOCSScanOpaque(node, currentRelation);
+			if (node->ss_aocs_proj == NULL)
+				InitAOCSScanOpaque(node, currentRelation);
 
 			appendOnlyMetaDataSnapshot = node->ss.ps.state->es_snapshot;
 			if (appendOnlyMetaDataSnapshot == SnapshotAny)
@@ -120,6 +132,12 @@ SeqNext(SeqScanState *node)
 							   appendOnlyMetaDataSnapshot,
 							   NULL /* relationTupleDesc */,
 							   node->ss_aocs_proj);
+
+			SetAOCSZoneKeys(node, currentRelation);
+
+			if (node->ss_ao_readstats)
+				aocs_set_read_stats(node->ss_currentScanDesc_aocs,
+									node->ss_ao_readstats);
 		}
 		else
 		{
@@ -130,41 +148,81 @@ SeqNext(SeqScanState *node)
 	}
 
 	/*
-	 * get the next tuple from the table
+	 * get the next tuple from the table, skipping the rows the hash joins
+	 * above would reject
 	 */
-	if (node->ss_currentScanDesc_ao)
+	for (;;)
 	{
-		appendonly_getnext(node->ss_currentScanDesc_ao, direction, slot);
+		if (node->ss_currentScanDesc_ao)
+		{
+			appendonly_getnext(node->ss_currentScanDesc_ao, direction, slot);
+		}
+		else if (node->ss_currentScanDesc_aocs)
+		{
+			aocs_getnext(node->ss_currentScanDesc_aocs, direction, slot);
+		}
+		else
+		{
+			HeapScanDesc scandesc = node->ss_currentScanDesc_heap;
+
+			tuple = heap_getnext(scandesc, direction);
+
+			/*
+			 * save the tuple and the buffer returned to us by the access methods in
+			 * our scan tuple slot and return the slot.  Note: we pass 'false' because
+			 * tuples returned by heap_getnext() are pointers onto disk pages and were
+			 * not created with palloc() and so should not be pfree()'d.  Note also
+			 * that ExecStoreTuple will increment the refcount of the buffer; the
+			 * refcount will not be dropped until the tuple table slot is cleared.
+			 */
+			if (tuple)
+				ExecStoreHeapTuple(tuple,	/* tuple to store */
+							   slot,	/* slot to store in */
+							   scandesc->rs_cbuf,		/* buffer associated with this
+														 * tuple */
+							   false);	/* don't pfree this pointer */
+			else
+				ExecClearTuple(slot);
+		}
+
+		if (node->ss_runtimefilters == NIL || TupIsNull(slot) ||
+			SeqScanRuntimeFiltersPass(node, slot))
+			break;
 	}
-	else if (node->ss_currentScanDesc_aocs)
+
+	return slot;
+}
+
+/*
+ * Check a row against the runtime filters of the hash joins above.
+ */
+static bool
+SeqScanRuntimeFiltersPass(SeqScanState *node, TupleTableSlot *slot)
+{
+	ExprContext *econtext = node->ss.ps.ps_ExprContext;
+	MemoryContext oldContext;
+	ListCell   *lc;
+	bool		pass = true;
+
+	/* the hash functions may leak memory, e.g. when detoasting */
+	oldContext = MemoryContextSwitchTo(econtext->ecxt_per_tuple_memory);
+
+	foreach(lc, node->ss_runtimefilters)
 	{
-		aocs_getnext(node->ss_currentScanDesc_aocs, direction, slot);
+		if (!ExecRuntimeFilterCheck((RuntimeFilter *) lfirst(lc), slot))
+		{
+			pass = false;
+			break;
+		}
 	}
-	else
-	{
-		HeapScanDesc scandesc = node->ss_currentScanDesc_heap;
 
-		tuple = heap_getnext(scandesc, direction);
+	MemoryContextSwitchTo(oldContext);
 
-		/*
-		 * save the tuple and the buffer returned to us by the access methods in
-		 * our scan tuple slot and return the slot.  Note: we pass 'false' because
-		 * tuples returned by heap_getnext() are pointers onto disk pages and were
-		 * not created with palloc() and so should not be pfree()'d.  Note also
-		 * that ExecStoreTuple will increment the refcount of the buffer; the
-		 * refcount will not be dropped until the tuple table slot is cleared.
-		 */
-		if (tuple)
-			ExecStoreHeapTuple(tuple,	/* tuple to store */
-						   slot,	/* slot to store in */
-						   scandesc->rs_cbuf,		/* buffer associated with this
-													 * tuple */
-						   false);	/* don't pfree this pointer */
-		else
-			ExecClearTuple(slot);
-	}
+	/* like ExecScan() does between rows */
+	if (!pass)
+		ResetExprContext(econtext);
 
-	return slot;
+	return pass;
 }
 
 /*
@@ -285,9 +343,67 @@ ExecInitSeqScanForPartition(SeqScan *node, EState *estate, int eflags,
 	ExecAssignResultTypeFromTL(&scanstate->ss.ps);
 	ExecAssignScanProjectionInfo(&scanstate->ss);
 
+	/*
+	 * CDB: Offer extra info for EXPLAIN ANALYZE.
+	 */
+	if (estate->es_instrument && (estate->es_instrument & INSTRUMENT_CDB))
+	{
+		if (RelationIsAoRows(currentRelation) || RelationIsAoCols(currentRelation))
+			scanstate->ss_ao_readstats = palloc0(sizeof(BufferedReadStats));
+
+		/* Request a callback at end of query. */
+		scanstate->ss.ps.cdbexplainfun = ExecSeqScanExplainEnd;
+	}
+
 	return scanstate;
 }
 
+/*
+ * ExecSeqScanExplainEnd
+ *		Called before ExecutorEnd to finish EXPLAIN ANALYZE reporting.
+ *
+ * Reports the reads of an append-only scan, and how long it waited for them,
+ * and the rows rejected by runtime filters.
+ */
+static void
+ExecSeqScanExplainEnd(PlanState *planstate, struct StringInfoData *buf)
+{
+	SeqScanState *node = (SeqScanState *) planstate;
+	BufferedReadStats *stats = node->ss_ao_readstats;
+	int			start = buf->len;
+	ListCell   *lc;
+
+	if (stats && stats->reads > 0)
+	{
+		appendStringInfo(buf,
+						 "Append-only storage read " INT64_FORMAT " kB in "
+						 INT64_FORMAT " reads, waited %.3f ms.",
+						 stats->readBytes / 1024, stats->reads,
+						 INSTR_TIME_GET_MILLISEC(stats->stallTime));
+		if (stats->prefetches > 0)
+			appendStringInfo(buf,
+							 "  Prefetched " INT64_FORMAT " kB in "
+							 INT64_FORMAT " requests.",
+							 stats->prefetchBytes / 1024, stats->prefetches);
+	}
+
+	foreach(lc, node->ss_runtimefilters)
+	{
+		RuntimeFilter *filter = (RuntimeFilter *) lfirst(lc);
+
+		if (filter->nprobed == 0)
+			continue;
+
+		if (buf->len > start)
+			appendStringInfoString(buf, "  ");
+		appendStringInfo(buf,
+						 "Runtime filter rejected " INT64_FORMAT " of "
+						 INT64_FORMAT " rows%s.",
+						 filter->nrejected, filter->nprobed,
+						 filter->disabled ? ", then was turned off" : "");
+	}
+}
+
 /* ----------------------------------------------------------------
  *		ExecEndSeqScan
  *
@@ -361,7 +477,17 @@ ExecReScanSeqScan(SeqScanState *node)
 	}
 	else if (node->ss_currentScanDesc_aocs)
 	{
-		aocs_rescan(node->ss_currentScanDesc_aocs);
+		/*
+		 * The ranges of the runtime filters may change, start over with new
+		 * zone keys.
+		 */
+		if (node->ss_aocs_runtime_zones)
+		{
+			aocs_endscan(node->ss_currentScanDesc_aocs);
+			node->ss_currentScanDesc_aocs = NULL;
+		}
+		else
+			aocs_rescan(node->ss_currentScanDesc_aocs);
 	}
 	else if (node->ss_currentScanDesc_heap)
 	{
@@ -408,6 +534,151 @@ InitAOCSScanOpaque(SeqScanState *scanstate, Relation currentRelation)
 	scanstate->ss_aocs_proj = proj;
 }
 
+/*
+ * Can a zone map of a column of type 'coltype' be compared with a constant
+ * of type 'consttype'?  The integer types all map to the same int64 values.
+ */
+static bool
+ZoneKeyTypesComparable(Oid coltype, Oid consttype)
+{
+	if (coltype == consttype)
+		return true;
+
+	return ((coltype == INT2OID || coltype == INT4OID || coltype == INT8OID) &&
+			(consttype == INT2OID || consttype == INT4OID || consttype == INT8OID));
+}
+
+/*
+ * Hand the "column op constant" quals of an AOCS scan to the scan, to skip
+ * blocks with the min/max zone maps of the block directory.  The ranges of
+ * the runtime filters already built are handed over too.
+ */
+static void
+SetAOCSZoneKeys(SeqScanState *scanstate, Relation currentRelation)
+{
+	List	   *quals = scanstate->ss.ps.plan->qual;
+	AOCSZoneKey *keys;
+	int			maxkeys;
+	int			nkeys = 0;
+	ListCell   *lc;
+
+	scanstate->ss_aocs_runtime_zones = false;
+
+	if (!gp_appendonly_zone_maps ||
+		(quals == NIL && scanstate->ss_runtimefilters == NIL) ||
+		!OidIsValid(currentRelation->rd_appendonly->blkdirrelid))
+		return;
+
+	maxkeys = list_length(quals);
+	foreach(lc, scanstate->ss_runtimefilters)
+		maxkeys += 2 * ((RuntimeFilter *) lfirst(lc))->nkeys;
+
+	keys = palloc(maxkeys * sizeof(AOCSZoneKey));
+
+	foreach(lc, quals)
+	{
+		OpExpr	   *opexpr = (OpExpr *) lfirst(lc);
+		Node	   *leftop;
+		Node	   *rightop;
+		Var		   *var;
+		Const	   *con;
+		Oid			opno;
+		Oid			coltype;
+		List	   *interpretations;
+		ListCell   *lc2;
+		StrategyNumber strategy = InvalidStrategy;
+
+		if (!IsA(opexpr, OpExpr) || list_length(opexpr->args) != 2)
+			continue;
+
+		leftop = linitial(opexpr->args);
+		rightop = lsecond(opexpr->args);
+		if (IsA(leftop, Var) && IsA(rightop, Const))
+		{
+			var = (Var *) leftop;
+			con = (Const *) rightop;
+			opno = opexpr->opno;
+		}
+		else if (IsA(leftop, Const) && IsA(rightop, Var))
+		{
+			var = (Var *) rightop;
+			con = (Const *) leftop;
+			opno = get_commutator(opexpr->opno);
+		}
+		else
+			continue;
+
+		if (!OidIsValid(opno) || con->constisnull || var->varlevelsup != 0 ||
+			var->varattno <= 0 || var->varattno > scanstate->ss_aocs_ncol)
+			continue;
+
+		coltype = currentRelation->rd_att->attrs[var->varattno - 1]->atttypid;
+		if (coltype != var->vartype ||
+			!AppendOnlyBlockDirectory_ZoneSupportedType(coltype) ||
+			!ZoneKeyTypesComparable(coltype, con->consttype))
+			continue;
+
+		interpretations = get_op_btree_interpretation(opno);
+		foreach(lc2, interpretations)
+		{
+			OpBtreeInterpretation *interp = (OpBtreeInterpretation *) lfirst(lc2);
+
+			if (interp->strategy >= BTLessStrategyNumber &&
+				interp->strategy <= BTGreaterStrategyNumber &&
+				interp->oplefttype == coltype &&
+				interp->oprighttype == con->consttype)
+			{
+				strategy = interp->strategy;
+				break;
+			}
+		}
+		list_free_deep(interpretations);
+
+		if (strategy == InvalidStrategy)
+			continue;
+
+		keys[nkeys].attno = var->varattno - 1;
+		keys[nkeys].strategy = strategy;
+		keys[nkeys].value = AppendOnlyBlockDirectory_ZoneValue(con->consttype,
+															   con->constvalue);
+		nkeys++;
+	}
+
+	foreach(lc, scanstate->ss_runtimefilters)
+	{
+		RuntimeFilter *filter = (RuntimeFilter *) lfirst(lc);
+		int			i;
+
+		if (!filter->ready)
+			continue;
+
+		for (i = 0; i < filter->nkeys; i++)
+		{
+			RuntimeFilterKey *key = &filter->keys[i];
+
+			if (!key->hasRange || key->minValue > key->maxValue ||
+				!scanstate->ss_aocs_proj[key->attno - 1])
+				continue;
+
+			keys[nkeys].attno = key->attno - 1;
+			keys[nkeys].strategy = BTGreaterEqualStrategyNumber;
+			keys[nkeys].value = key->minValue;
+			nkeys++;
+			keys[nkeys].attno = key->attno - 1;
+			keys[nkeys].strategy = BTLessEqualStrategyNumber;
+			keys[nkeys].value = key->maxValue;
+			nkeys++;
+
+			scanstate->ss_aocs_runtime_zones = true;
+		}
+	}
+
+	if (nkeys > 0)
+		aocs_set_zone_keys(scanstate->ss_currentScanDesc_aocs, keys, nkeys);
+	else
+		pfree(keys);
+}
+
 /* ----------------------------------------------------------------
  *						Parallel Scan Support
  * ----------------------------------------------------------------
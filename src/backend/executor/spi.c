@@ -2308,6 +2308,7 @@ _SPI_execute_plan(SPIPlanPtr plan, ParamListInfo paramLI,
 										snap, crosscheck_snapshot,
 										dest,
 										paramLI, 0);
+				qdesc->plan_cached = plan->saved;
 
 				/* GPDB hook for collecting query info */
 				if (query_info_collect_hook)
@@ -3066,16 +3066,22 @@ gpdb::CountLeafPartTables
 }
 
 /*
- * To detect changes to catalog tables that require resetting the Metadata
+ * To detect changes to catalog tables that require invalidating the Metadata
  * Cache, we use the normal PostgreSQL catalog cache invalidation mechanism.
  * We register a callback to a cache on all the catalog tables that contain
  * information that's contained in the ORCA metadata cache.
-
- * There is no fine-grained mechanism in the metadata cache for invalidating
- * individual entries ATM, so we just blow the whole cache whenever anything
- * changes. The callback simply increments a counter. Whenever we start
- * planning a query, we check the counter to see if it has changed since the
- * last planned query, and reset the whole cache if it has.
+ *
+ * The callbacks remember what changed: the OIDs of the relations whose
+ * relcache entry was invalidated, and the hash values of the syscache
+ * entries.  Whenever we start planning a query, COptTasks takes them, and
+ * drops the cache entries built from what changed (see
+ * MDCacheTakeInvalidations() and the functions after it).  A syscache
+ * invalidation only tells the hash value of the key of the catalog row, so
+ * an object is dropped if the hash value of its key matches; a collision
+ * just drops one more entry.
+ *
+ * When we can't tell which entries are affected, or too many changes piled
+ * up, we blow the whole cache, like a sinval reset does.
  *
  * To make sure we've covered all catalog tables that contain information
  * that's stored in the metadata cache, there are "catalog tables: xxx"
@@ -3084,20 +3090,84 @@ gpdb::CountLeafPartTables
  * anything fetched via the wrapper functions in this file can end up in the
  * metadata cache and hence need to have an invalidation callback registered.
  */
-static bool mdcache_invalidation_counter_registered = false;
-static int64 mdcache_invalidation_counter = 0;
-static int64 last_mdcache_invalidation_counter = 0;
+#define MDCACHE_MAX_INVALIDATIONS	1024
+
+typedef struct MDCacheSyscacheInvalidation
+{
+	int			cacheid;
+	uint32		hashvalue;
+} MDCacheSyscacheInvalidation;
+
+typedef struct MDCacheInvalidations
+{
+	bool		reset;			/* everything must go */
+	bool		partitions;		/* pg_partition or pg_partition_rule changed */
+	int			nrelids;
+	int			nsyscache;
+	Oid			relids[MDCACHE_MAX_INVALIDATIONS];
+	MDCacheSyscacheInvalidation syscache[MDCACHE_MAX_INVALIDATIONS];
+} MDCacheInvalidations;
+
+static bool mdcache_invalidation_callbacks_registered = false;
+
+/* pending, filled by the callbacks */
+static MDCacheInvalidations mdcache_pending_invalidations;
+
+/* taken by MDCacheTakeInvalidations(), for the MDCache*Invalidated() tests */
+static MDCacheInvalidations mdcache_taken_invalidations;
 
 static void
-mdsyscache_invalidation_counter_callback(Datum arg, int cacheid, uint32 hashvalue)
+mdsyscache_invalidation_callback(Datum arg, int cacheid, uint32 hashvalue)
 {
-	mdcache_invalidation_counter++;
+	MDCacheInvalidations *inv = &mdcache_pending_invalidations;
+
+	if (inv->reset)
+		return;
+
+	switch (cacheid)
+	{
+		case PARTOID:
+		case PARTRULEOID:
+			inv->partitions = true;
+			return;
+
+		case AMOPOPID:
+			/* operator families of the operators, rarely changes */
+			inv->reset = true;
+			return;
+
+		default:
+			break;
+	}
+
+	/* a zero hash value means all the entries of the cache */
+	if (hashvalue == 0 || inv->nsyscache == MDCACHE_MAX_INVALIDATIONS)
+	{
+		inv->reset = true;
+		return;
+	}
+
+	inv->syscache[inv->nsyscache].cacheid = cacheid;
+	inv->syscache[inv->nsyscache].hashvalue = hashvalue;
+	inv->nsyscache++;
 }
 
 static void
-mdrelcache_invalidation_counter_callback(Datum arg, Oid relid)
+mdrelcache_invalidation_callback(Datum arg, Oid relid)
 {
-	mdcache_invalidation_counter++;
+	MDCacheInvalidations *inv = &mdcache_pending_invalidations;
+
+	if (inv->reset)
+		return;
+
+	/* InvalidOid means all the relations */
+	if (!OidIsValid(relid) || inv->nrelids == MDCACHE_MAX_INVALIDATIONS)
+	{
+		inv->reset = true;
+		return;
+	}
+
+	inv->relids[inv->nrelids++] = relid;
 }
 
 static void
@@ -3158,16 +3228,18 @@ register_mdcache_invalidation_callbacks(void)
 	for (i = 0; i < lengthof(metadata_caches); i++)
 	{
 		CacheRegisterSyscacheCallback(metadata_caches[i],
-									  &mdsyscache_invalidation_counter_callback,
+									  &mdsyscache_invalidation_callback,
 									  (Datum) 0);
 	}
 
 	/* also register the relcache callback */
-	CacheRegisterRelcacheCallback(&mdrelcache_invalidation_counter_callback,
+	CacheRegisterRelcacheCallback(&mdrelcache_invalidation_callback,
 								  (Datum) 0);
 }
 
-// Has there been any catalog changes since last call?
+// Does the whole metadata cache need to be reset because of catalog changes
+// since last call? If not, the changes to individual objects are left for
+// MDCacheTakeInvalidations().
 bool
 gpdb::MDCacheNeedsReset
 		(
@@ -3176,16 +3248,19 @@ gpdb::MDCacheNeedsReset
 {
 	GP_WRAP_START;
 	{
-		if (!mdcache_invalidation_counter_registered)
+		if (!mdcache_invalidation_callbacks_registered)
 		{
 			register_mdcache_invalidation_callbacks();
-			mdcache_invalidation_counter_registered = true;
+			mdcache_invalidation_callbacks_registered = true;
 		}
-		if (last_mdcache_invalidation_counter == mdcache_invalidation_counter)
+		if (!mdcache_pending_invalidations.reset)
 			return false;
 		else
 		{
-			last_mdcache_invalidation_counter = mdcache_invalidation_counter;
+			mdcache_pending_invalidations.reset = false;
+			mdcache_pending_invalidations.partitions = false;
+			mdcache_pending_invalidations.nrelids = 0;
+			mdcache_pending_invalidations.nsyscache = 0;
 			return true;
 		}
 	}
@@ -3194,6 +3269,208 @@ gpdb::MDCacheNeedsReset
 	return true;
 }
 
+// Take the changes to individual metadata cache objects since last call.
+// Returns false if there are none. The MDCache*Invalidated() functions
+// then tell whether an object is affected.
+bool
+gpdb::MDCacheTakeInvalidations
+		(
+			void
+		)
+{
+	GP_WRAP_START;
+	{
+		MDCacheInvalidations *pending = &mdcache_pending_invalidations;
+		MDCacheInvalidations *taken = &mdcache_taken_invalidations;
+		int			i;
+
+		Assert(!pending->reset);
+
+		if (!pending->partitions && pending->nrelids == 0 &&
+			pending->nsyscache == 0)
+			return false;
+
+		taken->reset = false;
+		taken->partitions = pending->partitions;
+		taken->nrelids = pending->nrelids;
+		taken->nsyscache = pending->nsyscache;
+		memcpy(taken->relids, pending->relids, pending->nrelids * sizeof(Oid));
+		memcpy(taken->syscache, pending->syscache,
+			   pending->nsyscache * sizeof(MDCacheSyscacheInvalidation));
+
+		pending->partitions = false;
+		pending->nrelids = 0;
+		pending->nsyscache = 0;
+
+		/*
+		 * The metadata of a partitioned table is built from its partitions
+		 * too, e.g. its number of rows.
+		 */
+		for (i = 0; i < taken->nrelids && !taken->partitions; i++)
+		{
+			/* catalog tables: pg_partition, pg_partition_rule */
+			if (rel_is_child_partition(taken->relids[i]))
+				taken->partitions = true;
+		}
+
+		return true;
+	}
+	GP_WRAP_END;
+
+	return true;
+}
+
+// Was the relation, or the type, operator, function, aggregate, operator
+// family or constraint with the given OID invalidated? OIDs of objects of
+// different catalogs rarely collide; if they do, we just drop one more entry.
+bool
+gpdb::MDCacheOidInvalidated
+		(
+			Oid oid
+		)
+{
+	static const int oid_caches[] = {
+		TYPEOID, OPEROID, PROCOID, AGGFNOID, CONSTROID, OPFAMILYOID
+	};
+	MDCacheInvalidations *taken = &mdcache_taken_invalidations;
+	int			i;
+
+	for (i = 0; i < taken->nrelids; i++)
+	{
+		if (taken->relids[i] == oid)
+			return true;
+	}
+
+	GP_WRAP_START;
+	{
+		unsigned int j;
+
+		for (j = 0; j < lengthof(oid_caches); j++)
+		{
+			bool		computed = false;
+			uint32		hashvalue = 0;
+
+			for (i = 0; i < taken->nsyscache; i++)
+			{
+				if (taken->syscache[i].cacheid != oid_caches[j])
+					continue;
+
+				if (!computed)
+				{
+					hashvalue = GetSysCacheHashValue1(oid_caches[j],
+													  ObjectIdGetDatum(oid));
+					computed = true;
+				}
+				if (taken->syscache[i].hashvalue == hashvalue)
+					return true;
+			}
+		}
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Were the statistics of the given column invalidated?
+bool
+gpdb::MDCacheColStatsInvalidated
+		(
+			Oid relid,
+			AttrNumber attno
+		)
+{
+	MDCacheInvalidations *taken = &mdcache_taken_invalidations;
+	int			i;
+
+	for (i = 0; i < taken->nrelids; i++)
+	{
+		if (taken->relids[i] == relid)
+			return true;
+	}
+
+	GP_WRAP_START;
+	{
+		for (i = 0; i < taken->nsyscache; i++)
+		{
+			uint32		hashvalue = taken->syscache[i].hashvalue;
+
+			if (taken->syscache[i].cacheid != STATRELATTINH)
+				continue;
+
+			if (hashvalue == GetSysCacheHashValue3(STATRELATTINH,
+												   ObjectIdGetDatum(relid),
+												   Int16GetDatum(attno),
+												   BoolGetDatum(false)) ||
+				hashvalue == GetSysCacheHashValue3(STATRELATTINH,
+												   ObjectIdGetDatum(relid),
+												   Int16GetDatum(attno),
+												   BoolGetDatum(true)))
+				return true;
+		}
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Was the cast between the given types invalidated?
+bool
+gpdb::MDCacheCastInvalidated
+		(
+			Oid src_type,
+			Oid dest_type
+		)
+{
+	MDCacheInvalidations *taken = &mdcache_taken_invalidations;
+	int			i;
+
+	GP_WRAP_START;
+	{
+		for (i = 0; i < taken->nsyscache; i++)
+		{
+			if (taken->syscache[i].cacheid == CASTSOURCETARGET &&
+				taken->syscache[i].hashvalue ==
+				GetSysCacheHashValue2(CASTSOURCETARGET,
+									  ObjectIdGetDatum(src_type),
+									  ObjectIdGetDatum(dest_type)))
+				return true;
+		}
+	}
+	GP_WRAP_END;
+
+	return false;
+}
+
+// Was any operator invalidated? The comparison between two types is looked
+// up by operator name, so any change of pg_operator may affect it.
+bool
+gpdb::MDCacheOperatorsInvalidated
+		(
+			void
+		)
+{
+	MDCacheInvalidations *taken = &mdcache_taken_invalidations;
+	int			i;
+
+	for (i = 0; i < taken->nsyscache; i++)
+	{
+		if (taken->syscache[i].cacheid == OPEROID)
+			return true;
+	}
+
+	return false;
+}
+
+// Did the partitioning of any table change?
+bool
+gpdb::MDCachePartitionsInvalidated
+		(
+			void
+		)
+{
+	return mdcache_taken_invalidations.partitions;
+}
+
 // returns true if a query cancel is requested in GPDB
 bool
 gpdb::IsAbortRequested
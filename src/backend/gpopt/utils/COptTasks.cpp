@@ -66,6 +66,9 @@
 
 #include "naucrates/md/IMDId.h"
 #include "naucrates/md/CMDIdRelStats.h"
+#include "naucrates/md/CMDIdColStats.h"
+#include "naucrates/md/IMDRelation.h"
+#include "naucrates/md/IMDColumn.h"
 
 #include "naucrates/md/CSystemId.h"
 #include "naucrates/md/IMDRelStats.h"
@@ -525,6 +528,257 @@ COptTasks::GetCostModel
 	return cost_model;
 }
 
+//---------------------------------------------------------------------------
+//	@struct:
+//		SMDCacheInvalidationCtx
+//
+//	@doc:
+//		Relations found by the first pass over the metadata cache, used by
+//		the second pass to decide which entries to drop
+//
+//---------------------------------------------------------------------------
+struct SMDCacheInvalidationCtx
+{
+	CMemoryPool *m_mp;
+
+	// all cached relations
+	MdidHashSet *m_cached_rels;
+
+	// relations whose entries depend on partitions that may have changed
+	MdidHashSet *m_partition_rels;
+
+	// relations with changed column statistics
+	MdidHashSet *m_stats_rels;
+
+	// indexes and triggers of all cached relations
+	MdidHashSet *m_rel_objs;
+
+	// indexes and triggers of the relations whose entries are dropped
+	MdidHashSet *m_changed_rel_objs;
+};
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::CollectInvalidatedRel
+//
+//	@doc:
+//		First pass over the metadata cache. Column statistics entries only
+//		know the position of their column, so the attribute numbers are
+//		mapped here, from the cached relation. Index and trigger entries
+//		are not invalidated by their own OIDs, ENABLE TRIGGER or the index
+//		of a partition only invalidate the table, so they are mapped to
+//		their relation here too. Never drops an entry.
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::CollectInvalidatedRel
+	(
+	IMDCacheObject *md_obj,
+	void *ptr
+	)
+{
+	SMDCacheInvalidationCtx *ctx = (SMDCacheInvalidationCtx *) ptr;
+
+	if (IMDCacheObject::EmdtRel != md_obj->MDType() ||
+		IMDId::EmdidGPDB != md_obj->MDId()->MdidType())
+	{
+		return false;
+	}
+
+	const IMDRelation *md_rel = dynamic_cast<const IMDRelation *>(md_obj);
+	OID rel_oid = CMDIdGPDB::CastMdid(md_obj->MDId())->Oid();
+
+	// the cache entry may be dropped by the second pass, so keep a copy
+	CMDIdGPDB *mdid = GPOS_NEW(ctx->m_mp) CMDIdGPDB(*CMDIdGPDB::CastMdid(md_obj->MDId()));
+	BOOL rel_changed = gpdb::MDCacheOidInvalidated(rel_oid);
+
+	if (md_rel->IsPartitioned() && gpdb::MDCachePartitionsInvalidated())
+	{
+		mdid->AddRef();
+		ctx->m_partition_rels->Insert(mdid);
+		rel_changed = true;
+	}
+
+	ULONG index_count = md_rel->IndexCount();
+	ULONG trigger_count = md_rel->TriggerCount();
+
+	// the index of a partitioned table is one of a leaf partition's, so
+	// the same index may come up twice
+	for (ULONG ul = 0; ul < index_count + trigger_count; ul++)
+	{
+		IMDId *obj_mdid = ul < index_count ? md_rel->IndexMDidAt(ul) :
+			md_rel->TriggerMDidAt(ul - index_count);
+		CMDIdGPDB *obj_copy = GPOS_NEW(ctx->m_mp) CMDIdGPDB(*CMDIdGPDB::CastMdid(obj_mdid));
+
+		if (rel_changed && !ctx->m_changed_rel_objs->Contains(obj_copy))
+		{
+			obj_copy->AddRef();
+			ctx->m_changed_rel_objs->Insert(obj_copy);
+		}
+		if (!ctx->m_rel_objs->Insert(obj_copy))
+		{
+			obj_copy->Release();
+		}
+	}
+
+	for (ULONG ul = 0; ul < md_rel->ColumnCount(); ul++)
+	{
+		const IMDColumn *md_col = md_rel->GetMdCol(ul);
+
+		if (!md_col->IsSystemColumn() &&
+			gpdb::MDCacheColStatsInvalidated(rel_oid, (AttrNumber) md_col->AttrNum()))
+		{
+			mdid->AddRef();
+			ctx->m_stats_rels->Insert(mdid);
+			break;
+		}
+	}
+
+	// takes over the reference
+	ctx->m_cached_rels->Insert(mdid);
+
+	return false;
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::IsMDCacheObjectInvalidated
+//
+//	@doc:
+//		Second pass over the metadata cache: is the entry affected by the
+//		catalog changes since the last query?
+//
+//---------------------------------------------------------------------------
+BOOL
+COptTasks::IsMDCacheObjectInvalidated
+	(
+	IMDCacheObject *md_obj,
+	void *ptr
+	)
+{
+	SMDCacheInvalidationCtx *ctx = (SMDCacheInvalidationCtx *) ptr;
+	IMDId *mdid = md_obj->MDId();
+
+	switch (mdid->MdidType())
+	{
+		case IMDId::EmdidGPDB:
+		{
+			if (gpdb::MDCacheOidInvalidated(CMDIdGPDB::CastMdid(mdid)->Oid()) ||
+				ctx->m_partition_rels->Contains(mdid))
+			{
+				return true;
+			}
+
+			// without its relation, we can't tell whether an index or
+			// trigger has changed
+			if (IMDCacheObject::EmdtInd == md_obj->MDType() ||
+				IMDCacheObject::EmdtTrigger == md_obj->MDType())
+			{
+				return ctx->m_changed_rel_objs->Contains(mdid) ||
+					!ctx->m_rel_objs->Contains(mdid);
+			}
+
+			return false;
+		}
+
+		case IMDId::EmdidRelStats:
+		{
+			IMDId *rel_mdid = CMDIdRelStats::CastMdid(mdid)->GetRelMdId();
+
+			// the number of rows of a partitioned table adds up its partitions
+			return gpdb::MDCacheOidInvalidated(CMDIdGPDB::CastMdid(rel_mdid)->Oid()) ||
+				ctx->m_partition_rels->Contains(rel_mdid);
+		}
+
+		case IMDId::EmdidColStats:
+		{
+			IMDId *rel_mdid = CMDIdColStats::CastMdid(mdid)->GetRelMdId();
+
+			// without the relation, we can't tell which attribute the
+			// statistics are for
+			return gpdb::MDCacheOidInvalidated(CMDIdGPDB::CastMdid(rel_mdid)->Oid()) ||
+				ctx->m_partition_rels->Contains(rel_mdid) ||
+				ctx->m_stats_rels->Contains(rel_mdid) ||
+				!ctx->m_cached_rels->Contains(rel_mdid);
+		}
+
+		case IMDId::EmdidCastFunc:
+		{
+			CMDIdCast *cast_mdid = CMDIdCast::CastMdid(mdid);
+			OID src_oid = CMDIdGPDB::CastMdid(cast_mdid->MdidSrc())->Oid();
+			OID dest_oid = CMDIdGPDB::CastMdid(cast_mdid->MdidDest())->Oid();
+
+			return gpdb::MDCacheCastInvalidated(src_oid, dest_oid) ||
+				gpdb::MDCacheOidInvalidated(src_oid) ||
+				gpdb::MDCacheOidInvalidated(dest_oid);
+		}
+
+		case IMDId::EmdidScCmp:
+		{
+			CMDIdScCmp *sc_cmp_mdid = CMDIdScCmp::CastMdid(mdid);
+
+			return gpdb::MDCacheOperatorsInvalidated() ||
+				gpdb::MDCacheOidInvalidated(CMDIdGPDB::CastMdid(sc_cmp_mdid->GetLeftMdid())->Oid()) ||
+				gpdb::MDCacheOidInvalidated(CMDIdGPDB::CastMdid(sc_cmp_mdid->GetRightMdid())->Oid());
+		}
+
+		default:
+			return true;
+	}
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		COptTasks::InvalidateMDCache
+//
+//	@doc:
+//		Drop the metadata cache entries affected by the catalog changes
+//		since the last query, instead of resetting the whole cache
+//
+//---------------------------------------------------------------------------
+void
+COptTasks::InvalidateMDCache
+	(
+	CMemoryPool *mp
+	)
+{
+	SMDCacheInvalidationCtx ctx;
+
+	ctx.m_mp = mp;
+	ctx.m_cached_rels = GPOS_NEW(mp) MdidHashSet(mp);
+	ctx.m_partition_rels = GPOS_NEW(mp) MdidHashSet(mp);
+	ctx.m_stats_rels = GPOS_NEW(mp) MdidHashSet(mp);
+	ctx.m_rel_objs = GPOS_NEW(mp) MdidHashSet(mp);
+	ctx.m_changed_rel_objs = GPOS_NEW(mp) MdidHashSet(mp);
+
+	GPOS_TRY
+	{
+		(void) CMDCache::Invalidate(CollectInvalidatedRel, &ctx);
+		(void) CMDCache::Invalidate(IsMDCacheObjectInvalidated, &ctx);
+	}
+	GPOS_CATCH_EX(ex)
+	{
+		ctx.m_cached_rels->Release();
+		ctx.m_partition_rels->Release();
+		ctx.m_stats_rels->Release();
+		ctx.m_rel_objs->Release();
+		ctx.m_changed_rel_objs->Release();
+
+		GPOS_RETHROW(ex);
+	}
+	GPOS_CATCH_END;
+
+	ctx.m_cached_rels->Release();
+	ctx.m_partition_rels->Release();
+	ctx.m_stats_rels->Release();
+	ctx.m_rel_objs->Release();
+	ctx.m_changed_rel_objs->Release();
+}
+
+
 //---------------------------------------------------------------------------
 //	@function:
 //		COptTasks::OptimizeTask
@@ -562,15 +816,27 @@ COptTasks::OptimizeTask
 	{
 		CMDCache::Init();
 		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+
+		// nothing is cached yet
+		(void) gpdb::MDCacheTakeInvalidations();
 	}
 	else if (reset_mdcache)
 	{
 		CMDCache::Reset();
 		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
 	}
-	else if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+	else
 	{
-		CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		// drop only the entries of the objects that changed
+		if (gpdb::MDCacheTakeInvalidations())
+		{
+			InvalidateMDCache(mp);
+		}
+
+		if (CMDCache::ULLGetCacheQuota() != (ULLONG) optimizer_mdcache_size * 1024L)
+		{
+			CMDCache::SetCacheQuota(optimizer_mdcache_size * 1024L);
+		}
 	}
 
 
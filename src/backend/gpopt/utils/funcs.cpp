@@ -18,6 +18,8 @@
 extern "C" {
 #include "postgres.h"
 #include "fmgr.h"
+#include "funcapi.h"
+#include "access/htup_details.h"
 #include "lib/stringinfo.h"
 #include "utils/builtins.h"
 }
@@ -27,6 +29,7 @@ extern "C" {
 
 #include "gpos/_api.h"
 #include "gpopt/gpdbwrappers.h"
+#include "gpopt/mdcache/CMDCache.h"
 
 #include "xercesc/util/XercesVersion.hpp"
 
@@ -119,3 +122,48 @@ LibraryVersion()
 }
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		MDCacheStats
+//
+//	@doc:
+//		Returns the size and counters of the metadata cache of this backend
+//
+//---------------------------------------------------------------------------
+extern "C" {
+Datum
+MDCacheStats(PG_FUNCTION_ARGS)
+{
+	TupleDesc tupdesc;
+	Datum values[7];
+	bool nulls[7];
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+	{
+		elog(ERROR, "return type must be a row type");
+	}
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	int64 entries = 0;
+	int64 size = 0;
+
+	if (CMDCache::FInitialized())
+	{
+		entries = (int64) CMDCache::Pcache()->Size();
+		size = (int64) CMDCache::Pcache()->TotalAllocatedSize();
+	}
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(entries);
+	values[1] = Int64GetDatum(size);
+	values[2] = Int64GetDatum((int64) CMDCache::ULLGetHits());
+	values[3] = Int64GetDatum((int64) CMDCache::ULLGetMisses());
+	values[4] = Int64GetDatum((int64) CMDCache::ULLGetTotalEvictionCounter());
+	values[5] = Int64GetDatum((int64) CMDCache::ULLGetInvalidations());
+	values[6] = Int64GetDatum((int64) CMDCache::ULLGetResets());
+
+	HeapTuple tuple = heap_form_tuple(tupdesc, values, nulls);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(tuple));
+}
+}
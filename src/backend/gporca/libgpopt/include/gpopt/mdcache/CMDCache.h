@@ -45,6 +45,18 @@ namespace gpopt
 			// the maximum size of the cache
 			static ULLONG m_ullCacheQuota;
 
+			// number of lookups that found the object in the cache, and that
+			// did not
+			static ULLONG m_ullHits;
+			static ULLONG m_ullMisses;
+
+			// number of objects invalidated, and of times the whole cache was reset
+			static ULLONG m_ullInvalidations;
+			static ULLONG m_ullResets;
+
+			// evictions from the caches that were reset
+			static ULLONG m_ullEvictionsBeforeReset;
+
 			// private ctor
 			CMDCache()
 			{};
@@ -58,6 +70,9 @@ namespace gpopt
 
 		public:
 
+			// predicate on cached objects, for Invalidate()
+			typedef BOOL (*InvalidateFuncPtr)(IMDCacheObject *, void *);
+
 			// initialize underlying cache
 			static
 			void Init();
@@ -89,6 +104,54 @@ namespace gpopt
 			static
 			void Reset();
 
+			// drop the objects for which pfn returns true
+			static
+			ULONG Invalidate(InvalidateFuncPtr pfn, void *pv);
+
+			// record a lookup of an object in the cache
+			static
+			void RecordLookup(BOOL fHit)
+			{
+				if (fHit)
+				{
+					m_ullHits++;
+				}
+				else
+				{
+					m_ullMisses++;
+				}
+			}
+
+			// counters
+			static
+			ULLONG ULLGetHits()
+			{
+				return m_ullHits;
+			}
+
+			static
+			ULLONG ULLGetMisses()
+			{
+				return m_ullMisses;
+			}
+
+			static
+			ULLONG ULLGetInvalidations()
+			{
+				return m_ullInvalidations;
+			}
+
+			static
+			ULLONG ULLGetResets()
+			{
+				return m_ullResets;
+			}
+
+			// get the number of times we evicted entries from this cache,
+			// including the caches it replaced on a reset
+			static
+			ULLONG ULLGetTotalEvictionCounter();
+
 			// global accessor
 			static
 			CMDAccessor::MDCache *Pcache()
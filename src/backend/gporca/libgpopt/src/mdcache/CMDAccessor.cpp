@@ -22,6 +22,7 @@
 #include "gpopt/exception.h"
 #include "gpopt/mdcache/CMDAccessor.h"
 #include "gpopt/mdcache/CMDAccessorUtils.h"
+#include "gpopt/mdcache/CMDCache.h"
 
 
 #include "naucrates/exception.h"
@@ -589,6 +590,7 @@ CMDAccessor::GetImdObj
 		a_pmdcacc = GPOS_NEW(m_mp) CacheAccessorMD(m_pcache);
 		a_pmdcacc->Lookup(&mdkey);
 		IMDCacheObject *pmdobjNew = a_pmdcacc->Val();
+		CMDCache::RecordLookup(NULL != pmdobjNew);
 		if (NULL == pmdobjNew)
 		{
 			// object not found in MD cache: retrieve it from MD provider
@@ -24,6 +24,13 @@ CMDAccessor::MDCache *CMDCache::m_pcache = NULL;
 // maximum size of the cache
 ULLONG CMDCache::m_ullCacheQuota = UNLIMITED_CACHE_QUOTA;
 
+// counters
+ULLONG CMDCache::m_ullHits = 0;
+ULLONG CMDCache::m_ullMisses = 0;
+ULLONG CMDCache::m_ullInvalidations = 0;
+ULLONG CMDCache::m_ullResets = 0;
+ULLONG CMDCache::m_ullEvictionsBeforeReset = 0;
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDCache::Init
@@ -112,6 +119,28 @@ CMDCache::ULLGetCacheEvictionCounter()
 	return m_pcache->GetEvictionCounter();
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDCache::ULLGetTotalEvictionCounter
+//
+//	@doc:
+// 		Get the number of times we evicted entries from this cache, and from
+//		the caches it replaced on a reset
+//
+//---------------------------------------------------------------------------
+ULLONG
+CMDCache::ULLGetTotalEvictionCounter()
+{
+	ULLONG ullEvictions = m_ullEvictionsBeforeReset;
+
+	if (NULL != m_pcache)
+	{
+		ullEvictions += m_pcache->GetEvictionCounter();
+	}
+
+	return ullEvictions;
+}
+
 //---------------------------------------------------------------------------
 //	@function:
 //		CMDCache::Reset
@@ -128,8 +157,36 @@ CMDCache::Reset()
 	CAutoTraceFlag atf3(EtraceSimulateIOError, false);
 	CAutoTraceFlag atf4(EtraceSimulateNetError, false);
 
+	m_ullEvictionsBeforeReset += m_pcache->GetEvictionCounter();
+	m_ullResets++;
+
 	Shutdown();
 	Init();
 }
 
+//---------------------------------------------------------------------------
+//	@function:
+//		CMDCache::Invalidate
+//
+//	@doc:
+//		Drop the cached objects for which pfn returns true, e.g. after the
+//		catalog entries they were built from changed. The other objects stay.
+//		Returns the number of objects dropped
+//
+//---------------------------------------------------------------------------
+ULONG
+CMDCache::Invalidate
+	(
+	InvalidateFuncPtr pfn,
+	void *pv
+	)
+{
+	GPOS_ASSERT(NULL != m_pcache && "Metadata cache was not created");
+
+	ULONG ulInvalidated = m_pcache->DeleteMatchingEntries(pfn, pv);
+	m_ullInvalidations += ulInvalidated;
+
+	return ulInvalidated;
+}
+
 // EOF
@@ -80,6 +80,9 @@ namespace gpos
 			typedef ULONG (*HashFuncPtr)(const K&);
 			typedef BOOL (*EqualFuncPtr)(const K&, const K&);
 
+			// type definition of a predicate on cached objects
+			typedef BOOL (*MatchFuncPtr)(T, void *);
+
 		private:
 
 			typedef CCacheEntry<T, K> CCacheHashTableEntry;
@@ -255,6 +258,7 @@ namespace gpos
 						// remove entry from hash table
 						acc.Remove(entry);
 						deleted = true;
+						m_cache_size -= entry->Pmp()->TotalAllocatedSize();
 					}
 				}
 
@@ -513,6 +517,58 @@ namespace gpos
 				return m_eviction_factor;
 			}
 
+			// deletes the objects for which match_func returns true; the
+			// objects still in use are only marked for deletion, and deleted
+			// when their last accessor releases them. Returns the number of
+			// objects deleted or marked
+			ULONG DeleteMatchingEntries(MatchFuncPtr match_func, void *arg)
+			{
+				GPOS_ASSERT(NULL != match_func);
+
+				CCacheHashtableIter iter(m_hash_table);
+				BOOL advanced = false;
+				ULONG num_deleted = 0;
+
+				while (advanced || iter.Advance())
+				{
+					advanced = false;
+					CCacheHashTableEntry *entry = NULL;
+					BOOL deleted = false;
+
+					// scope for CCacheHashtableIterAccessor
+					{
+						CCacheHashtableIterAccessor acc(iter);
+
+						if (NULL != (entry = acc.Value()) &&
+							!entry->IsMarkedForDeletion() &&
+							match_func(entry->Val(), arg))
+						{
+							num_deleted++;
+
+							if (EXPECTED_REF_COUNT_FOR_DELETE == entry->RefCount())
+							{
+								// remove advances iterator automatically
+								acc.Remove(entry);
+								deleted = true;
+								advanced = true;
+								m_cache_size -= entry->Pmp()->TotalAllocatedSize();
+							}
+							else
+							{
+								entry->MarkForDeletion();
+							}
+						}
+					}
+
+					if (deleted)
+					{
+						DestroyCacheEntry(entry);
+					}
+				}
+
+				return num_deleted;
+			}
+
     }; //  CCache
 
 	// invalid key
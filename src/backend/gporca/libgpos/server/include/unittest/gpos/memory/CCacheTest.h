@@ -99,6 +99,9 @@ namespace gpos
 			// tests if cache eviction works for a single cache size
 			static void TestEvictionForOneCacheSize(ULLONG ullCacheQuota);
 
+			// matches the objects with an even key
+			static BOOL FEvenKey(SSimpleObject *pso, void *pv);
+
 
 			// An object with a deep structure
 			class CDeepObject : public CRefCount
@@ -191,6 +194,7 @@ namespace gpos
 			static GPOS_RESULT EresUnittest_DeepObject();
 			static GPOS_RESULT EresUnittest_Iteration();
 			static GPOS_RESULT EresUnittest_IterativeDeletion();
+			static GPOS_RESULT EresUnittest_DeleteMatching();
 
 
 	}; // class CCacheTest
@@ -51,7 +51,8 @@ CCacheTest::EresUnittest()
 		GPOS_UNITTEST_FUNC(CCacheTest::EresUnittest_Eviction),
 		GPOS_UNITTEST_FUNC(CCacheTest::EresUnittest_Iteration),
 		GPOS_UNITTEST_FUNC(CCacheTest::EresUnittest_DeepObject),
-		GPOS_UNITTEST_FUNC(CCacheTest::EresUnittest_IterativeDeletion)
+		GPOS_UNITTEST_FUNC(CCacheTest::EresUnittest_IterativeDeletion),
+		GPOS_UNITTEST_FUNC(CCacheTest::EresUnittest_DeleteMatching)
 		};
 
 	fUnique = true;
@@ -1014,4 +1015,114 @@ CCacheTest::EresUnittest_IterativeDeletion()
 	return GPOS_OK;
 }
 
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CCacheTest::FEvenKey
+//
+//	@doc:
+//		Predicate for EresUnittest_DeleteMatching
+//
+//---------------------------------------------------------------------------
+BOOL
+CCacheTest::FEvenKey
+	(
+	SSimpleObject *pso,
+	void * // pv
+	)
+{
+	return 0 == pso->m_ulKey % 2;
+}
+
+
+//---------------------------------------------------------------------------
+//	@function:
+//		CCacheTest::EresUnittest_DeleteMatching
+//
+//	@doc:
+//		Deleting the objects matching a predicate, some of them in use
+//
+//---------------------------------------------------------------------------
+GPOS_RESULT
+CCacheTest::EresUnittest_DeleteMatching()
+{
+	CAutoP<CCache<SSimpleObject*, ULONG*> > apcache;
+	apcache = CCacheFactory::CreateCache<SSimpleObject*, ULONG*>
+				(
+				fUnique,
+				UNLIMITED_CACHE_QUOTA,
+				SSimpleObject::UlMyHash,
+				SSimpleObject::FMyEqual
+				);
+
+	CCache<SSimpleObject*, ULONG*> *pcache = apcache.Value();
+
+#ifdef GPOS_DEBUG
+	ULLONG ullOneElemSize = 0;
+#endif // GPOS_DEBUG
+	for (ULONG i = 0; i < GPOS_CACHE_ELEMENTS; i++)
+	{
+#ifdef GPOS_DEBUG
+		ullOneElemSize =
+#endif // GPOS_DEBUG
+			InsertOneElement(pcache, i);
+	}
+
+	GPOS_ASSERT(GPOS_CACHE_ELEMENTS == pcache->Size());
+	GPOS_ASSERT(GPOS_CACHE_ELEMENTS * ullOneElemSize == pcache->TotalAllocatedSize());
+
+	// scope for an accessor holding an object to delete
+	{
+		ULONG ulKey = 2;
+		CSimpleObjectCacheAccessor ca(pcache);
+		ca.Lookup(&ulKey);
+		SSimpleObject *pso = ca.Val();
+		GPOS_ASSERT(NULL != pso);
+
+		// release object since there is no customer to release it after lookup and before CCache's cleanup
+		pso->Release();
+
+#ifdef GPOS_DEBUG
+		ULONG ulDeleted =
+#endif // GPOS_DEBUG
+			pcache->DeleteMatchingEntries(FEvenKey, NULL);
+
+		GPOS_ASSERT(GPOS_CACHE_ELEMENTS / 2 == ulDeleted);
+
+		// the object in use stays in the cache until it is released
+		GPOS_ASSERT(GPOS_CACHE_ELEMENTS / 2 + 1 == pcache->Size());
+		GPOS_ASSERT(2 == pso->m_ulKey);
+	}
+
+	GPOS_ASSERT(GPOS_CACHE_ELEMENTS / 2 == pcache->Size());
+	GPOS_ASSERT(GPOS_CACHE_ELEMENTS / 2 * ullOneElemSize == pcache->TotalAllocatedSize());
+
+	for (ULONG i = 0; i < GPOS_CACHE_ELEMENTS; i++)
+	{
+		GPOS_CHECK_ABORT;
+
+		CSimpleObjectCacheAccessor ca(pcache);
+		ca.Lookup(&i);
+		SSimpleObject *pso = ca.Val();
+
+		GPOS_ASSERT_IMP(0 == i % 2, NULL == pso);
+		GPOS_ASSERT_IMP(1 == i % 2, NULL != pso);
+
+		if (NULL != pso)
+		{
+			// release object since there is no customer to release it after lookup and before CCache's cleanup
+			pso->Release();
+		}
+	}
+
+	// nothing else matches
+#ifdef GPOS_DEBUG
+	ULONG ulDeleted =
+#endif // GPOS_DEBUG
+		pcache->DeleteMatchingEntries(FEvenKey, NULL);
+	GPOS_ASSERT(0 == ulDeleted);
+
+	return GPOS_OK;
+}
+
 // EOF
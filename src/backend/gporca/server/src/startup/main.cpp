@@ -16,6 +16,9 @@
 #include "naucrates/init.h"
 
 #include "gpos/common/CMainArgs.h"
+#include "gpos/common/clibwrapper.h"
+#include "gpos/common/CWallClock.h"
+#include "gpos/error/CAutoTrace.h"
 #include "gpos/memory/CAutoMemoryPool.h"
 #include "gpos/test/CFSimulatorTestExt.h"
 #include "gpos/test/CUnittest.h"
@@ -308,6 +311,7 @@ PvExec
 	BOOL fMinidump = false;
 	BOOL fUnittest = false;
 	ULLONG ullPlanId = 0;
+	ULONG ulIterations = 1;
 
 	while (pma->Getopt(&ch))
 	{
@@ -342,6 +346,14 @@ PvExec
 				file_name = optarg;
 				break;
 
+			case 'n':
+				ulIterations = (ULONG) clib::Strtol(optarg, NULL, 10);
+				if (0 == ulIterations)
+				{
+					ulIterations = 1;
+				}
+				break;
+
 			default:
 				// ignore other parameters
 				break;
@@ -386,20 +398,52 @@ PvExec
 
 		ULONG ulSegments = CTestUtils::UlSegments(optimizer_config);
 
-		CDXLNode *pdxlnPlan = CMinidumperUtils::PdxlnExecuteMinidump
-								(
-								mp,
-								file_name,
-								ulSegments,
-								1 /*ulSessionId*/,
-								1 /*ulCmdId*/,
-								optimizer_config,
-								NULL /*pceeval*/
-								);
+		// with -n, optimize the minidump repeatedly and report the time it
+		// took; the metadata is cached after the first iteration
+		ULONG ulMinUS = gpos::ulong_max;
+		ULONG ulMaxUS = 0;
+		ULLONG ullTotalUS = 0;
+
+		for (ULONG ul = 0; ul < ulIterations; ul++)
+		{
+			CWallClock clock;
+
+			CDXLNode *pdxlnPlan = CMinidumperUtils::PdxlnExecuteMinidump
+									(
+									mp,
+									file_name,
+									ulSegments,
+									1 /*ulSessionId*/,
+									1 /*ulCmdId*/,
+									optimizer_config,
+									NULL /*pceeval*/
+									);
+
+			ULONG ulElapsedUS = clock.ElapsedUS();
+			if (ulElapsedUS < ulMinUS)
+			{
+				ulMinUS = ulElapsedUS;
+			}
+			if (ulElapsedUS > ulMaxUS)
+			{
+				ulMaxUS = ulElapsedUS;
+			}
+			ullTotalUS += ulElapsedUS;
+
+			pdxlnPlan->Release();
+		}
+
+		if (1 < ulIterations)
+		{
+			CAutoTrace at(mp);
+			at.Os() << "Optimized " << file_name << " " << ulIterations << " times: "
+					<< "min " << ulMinUS / 1000.0 << " ms, "
+					<< "avg " << ullTotalUS / ulIterations / 1000.0 << " ms, "
+					<< "max " << ulMaxUS / 1000.0 << " ms";
+		}
 
 		GPOS_DELETE(pdxlmd);
 		optimizer_config->Release();
-		pdxlnPlan->Release();
 		CMDCache::Shutdown();
 	}
 	else
@@ -438,7 +482,7 @@ INT main
 	GPOS_ASSERT(iArgs >= 0);
 
 	// setup args for unittest params
-	CMainArgs ma(iArgs, rgszArgs, "uU:d:xT:i:");
+	CMainArgs ma(iArgs, rgszArgs, "uU:d:n:xT:i:");
 	
 	// initialize unittest framework
 	CUnittest::Init(rgut, GPOS_ARRAY_SIZE(rgut), ConfigureTests, Cleanup);
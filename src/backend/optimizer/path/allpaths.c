@@ -725,6 +725,15 @@ set_rel_consider_parallel(PlannerInfo *root, RelOptInfo *rel,
 			if (get_rel_persistence(rte->relid) == RELPERSISTENCE_TEMP)
 				return;
 
+			/*
+			 * GPDB: Append-only scans are not parallel-aware. There is no
+			 * shared cursor over the segment files, so every worker would
+			 * scan the whole table, and a Gather would return each row once
+			 * per worker. Keep them out of parallel plans until there is one.
+			 */
+			if (relstorage_is_ao(rel->relstorage))
+				return;
+
 			/*
 			 * Table sampling can be pushed down to workers if the sample
 			 * function and its arguments are safe.
@@ -21,9 +21,14 @@
 
 #include "postgres.h"
 
+#include "access/hash.h"
+#include "access/htup_details.h"
 #include "cdb/cdbmutate.h"		/* apply_shareinput */
 #include "cdb/cdbplan.h"
+#include "cdb/cdbutil.h"
 #include "cdb/cdbvars.h"
+#include "funcapi.h"
+#include "lib/ilist.h"
 #include "nodes/makefuncs.h"
 #include "optimizer/orca.h"
 #include "optimizer/paths.h"
@@ -32,11 +37,51 @@
 #include "optimizer/transform.h"
 #include "portability/instr_time.h"
 #include "utils/guc.h"
+#include "utils/guc_tables.h"
+#include "utils/inval.h"
 #include "utils/lsyscache.h"
+#include "utils/memutils.h"
+#include "utils/syscache.h"
 
 /* GPORCA entry point */
 extern PlannedStmt * GPOPTOptimizedPlan(Query *parse, bool *had_unexpected_failure);
 
+/*
+ * A plan in the ORCA plan cache.
+ *
+ * The key is the preprocessed Query, with the constants folded from the
+ * bound parameters, followed by the number of segments and the settings
+ * of the optimizer GUCs.  Each entry has its own memory context, so that
+ * dropping it frees everything.
+ */
+typedef struct OrcaCachedPlan
+{
+	dlist_node	node;			/* most recently used first */
+	MemoryContext context;
+	uint32		hash;			/* of key */
+	char	   *key;
+	PlannedStmt *plan;
+	Size		size;			/* memory used by the entry */
+} OrcaCachedPlan;
+
+static dlist_head orca_plan_cache = DLIST_STATIC_INIT(orca_plan_cache);
+static MemoryContext OrcaPlanCacheContext = NULL;
+static Size orca_plan_cache_used = 0;
+
+/* counters reported by gp_opt_plan_cache_stats() */
+static uint64 orca_plan_cache_hits = 0;
+static uint64 orca_plan_cache_misses = 0;
+static uint64 orca_plan_cache_evictions = 0;
+
+static void orca_plan_cache_init(void);
+static char *orca_plan_cache_key(Query *query);
+static PlannedStmt *orca_plan_cache_lookup(const char *key, uint32 hash);
+static void orca_plan_cache_insert(const char *key, uint32 hash, PlannedStmt *plan);
+static void orca_plan_cache_drop(OrcaCachedPlan *entry);
+static void OrcaPlanCacheRelCallback(Datum arg, Oid relid);
+static void OrcaPlanCacheFuncCallback(Datum arg, int cacheid, uint32 hashvalue);
+static void OrcaPlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue);
+
 static Plan *remove_redundant_results(PlannerInfo *root, Plan *plan);
 static Node *remove_redundant_results_mutator(Node *node, void *);
 static bool can_replace_tlist(Plan *plan);
@@ -88,6 +133,8 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	List		   *invalItems;
 	ListCell	   *lc;
 	ListCell	   *lp;
+	char		   *cache_key = NULL;
+	uint32			cache_hash = 0;
 
 	/*
 	 * Initialize a dummy PlannerGlobal struct. ORCA doesn't use it, but the
@@ -130,6 +177,33 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	 */
 	pqueryCopy = preprocess_query_optimizer(root, pqueryCopy, boundParams);
 
+	/*
+	 * Did we already plan the same query? Not if the preprocessing evaluated
+	 * stable functions, their values would change next time.
+	 */
+	if (optimizer_plan_cache_size > 0 && !glob->oneoffPlan)
+	{
+		orca_plan_cache_init();
+
+		cache_key = orca_plan_cache_key(pqueryCopy);
+		cache_hash = DatumGetUInt32(hash_any((const unsigned char *) cache_key,
+											 strlen(cache_key)));
+
+		result = orca_plan_cache_lookup(cache_key, cache_hash);
+		if (result)
+		{
+			if (optimizer_log)
+				elog(DEBUG1, "GPORCA plan taken from the plan cache");
+
+			/* not part of the key */
+			result->queryId = parse->queryId;
+
+			return result;
+		}
+	}
+	else if (optimizer_plan_cache_size == 0)
+		ResetOrcaPlanCache();
+
 	/* Ok, invoke ORCA. */
 	result = GPOPTOptimizedPlan(pqueryCopy, &fUnexpectedFailure);
 
@@ -256,9 +330,275 @@ optimize_query(Query *parse, ParamListInfo boundParams)
 	result->oneoffPlan = glob->oneoffPlan;
 	result->transientPlan = glob->transientPlan;
 
+	if (cache_key && !result->oneoffPlan && !result->transientPlan)
+		orca_plan_cache_insert(cache_key, cache_hash, result);
+
 	return result;
 }
 
+/*
+ * Set up the ORCA plan cache on first use.
+ *
+ * Like the plancache, we hook into inval.c's callback lists, to drop the
+ * plans that depend on a changed relation or function.  Changes to the
+ * catalogs ORCA reads but that the plans don't record a dependency on
+ * drop all the plans.
+ */
+static void
+orca_plan_cache_init(void)
+{
+	if (OrcaPlanCacheContext)
+		return;
+
+	OrcaPlanCacheContext = AllocSetContextCreate(CacheMemoryContext,
+												 "ORCA plan cache",
+												 ALLOCSET_DEFAULT_SIZES);
+
+	CacheRegisterRelcacheCallback(OrcaPlanCacheRelCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(PROCOID, OrcaPlanCacheFuncCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(TYPEOID, OrcaPlanCacheFuncCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(AGGFNOID, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(AMOPOPID, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(CASTSOURCETARGET, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(NAMESPACEOID, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(OPEROID, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(OPFAMILYOID, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(PARTOID, OrcaPlanCacheSysCallback, (Datum) 0);
+	CacheRegisterSyscacheCallback(PARTRULEOID, OrcaPlanCacheSysCallback, (Datum) 0);
+}
+
+/*
+ * Build the key of a preprocessed query in the ORCA plan cache.
+ *
+ * The plan also depends on the cluster size and on the optimizer GUCs.
+ * Rather than to track which of them ORCA looks at, all the "optimizer*"
+ * GUCs are part of the key.
+ */
+static char *
+orca_plan_cache_key(Query *query)
+{
+	struct config_generic **gucs = get_guc_variables();
+	int			nguc = GetNumConfigOptions();
+	StringInfoData buf;
+	char	   *str;
+	int			i;
+
+	initStringInfo(&buf);
+
+	str = nodeToString(query);
+	appendStringInfoString(&buf, str);
+	pfree(str);
+
+	appendStringInfo(&buf, " :numsegments %d", getgpsegmentCount());
+
+	for (i = 0; i < nguc; i++)
+	{
+		const char *name = gucs[i]->name;
+
+		if (strncmp(name, "optimizer", strlen("optimizer")) != 0 &&
+			strcmp(name, "gp_use_legacy_hashops") != 0)
+			continue;
+
+		appendStringInfo(&buf, " :%s %s", name,
+						 GetConfigOption(name, true, false));
+	}
+
+	return buf.data;
+}
+
+/*
+ * Return a copy of the cached plan with the given key, or NULL.
+ */
+static PlannedStmt *
+orca_plan_cache_lookup(const char *key, uint32 hash)
+{
+	dlist_iter	iter;
+
+	dlist_foreach(iter, &orca_plan_cache)
+	{
+		OrcaCachedPlan *entry = dlist_container(OrcaCachedPlan, node, iter.cur);
+
+		if (entry->hash != hash || strcmp(entry->key, key) != 0)
+			continue;
+
+		dlist_move_head(&orca_plan_cache, &entry->node);
+		orca_plan_cache_hits++;
+
+		/* the caller may scribble on the plan */
+		return (PlannedStmt *) copyObject(entry->plan);
+	}
+
+	orca_plan_cache_misses++;
+	return NULL;
+}
+
+/*
+ * Remember a plan, dropping the least recently used ones to stay within
+ * optimizer_plan_cache_size.
+ */
+static void
+orca_plan_cache_insert(const char *key, uint32 hash, PlannedStmt *plan)
+{
+	Size		limit = (Size) optimizer_plan_cache_size * 1024L;
+	OrcaCachedPlan *entry;
+	MemoryContext context;
+	MemoryContext oldcontext;
+
+	context = AllocSetContextCreate(OrcaPlanCacheContext,
+									"ORCA cached plan",
+									ALLOCSET_SMALL_SIZES);
+	oldcontext = MemoryContextSwitchTo(context);
+
+	entry = (OrcaCachedPlan *) palloc(sizeof(OrcaCachedPlan));
+	entry->context = context;
+	entry->hash = hash;
+	entry->key = pstrdup(key);
+	entry->plan = (PlannedStmt *) copyObject(plan);
+
+	MemoryContextSwitchTo(oldcontext);
+
+	entry->size = MemoryContextGetCurrentSpace(context);
+	if (entry->size > limit)
+	{
+		MemoryContextDelete(context);
+		return;
+	}
+
+	while (orca_plan_cache_used + entry->size > limit)
+	{
+		OrcaCachedPlan *victim = dlist_tail_element(OrcaCachedPlan, node,
+													&orca_plan_cache);
+
+		orca_plan_cache_drop(victim);
+		orca_plan_cache_evictions++;
+	}
+
+	dlist_push_head(&orca_plan_cache, &entry->node);
+	orca_plan_cache_used += entry->size;
+}
+
+static void
+orca_plan_cache_drop(OrcaCachedPlan *entry)
+{
+	dlist_delete(&entry->node);
+	orca_plan_cache_used -= entry->size;
+	MemoryContextDelete(entry->context);
+}
+
+/*
+ * Drop all the plans in the ORCA plan cache. Needed when something the
+ * plans depend on changes outside the catalogs, like the xforms enabled.
+ */
+void
+ResetOrcaPlanCache(void)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &orca_plan_cache)
+	{
+		OrcaCachedPlan *entry = dlist_container(OrcaCachedPlan, node, iter.cur);
+
+		orca_plan_cache_drop(entry);
+	}
+}
+
+/*
+ * Returns the size and counters of the ORCA plan cache of this backend.
+ */
+Datum
+OrcaPlanCacheStats(PG_FUNCTION_ARGS)
+{
+	TupleDesc	tupdesc;
+	Datum		values[5];
+	bool		nulls[5];
+	dlist_iter	iter;
+	int64		entries = 0;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	dlist_foreach(iter, &orca_plan_cache)
+		entries++;
+
+	memset(nulls, 0, sizeof(nulls));
+	values[0] = Int64GetDatum(entries);
+	values[1] = Int64GetDatum((int64) orca_plan_cache_used);
+	values[2] = Int64GetDatum((int64) orca_plan_cache_hits);
+	values[3] = Int64GetDatum((int64) orca_plan_cache_misses);
+	values[4] = Int64GetDatum((int64) orca_plan_cache_evictions);
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
+
+/*
+ * OrcaPlanCacheRelCallback
+ *		Relcache inval callback function
+ *
+ * Drop all plans mentioning the given relation, or all plans if relid is
+ * InvalidOid.  Like in the plancache, ANALYZE of a relation comes here too,
+ * through its pg_class update.
+ */
+static void
+OrcaPlanCacheRelCallback(Datum arg, Oid relid)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &orca_plan_cache)
+	{
+		OrcaCachedPlan *entry = dlist_container(OrcaCachedPlan, node, iter.cur);
+
+		if (relid == InvalidOid ||
+			list_member_oid(entry->plan->relationOids, relid))
+			orca_plan_cache_drop(entry);
+	}
+}
+
+/*
+ * OrcaPlanCacheFuncCallback
+ *		Syscache inval callback function for PROCOID and TYPEOID caches
+ *
+ * Drop all plans mentioning the object with the specified hash value, or
+ * all plans mentioning any member of this cache if hashvalue == 0.
+ */
+static void
+OrcaPlanCacheFuncCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	dlist_mutable_iter iter;
+
+	dlist_foreach_modify(iter, &orca_plan_cache)
+	{
+		OrcaCachedPlan *entry = dlist_container(OrcaCachedPlan, node, iter.cur);
+		ListCell   *lc;
+
+		foreach(lc, entry->plan->invalItems)
+		{
+			PlanInvalItem *item = (PlanInvalItem *) lfirst(lc);
+
+			if (item->cacheId != cacheid)
+				continue;
+			if (hashvalue == 0 ||
+				item->hashValue == hashvalue)
+			{
+				orca_plan_cache_drop(entry);
+				break;
+			}
+		}
+	}
+}
+
+/*
+ * OrcaPlanCacheSysCallback
+ *		Syscache inval callback function for other caches
+ *
+ * Just drop all plans.
+ */
+static void
+OrcaPlanCacheSysCallback(Datum arg, int cacheid, uint32 hashvalue)
+{
+	ResetOrcaPlanCache();
+}
+
 /*
  * ORCA tends to generate gratuitous Result nodes for various reasons. We
  * try to clean it up here, as much as we can, by eliminating the Results
@@ -139,7 +139,7 @@ static BufFile *makeBufFile(File firstfile);
 static void BufFileUpdateSize(BufFile *buffile);
 
 static void BufFileStartCompression(BufFile *file);
-static void BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes);
+static void BufFileWriteCompressed(BufFile *file, const void *ptr, Size size);
 static void BufFileEndCompression(BufFile *file);
 static int BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize);
 
@@ -325,6 +325,8 @@ BufFileClose(BufFile *file)
 #ifdef HAVE_LIBZSTD
 	if (file->zstd_context)
 		zstd_free_context(file->zstd_context);
+	if (file->compressed_buffer.src)
+		pfree((void *) file->compressed_buffer.src);
 #endif
 
 	pfree(file);
@@ -568,7 +570,7 @@ BufFileWrite(BufFile *file, const void *ptr, size_t size)
 			break;
 
 		case BFS_COMPRESSED_WRITING:
-			BufFileDumpCompressedBuffer(file, ptr, size);
+			BufFileWriteCompressed(file, ptr, size);
 			return size;
 
 		case BFS_SEQUENTIAL_READING:
@@ -831,7 +833,8 @@ BufFileUpdateSize(BufFile *buffile)
 /*
  * Returns the size of this file according to current accounting.
  *
- * For a compressed BufFile, this returns the uncompressed size!
+ * For a compressed BufFile, this returns the uncompressed size! See
+ * BufFileGetDiskSize() for the space it takes on disk.
  */
 int64
 BufFileGetSize(BufFile *buffile)
@@ -858,6 +861,25 @@ BufFileGetSize(BufFile *buffile)
 	return buffile->maxoffset;
 }
 
+/*
+ * Returns the number of bytes this file takes on disk. That's the same as
+ * BufFileGetSize(), unless the file is compressed.
+ *
+ * For a compressed BufFile that is still being written, the data that
+ * libzstd is still holding on to is not included.
+ */
+int64
+BufFileGetDiskSize(BufFile *buffile)
+{
+	Assert(NULL != buffile);
+
+	if (buffile->state == BFS_COMPRESSED_WRITING ||
+		buffile->state == BFS_COMPRESSED_READING)
+		return buffile->maxoffset;
+
+	return BufFileGetSize(buffile);
+}
+
 const char *
 BufFileGetFilename(BufFile *buffile)
 {
@@ -962,8 +984,20 @@ BufFilePledgeSequential(BufFile *buffile)
 /*
  * Temporary buffer used during compression. It's used only within the
  * functions, so we can allocate this once and reuse it for all files.
+ *
+ * It is sized to hold a whole compressed zstd block, so that each block
+ * that libzstd completes is written out with a single FileWrite() call,
+ * rather than in BLCKSZ pieces.
  */
 static char *compression_buffer;
+static size_t compression_buffer_size;
+
+/*
+ * Size of the reads of compressed data, during decompression. The buffer
+ * is only allocated when the file is first read, so files that are waiting
+ * to be read don't hold one.
+ */
+#define BUFFILE_COMPRESSED_READ_SIZE (8 * BLCKSZ)
 
 /*
  * Initialize the compressor.
@@ -974,19 +1008,19 @@ BufFileStartCompression(BufFile *file)
 	ResourceOwner oldowner;
 
 	/*
-	 * When working with compressed files, we rely on libzstd's buffer,
-	 * and the BufFile's own buffer is unused. It's a bit silly that we
-	 * allocate it in makeBufFile(), just to free it here again, but it
-	 * doesn't seem worth the trouble to avoid that either.
+	 * While writing, the BufFile's own buffer collects the small writes,
+	 * so that libzstd is called once per BLCKSZ of input rather than once
+	 * per tuple. It is freed when the writing is done.
 	 */
-	if (file->buffer)
-	{
-		pfree(file->buffer);
-		file->buffer = NULL;
-	}
+	file->pos = 0;
+	file->nbytes = 0;
 
 	if (compression_buffer == NULL)
-		compression_buffer = MemoryContextAlloc(TopMemoryContext, BLCKSZ);
+	{
+		compression_buffer_size = ZSTD_CStreamOutSize();
+		compression_buffer = MemoryContextAlloc(TopMemoryContext,
+												compression_buffer_size);
+	}
 
 	/*
 	 * Make sure the zstd handle is kept in the same resource owner as
@@ -1013,8 +1047,6 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 {
 	ZSTD_inBuffer input;
 
-	file->uncompressed_bytes += nbytes;
-
 	/*
 	 * Call ZSTD_compressStream() until all the input has been consumed.
 	 */
@@ -1027,7 +1059,7 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 		size_t		ret;
 
 		output.dst = compression_buffer;
-		output.size = BLCKSZ;
+		output.size = compression_buffer_size;
 		output.pos = 0;
 
 		ret = ZSTD_compressStream(file->zstd_context->cctx, &output, &input);
@@ -1046,6 +1078,30 @@ BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
 	}
 }
 
+/*
+ * Write to a compressed file. Small writes are collected in the BufFile's
+ * buffer, and passed to libzstd a block at a time.
+ */
+static void
+BufFileWriteCompressed(BufFile *file, const void *ptr, Size size)
+{
+	file->uncompressed_bytes += size;
+
+	if (file->pos + size > BLCKSZ && file->pos > 0)
+	{
+		BufFileDumpCompressedBuffer(file, file->buffer, file->pos);
+		file->pos = 0;
+	}
+
+	if (size >= BLCKSZ)
+		BufFileDumpCompressedBuffer(file, ptr, size);
+	else
+	{
+		memcpy(file->buffer + file->pos, ptr, size);
+		file->pos += size;
+	}
+}
+
 /*
  * End compression stage. Rewind and prepare the BufFile for decompression.
  */
@@ -1058,9 +1114,19 @@ BufFileEndCompression(BufFile *file)
 
 	Assert(file->state == BFS_COMPRESSED_WRITING);
 
+	/* Compress what's left in the buffer, and free it. */
+	if (file->pos > 0)
+		BufFileDumpCompressedBuffer(file, file->buffer, file->pos);
+	file->pos = 0;
+	if (file->buffer)
+	{
+		pfree(file->buffer);
+		file->buffer = NULL;
+	}
+
 	do {
 		output.dst = compression_buffer;
-		output.size = BLCKSZ;
+		output.size = compression_buffer_size;
 		output.pos = 0;
 
 		ret = ZSTD_endStream(file->zstd_context->cctx, &output);
@@ -1085,7 +1151,7 @@ BufFileEndCompression(BufFile *file)
 		elog(ERROR, "out of memory");
 	ZSTD_initDStream(file->zstd_context->dctx);
 
-	file->compressed_buffer.src = palloc(BLCKSZ);
+	file->compressed_buffer.src = NULL;
 	file->compressed_buffer.size = 0;
 	file->compressed_buffer.pos = 0;
 	file->offset = 0;
@@ -1117,7 +1183,13 @@ BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 		{
 			int			nb;
 
-			nb = FileRead(file->file, (char *) file->compressed_buffer.src, BLCKSZ);
+			if (file->compressed_buffer.src == NULL)
+				file->compressed_buffer.src =
+					MemoryContextAlloc(GetMemoryChunkContext(file),
+									   BUFFILE_COMPRESSED_READ_SIZE);
+
+			nb = FileRead(file->file, (char *) file->compressed_buffer.src,
+						  BUFFILE_COMPRESSED_READ_SIZE);
 			if (nb < 0)
 			{
 				elog(ERROR, "could not read from temporary file: %m");
@@ -1139,6 +1211,8 @@ BufFileLoadCompressedBuffer(BufFile *file, void *buffer, size_t bufsize)
 			/* End of compressed data. */
 			Assert (file->compressed_buffer.pos == file->compressed_buffer.size);
 			file->decompression_finished = true;
+			pfree((void *) file->compressed_buffer.src);
+			file->compressed_buffer.src = NULL;
 			break;
 		}
 
@@ -1170,7 +1244,7 @@ BufFileStartCompression(BufFile *file)
 	elog(ERROR, "zstandard compression not supported by this build");
 }
 static void
-BufFileDumpCompressedBuffer(BufFile *file, const void *buffer, Size nbytes)
+BufFileWriteCompressed(BufFile *file, const void *ptr, Size size)
 {
 	elog(ERROR, "zstandard compression not supported by this build");
 }
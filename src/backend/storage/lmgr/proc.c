@@ -452,6 +452,7 @@ InitProcess(void)
 	MyProc->resSlot = NULL;
 	MyProc->movetoResSlot = NULL;
 	MyProc->movetoGroupId = InvalidOid;
+	MyProc->spareVmemChunks = 0;
 
     /* 
      * mppLocalProcessSerial uniquely identifies this backend process among
@@ -685,6 +686,7 @@ InitAuxiliaryProcess(void)
 	MyProc->lwWaitMode = 0;
 	MyProc->waitLock = NULL;
 	MyProc->waitProcLock = NULL;
+	MyProc->spareVmemChunks = 0;
 #ifdef USE_ASSERT_CHECKING
 	{
 		int			i;
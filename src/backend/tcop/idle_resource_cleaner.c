@@ -16,6 +16,7 @@
 #include <signal.h>
 
 #include "cdb/cdbgang.h"
+#include "cdb/cdbvars.h"
 #include "commands/async.h"
 #include "storage/sinval.h"
 #include "tcop/idle_resource_cleaner.h"
@@ -27,6 +28,9 @@ static volatile sig_atomic_t clientWaitTimeoutInterruptEnabled = 0;
 
 static volatile sig_atomic_t idle_gang_timeout_occurred;
 
+/* the pending GANG_TIMEOUT is the one of the QE pool (gp_qe_pool_size) */
+static volatile sig_atomic_t qe_pool_timeout_pending;
+
 /*
  * We want to check to see if our session goes "idle" (nobody sending us work to
  * do). We decide this is true if after waiting a while, we don't get a message
@@ -42,6 +46,7 @@ StartIdleResourceCleanupTimers()
 	if (IdleSessionGangTimeout <= 0 || !cdbcomponent_qesExist())
 		return;
 
+	qe_pool_timeout_pending = 0;
 	enable_timeout_after(GANG_TIMEOUT, IdleSessionGangTimeout);
 }
 
@@ -93,6 +98,9 @@ DisableClientWaitTimeoutInterrupt(void)
  * anything. This entails extra work, so we don't want to do this if we don't
  * think the session has gone idle.
  *
+ * The QEs kept by gp_qe_pool_size are only freed after
+ * gp_qe_pool_idle_timeout: the timeout fires a second time for them.
+ *
  * PS: Is there anything we can free up on the master (QD) side? I can't
  * think of anything.
  */
@@ -103,7 +111,21 @@ IdleGangTimeoutHandler(void)
 	{
 		idle_gang_timeout_occurred = 0;
 
-		DisconnectAndDestroyUnusedQEs();
+		if (gp_qe_pool_size > 0 && !qe_pool_timeout_pending &&
+			(gp_qe_pool_idle_timeout == 0 ||
+			 gp_qe_pool_idle_timeout > IdleSessionGangTimeout))
+		{
+			DisconnectAndDestroyUnusedQEs(true);
+
+			if (gp_qe_pool_idle_timeout > 0 && cdbcomponent_qesExist())
+			{
+				qe_pool_timeout_pending = 1;
+				enable_timeout_after(GANG_TIMEOUT,
+									 gp_qe_pool_idle_timeout - IdleSessionGangTimeout);
+			}
+		}
+		else
+			DisconnectAndDestroyUnusedQEs(false);
 	}
 	else
 		idle_gang_timeout_occurred = 1;
@@ -4911,6 +4911,7 @@ PostgresMain(int argc, char *argv[],
 		MemoryContextResetAndDeleteChildren(MessageContext);
 		VmemTracker_ResetMaxVmemReserved();
 		VmemTracker_ResetWaiver();
+		VmemTracker_ReleaseSpareVmem();
 
 		initStringInfo(&input_message);
 
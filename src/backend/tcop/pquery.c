@@ -112,6 +112,7 @@ CreateQueryDesc(PlannedStmt *plannedstmt,
 
 	qd->extended_query = false; /* default value */
 	qd->portal_name = NULL;
+	qd->plan_cached = false;
 
 	qd->ddesc = NULL;
 	
@@ -151,6 +152,7 @@ CreateUtilityQueryDesc(Node *utilitystmt,
 
 	qd->extended_query = false; /* default value */
 	qd->portal_name = NULL;
+	qd->plan_cached = false;
 
 	return qd;
 }
@@ -224,6 +226,7 @@ ProcessQuery(Portal portal,
 									dest, params,
 									GP_INSTRUMENT_OPTS);
 	queryDesc->ddesc = portal->ddesc;
+	queryDesc->plan_cached = (portal->cplan != NULL);
 
 	/* GPDB hook for collecting query info */
 	if (query_info_collect_hook)
@@ -647,6 +650,7 @@ PortalStart(Portal portal, ParamListInfo params,
 											params,
 											GP_INSTRUMENT_OPTS);
 				queryDesc->ddesc = ddesc;
+				queryDesc->plan_cached = (portal->cplan != NULL);
 				
 				/* GPDB hook for collecting query info */
 				if (query_info_collect_hook)
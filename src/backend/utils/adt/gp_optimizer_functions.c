@@ -8,12 +8,17 @@
  *
  * gp_opt_version: This function wraps LibraryVersion. 
  *
+ * gp_opt_mdcache_stats: This function wraps MDCacheStats.
+ *
+ * gp_opt_plan_cache_stats: This function wraps OrcaPlanCacheStats.
+ *
  * Copyright(c) 2012 - present, EMC/Greenplum
  */
 
 #include "postgres.h"
 
 #include "funcapi.h"
+#include "optimizer/orca.h"
 #include "utils/builtins.h"
 
 extern Datum EnableXform(PG_FUNCTION_ARGS);
@@ -25,6 +30,8 @@ Datum
 enable_xform(PG_FUNCTION_ARGS)
 {
 #ifdef USE_ORCA
+	/* the cached plans were made with the old set of xforms */
+	ResetOrcaPlanCache();
 	return EnableXform(fcinfo);
 #else
 	return CStringGetTextDatum("Server has been compiled without ORCA");
@@ -40,6 +47,7 @@ Datum
 disable_xform(PG_FUNCTION_ARGS)
 {
 #ifdef USE_ORCA
+	ResetOrcaPlanCache();
 	return DisableXform(fcinfo);
 #else
 	return CStringGetTextDatum("Server has been compiled without ORCA");
@@ -60,3 +68,31 @@ gp_opt_version(PG_FUNCTION_ARGS pg_attribute_unused())
 	return CStringGetTextDatum("Server has been compiled without ORCA");
 #endif
 }
+
+extern Datum MDCacheStats(PG_FUNCTION_ARGS);
+
+/*
+* Returns the size and counters of the optimizer metadata cache.
+*/
+Datum
+gp_opt_mdcache_stats(PG_FUNCTION_ARGS)
+{
+#ifdef USE_ORCA
+	return MDCacheStats(fcinfo);
+#else
+	PG_RETURN_NULL();
+#endif
+}
+
+/*
+* Returns the size and counters of the ORCA plan cache.
+*/
+Datum
+gp_opt_plan_cache_stats(PG_FUNCTION_ARGS)
+{
+#ifdef USE_ORCA
+	return OrcaPlanCacheStats(fcinfo);
+#else
+	PG_RETURN_NULL();
+#endif
+}
@@ -303,7 +303,16 @@ datumstreamwrite_put(
 					 bool null,
 					 void **toFree)
 {
-	return DatumStreamBlockWrite_Put(&acc->blockWrite, d, null, toFree);
+	int			result;
+
+	result = DatumStreamBlockWrite_Put(&acc->blockWrite, d, null, toFree);
+
+	if (result >= 0 && acc->zone_enabled && !null)
+		AppendOnlyBlockDirectory_ZoneAdd(
+			&acc->zone,
+			AppendOnlyBlockDirectory_ZoneValue(acc->typeInfo.typid, d));
+
+	return result;
 }
 
 int
@@ -571,6 +580,10 @@ create_datumstreamwrite(
 	acc->ao_write.verifyWriteCompressionState = verifyBlockCompressionState;
 	acc->title = title;
 
+	acc->zone_enabled = gp_appendonly_zone_maps &&
+		AppendOnlyBlockDirectory_ZoneSupportedType(attr->atttypid);
+	AppendOnlyBlockDirectory_ZoneReset(&acc->zone);
+
 	/*
 	 * Temporarily set the firstRowNum for the block so that we can
 	 * calculate the correct header length.
@@ -993,13 +1006,17 @@ datumstreamwrite_block(DatumStreamWrite *acc,
 	}
 
 	/* Insert an entry to the block directory */
-	AppendOnlyBlockDirectory_InsertEntry(
+	if (acc->zone_enabled)
+		acc->zone.lastRowNum = acc->blockFirstRowNum + itemCount - 1;
+	AppendOnlyBlockDirectory_InsertEntryWithZone(
 		blockDirectory,
 		columnGroupNo,
 		acc->blockFirstRowNum,
 		AppendOnlyStorageWrite_LogicalBlockStartOffset(&acc->ao_write),
 		itemCount,
+		acc->zone_enabled ? &acc->zone : NULL,
 		addColAction);
+	AppendOnlyBlockDirectory_ZoneReset(&acc->zone);
 
 	return writesz;
 }
@@ -1285,10 +1302,45 @@ datumstreamread_block_content(DatumStreamRead * acc)
 }
 
 
-int
-datumstreamread_block(DatumStreamRead * acc,
-					  AppendOnlyBlockDirectory *blockDirectory,
-					  int colGroupNo)
+/*
+ * Compute the zone of the block just read, when building the block directory
+ * of existing data. The block is rewound afterwards.
+ */
+static bool
+datumstreamread_block_zone(DatumStreamRead * acc, MinipageZone *zone)
+{
+	Datum		value;
+	bool		null;
+
+	if (!gp_appendonly_zone_maps ||
+		!AppendOnlyBlockDirectory_ZoneSupportedType(acc->typeInfo.typid) ||
+		acc->getBlockInfo.execBlockKind != AOCSBK_BLOCK)
+		return false;
+
+	AppendOnlyBlockDirectory_ZoneReset(zone);
+	while (DatumStreamBlockRead_Advance(&acc->blockRead))
+	{
+		DatumStreamBlockRead_Get(&acc->blockRead, &value, &null);
+		if (!null)
+			AppendOnlyBlockDirectory_ZoneAdd(
+				zone,
+				AppendOnlyBlockDirectory_ZoneValue(acc->typeInfo.typid, value));
+	}
+	zone->lastRowNum = acc->blockFirstRowNum + acc->blockRowCount - 1;
+
+	datumstreamread_rewind_block(acc);
+
+	return true;
+}
+
+/*
+ * Read the header of the next block, without reading its content.
+ *
+ * The caller follows up with either datumstreamread_block_content() or
+ * datumstreamread_skip_block(). Returns false at the end of the file.
+ */
+bool
+datumstreamread_block_header(DatumStreamRead * acc)
 {
 	bool		readOK = false;
 
@@ -1304,7 +1356,7 @@ datumstreamread_block(DatumStreamRead * acc,
 												&acc->getBlockInfo.isLarge,
 											&acc->getBlockInfo.isCompressed);
 	if (!readOK)
-		return -1;
+		return false;
 
 	if (Debug_appendonly_print_datumstream)
 		elog(LOG,
@@ -1346,21 +1398,63 @@ datumstreamread_block(DatumStreamRead * acc,
 			 acc->blockFileOffset,
 			 acc->blockRowCount);
 
+	return true;
+}
+
+int
+datumstreamread_block(DatumStreamRead * acc,
+					  AppendOnlyBlockDirectory *blockDirectory,
+					  int colGroupNo)
+{
+	if (!datumstreamread_block_header(acc))
+		return -1;
+
 	datumstreamread_block_content(acc);
 
 	if (blockDirectory)
 	{
-		AppendOnlyBlockDirectory_InsertEntry(blockDirectory,
-											 colGroupNo,
-											 acc->blockFirstRowNum,
-											 acc->blockFileOffset,
-											 acc->blockRowCount,
-											 false);
+		MinipageZone zone;
+		bool		haveZone;
+
+		haveZone = datumstreamread_block_zone(acc, &zone);
+		AppendOnlyBlockDirectory_InsertEntryWithZone(blockDirectory,
+													 colGroupNo,
+													 acc->blockFirstRowNum,
+													 acc->blockFileOffset,
+													 acc->blockRowCount,
+													 haveZone ? &zone : NULL,
+													 false);
 	}
 
 	return 0;
 }
 
+/*
+ * Skip over the block whose header datumstreamread_block_header() just read,
+ * without reading or decompressing its content.
+ */
+void
+datumstreamread_skip_block(DatumStreamRead * acc)
+{
+	AppendOnlyStorageRead_SkipCurrentBlock(&acc->ao_read);
+
+	DatumStreamBlockRead_Reset(&acc->blockRead);
+	acc->largeObjectState = DatumStreamLargeObjectState_None;
+}
+
+/*
+ * Advance over the next 'count' items of the current block, without
+ * getting them.
+ */
+void
+datumstreamread_skip(DatumStreamRead * acc, int count)
+{
+	Assert(count <= datumstreamread_remaining(acc));
+
+	while (count-- > 0)
+		datumstreamread_advance(acc);
+}
+
 void
 datumstreamread_rewind_block(DatumStreamRead * datumStream)
 {
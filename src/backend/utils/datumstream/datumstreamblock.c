@@ -406,6 +406,185 @@ DatumStreamBlockRead_Finish(
 	/* Place holder. */
 }
 
+/*
+ * Copy 'count' consecutive fixed-width pass-by-value items starting at 'p'.
+ *
+ * Each width gets its own simple loop so the compiler can turn it into
+ * vector loads and widening moves.
+ */
+static inline void
+DatumStreamBlockRead_CopyFixed(
+							   Datum *values,
+							   uint8 * p,
+							   int32 datumlen,
+							   int32 count)
+{
+	int32		i;
+
+	switch (datumlen)
+	{
+		case 1:
+			for (i = 0; i < count; i++)
+				values[i] = ((uint8 *) p)[i];
+			break;
+		case 2:
+			Assert(IsAligned(p, 2));
+			for (i = 0; i < count; i++)
+				values[i] = ((uint16 *) p)[i];
+			break;
+		case 4:
+			Assert(IsAligned(p, 4));
+			for (i = 0; i < count; i++)
+				values[i] = ((uint32 *) p)[i];
+			break;
+		case 8:
+			/* 8 byte items may only be 4 byte aligned */
+			Assert(sizeof(Datum) == 8);
+			memcpy(values, p, count * sizeof(Datum));
+			break;
+		default:
+			elog(ERROR, "unexpected pass-by-value datum length %d", datumlen);
+	}
+}
+
+/*
+ * DatumStreamBlockRead_GetBatch() for blocks of fixed-width pass-by-value
+ * items without RLE_TYPE or delta compression.
+ */
+static int32
+DatumStreamBlockRead_GetBatchFixed(
+								   DatumStreamBlockRead * dsr,
+								   Datum *values,
+								   bool *nulls,
+								   int32 count)
+{
+	int32		datumlen = dsr->typeInfo.datumlen;
+	uint8	   *p;
+	int32		nitems;
+	int32		i;
+
+	/*
+	 * The block read pre-positions datump to the first item, after that it
+	 * points to the current one.
+	 */
+	p = dsr->datump;
+	if (dsr->physical_datum_index >= 0)
+		p += datumlen;
+
+	if (!dsr->has_null)
+	{
+		DatumStreamBlockRead_CopyFixed(values, p, datumlen, count);
+		memset(nulls, false, count * sizeof(bool));
+		nitems = count;
+	}
+	else
+	{
+		nitems = 0;
+		for (i = 0; i < count; i++)
+		{
+			DatumStreamBitMapRead_Next(&dsr->null_bitmap);
+			if (DatumStreamBitMapRead_CurrentIsOn(&dsr->null_bitmap))
+			{
+				values[i] = (Datum) 0;
+				nulls[i] = true;
+			}
+			else
+			{
+				DatumStreamBlockRead_CopyFixed(&values[i], p + nitems * datumlen,
+											   datumlen, 1);
+				nulls[i] = false;
+				nitems++;
+			}
+		}
+	}
+
+	Assert(nitems == 0 || p + nitems * datumlen <= dsr->datum_afterp);
+
+	/* Leave the reader on the last item, as DatumStreamBlockRead_Advance would */
+	dsr->nth += count;
+	if (nitems > 0)
+	{
+		dsr->physical_datum_index += nitems;
+		dsr->datump = p + (nitems - 1) * datumlen;
+	}
+
+	return count;
+}
+
+/*
+ * Advance over and return up to 'maxCount' items of the current block, with
+ * the same result as calling DatumStreamBlockRead_Advance() and
+ * DatumStreamBlockRead_Get() for each of them.  Returns the number of items
+ * returned, 0 when the block is exhausted.  The reader is left positioned
+ * on the last item returned.
+ *
+ * Fixed-width pass-by-value items in a block without RLE_TYPE or delta
+ * compression are copied out in one go.  The copies of an RLE_TYPE repeated
+ * item are filled in without stepping through the bit-maps.  Everything
+ * else (variable-length items, delta compressed items) is decoded one item
+ * at a time, though still without the per-call overhead of the callers.
+ */
+int32
+DatumStreamBlockRead_GetBatch(
+							  DatumStreamBlockRead * dsr,
+							  Datum *values,
+							  bool *nulls,
+							  int32 maxCount)
+{
+	int32		count;
+	int32		n;
+
+	count = Min(maxCount, dsr->logical_row_count - 1 - dsr->nth);
+	if (count <= 0)
+		return 0;
+
+	if (dsr->typeInfo.byval &&
+		!dsr->rle_block_was_compressed &&
+		!dsr->delta_block_was_compressed)
+		return DatumStreamBlockRead_GetBatchFixed(dsr, values, nulls, count);
+
+	n = 0;
+	while (n < count)
+	{
+		if (dsr->rle_in_repeated_item)
+		{
+			int32		run;
+			Datum		value = (Datum) 0;
+			bool		isnull;
+			int32		i;
+
+			run = Min(dsr->rle_repeated_item_count, count - n);
+			Assert(run > 0);
+
+			/* The reader is on the first copy of the repeated item */
+			DatumStreamBlockRead_Get(dsr, &value, &isnull);
+			Assert(!isnull);
+
+			for (i = 0; i < run; i++)
+			{
+				values[n + i] = value;
+				nulls[n + i] = false;
+			}
+
+			dsr->nth += run;
+			dsr->rle_repeated_item_count -= run;
+			dsr->rle_total_repeat_items_read += run;
+			if (dsr->rle_repeated_item_count <= 0)
+				dsr->rle_in_repeated_item = false;
+
+			n += run;
+			continue;
+		}
+
+		if (DatumStreamBlockRead_Advance(dsr) == 0)
+			break;
+		DatumStreamBlockRead_Get(dsr, &values[n], &nulls[n]);
+		n++;
+	}
+
+	return n;
+}
+
 /*
  * Dense routines.
  */
@@ -31,6 +31,7 @@
 #include "cdb/cdbvars.h"
 #include "cdb/memquota.h"
 #include "commands/vacuum.h"
+#include "executor/execRuntimeFilter.h"
 #include "miscadmin.h"
 #include "optimizer/cost.h"
 #include "optimizer/planmain.h"
@@ -139,7 +140,9 @@ int			gp_max_local_distributed_cache = 1024;
 bool		gp_appendonly_verify_block_checksums = true;
 bool		gp_appendonly_verify_write_block = false;
 bool		gp_appendonly_compaction = true;
+bool		gp_appendonly_compaction_copy_blocks = true;
 int			gp_appendonly_compaction_threshold = 0;
+int			gp_appendonly_prefetch_size = 1024;
 bool		gp_heap_require_relhasoids_match = true;
 bool		gp_local_distributed_cache_stats = false;
 bool		debug_xlog_record_read = false;
@@ -283,6 +286,7 @@ int			optimizer_minidump;
 int			optimizer_cost_model;
 bool		optimizer_metadata_caching;
 int			optimizer_mdcache_size;
+int			optimizer_plan_cache_size;
 bool		optimizer_use_gpdb_allocators;
 
 /* Optimizer debugging GUCs */
@@ -508,6 +512,7 @@ static const struct config_enum_entry gp_autostats_modes[] = {
 static const struct config_enum_entry gp_interconnect_fc_methods[] = {
 	{"loss", INTERCONNECT_FC_METHOD_LOSS},
 	{"capacity", INTERCONNECT_FC_METHOD_CAPACITY},
+	{"bbr", INTERCONNECT_FC_METHOD_BBR},
 	{NULL, 0}
 };
 
@@ -607,6 +612,16 @@ struct config_bool ConfigureNamesBool_gp[] =
 		true,
 		NULL, NULL, NULL
 	},
+	{
+		{"gp_enable_runtime_filter", PGC_USERSET, QUERY_TUNING_METHOD,
+			gettext_noop("Enables hash joins to filter the rows of the scan on their outer side."),
+			gettext_noop("The rows whose join keys are not in a bloom filter or in the range "
+						 "of the inner keys are rejected by the scan.")
+		},
+		&gp_enable_runtime_filter,
+		false,
+		NULL, NULL, NULL
+	},
 	{
 		{"gp_enable_hashjoin_size_heuristic", PGC_USERSET, QUERY_TUNING_METHOD,
 			gettext_noop("In hash join plans, the smaller of the two inputs "
@@ -921,6 +936,28 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_compaction_copy_blocks", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Copy blocks without hidden rows verbatim when compacting append-only row-oriented tables."),
+			gettext_noop("Copied blocks are not decompressed and recompressed. Their rows are still decoded if the table has indexes."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_compaction_copy_blocks,
+		true,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_appendonly_zone_maps", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Keep min/max zone maps in the block directory, and use them to skip blocks in append-only column-oriented table scans."),
+			gettext_noop("Block directory minipages that carry zone maps can't be read by servers without zone map support."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_appendonly_zone_maps,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_heap_require_relhasoids_match", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Issue an error on discovery of a mismatch between relhasoids and a tuple header."),
@@ -1038,6 +1075,51 @@ struct config_bool ConfigureNamesBool_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_motion_batch_compression", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Compress columnar Motion batches with zstd."),
+			gettext_noop("Has no effect unless gp_motion_batch_size is set, "
+						 "or if the server was built without zstd."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_motion_batch_compression,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_batch_syscalls", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Send and receive UDP interconnect packets in batches using sendmmsg()/recvmmsg()."),
+			gettext_noop("Has no effect on platforms without sendmmsg()/recvmmsg(), or with the TCP interconnect."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_interconnect_batch_syscalls,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_compression", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Compress the data sent through the UDP interconnect with zstd."),
+			gettext_noop("Has no effect with the TCP interconnect, or if the server was built without zstd."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_interconnect_compression,
+		false,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_interconnect_local_shm", PGC_USERSET, QUERY_TUNING_OTHER,
+			gettext_noop("Pass UDP interconnect data between segments on the same host through shared memory."),
+			gettext_noop("Has no effect with the TCP interconnect, or on platforms without POSIX shared memory."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_interconnect_local_shm,
+		false,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_log_stats", PGC_USERSET, QUERY_TUNING_OTHER,
 			gettext_noop("Emit statistics from the UDP-IC at the end of every statement."),
@@ -3026,6 +3108,20 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_vmem_lease_chunks", PGC_SUSET, RESOURCES_MEM,
+			gettext_noop("Sets the number of vmem chunks a process reserves ahead of need."),
+			gettext_noop("Spare chunks let a process cross chunk boundaries without updating "
+						 "the segment vmem counter. They are not counted as used by the session "
+						 "or by the red zone check, are only reserved below the red zone, and are "
+						 "given back in it. 0 reserves exactly what is needed."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_vmem_lease_chunks,
+		4, 0, 1024,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_max_plan_size", PGC_SUSET, RESOURCES_MEM,
 			gettext_noop("Sets the maximum size of a plan to be dispatched."),
@@ -3037,6 +3133,19 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_serialized_plan_cache_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the size of the cache of compressed plans dispatched by this session."),
+			gettext_noop("Only the plans of prepared statements and other saved plans are cached, "
+						 "so that dispatching them again unchanged doesn't compress them again. "
+						 "Zero disables the cache."),
+			GUC_UNIT_KB
+		},
+		&gp_serialized_plan_cache_size,
+		1024, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_max_partition_level", PGC_SUSET, PRESET_OPTIONS,
 			gettext_noop("Sets the maximum number of levels allowed when creating a partitioned table."),
@@ -3059,6 +3168,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_appendonly_prefetch_size", PGC_USERSET, APPENDONLY_TABLES,
+			gettext_noop("Sets how far ahead of the current read append-only scans ask the kernel to prefetch."),
+			gettext_noop("Zero disables the read-ahead."),
+			GUC_UNIT_KB
+		},
+		&gp_appendonly_prefetch_size,
+		1024, 0, 1048576,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_workfile_max_entries", PGC_POSTMASTER, RESOURCES,
 			gettext_noop("Sets the maximum number of entries that can be stored in the workfile directory"),
@@ -3234,6 +3354,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_interconnect_rx_spin_count", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets how many times the UDP interconnect receiver polls for data before sleeping."),
+			gettext_noop("0 makes the receiver sleep as soon as its queues are empty."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_interconnect_rx_spin_count,
+		1000, 0, 1000000,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_interconnect_timer_period", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the timer period (in ms) for UDP interconnect"),
@@ -3408,6 +3539,29 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"gp_qe_pool_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Sets the number of reader segment workers per segment a session keeps started."),
+			gettext_noop("They are started along with the workers a query needs, and are not "
+						 "released before gp_qe_pool_idle_timeout. At most "
+						 "gp_cached_segworkers_threshold - 1 are kept."),
+		},
+		&gp_qe_pool_size,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
+	{
+		{"gp_qe_pool_idle_timeout", PGC_USERSET, CLIENT_CONN_OTHER,
+			gettext_noop("Sets the time a session can be idle (in milliseconds) before we release the segment workers kept by gp_qe_pool_size."),
+			gettext_noop("A value of 0 keeps them as long as the session lasts."),
+			GUC_UNIT_MS
+		},
+		&gp_qe_pool_idle_timeout,
+		0, 0, INT_MAX,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_cached_segworkers_threshold", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the maximum number of segment workers to cache between statements."),
@@ -3628,6 +3782,18 @@ struct config_int ConfigureNamesInt_gp[] =
 		check_gp_hashagg_default_nbatches, NULL, NULL
 	},
 
+	{
+		{"gp_motion_batch_size", PGC_USERSET, GP_ARRAY_TUNING,
+			gettext_noop("Number of rows to send in one columnar batch from a Motion node."),
+			gettext_noop("Only used for Motions whose columns are all fixed-width pass-by-value types. "
+						 "Zero sends one tuple at a time."),
+			GUC_NOT_IN_SAMPLE
+		},
+		&gp_motion_batch_size,
+		0, 0, MAX_MOTION_BATCH_SIZE,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"gp_motion_slice_noop", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Make motion nodes in certain slices noop"),
@@ -3936,6 +4102,17 @@ struct config_int ConfigureNamesInt_gp[] =
 		NULL, NULL, NULL
 	},
 
+	{
+		{"optimizer_plan_cache_size", PGC_USERSET, RESOURCES_MEM,
+			gettext_noop("Sets the size of the cache of the plans produced by GPORCA."),
+			gettext_noop("Zero disables the cache."),
+			GUC_UNIT_KB
+		},
+		&optimizer_plan_cache_size,
+		0, 0, MAX_KILOBYTES,
+		NULL, NULL, NULL
+	},
+
 	{
 		{"memory_profiler_dataset_size", PGC_USERSET, DEVELOPER_OPTIONS,
 			gettext_noop("Set the size in GB"),
@@ -4493,7 +4670,7 @@ struct config_enum ConfigureNamesEnum_gp[] =
 	{
 		{"gp_interconnect_fc_method", PGC_USERSET, GP_ARRAY_TUNING,
 			gettext_noop("Sets the flow control method used for UDP interconnect."),
-			gettext_noop("Valid values are \"capacity\" and \"loss\".")
+			gettext_noop("Valid values are \"capacity\", \"loss\" and \"bbr\".")
 		},
 		&Gp_interconnect_fc_method,
 		INTERCONNECT_FC_METHOD_LOSS, gp_interconnect_fc_methods,
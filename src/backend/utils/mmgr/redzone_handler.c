@@ -136,8 +136,16 @@ RedZoneHandler_IsVmemRedZone()
 	{
 		if (IsResGroupEnabled())
 			return IsGroupInRedZone();
-		else
-			return *segmentVmemChunks > redZoneChunks;
+
+		/*
+		 * The segment counter includes the spare chunks leased with
+		 * gp_vmem_lease_chunks, which are not in use. Leave them out, but
+		 * only add them up once the counter is past the red zone.
+		 */
+		if (*segmentVmemChunks <= redZoneChunks)
+			return false;
+
+		return *segmentVmemChunks - VmemTracker_GetSpareVmemChunks() > redZoneChunks;
 	}
 
 	return false;
@@ -186,6 +186,9 @@ RunawayCleaner_StartCleanup()
 		{
 			SIMPLE_FAULT_INJECTOR("runaway_cleanup");
 
+			/* Give back our spare chunks along with the query's memory */
+			VmemTracker_ReleaseSpareVmem();
+
 			if (IsResGroupEnabled())
 			{
 				StringInfoData    str;
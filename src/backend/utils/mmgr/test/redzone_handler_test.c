@@ -207,8 +207,13 @@ test__RedZoneHandler_IsVmemRedZone__ProperlyIdentifiesRedZone(void **state)
 	*segmentVmemChunks = 100;
 	redZoneChunks = 80;
 	/* segmentVmemChunks exceeds redZoneChunks. So, should be red zone */
+	will_return(VmemTracker_GetSpareVmemChunks, 0);
 	assert_true(RedZoneHandler_IsVmemRedZone());
 
+	/* Not a red zone once the spare chunks are left out */
+	will_return(VmemTracker_GetSpareVmemChunks, 20);
+	assert_false(RedZoneHandler_IsVmemRedZone());
+
 	vmemTrackerInited = false;
 	/*
 	 * segmentVmemChunks exceeds redZoneChunks. But vmem tracker is not
@@ -86,6 +86,8 @@ void VmemTrackerTestSetup(void **state)
 	gp_vmem_protect_limit = 8192;
 	/* Disable runaway detector */
 	runaway_detector_activation_percent = 100;
+	/* Reserve exactly what is needed, unless a test enables leasing */
+	gp_vmem_lease_chunks = 0;
 
 	will_return(ShmemInitStruct, &fakeSegmentVmemChunks);
 	will_assign_value(ShmemInitStruct, foundPtr, false);
@@ -669,6 +671,144 @@ void test__VmemTracker_RequestWaiver__WaiveEnforcement(void **state)
 	assert_true(waivedChunks == 0);
 }
 
+/*
+ * Checks the spare chunks leased with gp_vmem_lease_chunks.
+ *
+ * This will test the following:
+ *
+ * 1. A chunk boundary crossing leases the needed chunks plus a lease
+ * 2. Spare chunks are counted in the segment, but not in the session
+ * 3. Freed chunks are kept as spare, and later crossings use them without
+ *    touching the segment counter
+ * 4. Spare chunks beyond twice the lease are given back
+ * 5. Near the vmem limit, we fall back to reserving exactly what is needed
+ */
+static
+void test__VmemTracker_ReserveVmem__LeaseSpareChunks(void **state)
+{
+	gp_mp_inited = true;
+	gp_vmem_lease_chunks = 4;
+
+	/* Red zone is disabled: spare chunks may be leased up to the vmem limit */
+	will_return_count(RedZoneHandler_GetRedZoneLimitChunks, INT32_MAX, -1);
+
+	int64 updates = sharedVmemUpdates;
+
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	MemoryAllocationStatus status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(1));
+	assert_true(status == MemoryAllocation_Success);
+	assert_true(trackedVmemChunks == 1);
+	assert_true(spareVmemChunks == 4);
+	assert_true(fakeSegmentVmemChunks == 5);
+	assert_true(MySessionState->sessionVmem == 1);
+	assert_true(sharedVmemUpdates == updates + 1);
+
+	/* The freed chunk is kept as spare */
+	VmemTracker_ReleaseVmem(CHUNKS_TO_BYTES(1));
+	assert_true(trackedVmemChunks == 0);
+	assert_true(spareVmemChunks == 5);
+	assert_true(fakeSegmentVmemChunks == 5);
+	assert_true(MySessionState->sessionVmem == 0);
+
+	/* This is served from the spare chunks */
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(3));
+	assert_true(status == MemoryAllocation_Success);
+	assert_true(trackedVmemChunks == 3);
+	assert_true(spareVmemChunks == 2);
+	assert_true(fakeSegmentVmemChunks == 5);
+	assert_true(MySessionState->sessionVmem == 3);
+	assert_true(sharedVmemUpdates == updates + 1);
+
+	/* Not enough spare chunks: lease the 8 missing ones plus a lease */
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(10));
+	assert_true(status == MemoryAllocation_Success);
+	assert_true(trackedVmemChunks == 13);
+	assert_true(spareVmemChunks == 4);
+	assert_true(fakeSegmentVmemChunks == 17);
+	assert_true(MySessionState->sessionVmem == 13);
+	assert_true(sharedVmemUpdates == updates + 2);
+
+	/* 17 spare chunks is more than twice the lease: keep one lease */
+	VmemTracker_ReleaseVmem(CHUNKS_TO_BYTES(13));
+	assert_true(trackedVmemChunks == 0);
+	assert_true(spareVmemChunks == 4);
+	assert_true(fakeSegmentVmemChunks == 4);
+	assert_true(MySessionState->sessionVmem == 0);
+
+	/* Going idle gives back all spare chunks */
+	VmemTracker_ReleaseSpareVmem();
+	assert_true(spareVmemChunks == 0);
+	assert_true(fakeSegmentVmemChunks == 0);
+	assert_true(MySessionState->sessionVmem == 0);
+
+#ifdef USE_ASSERT_CHECKING
+	will_return(MemoryProtection_IsOwnerThread, true);
+#endif
+
+	/* A lease would exceed the vmem limit: reserve exactly what is needed */
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(vmemChunksQuota - 2));
+	assert_true(status == MemoryAllocation_Success);
+	assert_true(trackedVmemChunks == vmemChunksQuota - 2);
+	assert_true(spareVmemChunks == 0);
+	assert_true(fakeSegmentVmemChunks == vmemChunksQuota - 2);
+	assert_true(MySessionState->sessionVmem == vmemChunksQuota - 2);
+
+	/* And don't keep spare chunks that close to the limit */
+	VmemTracker_ReleaseVmem(CHUNKS_TO_BYTES(1));
+	assert_true(trackedVmemChunks == vmemChunksQuota - 3);
+	assert_true(spareVmemChunks == 0);
+	assert_true(fakeSegmentVmemChunks == vmemChunksQuota - 3);
+}
+
+/* Checks that the spare chunks were given back before the runaway check */
+static void
+CheckNoSpareVmemChunks(void *arg)
+{
+	assert_true(spareVmemChunks == 0);
+	assert_true(fakeSegmentVmemChunks == trackedVmemChunks);
+	assert_true(MySessionState->sessionVmem == trackedVmemChunks);
+}
+
+/*
+ * Checks that spare chunks are given back once the segment is in the red
+ * zone, before the runaway detector runs, and that no new ones are leased
+ * there.
+ */
+static
+void test__VmemTracker_ReserveVmem__ReturnSpareInRedZone(void **state)
+{
+	gp_mp_inited = true;
+	gp_vmem_lease_chunks = 4;
+
+	/* Lease the spare chunks below the red zone */
+	will_return_count(RedZoneHandler_GetRedZoneLimitChunks, INT32_MAX, 3);
+
+	will_be_called(RedZoneHandler_DetectRunawaySession);
+	MemoryAllocationStatus status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(1));
+	assert_true(status == MemoryAllocation_Success);
+	VmemTracker_ReleaseVmem(CHUNKS_TO_BYTES(1));
+	assert_true(trackedVmemChunks == 0);
+	assert_true(spareVmemChunks == 5);
+	assert_true(fakeSegmentVmemChunks == 5);
+
+	/* Now the segment is in the red zone */
+	will_return_count(RedZoneHandler_GetRedZoneLimitChunks, 3, -1);
+	will_be_called_with_sideeffect(RedZoneHandler_DetectRunawaySession, &CheckNoSpareVmemChunks, NULL);
+#ifdef USE_ASSERT_CHECKING
+	will_return(MemoryProtection_IsOwnerThread, true);
+#endif
+
+	status = VmemTracker_ReserveVmem(CHUNKS_TO_BYTES(3));
+	assert_true(status == MemoryAllocation_Success);
+	assert_true(trackedVmemChunks == 3);
+	assert_true(spareVmemChunks == 0);
+	assert_true(fakeSegmentVmemChunks == 3);
+	assert_true(MySessionState->sessionVmem == 3);
+}
+
 int
 main(int argc, char* argv[])
 {
@@ -687,6 +827,8 @@ main(int argc, char* argv[])
 		unit_test_setup_teardown(test__VmemTracker_Init__InitializesOthers, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_Shutdown__ReleasesAllVmem, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 		unit_test_setup_teardown(test__VmemTracker_RequestWaiver__WaiveEnforcement, VmemTrackerTestSetup, VmemTrackerTestTeardown),
+		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__LeaseSpareChunks, VmemTrackerTestSetup, VmemTrackerTestTeardown),
+		unit_test_setup_teardown(test__VmemTracker_ReserveVmem__ReturnSpareInRedZone, VmemTrackerTestSetup, VmemTrackerTestTeardown),
 	};
 
 	return run_tests(tests);
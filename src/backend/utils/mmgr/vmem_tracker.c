@@ -21,6 +21,7 @@
 #include "cdb/cdbvars.h"
 #include "miscadmin.h"
 #include "port/atomics.h"
+#include "storage/proc.h"
 #include "utils/guc.h"
 #include "utils/vmem_tracker.h"
 #include "utils/resource_manager.h"
@@ -75,12 +76,32 @@ static int32 maxChunksPerQuery = 0;
  */
 static int32 waivedChunks = 0;
 
+/*
+ * Number of vmem chunks this process has reserved ahead of need. They are
+ * counted in the resource group and segment counters, but not in the
+ * session's, so crossing a chunk boundary can take one of them without
+ * touching the segment-wide counter. The count is published in
+ * MyProc->spareVmemChunks, so that the red zone check can leave the spare
+ * chunks of all processes out. See VmemTracker_LeaseVmemChunks().
+ */
+static int32 spareVmemChunks = 0;
+
+/*
+ * Number of times this process updated the segment vmem counter, for
+ * measuring the effect of gp_vmem_lease_chunks.
+ */
+static int64 sharedVmemUpdates = 0;
+
+/* How many spare chunks to lease at a time; 0 reserves exactly what is needed */
+int			gp_vmem_lease_chunks = 4;
+
 /*
  * Consumed vmem on the segment.
  */
 volatile int32 *segmentVmemChunks = NULL;
 
 static void ReleaseAllVmemChunks(void);
+static void VmemTracker_SetSpareVmemChunks(int32 numChunks);
 static int32 VmemTracker_GetMaxChunksPerQuery(void);
 
 /*
@@ -148,6 +169,7 @@ VmemTracker_Init()
 	Assert(trackedVmemChunks == 0);
 	Assert(maxVmemChunksTracked == 0);
 	Assert(trackedBytes == 0);
+	Assert(spareVmemChunks == 0);
 
 	/*
 	 * Even though asserts have passed, make sure that in production system
@@ -156,6 +178,7 @@ VmemTracker_Init()
 	trackedVmemChunks = 0;
 	maxVmemChunksTracked = 0;
 	trackedBytes = 0;
+	VmemTracker_SetSpareVmemChunks(0);
 
 	Assert(0 < vmemChunksQuota || Gp_role != GP_ROLE_EXECUTE);
 	Assert(gp_vmem_limit_per_query == 0 || (maxChunksPerQuery != 0 && maxChunksPerQuery < gp_vmem_limit_per_query));
@@ -204,6 +227,7 @@ VmemTracker_ReserveVmemChunks(int32 numChunksToReserve)
 	Assert(NULL != MySessionState);
 
 	Assert(0 <= numChunksToReserve);
+	sharedVmemUpdates++;
 	int32 total = pg_atomic_add_fetch_u32((pg_atomic_uint32 *)&MySessionState->sessionVmem, numChunksToReserve);
 	Assert(total > (int32) 0);
 
@@ -293,6 +317,7 @@ VmemTracker_ReleaseVmemChunks(int reduction)
 	/* We don't support vmem usage from non-owner thread */
 	Assert(MemoryProtection_IsOwnerThread());
 
+	sharedVmemUpdates++;
 	pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) segmentVmemChunks, reduction);
 
 	Assert(*segmentVmemChunks >= 0);
@@ -303,17 +328,216 @@ VmemTracker_ReleaseVmemChunks(int reduction)
 	trackedVmemChunks -= reduction;
 }
 
+/*
+ * Returns the highest segment vmem usage, in chunks, up to which spare chunks
+ * may be leased. Leasing stops short of the red zone, so that spare chunks
+ * never push the segment into it, and short of the vmem limit.
+ */
+static int32
+VmemTracker_GetLeaseCeilingChunks(void)
+{
+	return Min(VmemTracker_GetVmemLimitChunks(),
+			   RedZoneHandler_GetRedZoneLimitChunks());
+}
+
+/*
+ * Can this process hold numChunks more spare chunks?
+ *
+ * This is only a hint read without locks; VmemTracker_LeaseVmemChunks()
+ * checks the limits again on the counters it updates.
+ */
+static bool
+VmemTracker_CanLeaseVmemChunks(int32 numChunks)
+{
+	/* Leasing is disabled, or we are out of memory and using a waiver */
+	if (gp_vmem_lease_chunks <= 0 || waivedChunks > 0)
+		return false;
+
+	if (*segmentVmemChunks + numChunks > VmemTracker_GetLeaseCeilingChunks())
+		return false;
+
+	/* Don't eat into the memory shared by the resource group */
+	return ResGroupCanLeaseMemory(numChunks);
+}
+
+/*
+ * Sets the number of spare chunks of this process, and publishes it for
+ * VmemTracker_GetSpareVmemChunks().
+ */
+static void
+VmemTracker_SetSpareVmemChunks(int32 numChunks)
+{
+	spareVmemChunks = numChunks;
+
+	if (MyProc != NULL)
+		MyProc->spareVmemChunks = numChunks;
+}
+
+/*
+ * Reserve numChunks spare chunks in one go, in the resource group and segment
+ * counters. Unlike VmemTracker_ReserveVmemChunks(), no waiver and no over-use
+ * is allowed: if any limit would be exceeded the reservation is rolled back
+ * and false is returned, and the caller falls back to reserving exactly what
+ * it needs.
+ */
+static bool
+VmemTracker_LeaseVmemChunks(int32 numChunks)
+{
+	Assert(0 < numChunks);
+
+	if (!VmemTracker_CanLeaseVmemChunks(numChunks))
+		return false;
+
+	if (!ResGroupLeaseMemory(numChunks))
+		return false;
+
+	sharedVmemUpdates++;
+	int32 new_vmem = pg_atomic_add_fetch_u32((pg_atomic_uint32 *) segmentVmemChunks, numChunks);
+
+	if (new_vmem > VmemTracker_GetLeaseCeilingChunks())
+	{
+		pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) segmentVmemChunks, numChunks);
+		ResGroupReleaseMemory(numChunks);
+		return false;
+	}
+
+	VmemTracker_SetSpareVmemChunks(spareVmemChunks + numChunks);
+
+	return true;
+}
+
+/*
+ * Moves numChunks chunks from the spare chunks of this process to its
+ * tracked chunks, and counts them in the session. If there are not enough
+ * spare chunks, leases the missing ones plus gp_vmem_lease_chunks more.
+ * Returns false, without taking any, if they can't be leased or if the
+ * session would go over gp_vmem_limit_per_query; the caller then reserves
+ * exactly what it needs, with the usual waiver rules.
+ */
+static bool
+VmemTracker_TakeSpareVmemChunks(int32 numChunks)
+{
+	int32 memLimitPerQuery = VmemTracker_GetMaxChunksPerQuery();
+
+	if (spareVmemChunks < numChunks &&
+		!VmemTracker_LeaseVmemChunks(numChunks - spareVmemChunks + gp_vmem_lease_chunks))
+		return false;
+
+	int32 total = pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &MySessionState->sessionVmem, numChunks);
+
+	if (memLimitPerQuery != 0 && total > memLimitPerQuery)
+	{
+		pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) &MySessionState->sessionVmem, numChunks);
+		return false;
+	}
+
+	VmemTracker_SetSpareVmemChunks(spareVmemChunks - numChunks);
+	trackedVmemChunks += numChunks;
+
+	maxVmemChunksTracked = Max(maxVmemChunksTracked, trackedVmemChunks);
+
+	return true;
+}
+
+/*
+ * Returns numChunks spare chunks to the resource group and segment.
+ */
+static void
+VmemTracker_ReturnSpareVmemChunks(int32 numChunks)
+{
+	Assert(0 <= numChunks && numChunks <= spareVmemChunks);
+
+	if (numChunks == 0)
+		return;
+
+	sharedVmemUpdates++;
+	pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) segmentVmemChunks, numChunks);
+	ResGroupReleaseMemory(numChunks);
+	VmemTracker_SetSpareVmemChunks(spareVmemChunks - numChunks);
+}
+
+/*
+ * Gives back spare chunks once this process holds more than twice the lease
+ * size, keeping one lease. The gap between the two avoids leasing and
+ * returning chunks on every free/allocate cycle around a chunk boundary.
+ * All spare chunks are given back once another lease would not fit, e.g.
+ * because the segment is getting close to the red zone.
+ */
+static void
+VmemTracker_TrimSpareVmemChunks(void)
+{
+	int32		keep = 0;
+
+	if (VmemTracker_CanLeaseVmemChunks(gp_vmem_lease_chunks))
+		keep = gp_vmem_lease_chunks;
+
+	if (spareVmemChunks > 2 * keep)
+		VmemTracker_ReturnSpareVmemChunks(spareVmemChunks - keep);
+}
+
+/*
+ * Gives back all spare chunks when memory is short: once the segment, spare
+ * chunks included, goes past the lease ceiling, or after another process ran
+ * out of memory.
+ */
+static void
+VmemTracker_ReturnSpareIfMemoryShort(void)
+{
+	if (spareVmemChunks == 0)
+		return;
+
+	if (*segmentVmemChunks > VmemTracker_GetLeaseCeilingChunks() ||
+		(*segmentOOMTime >= oomTrackerStartTime &&
+		 *segmentOOMTime > alreadyReportedOOMTime))
+		VmemTracker_ReturnSpareVmemChunks(spareVmemChunks);
+}
+
 /*
  * Releases all vmem reserved by this process.
  */
 static void
 ReleaseAllVmemChunks()
 {
+	VmemTracker_ReturnSpareVmemChunks(spareVmemChunks);
 	VmemTracker_ReleaseVmemChunks(trackedVmemChunks);
 	Assert(0 == trackedVmemChunks);
 	trackedBytes = 0;
 }
 
+/*
+ * Gives back all spare chunks of this process, e.g. before it goes idle.
+ */
+void
+VmemTracker_ReleaseSpareVmem(void)
+{
+	if (!VmemTrackerIsActivated())
+		return;
+
+	VmemTracker_ReturnSpareVmemChunks(spareVmemChunks);
+}
+
+/*
+ * Returns the number of spare chunks held by all processes on this segment.
+ * They are included in the segment vmem counter, but are not in use.
+ *
+ * The per-process counts are read without locks, so this is only an
+ * estimate.
+ */
+int32
+VmemTracker_GetSpareVmemChunks(void)
+{
+	int32		total = 0;
+	int			i;
+
+	if (ProcGlobal == NULL)
+		return 0;
+
+	for (i = 0; i < ProcGlobal->allProcCount; i++)
+		total += ProcGlobal->allProcs[i].spareVmemChunks;
+
+	return total;
+}
+
 /*
  * Returns the available VMEM in "chunks" unit. If the available chunks
  * is less than 0, it return 0.
@@ -483,6 +707,15 @@ VmemTracker_GetReservedVmemBytes(void)
 	return CHUNKS_TO_BYTES(trackedVmemChunks);
 }
 
+/*
+ * Returns how many times this process updated the segment vmem counter.
+ */
+int64
+VmemTracker_GetSharedVmemUpdates(void)
+{
+	return sharedVmemUpdates;
+}
+
 /*
  * Returns the available VMEM in "bytes" unit
  */
@@ -543,6 +776,8 @@ VmemTracker_ReserveVmem(int64 newlyRequestedBytes)
 		 */
 		trackedBytes -= newlyRequestedBytes;
 
+		VmemTracker_ReturnSpareIfMemoryShort();
+
 		/*
 		 * Detect a runaway session. Moreover, if the current session is deemed
 		 * as runaway, start cleanup.
@@ -579,7 +814,17 @@ VmemTracker_ReserveVmem(int64 newlyRequestedBytes)
 		ReportOOMConsumption();
 
 		int32 needChunk = newszChunk - trackedVmemChunks;
-		status = VmemTracker_ReserveVmemChunks(needChunk);
+
+		if (!VmemTracker_TakeSpareVmemChunks(needChunk))
+		{
+			/*
+			 * No more can be leased. Give back the spare chunks we still
+			 * hold and reserve exactly what we need, with the usual
+			 * waiver and over-use rules.
+			 */
+			VmemTracker_ReturnSpareVmemChunks(spareVmemChunks);
+			status = VmemTracker_ReserveVmemChunks(needChunk);
+		}
 	}
 
 	/* Failed to reserve vmem chunks. Revert changes to trackedBytes */
@@ -630,7 +875,20 @@ VmemTracker_ReleaseVmem(int64 toBeFreedRequested)
 	{
 		int reduction = trackedVmemChunks - newszChunk;
 
-		VmemTracker_ReleaseVmemChunks(reduction);
+		if (gp_vmem_lease_chunks > 0)
+		{
+			/* Keep the freed chunks as spare, and give back the excess */
+			pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) &MySessionState->sessionVmem, reduction);
+			Assert(0 <= MySessionState->sessionVmem);
+			trackedVmemChunks -= reduction;
+			VmemTracker_SetSpareVmemChunks(spareVmemChunks + reduction);
+			VmemTracker_TrimSpareVmemChunks();
+		}
+		else
+		{
+			VmemTracker_ReturnSpareVmemChunks(spareVmemChunks);
+			VmemTracker_ReleaseVmemChunks(reduction);
+		}
 	}
 }
 
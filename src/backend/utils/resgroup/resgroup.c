@@ -1222,6 +1222,67 @@ ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed)
 	return true;
 }
 
+/*
+ * Can the current process reserve memoryChunks ahead of need without using
+ * the shared memory of its group or of the segment?
+ *
+ * This is only a hint, ResGroupLeaseMemory() does the real check.
+ */
+bool
+ResGroupCanLeaseMemory(int32 memoryChunks)
+{
+	ResGroupSlotData	*slot = self->slot;
+
+	if (!IsResGroupEnabled())
+		return true;
+
+	/* Keep bypassed and unassigned processes to exact accounting */
+	if (bypassedGroup || !selfIsAssigned())
+		return false;
+
+	return slot->memUsage + memoryChunks < slot->memQuota;
+}
+
+/*
+ * Reserve memoryChunks ahead of need, from the slot quota only.
+ *
+ * Unlike ResGroupReserveMemory(), this never uses the shared memory of the
+ * group or of the segment: if the slot quota would be exceeded the change
+ * is reverted and false is returned. The chunks are given back with
+ * ResGroupReleaseMemory().
+ */
+bool
+ResGroupLeaseMemory(int32 memoryChunks)
+{
+	ResGroupSlotData	*slot = self->slot;
+	ResGroupData		*group = self->group;
+	int32				slotMemUsage;
+
+	if (!IsResGroupEnabled())
+		return true;
+
+	Assert(memoryChunks >= 0);
+
+	if (!ResGroupCanLeaseMemory(memoryChunks))
+		return false;
+
+	slotMemUsage = pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &slot->memUsage,
+										   memoryChunks);
+	if (slotMemUsage >= slot->memQuota)
+	{
+		/* Another process of the slot got there first */
+		pg_atomic_sub_fetch_u32((pg_atomic_uint32 *) &slot->memUsage,
+								memoryChunks);
+		return false;
+	}
+
+	pg_atomic_add_fetch_u32((pg_atomic_uint32 *) &group->memUsage,
+							memoryChunks);
+	self->memUsage += memoryChunks;
+
+	return true;
+}
+
 /*
  * Release the memory of resource group
  */
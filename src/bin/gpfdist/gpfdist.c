@@ -152,6 +152,10 @@ static void percent_encoding_to_char(char* p, char* pp, char* path);
 #endif
 
 
+/* Reader threads (--parallel) */
+#define GPFDIST_MAX_READER_THREADS 64
+#define GPFDIST_READAHEAD_BLOCKS 4 /* blocks read ahead for each session */
+
 /*	Struct of command line options */
 static struct
 {
@@ -173,7 +177,8 @@ static struct
 	struct transform* trlist; /* transforms from config file */
 	const char* ssl; /* path to certificates in case we use gpfdist with ssl */
 	int			w; /* The time used for session timeout in seconds */
-} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0 };
+	int			parallel; /* number of reader threads, 0 to read in the event loop */
+} opt = { 8080, 8080, 0, 0, 0, ".", 0, 0, -1, 5, 0, 32768, 0, 256, 0, 0, 0, 0, 0 };
 
 
 typedef union address
@@ -209,6 +214,48 @@ static struct
 	int 			wdtimer; /* Kill gpfdist after k seconds of inactivity. 0 to disable. */
 } gcb;
 
+#ifndef WIN32
+/*
+ * A block read ahead by a reader thread, waiting to be sent.
+ */
+typedef struct readahead_block_t readahead_block_t;
+struct readahead_block_t
+{
+	int				size;		/* bytes of data, 0 at EOF, -1 on error */
+	char*			data;
+	struct fstream_filename_and_offset fos;
+	apr_int64_t		read_bytes;	/* compressed bytes consumed to read it */
+};
+
+/*
+ * Read-ahead state of a GET session.
+ *
+ * A reader thread reads, decompresses and splits into rows the next
+ * blocks of the session, while the event loop sends the previous ones
+ * to the segments. The fstream is read by one thread at a time, so a
+ * session keeps one thread busy at most; the threads are shared by all
+ * the sessions.
+ *
+ * Everything here is protected by readers.mutex.
+ */
+typedef struct readahead_t readahead_t;
+struct readahead_t
+{
+	struct session_t* session;
+	readahead_block_t blocks[GPFDIST_READAHEAD_BLOCKS];
+	int				head;		/* next block to send */
+	int				count;		/* # blocks read and not sent yet */
+	int				queued;		/* waiting in readers.queue */
+	int				reading;	/* a reader thread is filling blocks */
+	int				done;		/* the last block (EOF or error) was read */
+	int				stopping;	/* session ending, don't read any more */
+	char			error[256];	/* fstream error of the last block */
+	char*			line_delim_str;
+	int				line_delim_length;
+	readahead_t*	next;		/* next in readers.queue */
+};
+#endif
+
 /*  A session */
 typedef struct session_t session_t;
 struct session_t
@@ -232,6 +279,13 @@ struct session_t
 	struct timeval 	tm;             /* timeout for struct event */
 	struct event   	ev;             /* event we are watching for this session*/
 	apr_hash_t		*requests;
+	apr_time_t		ctime;			/* time when the session was created */
+	apr_int64_t		bytes_sent;		/* data bytes sent to the segments */
+	apr_int64_t		blocks_sent;	/* # data blocks sent to the segments */
+	apr_time_t		wait_time;		/* usec spent waiting for data to send */
+#ifndef WIN32
+	readahead_t*	readahead;		/* NULL if read in the event loop */
+#endif
 };
 
 /*  An http request */
@@ -501,7 +555,7 @@ static void usage_error(const char* msg, int print_usage)
 		{
 			fprintf(stderr,
 					"gpfdist -- file distribution web server\n\n"
-						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>]"
+						"usage: gpfdist [--ssl <certificates_directory>] [-d <directory>] [-p <http(s)_port>] [-l <log_file>] [-t <timeout>] [-v | -V | -s] [-m <maxlen>] [-w <timeout>] [--parallel <threads>]"
 #ifdef GPFXDIST
 					    "[-c file]"
 #endif
@@ -527,7 +581,9 @@ static void usage_error(const char* msg, int print_usage)
 					    "        -c file    : configuration file for transformations\n"
 #endif
 						"        --version  : print version information\n"
-						"        -w timeout : timeout in seconds before close target file\n\n");
+						"        -w timeout : timeout in seconds before close target file\n"
+						"        --parallel n : read, decompress and split the data of the sessions\n"
+						"                     in n threads, ahead of sending it. default is 0\n\n");
 		}
 	}
 
@@ -590,6 +646,7 @@ static void parse_command_line(int argc, const char* const argv[],
 #endif
 	{ "version", 256, 0, "print version number" },
 	{ NULL, 'w', 1, "wait for session timeout in seconds" },
+	{ "parallel", 258, 1, "number of threads reading data ahead" },
 	{ 0 } };
 
 	status = apr_getopt_init(&os, pool, argc, argv);
@@ -674,6 +731,9 @@ static void parse_command_line(int argc, const char* const argv[],
 		case 'w':
 			opt.w = atoi(arg);
 			break;
+		case 258:
+			opt.parallel = atoi(arg);
+			break;
 		}
 	}
 
@@ -695,6 +755,14 @@ static void parse_command_line(int argc, const char* const argv[],
 	if (!is_valid_session_timeout(opt.w))
 		usage_error("Error: -w timeout must be between 1 and 7200, or 0 for no timeout", 0);
 
+#ifndef WIN32
+	if (!(0 <= opt.parallel && opt.parallel <= GPFDIST_MAX_READER_THREADS))
+		usage_error("Error: --parallel must be between 0 and 64", 0);
+#else
+	if (opt.parallel != 0)
+		usage_error("Error: --parallel is not supported on this platform", 0);
+#endif
+
 	/* validate max row length */
     if (! ((GPFDIST_MAX_LINE_LOWER_LIMIT <= opt.m) && (opt.m <= GPFDIST_MAX_LINE_UPPER_LIMIT)))
     	usage_error(GPFDIST_MAX_LINE_MESSAGE, 0);
@@ -1078,6 +1146,64 @@ static apr_status_t send_gpfdist_status(request_t* r)
 		return APR_EGENERAL;
 	}
 
+	/* per-session throughput */
+	n = apr_snprintf(buf, sizeof(buf), "reader_threads %d\r\n", opt.parallel);
+	if (local_send(r, buf, n) != n)
+	{
+		gprint(r, "%s - socket error\n", r->peer);
+		return APR_EGENERAL;
+	}
+
+	apr_hash_index_t* hi;
+	for (hi = apr_hash_first(r->pool, gcb.session.tab); hi; hi = apr_hash_next(hi))
+	{
+		void *entry;
+		apr_hash_this(hi, 0, 0, &entry);
+		session_t *s = (session_t*) entry;
+		if (s == NULL)
+			continue;
+
+		apr_time_t elapsed = apr_time_now() - s->ctime;
+		apr_int64_t rate = elapsed > 0 ? s->bytes_sent * APR_USEC_PER_SEC / elapsed : 0;
+
+		n = apr_snprintf(buf, sizeof(buf), "session %ld tid %s path %s"
+#ifdef WIN32
+										" bytes_sent %ld"
+										" blocks_sent %ld"
+										" elapsed_ms %ld"
+										" wait_ms %ld"
+										" bytes_per_sec %ld\r\n",
+#else
+										" bytes_sent %"APR_INT64_T_FMT
+										" blocks_sent %"APR_INT64_T_FMT
+										" elapsed_ms %"APR_INT64_T_FMT
+										" wait_ms %"APR_INT64_T_FMT
+										" bytes_per_sec %"APR_INT64_T_FMT"\r\n",
+#endif
+										s->id, s->tid, s->path,
+#ifdef WIN32
+										(long) s->bytes_sent,
+										(long) s->blocks_sent,
+										(long) apr_time_as_msec(elapsed),
+										(long) apr_time_as_msec(s->wait_time),
+										(long) rate);
+#else
+										s->bytes_sent,
+										s->blocks_sent,
+										(apr_int64_t) apr_time_as_msec(elapsed),
+										(apr_int64_t) apr_time_as_msec(s->wait_time),
+										rate);
+#endif
+		if (n >= sizeof buf - 1)
+			n = sizeof buf - 1;
+
+		if (local_send(r, buf, n) != n)
+		{
+			gprint(r, "%s - socket error\n", r->peer);
+			return APR_EGENERAL;
+		}
+	}
+
 	return 0;
 }
 
@@ -1289,6 +1415,232 @@ static void gp1_send_errfile(request_t* r, apr_file_t* errfile)
 }
 #endif
 
+#ifndef WIN32
+/*
+ * The reader threads, and the queue of the sessions waiting for one of
+ * them to read their next blocks.
+ */
+static struct
+{
+	pthread_mutex_t	mutex;
+	pthread_cond_t	work;	/* a session was queued */
+	pthread_cond_t	ready;	/* a block was read, or a reader let go of a session */
+	readahead_t*	head;
+	readahead_t*	tail;
+} readers = { PTHREAD_MUTEX_INITIALIZER, PTHREAD_COND_INITIALIZER,
+			  PTHREAD_COND_INITIALIZER, NULL, NULL };
+
+/*
+ * readahead_read_block
+ *
+ * Read the next block of a session into b. Called by a reader thread
+ * without the lock: nothing else touches the fstream, or the block, while
+ * the session is being read.
+ */
+static void readahead_read_block(readahead_t* ra, readahead_block_t* b)
+{
+	fstream_t*	fstream = ra->session->fstream;
+	apr_int64_t	pos = fstream_get_compressed_position(fstream);
+
+	/* gpfdist must not read data with partial rows */
+	b->size = fstream_read(fstream, b->data, opt.m, &b->fos, 1,
+						   ra->line_delim_str, ra->line_delim_length);
+
+	if (b->size == 0)
+		b->read_bytes = fstream_get_compressed_size(fstream) - pos;
+	else
+		b->read_bytes = fstream_get_compressed_position(fstream) - pos;
+
+	if (b->size < 0)
+	{
+		const char* ferror = fstream_get_error(fstream);
+
+		apr_cpystrn(ra->error, ferror ? ferror : "unknown error", sizeof(ra->error));
+	}
+}
+
+/*
+ * reader_thread
+ *
+ * Take the sessions off the queue, and fill their free blocks.
+ */
+static void* reader_thread(void* arg)
+{
+	pthread_mutex_lock(&readers.mutex);
+	for (;;)
+	{
+		readahead_t* ra;
+
+		while (readers.head == NULL)
+			pthread_cond_wait(&readers.work, &readers.mutex);
+
+		ra = readers.head;
+		readers.head = ra->next;
+		if (readers.head == NULL)
+			readers.tail = NULL;
+		ra->next = NULL;
+		ra->queued = 0;
+		ra->reading = 1;
+
+		while (!ra->stopping && !ra->done &&
+			   ra->count < GPFDIST_READAHEAD_BLOCKS)
+		{
+			readahead_block_t* b;
+
+			b = &ra->blocks[(ra->head + ra->count) % GPFDIST_READAHEAD_BLOCKS];
+
+			pthread_mutex_unlock(&readers.mutex);
+			readahead_read_block(ra, b);
+			pthread_mutex_lock(&readers.mutex);
+
+			ra->count++;
+			if (b->size <= 0)
+				ra->done = 1;
+			pthread_cond_broadcast(&readers.ready);
+		}
+
+		ra->reading = 0;
+		pthread_cond_broadcast(&readers.ready);
+	}
+
+	return NULL;
+}
+
+/*
+ * readahead_schedule
+ *
+ * Queue the session for a reader thread, if it has free blocks to fill
+ * and it isn't queued or being read already. Called with the lock held.
+ */
+static void readahead_schedule(readahead_t* ra)
+{
+	if (ra->queued || ra->reading || ra->done || ra->stopping ||
+		ra->count == GPFDIST_READAHEAD_BLOCKS)
+		return;
+
+	ra->queued = 1;
+	if (readers.tail)
+		readers.tail->next = ra;
+	else
+		readers.head = ra;
+	readers.tail = ra;
+	pthread_cond_signal(&readers.work);
+}
+
+/*
+ * readahead_start
+ *
+ * Set up the read-ahead of a new GET session, and get its first blocks
+ * read while the segments connect.
+ */
+static void readahead_start(request_t* r, session_t* session)
+{
+	readahead_t*	ra;
+	int				i;
+
+	ra = pcalloc_safe(r, session->pool, sizeof(readahead_t), "out of memory in session_attach");
+	for (i = 0; i < GPFDIST_READAHEAD_BLOCKS; i++)
+		ra->blocks[i].data = palloc_safe(r, session->pool, opt.m,
+										 "out of memory when allocating buffer: %d bytes", opt.m);
+	ra->session = session;
+	ra->line_delim_str = apr_pstrdup(session->pool, r->line_delim_str);
+	ra->line_delim_length = r->line_delim_length;
+	if (ra->line_delim_str == 0)
+		gfatal(r, "out of memory in session_attach");
+
+	session->readahead = ra;
+
+	pthread_mutex_lock(&readers.mutex);
+	readahead_schedule(ra);
+	pthread_mutex_unlock(&readers.mutex);
+}
+
+/*
+ * readahead_stop
+ *
+ * Stop reading ahead for a session, and wait for its reader thread to let
+ * go of it, so that the fstream can be closed.
+ */
+static void readahead_stop(session_t* session)
+{
+	readahead_t* ra = session->readahead;
+
+	if (ra == NULL)
+		return;
+
+	pthread_mutex_lock(&readers.mutex);
+	ra->stopping = 1;
+	if (ra->queued)
+	{
+		readahead_t* prev = NULL;
+		readahead_t* cur;
+
+		for (cur = readers.head; cur != ra; cur = cur->next)
+			prev = cur;
+		if (prev)
+			prev->next = ra->next;
+		else
+			readers.head = ra->next;
+		if (readers.tail == ra)
+			readers.tail = prev;
+		ra->next = NULL;
+		ra->queued = 0;
+	}
+	while (ra->reading)
+		pthread_cond_wait(&readers.ready, &readers.mutex);
+	pthread_mutex_unlock(&readers.mutex);
+}
+
+/*
+ * readahead_get_block
+ *
+ * Take the next block read ahead for the session, waiting for it if it
+ * isn't read yet. Returns the size of the data copied to 'data', like
+ * fstream_read().
+ */
+static int readahead_get_block(session_t* session, char* data,
+							   struct fstream_filename_and_offset* fos,
+							   apr_int64_t* read_bytes)
+{
+	readahead_t*		ra = session->readahead;
+	readahead_block_t*	b;
+	int					size;
+
+	pthread_mutex_lock(&readers.mutex);
+	while (ra->count == 0 && !ra->done)
+	{
+		readahead_schedule(ra);
+		pthread_cond_wait(&readers.ready, &readers.mutex);
+	}
+	if (ra->count == 0)
+	{
+		/* the last block was taken already */
+		pthread_mutex_unlock(&readers.mutex);
+		*read_bytes = 0;
+		return 0;
+	}
+	b = &ra->blocks[ra->head];
+	pthread_mutex_unlock(&readers.mutex);
+
+	/* the reader threads leave this block alone until we release it */
+	size = b->size;
+	if (size > 0)
+	{
+		memcpy(data, b->data, size);
+		*fos = b->fos;
+	}
+	*read_bytes = b->read_bytes;
+
+	pthread_mutex_lock(&readers.mutex);
+	ra->head = (ra->head + 1) % GPFDIST_READAHEAD_BLOCKS;
+	ra->count--;
+	readahead_schedule(ra);
+	pthread_mutex_unlock(&readers.mutex);
+
+	return size;
+}
+#endif
+
 /*
  * session_get_block
  *
@@ -1301,6 +1653,7 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 	int 		size;
 	const int 	whole_rows = 1; /* gpfdist must not read data with partial rows */
 	struct fstream_filename_and_offset fos;
+	apr_time_t	start;
 
 	session_t *session = r->session;
 
@@ -1313,26 +1666,51 @@ session_get_block(const request_t* r, block_t* retblock, char* line_delim_str, i
 		return 0;
 	}
 
-	gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
+	start = apr_time_now();
+
+#ifndef WIN32
+	if (session->readahead)
+	{
+		apr_int64_t read_bytes;
+
+		/* a reader thread has read the data as a chunk with whole data rows */
+		size = readahead_get_block(session, retblock->data, &fos, &read_bytes);
+		gcb.read_bytes += read_bytes;
+	}
+	else
+#endif
+	{
+		gcb.read_bytes -= fstream_get_compressed_position(session->fstream);
 
-	/* read data from our filestream as a chunk with whole data rows */
+		/* read data from our filestream as a chunk with whole data rows */
+		size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
 
-	size = fstream_read(session->fstream, retblock->data, opt.m, &fos, whole_rows, line_delim_str, line_delim_length);
+		if (size == 0)
+			gcb.read_bytes += fstream_get_compressed_size(session->fstream);
+		else
+			gcb.read_bytes += fstream_get_compressed_position(session->fstream);
+	}
 	delay_watchdog_timer();
 
+	session->wait_time += apr_time_now() - start;
+
 	if (size == 0)
 	{
 		gprintln(NULL, "session_get_block: end session due to EOF");
-		gcb.read_bytes += fstream_get_compressed_size(session->fstream);
 		session_end(session, 0);
 		return 0;
 	}
 
-	gcb.read_bytes += fstream_get_compressed_position(session->fstream);
-
 	if (size < 0)
 	{
-		const char* ferror = fstream_get_error(session->fstream);
+		const char* ferror;
+
+#ifndef WIN32
+		if (session->readahead)
+			ferror = session->readahead->error;
+		else
+#endif
+			ferror = fstream_get_error(session->fstream);
 		gwarning(NULL, "session_get_block end session due to %s", ferror);
 		session_end(session, 1);
 		return ferror;
@@ -1356,6 +1734,9 @@ static void session_end(session_t* session, int error)
 
 	if (session->fstream)
 	{
+#ifndef WIN32
+		readahead_stop(session);
+#endif
 		gprintln(NULL, "close fstream");
 		fstream_close(session->fstream);
 		session->fstream = 0;
@@ -1369,6 +1750,9 @@ static void session_free(session_t* session)
 
 	if (session->fstream)
 	{
+#ifndef WIN32
+		readahead_stop(session);
+#endif
 		fstream_close(session->fstream);
 		session->fstream = 0;
 	}
@@ -1626,11 +2010,25 @@ static int session_attach(request_t* r)
 		session->active_segids[r->segid] = 1; /* mark this segid as active */
 		session->maxsegs = r->totalsegs;
 		session->requests = apr_hash_make(pool);
+		session->ctime = apr_time_now();
 		event_set(&session->ev, 0, 0, 0, 0);
 
 		if (session->tid == 0 || session->path == 0 || session->key == 0)
 			gfatal(r, "out of memory in session_attach");
 
+#ifndef WIN32
+		/*
+		 * Read the data ahead in the reader threads. Not with a transform:
+		 * that shares the session's apr pool, which isn't thread-safe.
+		 */
+		if (opt.parallel > 0 && session->is_get
+#ifdef GPFXDIST
+			&& !r->trans.command
+#endif
+			)
+			readahead_start(r, session);
+#endif
+
 		/* insert into hashtable */
 		apr_hash_set(gcb.session.tab, session->key, APR_HASH_KEY_STRING, session);
 
@@ -1827,11 +2225,17 @@ static void do_write(int fd, short event, void* arg)
 		r->last = apr_time_now();
 		datablock->bot += n;
 
+		if (r->session)
+			r->session->bytes_sent += n;
+
 		if (datablock->top != datablock->bot)
 		{ /* network chocked */
 			gdebug(r, "network full");
 			break;
 		}
+
+		if (r->session)
+			r->session->blocks_sent++;
 	}
 
 	/* Set up for this routine to be called again */
@@ -3628,6 +4032,26 @@ int gpfdist_init(int argc, const char* const argv[])
 			pthread_create(&watchdog, 0, watchdog_thread, 0);
 		}
 	}
+
+	/* start the reader threads */
+	{
+		int			i;
+
+		for (i = 0; i < opt.parallel; i++)
+		{
+			pthread_t	reader;
+			int			rc;
+
+			if ((rc = pthread_create(&reader, 0, reader_thread, 0)) != 0)
+			{
+				fprintf(stderr, "failed to start reader thread: %s\n", strerror(rc));
+				return -1;
+			}
+			pthread_detach(reader);
+		}
+		if (opt.parallel > 0)
+			gprintln(NULL, "Reading data ahead in %d threads", opt.parallel);
+	}
 #endif
 	return 0;
 }
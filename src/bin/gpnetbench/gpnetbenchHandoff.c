@@ -0,0 +1,324 @@
+/*
+ * gpnetbenchHandoff
+ *
+ * Micro-benchmark for the hand-off of received packets from the UDP
+ * interconnect rx thread to the main executor thread.  One producer thread
+ * plays the rx thread, the main thread plays the receiving executor, and
+ * packets are passed between them either:
+ *
+ *  mutex: through a queue protected by a mutex, taken once to fetch and
+ *         once to release every packet, with a condition variable to wake
+ *         up the consumer (like the locked path in ic_udpifc.c), or
+ *  ring:  through a lock-free single-producer/single-consumer ring, where
+ *         the consumer spins for a while before sleeping on an eventfd (a
+ *         pipe where eventfd is not available).
+ */
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
+#define RING_SIZE 1024			/* must be a power of 2 */
+
+typedef struct HandoffQueue
+{
+	/* mutex mode */
+	pthread_mutex_t lock;
+	pthread_cond_t cond;
+	int			consumerWaiting;
+
+	/* ring mode */
+	unsigned int head;			/* advanced by consumer */
+	unsigned int tail;			/* advanced by producer */
+	int			sleeping;
+	int			wakeFd[2];
+
+	int			slots[RING_SIZE];
+} HandoffQueue;
+
+static HandoffQueue queue;
+static int	useRing = 1;
+static long npackets = 10000000;
+static int	spinCount = 1000;
+static int	producerWork = 0;
+static int	consumerWork = 0;
+static long nsleeps = 0;
+
+static void usage(void);
+static void *producer(void *arg);
+static void burn(int loops);
+static void wakeConsumer(void);
+static void sleepConsumer(void);
+static double subtractTimeOfDay(struct timeval *begin, struct timeval *end);
+
+static void
+usage(void)
+{
+	printf("usage: gpnetbenchHandoff [OPTIONS]\n\n");
+
+	printf(" -m MODE        hand-off scheme, \"ring\" (default) or \"mutex\"\n");
+	printf(" -n PACKETS     number of packets to pass, default is 10000000\n");
+	printf(" -s SPINS       polls before the consumer sleeps in ring mode, default is 1000\n");
+	printf(" -p LOOPS       busy loops per packet in the producer, default is 0\n");
+	printf(" -c LOOPS       busy loops per packet in the consumer, default is 0\n");
+	printf(" -h             show this help message\n");
+}
+
+static void
+burn(int loops)
+{
+	volatile int i;
+
+	for (i = 0; i < loops; i++)
+		;
+}
+
+static void
+wakeConsumer(void)
+{
+#ifdef __linux__
+	eventfd_write(queue.wakeFd[0], 1);
+#else
+	char		c = 0;
+
+	if (write(queue.wakeFd[1], &c, 1) < 0 && errno != EAGAIN)
+		perror("write");
+#endif
+}
+
+static void
+sleepConsumer(void)
+{
+#ifdef __linux__
+	eventfd_t	value;
+
+	eventfd_read(queue.wakeFd[0], &value);
+#else
+	char		c;
+
+	if (read(queue.wakeFd[0], &c, 1) < 0)
+		perror("read");
+#endif
+	nsleeps++;
+}
+
+static void *
+producer(void *arg)
+{
+	long		i;
+
+	for (i = 0; i < npackets; i++)
+	{
+		burn(producerWork);
+
+		if (useRing)
+		{
+			unsigned int tail = __atomic_load_n(&queue.tail, __ATOMIC_RELAXED);
+
+			/* wait for the consumer to make room */
+			while (tail - __atomic_load_n(&queue.head, __ATOMIC_ACQUIRE) >= RING_SIZE)
+				sched_yield();
+
+			queue.slots[tail & (RING_SIZE - 1)] = (int) i;
+			__atomic_store_n(&queue.tail, tail + 1, __ATOMIC_SEQ_CST);
+
+			if (__atomic_load_n(&queue.sleeping, __ATOMIC_SEQ_CST) &&
+				__atomic_exchange_n(&queue.sleeping, 0, __ATOMIC_SEQ_CST))
+				wakeConsumer();
+		}
+		else
+		{
+			pthread_mutex_lock(&queue.lock);
+			while (queue.tail - queue.head >= RING_SIZE)
+			{
+				pthread_mutex_unlock(&queue.lock);
+				sched_yield();
+				pthread_mutex_lock(&queue.lock);
+			}
+			queue.slots[queue.tail & (RING_SIZE - 1)] = (int) i;
+			queue.tail++;
+			if (queue.consumerWaiting)
+				pthread_cond_signal(&queue.cond);
+			pthread_mutex_unlock(&queue.lock);
+		}
+	}
+
+	return NULL;
+}
+
+static int
+consumeRing(void)
+{
+	unsigned int head = queue.head;
+	int			spins = 0;
+	int			value;
+
+	while (__atomic_load_n(&queue.tail, __ATOMIC_ACQUIRE) == head)
+	{
+		if (spins++ < spinCount)
+			continue;
+
+		/* announce that we are going to sleep, then re-check */
+		__atomic_store_n(&queue.sleeping, 1, __ATOMIC_SEQ_CST);
+		if (__atomic_load_n(&queue.tail, __ATOMIC_SEQ_CST) != head)
+		{
+			if (!__atomic_exchange_n(&queue.sleeping, 0, __ATOMIC_SEQ_CST))
+				sleepConsumer();	/* producer already signalled, eat it */
+			break;
+		}
+		sleepConsumer();
+		spins = 0;
+	}
+
+	value = queue.slots[head & (RING_SIZE - 1)];
+	__atomic_store_n(&queue.head, head + 1, __ATOMIC_RELEASE);
+
+	return value;
+}
+
+static int
+consumeMutex(void)
+{
+	int			value;
+
+	pthread_mutex_lock(&queue.lock);
+	while (queue.tail == queue.head)
+	{
+		queue.consumerWaiting = 1;
+		pthread_cond_wait(&queue.cond, &queue.lock);
+		queue.consumerWaiting = 0;
+		nsleeps++;
+	}
+	value = queue.slots[queue.head & (RING_SIZE - 1)];
+	pthread_mutex_unlock(&queue.lock);
+
+	/* the buffer is returned in a separate critical section */
+	pthread_mutex_lock(&queue.lock);
+	queue.head++;
+	pthread_mutex_unlock(&queue.lock);
+
+	return value;
+}
+
+static double
+subtractTimeOfDay(struct timeval *begin, struct timeval *end)
+{
+	double		seconds;
+
+	if (end->tv_usec < begin->tv_usec)
+	{
+		end->tv_usec += 1000000;
+		end->tv_sec -= 1;
+	}
+
+	seconds = end->tv_usec - begin->tv_usec;
+	seconds /= 1000000.0;
+
+	seconds += (end->tv_sec - begin->tv_sec);
+	return seconds;
+}
+
+int
+main(int argc, char **argv)
+{
+	int			c;
+	long		i;
+	pthread_t	thread;
+	struct timeval beginTimeDetails;
+	struct timeval endTimeDetails;
+	double		duration;
+
+	while ((c = getopt(argc, argv, "m:n:s:p:c:h")) != -1)
+	{
+		switch (c)
+		{
+			case 'm':
+				if (strcmp(optarg, "ring") == 0)
+					useRing = 1;
+				else if (strcmp(optarg, "mutex") == 0)
+					useRing = 0;
+				else
+				{
+					fprintf(stderr, "unknown mode \"%s\"\n", optarg);
+					usage();
+					return 1;
+				}
+				break;
+			case 'n':
+				npackets = atol(optarg);
+				break;
+			case 's':
+				spinCount = atoi(optarg);
+				break;
+			case 'p':
+				producerWork = atoi(optarg);
+				break;
+			case 'c':
+				consumerWork = atoi(optarg);
+				break;
+			case 'h':
+			case '?':
+			default:
+				usage();
+				return 1;
+		}
+	}
+
+	if (npackets < 1 || spinCount < 0 || producerWork < 0 || consumerWork < 0)
+	{
+		fprintf(stderr, "-n must be positive, other values must not be negative\n");
+		return 1;
+	}
+
+	memset(&queue, 0, sizeof(queue));
+	pthread_mutex_init(&queue.lock, NULL);
+	pthread_cond_init(&queue.cond, NULL);
+#ifdef __linux__
+	queue.wakeFd[0] = eventfd(0, 0);
+	if (queue.wakeFd[0] < 0)
+#else
+	if (pipe(queue.wakeFd) < 0)
+#endif
+	{
+		perror("could not create wakeup descriptor");
+		return 1;
+	}
+
+	gettimeofday(&beginTimeDetails, NULL);
+
+	if (pthread_create(&thread, NULL, producer, NULL) != 0)
+	{
+		perror("could not create producer thread");
+		return 1;
+	}
+
+	for (i = 0; i < npackets; i++)
+	{
+		int			value = useRing ? consumeRing() : consumeMutex();
+
+		if (value != (int) i)
+		{
+			fprintf(stderr, "packet %ld out of order (got %d)\n", i, value);
+			return 1;
+		}
+		burn(consumerWork);
+	}
+
+	pthread_join(thread, NULL);
+	gettimeofday(&endTimeDetails, NULL);
+
+	duration = subtractTimeOfDay(&beginTimeDetails, &endTimeDetails);
+
+	printf("%-6s %12ld packets %10.3f s %14.0f packets/s %10ld sleeps\n",
+		   useRing ? "ring" : "mutex", npackets, duration,
+		   npackets / duration, nsleeps);
+
+	return 0;
+}
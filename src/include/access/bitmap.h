@@ -417,6 +417,15 @@ typedef struct BMBuildState
 	 */
 	BMTidBuildBuf	*bm_tidLocsBuffer;
 
+	/*
+	 * Once bm_tidLocsBuffer outgrows maintenance_work_mem, the (LOV item,
+	 * tid location) pairs are sorted instead, and each bitmap vector is
+	 * written out in one go at the end of the build. bm_tidsort_desc
+	 * describes the sorted tuples.
+	 */
+	struct switcheroo_Tuplesortstate *bm_tidsort;
+	TupleDesc		bm_tidsort_desc;
+
 	double 			ituples;	/* the number of index tuples */
 	bool			use_wal;	/* whether or not we write WAL records */
 } BMBuildState;
@@ -784,6 +793,7 @@ extern void _bitmap_doinsert(Relation rel, ItemPointerData ht_ctid,
 							 Datum *attdata, bool *nulls);
 extern void _bitmap_write_alltids(Relation rel, BMTidBuildBuf *tids,
 						  		  bool use_wal);
+extern void _bitmap_write_sortedtids(Relation rel, BMBuildState *state);
 
 /* bitmaputil.c */
 extern BMLOVItem _bitmap_formitem(uint64 currTidNumber);
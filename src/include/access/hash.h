@@ -291,6 +291,52 @@ extern Datum hashvarlena(PG_FUNCTION_ARGS);
 extern Datum hash_any(register const unsigned char *k, register int keylen);
 extern Datum hash_uint32(uint32 k);
 
+/*
+ * The body of hash_uint32(), inline for callers that hash many values, like
+ * cdbhash().  This is final() of hash_any(), on a single 32-bit word.
+ */
+#define HASH_UINT32_ROT(x,k) (((x)<<(k)) | ((x)>>(32-(k))))
+
+static inline uint32
+hash_uint32_inline(uint32 k)
+{
+	uint32		a,
+				b,
+				c;
+
+	a = b = c = 0x9e3779b9 + (uint32) sizeof(uint32) + 3923095;
+	a += k;
+
+	c ^= b; c -= HASH_UINT32_ROT(b, 14);
+	a ^= c; a -= HASH_UINT32_ROT(c, 11);
+	b ^= a; b -= HASH_UINT32_ROT(a, 25);
+	c ^= b; c -= HASH_UINT32_ROT(b, 16);
+	a ^= c; a -= HASH_UINT32_ROT(c, 4);
+	b ^= a; b -= HASH_UINT32_ROT(a, 14);
+	c ^= b; c -= HASH_UINT32_ROT(b, 24);
+
+	return c;
+}
+
+/*
+ * The body of hashint8().  The idea here is to produce a hash value
+ * compatible with the values produced by hashint4 and hashint2 for logically
+ * equal inputs; this is necessary to support cross-type hash joins across
+ * these input types.  Since all three types are signed, we can xor the high
+ * half of the int8 value if the sign is positive, or the complement of the
+ * high half when the sign is negative.
+ */
+static inline uint32
+hash_int8_inline(int64 val)
+{
+	uint32		lohalf = (uint32) val;
+	uint32		hihalf = (uint32) (val >> 32);
+
+	lohalf ^= (val >= 0) ? hihalf : ~hihalf;
+
+	return hash_uint32_inline(lohalf);
+}
+
 /* private routines */
 
 /* hashinsert.c */
@@ -56,6 +56,6 @@
  */
 
 /*							3yyymmddN */
-#define CATALOG_VERSION_NO	302003117
+#define CATALOG_VERSION_NO	302003126
 
 #endif
@@ -70,6 +70,10 @@
 
  CREATE FUNCTION gp_dist_wait_status(OUT segid int4, OUT waiter_dxid xid, OUT holder_dxid xid, OUT holdTillEndXact bool, OUT waiter_lpid int4, OUT holder_lpid int4, OUT waiter_lockmode text, OUT waiter_locktype text, OUT waiter_sessionid int4, OUT holder_sessionid int4) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_dist_wait_status' WITH (OID=6036, DESCRIPTION="waiting relation information");
 
+ CREATE FUNCTION gp_get_interconnect_conn_stats(OUT gp_segment_id int4, OUT pid int4, OUT sess_id int4, OUT ic_id int4, OUT motion_id int4, OUT dst_segment_id int4, OUT fc_method text, OUT cwnd float8, OUT srtt int8, OUT min_rtt int8, OUT bandwidth float8, OUT packets_sent int8, OUT retransmits int8, OUT packets_compressed int8, OUT bytes_saved int8, OUT transport text, OUT end_time timestamptz) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_get_interconnect_conn_stats' WITH (OID=5068, DESCRIPTION="flow control, compression and transport of recently closed UDP interconnect connections");
+
+ CREATE FUNCTION gp_get_interconnect_syscall_stats(OUT gp_segment_id int4, OUT pid int4, OUT sess_id int4, OUT ic_id int4, OUT packets_sent int8, OUT send_calls int8, OUT datagrams_received int8, OUT receive_calls int8, OUT end_time timestamptz) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_get_interconnect_syscall_stats' WITH (OID=5073, DESCRIPTION="send and receive syscalls of recently torn down UDP interconnects");
+
  CREATE FUNCTION pg_resqueue_status() RETURNS SETOF record LANGUAGE internal VOLATILE STRICT PARALLEL RESTRICTED AS 'pg_resqueue_status' WITH (OID=6030, DESCRIPTION="Return resource queue information");
 
  CREATE FUNCTION pg_resqueue_status_kv() RETURNS SETOF record LANGUAGE internal VOLATILE STRICT PARALLEL RESTRICTED AS 'pg_resqueue_status_kv' WITH (OID=6069, DESCRIPTION="Return resource queue information");
@@ -144,6 +148,10 @@
 
  CREATE FUNCTION gp_execution_dbid() RETURNS int4 LANGUAGE internal VOLATILE AS 'gp_execution_dbid' WITH (OID=6068, DESCRIPTION="dbid executing function");
 
+ CREATE FUNCTION gp_qe_pool_stats(OUT idle_qes int4, OUT reused int8, OUT started int8, OUT prestarted int8, OUT allocations int8, OUT allocation_ms float8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_qe_pool_stats' WITH (OID=5070, DESCRIPTION="idle segment workers of this session, and how its segment workers were obtained");
+
+ CREATE FUNCTION gp_serialized_plan_cache_stats(OUT entries int8, OUT size_bytes int8, OUT hits int8, OUT misses int8, OUT evictions int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_serialized_plan_cache_stats' WITH (OID=5072, DESCRIPTION="size and counters of the cache of compressed plans dispatched by this session");
+
  CREATE FUNCTION get_ao_distribution(IN rel regclass, OUT segmentid int4, OUT tupcount int8) RETURNS SETOF pg_catalog.record LANGUAGE internal VOLATILE READS SQL DATA AS 'get_ao_distribution' WITH (OID=7169, DESCRIPTION="show append only table tuple distribution across segment databases");
 
  CREATE FUNCTION get_ao_compression_ratio(regclass) RETURNS float8 LANGUAGE internal VOLATILE STRICT READS SQL DATA AS 'get_ao_compression_ratio' WITH (OID=7171, DESCRIPTION="show append only table compression ratio");
@@ -270,6 +278,10 @@
  CREATE FUNCTION enable_xform(text) RETURNS text LANGUAGE internal IMMUTABLE STRICT PARALLEL RESTRICTED AS 'enable_xform' WITH (OID=6088, DESCRIPTION="enables transformations in the optimizer");
 
  CREATE FUNCTION gp_opt_version() RETURNS text LANGUAGE internal IMMUTABLE STRICT PARALLEL SAFE AS 'gp_opt_version' WITH (OID=6089, DESCRIPTION="Returns the optimizer and gpos library versions");
+
+ CREATE FUNCTION gp_opt_mdcache_stats(OUT entries int8, OUT size_bytes int8, OUT hits int8, OUT misses int8, OUT evictions int8, OUT invalidations int8, OUT resets int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_opt_mdcache_stats' WITH (OID=5069, DESCRIPTION="size and counters of the optimizer metadata cache of this backend");
+
+ CREATE FUNCTION gp_opt_plan_cache_stats(OUT entries int8, OUT size_bytes int8, OUT hits int8, OUT misses int8, OUT evictions int8) RETURNS pg_catalog.record LANGUAGE internal VOLATILE PARALLEL RESTRICTED AS 'gp_opt_plan_cache_stats' WITH (OID=5071, DESCRIPTION="size and counters of the GPORCA plan cache of this backend");
  
  
   -- functions for the complex data type
@@ -166,6 +166,14 @@ DESCR("statistics: information about resource groups");
 DATA(insert OID = 6036 ( gp_dist_wait_status  PGNSP PGUID 12 1 1000 0 0 f f f f f t v r 0 0 2249 "" "{23,28,28,16,23,23,25,25,23,23}" "{o,o,o,o,o,o,o,o,o,o}" "{segid,waiter_dxid,holder_dxid,holdTillEndXact,waiter_lpid,holder_lpid,waiter_lockmode,waiter_locktype,waiter_sessionid,holder_sessionid}" _null_ _null_ gp_dist_wait_status _null_ _null_ _null_ n a ));
 DESCR("waiting relation information");
 
+/* gp_get_interconnect_conn_stats(OUT gp_segment_id int4, OUT pid int4, OUT sess_id int4, OUT ic_id int4, OUT motion_id int4, OUT dst_segment_id int4, OUT fc_method text, OUT cwnd float8, OUT srtt int8, OUT min_rtt int8, OUT bandwidth float8, OUT packets_sent int8, OUT retransmits int8, OUT packets_compressed int8, OUT bytes_saved int8, OUT transport text, OUT end_time timestamptz) => SETOF pg_catalog.record */
+DATA(insert OID = 5068 ( gp_get_interconnect_conn_stats  PGNSP PGUID 12 1 1000 0 0 f f f f f t v r 0 0 2249 "" "{23,23,23,23,23,23,25,701,20,20,701,20,20,20,20,25,1184}" "{o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o,o}" "{gp_segment_id,pid,sess_id,ic_id,motion_id,dst_segment_id,fc_method,cwnd,srtt,min_rtt,bandwidth,packets_sent,retransmits,packets_compressed,bytes_saved,transport,end_time}" _null_ _null_ gp_get_interconnect_conn_stats _null_ _null_ _null_ n a ));
+DESCR("flow control, compression and transport of recently closed UDP interconnect connections");
+
+/* gp_get_interconnect_syscall_stats(OUT gp_segment_id int4, OUT pid int4, OUT sess_id int4, OUT ic_id int4, OUT packets_sent int8, OUT send_calls int8, OUT datagrams_received int8, OUT receive_calls int8, OUT end_time timestamptz) => SETOF pg_catalog.record */
+DATA(insert OID = 5073 ( gp_get_interconnect_syscall_stats  PGNSP PGUID 12 1 1000 0 0 f f f f f t v r 0 0 2249 "" "{23,23,23,23,20,20,20,20,1184}" "{o,o,o,o,o,o,o,o,o}" "{gp_segment_id,pid,sess_id,ic_id,packets_sent,send_calls,datagrams_received,receive_calls,end_time}" _null_ _null_ gp_get_interconnect_syscall_stats _null_ _null_ _null_ n a ));
+DESCR("send and receive syscalls of recently torn down UDP interconnects");
+
 /* pg_resqueue_status() => SETOF record */
 DATA(insert OID = 6030 ( pg_resqueue_status  PGNSP PGUID 12 1 1000 0 0 f f f f t t v r 0 0 2249 "" _null_ _null_ _null_ _null_ _null_ pg_resqueue_status _null_ _null_ _null_ n a ));
 DESCR("Return resource queue information");
@@ -309,6 +317,14 @@ DESCR("view logged distributed transaction status");
 DATA(insert OID = 6068 ( gp_execution_dbid  PGNSP PGUID 12 1 0 0 0 f f f f f f v u 0 0 23 "" _null_ _null_ _null_ _null_ _null_ gp_execution_dbid _null_ _null_ _null_ n a ));
 DESCR("dbid executing function");
 
+/* gp_qe_pool_stats(OUT idle_qes int4, OUT reused int8, OUT started int8, OUT prestarted int8, OUT allocations int8, OUT allocation_ms float8) => pg_catalog.record */
+DATA(insert OID = 5070 ( gp_qe_pool_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{23,20,20,20,20,701}" "{o,o,o,o,o,o}" "{idle_qes,reused,started,prestarted,allocations,allocation_ms}" _null_ _null_ gp_qe_pool_stats _null_ _null_ _null_ n a ));
+DESCR("idle segment workers of this session, and how its segment workers were obtained");
+
+/* gp_serialized_plan_cache_stats(OUT entries int8, OUT size_bytes int8, OUT hits int8, OUT misses int8, OUT evictions int8) => pg_catalog.record */
+DATA(insert OID = 5072 ( gp_serialized_plan_cache_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,20,20,20,20}" "{o,o,o,o,o}" "{entries,size_bytes,hits,misses,evictions}" _null_ _null_ gp_serialized_plan_cache_stats _null_ _null_ _null_ n a ));
+DESCR("size and counters of the cache of compressed plans dispatched by this session");
+
 /* get_ao_distribution(IN rel regclass, OUT segmentid int4, OUT tupcount int8) => SETOF pg_catalog.record */
 DATA(insert OID = 7169 ( get_ao_distribution  PGNSP PGUID 12 1 1000 0 0 f f f f f t v u 1 0 2249 "2205" "{2205,23,20}" "{i,o,o}" "{rel,segmentid,tupcount}" _null_ _null_ get_ao_distribution _null_ _null_ _null_ r a ));
 DESCR("show append only table tuple distribution across segment databases");
@@ -559,6 +575,14 @@ DESCR("enables transformations in the optimizer");
 DATA(insert OID = 6089 ( gp_opt_version  PGNSP PGUID 12 1 0 0 0 f f f f t f i s 0 0 25 "" _null_ _null_ _null_ _null_ _null_ gp_opt_version _null_ _null_ _null_ n a ));
 DESCR("Returns the optimizer and gpos library versions");
 
+/* gp_opt_mdcache_stats(OUT entries int8, OUT size_bytes int8, OUT hits int8, OUT misses int8, OUT evictions int8, OUT invalidations int8, OUT resets int8) => pg_catalog.record */
+DATA(insert OID = 5069 ( gp_opt_mdcache_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,20,20,20,20,20,20}" "{o,o,o,o,o,o,o}" "{entries,size_bytes,hits,misses,evictions,invalidations,resets}" _null_ _null_ gp_opt_mdcache_stats _null_ _null_ _null_ n a ));
+DESCR("size and counters of the optimizer metadata cache of this backend");
+
+/* gp_opt_plan_cache_stats(OUT entries int8, OUT size_bytes int8, OUT hits int8, OUT misses int8, OUT evictions int8) => pg_catalog.record */
+DATA(insert OID = 5071 ( gp_opt_plan_cache_stats  PGNSP PGUID 12 1 0 0 0 f f f f f f v r 0 0 2249 "" "{20,20,20,20,20}" "{o,o,o,o,o}" "{entries,size_bytes,hits,misses,evictions}" _null_ _null_ gp_opt_plan_cache_stats _null_ _null_ _null_ n a ));
+DESCR("size and counters of the GPORCA plan cache of this backend");
+
 
   /* functions for the complex data type */
 /* complex_in(cstring) => complex */
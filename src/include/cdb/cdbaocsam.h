@@ -71,6 +71,42 @@ typedef struct AOCSInsertDescData
 
 typedef AOCSInsertDescData *AOCSInsertDesc;
 
+/*
+ * Rows of an AOCS scan decoded a batch at a time, see aocs_getnext_batch().
+ *
+ * Values are kept column by column.  Only the projected columns have arrays,
+ * and rows hidden by the visibility map are left out.
+ */
+typedef struct AOCSColumnBatch
+{
+	int			natts;		/* length of values and isnull */
+	int			maxrows;
+	int			nrows;		/* rows in the batch */
+	int			next;		/* next row for aocs_getnext() to return */
+
+	Datum	  **values;		/* [attno][row], NULL if attno isn't projected */
+	bool	  **isnull;
+	AOTupleId  *tids;		/* [row] */
+} AOCSColumnBatch;
+
+/*
+ * Maximum rows per batch.  Scans of wide tables get fewer, to keep the
+ * column arrays of a batch within AOCS_BATCH_MAX_BYTES.
+ */
+#define AOCS_BATCH_MAX_ROWS		1024
+#define AOCS_BATCH_MAX_BYTES	(1024 * 1024)
+
+/*
+ * A "column op constant" qual of a scan, checked against the min/max zone
+ * maps of the block directory to skip blocks, see aocs_set_zone_keys().
+ */
+typedef struct AOCSZoneKey
+{
+	int			attno;		/* column number, starting from 0 */
+	StrategyNumber strategy;	/* btree strategy of the operator */
+	int64		value;		/* see AppendOnlyBlockDirectory_ZoneValue() */
+} AOCSZoneKey;
+
 /*
  * used for scan of append only relations using BufferedRead and VarBlocks
  */
@@ -126,6 +162,20 @@ typedef struct AOCSScanDescData
 
 	AppendOnlyVisimap visibilityMap;
 
+	/* Rows decoded ahead and returned one at a time by aocs_getnext() */
+	AOCSColumnBatch *batch;
+
+	/*
+	 * Quals to skip blocks with, and the block directory holding the zone
+	 * maps of their columns. NULL if the scan doesn't skip blocks.
+	 */
+	AOCSZoneKey *zoneKeys;
+	int			numZoneKeys;
+	AppendOnlyBlockDirectory *zoneDirectory;
+
+	/* I/O counters of all the columns for EXPLAIN ANALYZE, or NULL */
+	BufferedReadStats *readStats;
+
 }	AOCSScanDescData;
 
 typedef AOCSScanDescData *AOCSScanDesc;
@@ -208,10 +258,15 @@ extern AOCSScanDesc aocs_beginrangescan(Relation relation, Snapshot snapshot,
 		int *segfile_no_arr, int segfile_count,
 	TupleDesc relationTupleDesc, bool *proj);
 
+extern void aocs_set_zone_keys(AOCSScanDesc scan, AOCSZoneKey *keys, int nkeys);
+extern void aocs_set_read_stats(AOCSScanDesc scan, BufferedReadStats *stats);
 extern void aocs_rescan(AOCSScanDesc scan);
 extern void aocs_endscan(AOCSScanDesc scan);
 
 extern bool aocs_getnext(AOCSScanDesc scan, ScanDirection direction, TupleTableSlot *slot);
+extern AOCSColumnBatch *aocs_batch_init(AOCSScanDesc scan, int maxrows);
+extern void aocs_batch_finish(AOCSColumnBatch *batch);
+extern int aocs_getnext_batch(AOCSScanDesc scan, ScanDirection direction, AOCSColumnBatch *batch);
 extern AOCSInsertDesc aocs_insert_init(Relation rel, int segno, bool update_mode);
 extern Oid aocs_insert_values(AOCSInsertDesc idesc, Datum *d, bool *null, AOTupleId *aoTupleId);
 static inline Oid aocs_insert(AOCSInsertDesc idesc, TupleTableSlot *slot)
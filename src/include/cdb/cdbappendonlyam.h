@@ -221,6 +221,23 @@ typedef struct AppendOnlyScanDescData
 	 */ 
 	AppendOnlyVisimap visibilityMap;
 
+	/* I/O counters for EXPLAIN ANALYZE, or NULL */
+	BufferedReadStats *readStats;
+
+	/*
+	 * Set by VACUUM compaction with appendonly_set_block_copy(). Varblocks
+	 * whose rows are all visible are copied, still compressed, into
+	 * blockCopyDesc. If blockCopyReturnTuples is set, the rows of a copied
+	 * block are returned anyway, with blockCopied set, so that the caller
+	 * can make index entries for their new TIDs. Otherwise they are skipped.
+	 */
+	AppendOnlyInsertDesc blockCopyDesc;
+	bool		blockCopyReturnTuples;
+	bool		blockCopied;		/* was the current block copied? */
+	int64		blockCopyRowNumDelta;	/* new minus old row number */
+	int64		blockCopyCount;		/* number of blocks copied */
+	int64		blockCopyRowCount;	/* number of rows in them */
+
 }	AppendOnlyScanDescData;
 
 typedef AppendOnlyScanDescData *AppendOnlyScanDesc;
@@ -335,6 +352,10 @@ extern AppendOnlyScanDesc appendonly_beginrangescan(Relation relation,
 		Snapshot appendOnlyMetaDataSnapshot, 
 		int *segfile_no_arr, int segfile_count,
 		int nkeys, ScanKey keys);
+extern void appendonly_set_read_stats(AppendOnlyScanDesc scan, BufferedReadStats *stats);
+extern void appendonly_set_block_copy(AppendOnlyScanDesc scan,
+									  AppendOnlyInsertDesc insertDesc,
+									  bool returnTuples);
 extern void appendonly_rescan(AppendOnlyScanDesc scan, ScanKey key);
 extern void appendonly_endscan(AppendOnlyScanDesc scan);
 extern bool appendonly_getnext(AppendOnlyScanDesc scan,
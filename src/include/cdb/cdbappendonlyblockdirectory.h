@@ -21,6 +21,7 @@
 
 extern int gp_blockdirectory_entry_min_range;
 extern int gp_blockdirectory_minipage_size;
+extern bool gp_appendonly_zone_maps;
 
 typedef struct AppendOnlyBlockDirectoryEntry
 {
@@ -48,6 +49,33 @@ typedef struct MinipageEntry
 	int64 rowCount;
 } MinipageEntry;
 
+/*
+ * Min/max summary ("zone map") of the values of one column in the blocks
+ * covered by a minipage entry, for the types where
+ * AppendOnlyBlockDirectory_ZoneSupportedType() is true. The values are
+ * those returned by AppendOnlyBlockDirectory_ZoneValue(). Nulls are not
+ * summarized; a zone of nulls only has minValue > maxValue.
+ *
+ * lastRowNum is the last row number summarized, or 0 if the entry has no
+ * usable summary (the type is not supported, the blocks were written before
+ * the block directory existed, or by an older version).
+ */
+typedef struct MinipageZone
+{
+	int64 minValue;
+	int64 maxValue;
+	int64 lastRowNum;
+} MinipageZone;
+
+/*
+ * Minipage versions. A version 1 minipage carries an array of nEntry
+ * MinipageZones right after its entries. Servers without zone map support
+ * don't check the version and can't read such minipages, so version 1 is
+ * only written when gp_appendonly_zone_maps is on.
+ */
+#define MINIPAGE_VERSION_ORIGINAL	0
+#define MINIPAGE_VERSION_ZONES		1
+
 /*
  * Define a varlena type for a minipage.
  */
@@ -71,6 +99,9 @@ typedef struct MinipagePerColumnGroup
 	Minipage *minipage;
 	uint32 numMinipageEntries;
 	ItemPointerData tupleTid;
+
+	/* Zone of each entry in the minipage */
+	MinipageZone *zones;
 } MinipagePerColumnGroup;
 
 /*
@@ -166,6 +197,12 @@ extern bool AppendOnlyBlockDirectory_GetEntry(
 	AOTupleId 						*aoTupleId,
 	int                             columnGroupNo,
 	AppendOnlyBlockDirectoryEntry	*directoryEntry);
+extern bool AppendOnlyBlockDirectory_GetEntryZone(
+	AppendOnlyBlockDirectory		*blockDirectory,
+	AOTupleId 						*aoTupleId,
+	int                             columnGroupNo,
+	AppendOnlyBlockDirectoryEntry	*directoryEntry,
+	MinipageZone					*zone);
 extern void AppendOnlyBlockDirectory_Init_forInsert(
 	AppendOnlyBlockDirectory *blockDirectory,
 	Snapshot appendOnlyMetaDataSnapshot,
@@ -199,6 +236,14 @@ extern bool AppendOnlyBlockDirectory_InsertEntry(
 	int64 fileOffset,
 	int64 rowCount,
 	bool addColAction);
+extern bool AppendOnlyBlockDirectory_InsertEntryWithZone(
+	AppendOnlyBlockDirectory *blockDirectory,
+	int columnGroupNo,
+	int64 firstRowNum,
+	int64 fileOffset,
+	int64 rowCount,
+	const MinipageZone *zone,
+	bool addColAction);
 extern bool AppendOnlyBlockDirectory_addCol_InsertEntry(
 	AppendOnlyBlockDirectory *blockDirectory,
 	int columnGroupNo,
@@ -218,6 +263,10 @@ extern void AppendOnlyBlockDirectory_End_forSearch(
 	AppendOnlyBlockDirectory *blockDirectory);
 extern void AppendOnlyBlockDirectory_End_addCol(
 	AppendOnlyBlockDirectory *blockDirectory);
+extern bool AppendOnlyBlockDirectory_ZoneSupportedType(Oid typid);
+extern int64 AppendOnlyBlockDirectory_ZoneValue(Oid typid, Datum value);
+extern void AppendOnlyBlockDirectory_ZoneReset(MinipageZone *zone);
+extern void AppendOnlyBlockDirectory_ZoneAdd(MinipageZone *zone, int64 value);
 extern void AppendOnlyBlockDirectory_DeleteSegmentFile(
 	Relation aoRel,
 		Snapshot snapshot,
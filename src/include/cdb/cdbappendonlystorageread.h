@@ -97,6 +97,12 @@ typedef struct AppendOnlyStorageReadCurrent
 	 * The compressed length of the content.
 	 */
 	int32		compressedLen;
+
+	/*
+	 * The whole small content block in the read buffer, once one of the
+	 * content routines has fetched it.  NULL until then.
+	 */
+	uint8	   *blockBuffer;
 } AppendOnlyStorageReadCurrent;
 
 /*
@@ -219,6 +225,8 @@ extern int64 AppendOnlyStorageRead_CurrentHeaderOffsetInFile(AppendOnlyStorageRe
 extern int64 AppendOnlyStorageRead_CurrentCompressedLen(AppendOnlyStorageRead *storageRead);
 extern int64 AppendOnlyStorageRead_OverallBlockLen(AppendOnlyStorageRead *storageRead);
 extern uint8 *AppendOnlyStorageRead_GetBuffer(AppendOnlyStorageRead *storageRead);
+extern uint8 *AppendOnlyStorageRead_GetStoredContent(AppendOnlyStorageRead *storageRead,
+								 int32 *storedLen);
 extern void AppendOnlyStorageRead_Content(AppendOnlyStorageRead *storageRead,
 							  uint8 *contentOut, int32 contentLen);
 extern void AppendOnlyStorageRead_SkipCurrentBlock(AppendOnlyStorageRead *storageRead);
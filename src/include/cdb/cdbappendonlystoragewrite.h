@@ -230,6 +230,13 @@ extern void AppendOnlyStorageWrite_Content(AppendOnlyStorageWrite *storageWrite,
 							   int32 contentLen,
 							   int executorBlockKind,
 							   int rowCount);
+extern void AppendOnlyStorageWrite_CopyStoredContent(AppendOnlyStorageWrite *storageWrite,
+										 uint8 *storedContent,
+										 int32 storedLen,
+										 int32 contentLen,
+										 bool isCompressed,
+										 int executorBlockKind,
+										 int rowCount);
 extern void AppendOnlyStorageWrite_SetFirstRowNum(AppendOnlyStorageWrite *storageWrite,
 									  int64 firstRowNum);
 
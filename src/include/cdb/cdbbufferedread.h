@@ -18,8 +18,22 @@
 #ifndef CDBBUFFEREDREAD_H
 #define CDBBUFFEREDREAD_H
 
+#include "portability/instr_time.h"
 #include "storage/fd.h"
 
+/*
+ * I/O counters of a BufferedRead, for EXPLAIN ANALYZE.  Several BufferedReads
+ * (e.g. the columns of an AOCS scan) may add to the same counters.
+ */
+typedef struct BufferedReadStats
+{
+	int64				reads;		/* large reads done */
+	int64				readBytes;	/* bytes read */
+	int64				prefetches;	/* read-ahead requests issued */
+	int64				prefetchBytes;	/* bytes requested to be read ahead */
+	instr_time			stallTime;	/* time spent waiting in the large reads */
+} BufferedReadStats;
+
 typedef struct BufferedRead
 {
 	/*
@@ -76,6 +90,23 @@ typedef struct BufferedRead
 	bool				haveTemporaryLimitInEffect;
 	int64				temporaryLimitFileLen;
 
+	/*
+	 * Read-ahead.  While the current large read is being consumed, the kernel
+	 * is asked to bring in up to prefetchLen bytes that follow it, so that the
+	 * next large reads do not have to wait for the disk.  The window is
+	 * refilled once half of it has been read.
+	 */
+	int32				prefetchLen;
+	int64				prefetchPosition;
+							/*
+							 * The end of the range already requested.
+							 */
+
+	BufferedReadStats	*stats;
+							/*
+							 * Where to count the i/o, or NULL.
+							 */
+
 } BufferedRead;
 
 /*
@@ -101,6 +132,20 @@ extern void BufferedReadInit(
     int32                maxLargeReadLen,
     char				 *relationName);
 
+/*
+ * Set the read-ahead window of BufferedRead.  Zero turns read-ahead off.
+ */
+extern void BufferedReadSetPrefetch(
+    BufferedRead         *bufferedRead,
+    int32                prefetchLen);
+
+/*
+ * Count the i/o of BufferedRead in stats, which may be NULL.
+ */
+extern void BufferedReadSetStats(
+    BufferedRead         *bufferedRead,
+    BufferedReadStats    *stats);
+
 /*
  * Takes an open file handle for the next file.
  */
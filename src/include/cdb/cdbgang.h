@@ -50,7 +50,24 @@ extern int host_segments;
 extern int ic_htab_size;
 
 extern MemoryContext GangContext;
-extern Gang *CurrentGangCreating;
+extern List *CurrentGangsCreating;
+
+/*
+ * How the QEs of the gangs of this session were obtained, shown by
+ * gp_qe_pool_stats().
+ */
+typedef struct QEPoolStats
+{
+	int64		reused;			/* taken from the idle QEs */
+	int64		started;		/* started for a gang */
+	int64		prestarted;		/* started to fill the pool, included in
+								 * started */
+	int64		allocations;	/* gang creations, the gangs of a plan
+								 * count once */
+	double		allocation_time;	/* time spent creating gangs, in ms */
+} QEPoolStats;
+
+extern QEPoolStats qePoolStats;
 
 /*
  * cdbgang_createGang:
@@ -63,6 +80,15 @@ extern Gang *CurrentGangCreating;
 extern Gang *
 cdbgang_createGang(List *segments, SegmentType segmentType);
 
+/*
+ * cdbgang_createGangs:
+ *
+ * Like cdbgang_createGang(), for several gangs at once.  The QEs of all the
+ * gangs are connected concurrently.
+ */
+extern void
+cdbgang_createGangs(int ngangs, List **segments, SegmentType *segmentTypes, Gang **gangs);
+
 extern const char *gangTypeToString(GangType type);
 
 extern void setupCdbProcessList(ExecSlice *slice);
@@ -70,9 +96,11 @@ extern void setupCdbProcessList(ExecSlice *slice);
 extern List *getCdbProcessesForQD(int isPrimary);
 
 extern Gang *AllocateGang(struct CdbDispatcherState *ds, enum GangType type, List *segments);
+extern void AllocateGangs(struct CdbDispatcherState *ds, int ngangs, enum GangType *types,
+						  List **segments, Gang **gangs);
 extern void RecycleGang(Gang *gp, bool forceDestroy);
 extern void DisconnectAndDestroyAllGangs(bool resetSession);
-extern void DisconnectAndDestroyUnusedQEs(void);
+extern void DisconnectAndDestroyUnusedQEs(bool keepPool);
 
 extern void CheckForResetSession(void);
 extern void ResetAllGangs(void);
@@ -124,6 +152,6 @@ typedef struct CdbProcess
 	int contentid;
 } CdbProcess;
 
-typedef Gang *(*CreateGangFunc)(List *segments, SegmentType segmentType);
+typedef void (*CreateGangsFunc)(int ngangs, List **segments, SegmentType *segmentTypes, Gang **gangs);
 
 #endif   /* _CDBGANG_H_ */
@@ -30,6 +30,19 @@ typedef enum
 	REDUCE_JUMP_HASH
 } CdbHashReduce;
 
+/*
+ * Hash functions that are evaluated inline, instead of through the
+ * function manager. See cdbhash_fnkind_for_func().
+ */
+typedef enum
+{
+	CDBHASH_FN_GENERIC = 0,		/* call the hash function through fmgr */
+	CDBHASH_FN_INT2,			/* hashint2 */
+	CDBHASH_FN_INT4,			/* hashint4, also used for date */
+	CDBHASH_FN_INT8,			/* hashint8 */
+	CDBHASH_FN_OID				/* hashoid, hashenum */
+} CdbHashFnKind;
+
 /*
  * Structure that holds Greenplum Database hashing information.
  */
@@ -43,6 +56,7 @@ typedef struct CdbHash
 
 	int			natts;
 	FmgrInfo   *hashfuncs;
+	CdbHashFnKind *fnkinds;		/* inline kernel to use for each attribute */
 } CdbHash;
 
 /*
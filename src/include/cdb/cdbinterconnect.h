@@ -183,11 +183,61 @@ struct ICBuffer
 	uint32 nRetry;
 	int32 unackQueueRingSlot;
 
+	/*
+	 * bbr flow control: the connection's delivered count and the time of
+	 * its last delivery, when this buffer was sent.  See ICBbrState.
+	 */
+	uint64 delivered;
+	uint64 deliveredTime;
+
 	/* real data */
 	icpkthdr pkt[0];
 };
 
 
+/* number of round trips the bbr bottleneck bandwidth filter covers */
+#define IC_BBR_BW_FILTER_ROUNDS 10
+
+/*
+ * ICBbrState
+ * 		Per-connection state of the "bbr" flow control method (UDP only).
+ *
+ * The sender models the path as a bottleneck bandwidth and a minimal round
+ * trip time, and paces packets out at that bandwidth instead of reacting to
+ * losses.  Times are in microseconds, bandwidths in packets per second.
+ */
+typedef struct ICBbrState
+{
+	int			mode;			/* BBR_STARTUP, BBR_DRAIN or BBR_PROBE_BW */
+	float		cwnd;			/* congestion window, in packets */
+	float		pacingGain;
+
+	/* windowed max of the delivery rate samples, one slot per round trip */
+	float		bw;
+	float		bwSamples[IC_BBR_BW_FILTER_ROUNDS];
+
+	/* windowed min of the rtt samples */
+	uint64		minRtt;
+	uint64		minRttStamp;
+
+	/* delivery accounting, for the rate samples */
+	uint64		delivered;
+	uint64		deliveredTime;
+	uint64		nextRoundDelivered;
+	uint32		round;
+
+	/* startup: rounds the bandwidth didn't grow, and the bandwidth then */
+	int			fullBwCount;
+	float		fullBw;
+
+	/* probe_bw: position in the pacing gain cycle */
+	int			cycleIndex;
+	uint64		cycleStamp;
+
+	/* pacing: earliest time the next packet may be sent */
+	uint64		nextSendTime;
+} ICBbrState;
+
 /*
  * Structure used for keeping track of a pt-to-pt connection between two
  * Cdb Entities (either QE or QD).
@@ -281,6 +331,29 @@ struct MotionConn
 	int			pkt_q_tail;
 	uint8		**pkt_q;
 
+	/*
+	 * used by the receiver, UDP only: ready ring of the motion node this
+	 * connection belongs to.  See ICReadyRing in ic_udpifc.c.
+	 */
+	struct ICReadyRing *readyRing;
+
+	/*
+	 * UDP only: shared memory ring used instead of the socket when the peer
+	 * runs on the same host, or NULL.  See ICShmRing in ic_udpifc.c.
+	 *
+	 * A sender's ring is only offered until shmAccepted is set, shmDeclined
+	 * is set when the receiver turns it down.  A receiver's ring is set by
+	 * the rx thread when it accepts the offer, which also bumps the
+	 * numShmConns of the motion node that shmConnCount points to.  shmNext
+	 * is the next ring position the receiver moves into pkt_q.
+	 */
+	struct ICShmRing *shmRing;
+	uint32		shmSlots;
+	uint32		shmNext;
+	bool		shmAccepted;
+	bool		shmDeclined;
+	int		   *shmConnCount;
+
 	uint64 stat_total_ack_time;
 	uint64 stat_count_acks;
 	uint64 stat_max_ack_time;
@@ -289,6 +362,47 @@ struct MotionConn
 	uint64 stat_max_resent;
 	uint64 stat_count_dropped;
 
+	/*
+	 * used by the sender, for gp_interconnect_compression.
+	 *
+	 * compress_skip is the number of packets to send uncompressed before
+	 * trying again, after compression didn't pay off; compress_backoff is
+	 * the current length of that back-off.
+	 */
+	int			compress_skip;
+	int			compress_backoff;
+
+	/* packets sent compressed, and the payload bytes that saved */
+	uint64		stat_compressed_pkts;
+	uint64		stat_compress_saved_bytes;
+
+	/* used by the sender, for the "bbr" gp_interconnect_fc_method */
+	ICBbrState	bbr;
+
+	/*
+	 * Payload bytes of data packets, before compression and as they went
+	 * over the wire.  Counted by the receiver.
+	 */
+	uint64		stat_raw_bytes;
+	uint64		stat_wire_bytes;
+
+	/*
+	 * Runtime filter of the connection, see execRuntimeFilter.c.  The sender
+	 * keeps the one its receiver sent back; a UDP receiver keeps the one it
+	 * couldn't send yet, because no packet has come from the sender so far.
+	 * Allocated in InterconnectContext.
+	 */
+	char	   *runtimeFilter;
+	int			runtimeFilterLen;
+
+	/*
+	 * TCP only: the runtime filter message a receiver is still writing, or a
+	 * sender is still reading, and how much of it went through so far.
+	 */
+	char	   *runtimeFilterMsg;
+	int			runtimeFilterMsgLen;
+	int			runtimeFilterMsgDone;
+
 	/*
 	 * used by the sender.
 	 *
@@ -331,6 +445,21 @@ typedef struct ChunkTransportStateEntry
 
     int         scanStart;
 
+	/* UDP only: routes with a packet ready, pushed by the rx thread */
+	struct ICReadyRing *readyRing;
+
+	/*
+	 * UDP only: number of incoming connections using a shared memory ring,
+	 * bumped by the rx thread with ic_control_info.lock held
+	 */
+	int			numShmConns;
+
+	/*
+	 * Number of connections with a runtime filter: received by a sender, or
+	 * still to be sent by a receiver.
+	 */
+	int			numRuntimeFilters;
+
 	/* slice table entries */
 	struct ExecSlice *sendSlice;
 	struct ExecSlice *recvSlice;
@@ -377,6 +506,12 @@ typedef struct ChunkSorterEntry
 	 */
 	htup_fifo	ready_tuples;
 
+	/*
+	 * Received columnar batches (TupleBatch) not yet consumed, for an
+	 * order-preserving motion node.  See MotionNodeEntry.ready_batches.
+	 */
+	List	   *ready_batches;
+
 	/*
 	 * Flag recording whether end-of-stream has been reported from the source.
 	 */
@@ -412,12 +547,28 @@ typedef struct MotionNodeEntry
 	 */
 	SerTupInfo      ser_tup_info;
 
+	/*
+	 * Columnar batches being filled for each outgoing route, when
+	 * gp_motion_batch_size is set.  The last entry is used for broadcasts.
+	 * NULL until the first tuple is sent.
+	 */
+	TupleBatch    **send_batches;
+	int             num_send_batches;
+
 	/*
 	 * If preserve_order is false, this is used to hold completed tuples that
 	 * have not yet been consumed.  If preserve_order is true, this is NULL.
 	 */
 	htup_fifo       ready_tuples;
 
+	/*
+	 * If preserve_order is false, this holds the received columnar batches
+	 * (TupleBatch) that have not been consumed yet.  A sender batches either
+	 * all of its tuples or none, so the order between these and ready_tuples
+	 * doesn't matter.
+	 */
+	List           *ready_batches;
+
 	/*
 	 * Variable that records the total number of senders to this motion node.
 	 * This is expected to always be (number of qExecs).
@@ -525,6 +676,7 @@ typedef struct ChunkTransportState
 	TupleChunkListItem (*RecvTupleChunkFromAny)(struct ChunkTransportState *transportStates, int16 motNodeID, int16 *srcRoute);
 	void (*doSendStopMessage)(struct ChunkTransportState *transportStates, int16 motNodeID);
 	void (*SendEos)(struct ChunkTransportState *transportStates, int motNodeID, TupleChunkListItem tcItem);
+	void (*doSendRuntimeFilter)(struct ChunkTransportState *transportStates, int16 motNodeID, const char *data, int len);
 } ChunkTransportState;
 
 extern void dumpICBufferList(ICBufferList *list, const char *fname);
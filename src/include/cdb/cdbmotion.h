@@ -111,12 +111,14 @@ SendEndOfStream(MotionLayerState       *mlStates,
  * To get an result for unordered receive (we used to provide a separate
  * RecvTuple() function, set the srcRoute to ANY_ROUTE
  *
- * Returns the next tuple, or NULL if end-of-stream was reached.
+ * Stores the next tuple into 'slot' and returns it, or returns NULL if
+ * end-of-stream was reached.
  */
-extern GenericTuple RecvTupleFrom(MotionLayerState *mlStates,
-								  ChunkTransportState *transportStates,
-								  int16 motNodeID,
-								  int16 srcRoute);
+extern TupleTableSlot *RecvTupleFrom(MotionLayerState *mlStates,
+									 ChunkTransportState *transportStates,
+									 int16 motNodeID,
+									 int16 srcRoute,
+									 TupleTableSlot *slot);
 
 extern void SendStopMessage(MotionLayerState *mlStates,
 							ChunkTransportState *transportStates,
@@ -171,6 +171,7 @@ void cdbcomponent_updateCdbComponents(void);
  * This routine is also called from the sigalarm signal handler (hopefully that is safe to do).
  */
 void cdbcomponent_cleanupIdleQEs(bool includeWriter);
+void cdbcomponent_trimIdleQEs(int keepReaders);
 
 CdbComponentDatabaseInfo * cdbcomponent_getComponentInfo(int contentId);
 
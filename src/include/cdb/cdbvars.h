@@ -156,6 +156,17 @@ extern int qdPostmasterPort;
 /*How many gangs to keep around from stmt to stmt.*/
 extern int			gp_cached_gang_threshold;
 
+/*
+ * gp_qe_pool_size
+ *
+ * How many reader QEs per segment a session keeps started, on top of the
+ * writer, so that the next queries don't have to wait for new QEs.  They
+ * are started along with the gangs of a query, and survive the release of
+ * idle gangs (gp_vmem_idle_resource_timeout) until gp_qe_pool_idle_timeout.
+ */
+extern int			gp_qe_pool_size;
+extern int			gp_qe_pool_idle_timeout;
+
 /*
  * gp_reject_percent_threshold
  *
@@ -342,6 +353,7 @@ typedef enum GpVars_Interconnect_Method
 {
 	INTERCONNECT_FC_METHOD_CAPACITY = 0,
 	INTERCONNECT_FC_METHOD_LOSS = 2,
+	INTERCONNECT_FC_METHOD_BBR = 3,
 } GpVars_Interconnect_Method;
 
 extern int Gp_interconnect_fc_method;
@@ -395,6 +407,41 @@ extern bool gp_interconnect_aggressive_retry; /* fast-track app-level retry */
  */
 extern bool gp_interconnect_full_crc;
 
+/*
+ * Parameter gp_interconnect_batch_syscalls
+ *
+ * Send and receive UDP-IC packets in batches with sendmmsg()/recvmmsg(),
+ * where the platform supports it, instead of one syscall per packet.
+ */
+extern bool gp_interconnect_batch_syscalls;
+
+/*
+ * Parameter gp_interconnect_compression
+ *
+ * Compress the payload of UDP-IC data packets with zstd, if the server was
+ * built with it.  Each connection stops compressing for a while when the
+ * data turns out not to be compressible.
+ */
+extern bool gp_interconnect_compression;
+
+/*
+ * Parameter gp_interconnect_local_shm
+ *
+ * Pass UDP-IC data packets between QEs on the same host through a ring in
+ * POSIX shared memory instead of the loopback socket.  Both ends pick the
+ * transport from the peer's address, so the setting must be the same in
+ * the whole gang; it is synced from the QD.
+ */
+extern bool gp_interconnect_local_shm;
+
+/*
+ * Parameter gp_interconnect_rx_spin_count
+ *
+ * Number of times a UDP-IC receiver polls for a wakeup from the rx thread
+ * before it goes to sleep on its latch.  0 disables spinning.
+ */
+extern int	gp_interconnect_rx_spin_count;
+
 /*
  * Parameter gp_interconnect_log_stats
  *
@@ -681,6 +728,9 @@ extern int gp_segworker_relative_priority;
 /*  Max size of dispatched plans; 0 if no limit */
 extern int gp_max_plan_size;
 
+/* Size of the cache of compressed dispatched plans; 0 disables it */
+extern int gp_serialized_plan_cache_size;
+
 /* The default number of batches to use when the hybrid hashed aggregation
  * algorithm (re-)spills in-memory groups to disk.
  */
@@ -695,6 +745,24 @@ extern bool		gp_statistics_use_fkeys;
 /* Analyze tools */
 extern int gp_motion_slice_noop;
 
+/*
+ * Parameter gp_motion_batch_size
+ *
+ * Number of rows that a Motion sender packs into one columnar batch, for
+ * Motions whose columns are all fixed-width pass-by-value types. 0 sends
+ * one tuple at a time.
+ */
+#define MAX_MOTION_BATCH_SIZE 8192
+extern int	gp_motion_batch_size;
+
+/*
+ * Parameter gp_motion_batch_compression
+ *
+ * Compress columnar Motion batches with zstd, if the server was built
+ * with it.
+ */
+extern bool gp_motion_batch_compression;
+
 /* Disable setting of hint-bits while reading db pages */
 extern bool gp_disable_tuple_hints;
 
@@ -212,6 +212,41 @@ extern void DeregisterReadInterest(ChunkTransportState *transportStates,
 								   int                  srcRoute,
 								   const char          *reason);
 
+/*
+ * GetMotionCompressionStats() returns the number of payload bytes received
+ * by a motion node, as they came over the wire and after decompression.  The
+ * two are the same unless gp_interconnect_compression was in use.
+ */
+extern void GetMotionCompressionStats(ChunkTransportState *transportStates,
+									  int16 motNodeID,
+									  uint64 *rawBytes,
+									  uint64 *wireBytes);
+
+/*
+ * Runtime filters travel from the receivers of a motion node back to its
+ * senders, see execRuntimeFilter.c.  MAX_RUNTIME_FILTER_MSG_SIZE bounds the
+ * size of one, so that it fits in a UDP control packet.
+ *
+ * SendMotionRuntimeFilter() sends one to all the senders of a motion node.
+ * On the sending side, GetMotionRuntimeFilterCount() returns the number of
+ * connections that got one so far, out of *numRoutes, and
+ * GetMotionRuntimeFilter() the one received on a route, or NULL.  SaveMotionRuntimeFilter() is for the
+ * transports, to keep one they received.
+ */
+#define MAX_RUNTIME_FILTER_MSG_SIZE (8192 + 1024)
+
+extern void SendMotionRuntimeFilter(ChunkTransportState *transportStates,
+									int16 motNodeID,
+									const char *data, int len);
+extern int	GetMotionRuntimeFilterCount(ChunkTransportState *transportStates,
+										int16 motNodeID, int *numRoutes);
+extern const char *GetMotionRuntimeFilter(ChunkTransportState *transportStates,
+										  int16 motNodeID, int route,
+										  int *len);
+extern void SaveMotionRuntimeFilter(ChunkTransportStateEntry *pEntry,
+									MotionConn *conn,
+									const char *data, int len);
+
 extern void readPacket(MotionConn *conn, ChunkTransportState *transportStates);
 
 /* 
@@ -321,6 +356,10 @@ extern void TeardownUDPIFCInterconnect(ChunkTransportState *transportStates,
 
 extern uint32 getActiveMotionConns(void);
 
+extern Size ICConnStatsShmemSize(void);
+extern void ICConnStatsShmemInit(void);
+extern void ICShmRingCleanup(void);
+
 extern char *format_sockaddr(struct sockaddr_storage *sa, char *buf, size_t len);
 
 #endif   /* ML_IPC_H */
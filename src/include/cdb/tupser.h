@@ -60,8 +60,38 @@ typedef struct SerTupInfo
 
 	/* true if tupdesc contains record types */
 	bool		has_record_types;
+
+	/*
+	 * true if every attribute is fixed-width and pass-by-value, so that
+	 * tuples can be sent in columnar batches (see TupleBatch).
+	 */
+	bool		batchable;
+
+	/*
+	 * Batch decoded by the last CvtChunksToTup() call, until the caller
+	 * collects it with TakeReceivedTupleBatch().
+	 */
+	struct TupleBatch *recv_batch;
 }	SerTupInfo;
 
+/*
+ * A batch of rows buffered by a Motion sender for one route, stored
+ * column-wise.  For each attribute, 'values' holds maxrows values of typlen
+ * bytes packed back to back, and 'nulls' holds a bitmap in which a set bit
+ * means the value is not null (same convention as heap tuples).
+ *
+ * The receiver decodes a batch into the same structure, and hands the rows
+ * out one at a time from position 'next'.
+ */
+typedef struct TupleBatch
+{
+	int			nrows;
+	int			maxrows;
+	int			next;			/* next row to return, receiver only */
+	char	  **values;
+	bits8	  **nulls;
+}	TupleBatch;
+
 /*
  * forward declaration to avoid #including cdbmotion.h here, which would create a circular
  * dependency
@@ -81,6 +111,24 @@ extern void SerializeRecordCacheIntoChunks(SerTupInfo *pSerInfo,
 										   TupleChunkList tcList,
 										   MotionConn *conn);
 
+/* Create an empty TupleBatch that can hold 'maxrows' rows */
+extern TupleBatch *CreateTupleBatch(SerTupInfo *pSerInfo, int maxrows);
+
+/* Free a TupleBatch */
+extern void DestroyTupleBatch(SerTupInfo *pSerInfo, TupleBatch *batch);
+
+/* Append a tuple to a batch, returns true if the batch is now full */
+extern bool AddTupleToBatch(TupleBatch *batch, TupleTableSlot *slot, SerTupInfo *pSerInfo);
+
+/* Convert a batch into chunks ready to send out, and empty it */
+extern void SerializeTupleBatch(TupleBatch *batch, SerTupInfo *pSerInfo, TupleChunkList tcList);
+
+/* Return the batch decoded by the last CvtChunksToTup() call, or NULL */
+extern TupleBatch *TakeReceivedTupleBatch(SerTupInfo *pSerInfo);
+
+/* Store the next row of a received batch into a slot, false when exhausted */
+extern bool StoreNextBatchedTuple(TupleBatch *batch, TupleTableSlot *slot, SerTupInfo *pSerInfo);
+
 /* Convert a tuple into chunks directly in a set of transport buffers */
 extern int SerializeTuple(TupleTableSlot *tuple, SerTupInfo *pSerInfo, struct directTransportBuffer *b, TupleChunkList tcList, int16 targetRoute);
 
@@ -34,4 +34,17 @@
 #define PROGRESS_VACUUM_PHASE_TRUNCATE			5
 #define PROGRESS_VACUUM_PHASE_FINAL_CLEANUP		6
 
+/*
+ * Progress parameters for the compaction phase of VACUUM on append-only
+ * tables.  The tuple and block counters are for the segment file being
+ * compacted.
+ */
+#define PROGRESS_AO_COMPACTION_SEGNO				0
+#define PROGRESS_AO_COMPACTION_INSERT_SEGNO			1
+#define PROGRESS_AO_COMPACTION_SEGFILES_PROCESSED	2
+#define PROGRESS_AO_COMPACTION_TUPLES_TOTAL			3
+#define PROGRESS_AO_COMPACTION_TUPLES_SCANNED		4
+#define PROGRESS_AO_COMPACTION_TUPLES_MOVED			5
+#define PROGRESS_AO_COMPACTION_BLOCKS_COPIED		6
+
 #endif
@@ -204,6 +204,8 @@ typedef struct HashAggTable
 	uint64 num_spill_groups; /* number of spilled groups */
 	uint32 num_overflows; /* number of times hash table overflows */
 	uint32 num_expansions; /* number of times hash table is expanded */
+	uint64 spill_bytes; /* bytes written to spill files, uncompressed */
+	uint64 spill_disk_bytes; /* same, as stored on disk */
 
 	bool is_spilling; /* indicate that spilling happened for this batch. */
 	bool expandable;  /* hash table buckets still have space to grow */
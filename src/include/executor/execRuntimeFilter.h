@@ -0,0 +1,90 @@
+/*-------------------------------------------------------------------------
+ *
+ * execRuntimeFilter.h
+ *	  Runtime filters built from the inner side of a hash join, and checked
+ *	  by the scan or Motion feeding the outer side.
+ *
+ * Portions Copyright (c) 2012-Present Pivotal Software, Inc.
+ *
+ *
+ * IDENTIFICATION
+ *	    src/include/executor/execRuntimeFilter.h
+ *
+ *-------------------------------------------------------------------------
+ */
+#ifndef EXECRUNTIMEFILTER_H
+#define EXECRUNTIMEFILTER_H
+
+#include "fmgr.h"
+#include "lib/stringinfo.h"
+#include "nodes/execnodes.h"
+
+/*
+ * One join key of a runtime filter.
+ */
+typedef struct RuntimeFilterKey
+{
+	AttrNumber	attno;			/* column of the scan or Motion holding the
+								 * outer key */
+	FmgrInfo	hashfn;			/* outer hash function of the join operator */
+	bool		strict;			/* a null key can't join */
+
+	/*
+	 * Range of the inner keys, in the representation of
+	 * AppendOnlyBlockDirectory_ZoneValue().  Only kept when the types of both
+	 * sides support it.
+	 */
+	bool		hasRange;
+	ExprState  *innerExpr;		/* inner key, evaluated to get the range */
+	Oid			innerType;
+	Oid			outerType;
+	int64		minValue;
+	int64		maxValue;
+} RuntimeFilterKey;
+
+/*
+ * A runtime filter.  The Hash node adds the hash value of every tuple it
+ * inserts, and the inner key values to the ranges; the scan then rejects
+ * the rows that the hash join would reject anyway.
+ *
+ * The bloom filter is over the same hash value the hash join computes, so
+ * it is only used when all the join keys are columns of the scan.
+ *
+ * When the outer side comes from another slice, the filter goes to the
+ * receiving Motion instead, which sends it back to the sending slice once
+ * it is built.  The sending Motion checks its rows against it there.
+ */
+typedef struct RuntimeFilter
+{
+	int			nkeys;
+	RuntimeFilterKey *keys;
+
+	bool		ready;			/* built over the whole inner side */
+
+	bool		useBloom;
+	uint64	   *bloom;
+	uint32		bloomMask;		/* number of bits - 1 */
+	int64		ninserted;
+
+	struct MotionState *motion;	/* receiving Motion to send it to, or NULL */
+	bool		sent;
+
+	/* scan side counters, for EXPLAIN ANALYZE */
+	int64		nprobed;
+	int64		nrejected;
+	bool		disabled;		/* not selective enough to be worth it */
+} RuntimeFilter;
+
+extern bool gp_enable_runtime_filter;
+
+extern RuntimeFilter *ExecHashJoinCreateRuntimeFilter(HashJoinState *hjstate);
+extern void ExecRuntimeFilterReset(RuntimeFilter *filter);
+extern void ExecRuntimeFilterInsert(RuntimeFilter *filter, ExprContext *econtext,
+						uint32 hashvalue);
+extern void ExecRuntimeFilterFinish(RuntimeFilter *filter);
+extern bool ExecRuntimeFilterCheck(RuntimeFilter *filter, TupleTableSlot *slot);
+extern bool ExecRuntimeFilterSerialize(RuntimeFilter *filter, StringInfo buf);
+extern RuntimeFilter *ExecRuntimeFilterDeserialize(const char *data, int len);
+extern bool ExecRuntimeFilterMerge(RuntimeFilter *filter, RuntimeFilter *other);
+
+#endif   /* EXECRUNTIMEFILTER_H */
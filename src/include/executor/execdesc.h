@@ -289,6 +289,8 @@ typedef struct QueryDesc
 	Oid			es_lastoid;		/* oid of row inserted */
 	bool		extended_query;   /* simple or extended query protocol? */
 	char		*portal_name;	/* NULL for unnamed portal */
+	bool		plan_cached;	/* plan from a CachedPlan, may be dispatched
+								 * again unchanged */
 
 	QueryDispatchDesc *ddesc;
 
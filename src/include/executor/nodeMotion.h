@@ -24,4 +24,7 @@ extern void ExecReScanMotion(MotionState *node);
 
 extern void ExecSquelchMotion(MotionState *node);
 
+extern void ExecMotionSendRuntimeFilter(MotionState *node,
+							struct RuntimeFilter *filter);
+
 #endif   /* NODEMOTION_H */
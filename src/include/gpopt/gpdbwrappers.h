@@ -674,6 +674,24 @@ namespace gpdb {
 	// table has been changed?)
 	bool MDCacheNeedsReset(void);
 
+	// take the changes to individual metadata cache objects since last call
+	bool MDCacheTakeInvalidations(void);
+
+	// was the relation, type, operator, function etc. with this oid changed?
+	bool MDCacheOidInvalidated(Oid oid);
+
+	// were the statistics of a column changed?
+	bool MDCacheColStatsInvalidated(Oid relid, AttrNumber attno);
+
+	// was the cast between two types changed?
+	bool MDCacheCastInvalidated(Oid src_type, Oid dest_type);
+
+	// was any operator changed?
+	bool MDCacheOperatorsInvalidated(void);
+
+	// did the partitioning of any table change?
+	bool MDCachePartitionsInvalidated(void);
+
 	// returns true if a query cancel is requested in GPDB
 	bool IsAbortRequested(void);
 
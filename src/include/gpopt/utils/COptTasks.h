@@ -45,6 +45,11 @@ namespace gpopt
 	class ICostModel;
 }
 
+namespace gpmd
+{
+	class IMDCacheObject;
+}
+
 struct PlannedStmt;
 struct Query;
 struct List;
@@ -53,6 +58,7 @@ struct MemoryContextData;
 using namespace gpos;
 using namespace gpdxl;
 using namespace gpopt;
+using namespace gpmd;
 
 // context of optimizer input and output objects
 struct SOptContext
@@ -160,6 +166,18 @@ class COptTasks
 		static
 		void PrintMissingStatsWarning(CMemoryPool *mp, CMDAccessor *md_accessor, IMdIdArray *col_stats, MdidHashSet *phsmdidRel);
 
+		// drop the metadata cache entries affected by the catalog changes since last query
+		static
+		void InvalidateMDCache(CMemoryPool *mp);
+
+		// collect the cached relations whose partitions or column statistics changed
+		static
+		BOOL CollectInvalidatedRel(IMDCacheObject *md_obj, void *ptr);
+
+		// was the given metadata cache entry affected by the catalog changes?
+		static
+		BOOL IsMDCacheObjectInvalidated(IMDCacheObject *md_obj, void *ptr);
+
 	public:
 
 		// convert Query->DXL->LExpr->Optimize->PExpr->DXL
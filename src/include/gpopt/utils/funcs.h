@@ -21,6 +21,7 @@ extern "C"
 extern Datum DisableXform(PG_FUNCTION_ARGS);
 extern Datum EnableXform(PG_FUNCTION_ARGS);
 extern Datum LibraryVersion();
+extern Datum MDCacheStats(PG_FUNCTION_ARGS);
 
 }
 
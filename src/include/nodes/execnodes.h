@@ -1693,6 +1693,13 @@ typedef struct SeqScanState
 	/* extra state for AOCS scans */
 	bool	   *ss_aocs_proj;
 	int			ss_aocs_ncol;
+
+	/* i/o counters of AO/AOCS scans, kept for EXPLAIN ANALYZE */
+	struct BufferedReadStats *ss_ao_readstats;
+
+	/* runtime filters of hash joins above, see execRuntimeFilter.c */
+	List	   *ss_runtimefilters;
+	bool		ss_aocs_runtime_zones;	/* their ranges skip AOCS blocks */
 } SeqScanState;
 
 /* ----------------
@@ -2833,6 +2840,8 @@ typedef struct HashState
 	bool		hs_quit_if_hashkeys_null;	/* quit building hash table if hashkeys are all null */
 	bool		hs_hashkeys_null;	/* found an instance wherein hashkeys are all null */
 	/* hashkeys is same as parent's hj_InnerHashKeys */
+
+	struct RuntimeFilter *hs_runtimefilter;	/* filter for the outer scan, or NULL */
 } HashState;
 
 /* ----------------
@@ -2980,7 +2989,19 @@ typedef struct MotionState
 	struct CdbHash *cdbhash;	/* hash api object */
 	int			numHashSegments;	/* number of segments to use when calculating hash */
 
+	/*
+	 * Runtime filters sent back by the receivers, per route, and merged
+	 * for a broadcast.  See ExecMotionSendRuntimeFilter().
+	 */
+	int			numRoutes;
+	int			numRuntimeFiltersSeen;
+	struct RuntimeFilter **runtimeFilters;
+	struct RuntimeFilter *broadcastFilter;
+	int			numTuplesFiltered;	/* rejected by them */
+
 	/* For Motion recv */
+	struct RuntimeFilter *runtimeFilter;	/* of a hash join above, sent to
+											 * the senders; or NULL */
 	int			routeIdNext;	/* for a sorted motion node, the routeId to get next (same as
 								 * the routeId last returned ) */
 	bool		tupleheapReady; /* for a sorted motion node, false until we have a tuple from
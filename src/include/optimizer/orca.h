@@ -18,15 +18,18 @@
 #define ORCA_H
 
 #include "pg_config.h"
+#include "fmgr.h"
 
 #ifdef USE_ORCA
 
 extern PlannedStmt * optimize_query(Query *parse, ParamListInfo boundParams);
+extern void ResetOrcaPlanCache(void);
+extern Datum OrcaPlanCacheStats(PG_FUNCTION_ARGS);
 
 #else
 
 /* Keep compilers quiet in case the build used --disable-orca */
-static PlannedStmt *
+static inline PlannedStmt *
 optimize_query(Query *parse, ParamListInfo boundParams)
 {
 	Assert(false);
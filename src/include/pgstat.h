@@ -794,7 +794,8 @@ typedef enum WaitClass
 typedef enum ProgressCommandType
 {
 	PROGRESS_COMMAND_INVALID,
-	PROGRESS_COMMAND_VACUUM
+	PROGRESS_COMMAND_VACUUM,
+	PROGRESS_COMMAND_AO_COMPACTION
 } ProgressCommandType;
 
 #define PGSTAT_NUM_PROGRESS_PARAM	10
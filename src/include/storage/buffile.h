@@ -52,6 +52,7 @@ extern void BufFileTell(BufFile *file, int *fileno, off_t *offset);
 extern int	BufFileSeekBlock(BufFile *file, int64 blknum);
 extern void BufFileFlush(BufFile *file);
 extern int64 BufFileGetSize(BufFile *buffile);
+extern int64 BufFileGetDiskSize(BufFile *buffile);
 
 extern const char *BufFileGetFilename(BufFile *buffile);
 
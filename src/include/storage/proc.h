@@ -202,6 +202,12 @@ struct PGPROC
 	void		*movetoResSlot; /* the resource group slot move to, valid only on QD */
 	Oid			movetoGroupId;  /* the resource group id move to */
 
+	/*
+	 * Vmem chunks this process reserved ahead of need, still counted in the
+	 * segment vmem.  See vmem_tracker.c.
+	 */
+	int32		spareVmemChunks;
+
 	/* Support for group XID clearing. */
 	/* true, if member of ProcArray group waiting for XID clear */
 	bool		procArrayGroupMember;
@@ -489,6 +489,8 @@ extern Datum float84ge(PG_FUNCTION_ARGS);
 extern Datum width_bucket_float8(PG_FUNCTION_ARGS);
 extern Datum pg_highest_oid(PG_FUNCTION_ARGS); /* MPP */
 extern Datum gp_distributed_xid(PG_FUNCTION_ARGS); /* MPP */
+extern Datum gp_qe_pool_stats(PG_FUNCTION_ARGS); /* MPP */
+extern Datum gp_serialized_plan_cache_stats(PG_FUNCTION_ARGS); /* MPP */
 
 /* dbsize.c */
 extern Datum pg_tablespace_size_oid(PG_FUNCTION_ARGS);
@@ -1408,6 +1410,10 @@ extern Datum pg_resgroup_check_move_query(PG_FUNCTION_ARGS);
 /* utils/gdd/gddfuncs.c */
 extern Datum gp_dist_wait_status(PG_FUNCTION_ARGS);
 
+/* cdb/motion/ic_udpifc.c */
+extern Datum gp_get_interconnect_conn_stats(PG_FUNCTION_ARGS);
+extern Datum gp_get_interconnect_syscall_stats(PG_FUNCTION_ARGS);
+
 /* utils/adt/matrix.c */
 extern Datum matrix_add(PG_FUNCTION_ARGS);
 
@@ -1462,6 +1468,8 @@ extern Datum enable_xform(PG_FUNCTION_ARGS);
 
 /* Optimizer's version */
 extern Datum gp_opt_version(PG_FUNCTION_ARGS);
+extern Datum gp_opt_mdcache_stats(PG_FUNCTION_ARGS);
+extern Datum gp_opt_plan_cache_stats(PG_FUNCTION_ARGS);
 
 /* query_metrics.c */
 extern Datum gp_instrument_shmem_summary(PG_FUNCTION_ARGS);
@@ -16,6 +16,7 @@
 #define DATUMSTREAM_H
 
 #include "catalog/pg_attribute.h"
+#include "cdb/cdbappendonlyblockdirectory.h"
 #include "utils/datumstreamblock.h"
 
 /*
@@ -65,6 +66,13 @@ typedef struct DatumStreamWrite
 
 	DatumStreamBlockWrite blockWrite;
 
+	/*
+	 * Min/max of the values of the current block, recorded in the block
+	 * directory. Only kept for the types zone maps support.
+	 */
+	bool		zone_enabled;
+	MinipageZone zone;
+
 	/*
 	 * EOFs of current segment file.
 	 */
@@ -242,6 +250,47 @@ datumstreamread_nth(DatumStreamRead * acc)
 	}
 }
 
+/*
+ * Number of items left in the current block after the current position.
+ */
+inline static int
+datumstreamread_remaining(DatumStreamRead * acc)
+{
+	if (acc->largeObjectState == DatumStreamLargeObjectState_None)
+	{
+		return Max(acc->blockRead.logical_row_count - 1 - acc->blockRead.nth, 0);
+	}
+	else
+	{
+		/* A large object block holds a single item */
+		return (acc->largeObjectState == DatumStreamLargeObjectState_HaveAoContent) ? 1 : 0;
+	}
+}
+
+/*
+ * Advance over and get up to 'maxCount' items of the current block, as if
+ * datumstreamread_advance and datumstreamread_get were called for each.
+ * Returns the number of items, 0 when the block is exhausted.
+ */
+inline static int
+datumstreamread_get_batch(DatumStreamRead * acc, Datum *values, bool *nulls,
+						  int maxCount)
+{
+	if (acc->largeObjectState == DatumStreamLargeObjectState_None)
+	{
+		return DatumStreamBlockRead_GetBatch(&acc->blockRead, values, nulls, maxCount);
+	}
+	else
+	{
+		if (maxCount <= 0 || datumstreamread_remaining(acc) == 0)
+			return 0;
+
+		datumstreamread_advancelarge(acc);
+		datumstreamread_getlarge(acc, values, nulls);
+		return 1;
+	}
+}
+
 /* ------------------------------------------------------------------------------ */
 
 extern int datumstreamwrite_put(
@@ -309,6 +358,9 @@ extern int64 datumstreamwrite_lob(DatumStreamWrite *ds,
 extern int	datumstreamread_block(DatumStreamRead * ds,
 								  AppendOnlyBlockDirectory *blockDirectory,
 								  int colGroupNo);
+extern bool datumstreamread_block_header(DatumStreamRead * ds);
+extern void datumstreamread_skip_block(DatumStreamRead * ds);
+extern void datumstreamread_skip(DatumStreamRead * ds, int count);
 extern void datumstreamread_find(DatumStreamRead * datumStream,
 					 int32 rowNumInBlock);
 extern void datumstreamread_rewind_block(DatumStreamRead * datumStream);
@@ -2062,6 +2062,12 @@ DatumStreamBlockRead_Nth(DatumStreamBlockRead * dsr)
 	return dsr->nth;
 }
 
+extern int32 DatumStreamBlockRead_GetBatch(
+							  DatumStreamBlockRead * dsr,
+							  Datum *values,
+							  bool *nulls,
+							  int32 maxCount);
+
 extern void DatumStreamBlockRead_GetReadyOrig(
 								  DatumStreamBlockRead * dsr,
 								  uint8 * buffer,
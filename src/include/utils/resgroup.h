@@ -177,6 +177,9 @@ extern void ResGroupDumpMemoryInfo(void);
 extern bool ResGroupReserveMemory(int32 memoryChunks, int32 overuseChunks, bool *waiverUsed);
 /* Update the memory usage of resource group */
 extern void ResGroupReleaseMemory(int32 memoryChunks);
+/* Reserve memory of resource group ahead of need, within the slot quota */
+extern bool ResGroupCanLeaseMemory(int32 memoryChunks);
+extern bool ResGroupLeaseMemory(int32 memoryChunks);
 
 extern void ResGroupDropFinish(const ResourceGroupCallbackContext *callbackCtx,
 							   bool isCommit);
@@ -11,12 +11,16 @@
 		"force_parallel_mode",
 		"gin_fuzzy_search_limit",
 		"gin_pending_list_limit",
+		"gp_appendonly_compaction_copy_blocks",
+		"gp_appendonly_prefetch_size",
+		"gp_appendonly_zone_maps",
 		"gp_blockdirectory_entry_min_range",
 		"gp_blockdirectory_minipage_size",
 		"gp_debug_linger",
 		"gp_default_storage_options",
 		"gp_disable_tuple_hints",
 		"gp_enable_mk_sort",
+		"gp_enable_runtime_filter",
 		"gp_enable_segment_copy_checking",
 		"gp_external_enable_filter_pushdown",
 		"gp_hashagg_default_nbatches",
@@ -26,14 +30,18 @@
 		"gp_indexcheck_insert",
 		"gp_indexcheck_vacuum",
 		"gp_initial_bad_row_limit",
+		"gp_interconnect_batch_syscalls",
+		"gp_interconnect_compression",
 		"gp_interconnect_debug_retry_interval",
 		"gp_interconnect_default_rtt",
 		"gp_interconnect_fc_method",
 		"gp_interconnect_full_crc",
+		"gp_interconnect_local_shm",
 		"gp_interconnect_log_stats",
 		"gp_interconnect_min_retries_before_timeout",
 		"gp_interconnect_min_rto",
 		"gp_interconnect_queue_depth",
+		"gp_interconnect_rx_spin_count",
 		"gp_interconnect_setup_timeout",
 		"gp_interconnect_snd_queue_depth",
 		"gp_interconnect_tcp_listener_backlog",
@@ -49,6 +57,8 @@
 		"gp_max_partition_level",
 		"gp_max_slices",
 		"gp_mk_sort_check",
+		"gp_motion_batch_compression",
+		"gp_motion_batch_size",
 		"gp_motion_slice_noop",
 		"gp_partitioning_dynamic_selection_log",
 		"gp_resgroup_memory_policy_auto_fixed_mem",
@@ -66,6 +76,7 @@
 		"gp_udpic_fault_inject_percent",
 		"gp_udpic_network_disable_ipv6",
 		"gp_vmem_idle_resource_timeout",
+		"gp_vmem_lease_chunks",
 		"gp_workfile_caching_loglevel",
 		"gp_workfile_compression",
 		"gp_workfile_limit_files_per_query",
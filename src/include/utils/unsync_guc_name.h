@@ -212,6 +212,8 @@
 		"gp_motion_cost_per_row",
 		"gp_qd_hostname",
 		"gp_qd_port",
+		"gp_qe_pool_idle_timeout",
+		"gp_qe_pool_size",
 		"gp_recursive_cte",
 		"gp_recursive_cte_prototype",
 		"gp_reject_internal_tcp_connection",
@@ -241,6 +243,7 @@
 		"gp_selectivity_damping_for_joins",
 		"gp_selectivity_damping_for_scans",
 		"gp_selectivity_damping_sigsort",
+		"gp_serialized_plan_cache_size",
 		"gp_server_version",
 		"gp_server_version_num",
 		"gp_session_id",
@@ -400,6 +403,7 @@
 		"optimizer_parallel_union",
 		"optimizer_penalize_broadcast_threshold",
 		"optimizer_penalize_skew",
+		"optimizer_plan_cache_size",
 		"optimizer_print_expression_properties",
 		"optimizer_print_group_properties",
 		"optimizer_print_job_scheduler",
@@ -39,6 +39,7 @@ typedef enum MemoryAllocationStatus
 typedef int64 EventVersion;
 
 extern int runaway_detector_activation_percent;
+extern int gp_vmem_lease_chunks;
 
 extern int32 VmemTracker_ConvertVmemChunksToMB(int chunks);
 extern int32 VmemTracker_ConvertVmemMBToChunks(int mb);
@@ -46,6 +47,7 @@ extern int64 VmemTracker_ConvertVmemChunksToBytes(int chunks);
 extern int32 VmemTracker_ConvertVmemBytesToChunks(int64 bytes);
 extern int32 VmemTracker_GetReservedVmemChunks(void);
 extern int64 VmemTracker_GetReservedVmemBytes(void);
+extern int64 VmemTracker_GetSharedVmemUpdates(void);
 extern int64 VmemTracker_GetMaxReservedVmemChunks(void);
 extern int64 VmemTracker_GetMaxReservedVmemMB(void);
 extern int64 VmemTracker_GetMaxReservedVmemBytes(void);
@@ -61,6 +63,8 @@ extern void VmemTracker_Shutdown(void);
 extern void VmemTracker_ResetMaxVmemReserved(void);
 extern MemoryAllocationStatus VmemTracker_ReserveVmem(int64 newly_requested);
 extern void VmemTracker_ReleaseVmem(int64 to_be_freed_requested);
+extern void VmemTracker_ReleaseSpareVmem(void);
+extern int32 VmemTracker_GetSpareVmemChunks(void);
 extern MemoryAllocationStatus VmemTracker_RegisterStartupMemory(int64 bytes);
 extern void VmemTracker_UnregisterStartupMemory(void);
 extern void VmemTracker_RequestWaiver(int64 waiver_bytes);
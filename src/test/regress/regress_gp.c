@@ -48,12 +48,15 @@
 #include "storage/buf_internals.h"
 #include "libpq/auth.h"
 #include "libpq/hba.h"
+#include "portability/instr_time.h"
 #include "utils/builtins.h"
 #include "utils/geo_decls.h"
+#include "utils/gp_alloc.h"
 #include "utils/lsyscache.h"
 #include "utils/memutils.h"
 #include "utils/resource_manager.h"
 #include "utils/timestamp.h"
+#include "utils/vmem_tracker.h"
 
 /* table_functions test */
 extern Datum multiset_example(PG_FUNCTION_ARGS);
@@ -113,6 +116,9 @@ extern Datum broken_int4out(PG_FUNCTION_ARGS);
 /* fts tests */
 extern Datum gp_fts_probe_stats(PG_FUNCTION_ARGS);
 
+/* vmem tracker benchmark */
+extern Datum gp_vmem_alloc_bench(PG_FUNCTION_ARGS);
+
 /* Triggers */
 
 typedef struct
@@ -2156,3 +2162,61 @@ get_tablespace_version_directory_name(PG_FUNCTION_ARGS)
 {
 	PG_RETURN_TEXT_P(CStringGetTextDatum(GP_TABLESPACE_VERSION_DIRECTORY));
 }
+
+/*
+ * gp_vmem_alloc_bench(loops int4, chunks float8), allocates and frees the
+ * given number of vmem chunks with gp_malloc() loops times, and returns how
+ * many times the segment vmem counter was updated, and the elapsed time in
+ * milliseconds. The chunk size depends on gp_vmem_protect_limit, so the
+ * size is given in chunks rather than bytes.
+ *
+ * With a chunk and a half, every allocation and free crosses a chunk
+ * boundary. Run it from many sessions at once (e.g. with pgbench) to
+ * measure allocation throughput under contention on the segment counter,
+ * with and without gp_vmem_lease_chunks.
+ *
+ * Used by the 'vmem_lease' test.
+ */
+PG_FUNCTION_INFO_V1(gp_vmem_alloc_bench);
+Datum
+gp_vmem_alloc_bench(PG_FUNCTION_ARGS)
+{
+	int32		loops = PG_GETARG_INT32(0);
+	float8		chunks = PG_GETARG_FLOAT8(1);
+	Size		nbytes = (Size) (chunks * (1 << VmemTracker_GetChunkSizeInBits()));
+	int64		updates;
+	instr_time	start;
+	instr_time	elapsed;
+	TupleDesc	tupdesc;
+	Datum		values[2];
+	bool		nulls[2] = {false, false};
+	int			i;
+
+	if (get_call_result_type(fcinfo, NULL, &tupdesc) != TYPEFUNC_COMPOSITE)
+		elog(ERROR, "return type must be a row type");
+	tupdesc = BlessTupleDesc(tupdesc);
+
+	updates = VmemTracker_GetSharedVmemUpdates();
+	INSTR_TIME_SET_CURRENT(start);
+
+	for (i = 0; i < loops; i++)
+	{
+		void	   *ptr = gp_malloc(nbytes);
+
+		if (ptr == NULL)
+			ereport(ERROR,
+					(errcode(ERRCODE_OUT_OF_MEMORY),
+					 errmsg("out of memory")));
+		gp_free(ptr);
+
+		CHECK_FOR_INTERRUPTS();
+	}
+
+	INSTR_TIME_SET_CURRENT(elapsed);
+	INSTR_TIME_SUBTRACT(elapsed, start);
+
+	values[0] = Int64GetDatum(VmemTracker_GetSharedVmemUpdates() - updates);
+	values[1] = Float8GetDatum(INSTR_TIME_GET_MILLISEC(elapsed));
+
+	PG_RETURN_DATUM(HeapTupleGetDatum(heap_form_tuple(tupdesc, values, nulls)));
+}
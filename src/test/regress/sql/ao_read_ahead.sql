@@ -0,0 +1,51 @@
+--
+-- Tests for the read-ahead of append-only segment files.  Scans must return
+-- the same rows whatever the read-ahead window, and EXPLAIN ANALYZE reports
+-- the reads of the scans.
+--
+CREATE TABLE ao_read_ahead (a int, b text)
+WITH (appendonly=true, blocksize=8192) DISTRIBUTED BY (a);
+CREATE TABLE aocs_read_ahead (a int, b text)
+WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (a);
+INSERT INTO ao_read_ahead SELECT i, repeat('x', i % 100) FROM generate_series(1, 50000) i;
+INSERT INTO aocs_read_ahead SELECT * FROM ao_read_ahead;
+
+SET gp_appendonly_prefetch_size = 0;
+SELECT count(*), sum(a), sum(length(b)) FROM ao_read_ahead;
+SELECT count(*), sum(a), sum(length(b)) FROM aocs_read_ahead;
+
+SET gp_appendonly_prefetch_size = 64;
+SELECT count(*), sum(a), sum(length(b)) FROM ao_read_ahead;
+SELECT count(*), sum(a), sum(length(b)) FROM aocs_read_ahead;
+
+SET gp_appendonly_prefetch_size = '1GB';
+SHOW gp_appendonly_prefetch_size;
+SELECT count(*), sum(a), sum(length(b)) FROM ao_read_ahead;
+SELECT count(*), sum(a), sum(length(b)) FROM aocs_read_ahead;
+
+-- Does the EXPLAIN ANALYZE output of 'query' have a line matching 'pattern'?
+CREATE FUNCTION ao_read_ahead_explain(query text, pattern text) RETURNS boolean
+LANGUAGE plpgsql AS $$
+DECLARE
+	ln text;
+BEGIN
+	FOR ln IN EXECUTE 'EXPLAIN (ANALYZE) ' || query LOOP
+		IF ln ~ pattern THEN
+			RETURN true;
+		END IF;
+	END LOOP;
+	RETURN false;
+END
+$$;
+
+SET gp_appendonly_prefetch_size = 64;
+SELECT ao_read_ahead_explain('SELECT * FROM ao_read_ahead', 'Append-only storage read .* kB in .* reads, waited');
+SELECT ao_read_ahead_explain('SELECT * FROM aocs_read_ahead', 'Append-only storage read .* kB in .* reads, waited');
+SELECT ao_read_ahead_explain('SELECT * FROM aocs_read_ahead', 'Prefetched .* kB in .* requests');
+SET gp_appendonly_prefetch_size = 0;
+SELECT ao_read_ahead_explain('SELECT * FROM aocs_read_ahead', 'Prefetched');
+
+RESET gp_appendonly_prefetch_size;
+DROP FUNCTION ao_read_ahead_explain(text, text);
+DROP TABLE ao_read_ahead;
+DROP TABLE aocs_read_ahead;
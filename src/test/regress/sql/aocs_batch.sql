@@ -0,0 +1,53 @@
+--
+-- Tests for decoding AOCS columns a batch at a time.  The columns have
+-- different encodings and block row counts, so batches are cut short at the
+-- block boundaries of every column.
+--
+CREATE TABLE aocs_batch (
+	id int,
+	i2 smallint,
+	i8 bigint ENCODING (compresstype=rle_type),
+	d date ENCODING (compresstype=rle_type, compresslevel=2),
+	f8 float8,
+	t text,
+	big text)
+WITH (appendonly=true, orientation=column) DISTRIBUTED BY (id);
+
+INSERT INTO aocs_batch
+SELECT i,
+	   CASE WHEN i % 7 = 0 THEN NULL ELSE (i % 1000)::smallint END,
+	   i / 100,
+	   date '2000-01-01' + i / 10,
+	   CASE WHEN i % 3 = 0 THEN NULL ELSE i * 0.5 END,
+	   CASE WHEN i % 5 = 0 THEN NULL ELSE 'row ' || i END,
+	   CASE WHEN i % 20000 = 0 THEN repeat('x', 100000) END
+FROM generate_series(1, 100000) i;
+
+SELECT count(*), count(i2), sum(i2), sum(i8) FROM aocs_batch;
+SELECT to_char(min(d), 'YYYY-MM-DD') AS min, to_char(max(d), 'YYYY-MM-DD') AS max,
+	   sum(d - date '2000-01-01'), count(f8), sum(f8) FROM aocs_batch;
+SELECT count(t), sum(length(t)), count(big), sum(length(big)) FROM aocs_batch;
+SELECT id, i2, i8, to_char(d, 'YYYY-MM-DD') AS d, f8, t, length(big)
+FROM aocs_batch WHERE id IN (1, 7, 15, 20000, 99999, 100000) ORDER BY id;
+
+-- Every row gets its own row number
+SELECT count(*) FROM (SELECT DISTINCT gp_segment_id, ctid FROM aocs_batch) s;
+
+-- The index build scans the table too
+CREATE INDEX aocs_batch_i8 ON aocs_batch (i8);
+SET enable_seqscan = off;
+SELECT count(*), sum(id) FROM aocs_batch WHERE i8 = 500;
+RESET enable_seqscan;
+
+-- Deleted rows are left out of the batches
+DELETE FROM aocs_batch WHERE id % 11 = 0;
+
+SELECT count(*), count(i2), sum(i2), sum(i8) FROM aocs_batch;
+SELECT to_char(min(d), 'YYYY-MM-DD') AS min, to_char(max(d), 'YYYY-MM-DD') AS max,
+	   sum(d - date '2000-01-01'), count(f8), sum(f8) FROM aocs_batch;
+SELECT count(t), sum(length(t)), count(big), sum(length(big)) FROM aocs_batch;
+SET enable_seqscan = off;
+SELECT count(*), sum(id) FROM aocs_batch WHERE i8 = 500;
+RESET enable_seqscan;
+
+DROP TABLE aocs_batch;
@@ -0,0 +1,81 @@
+--
+-- Tests for skipping AOCS blocks with the min/max zone maps kept in the
+-- block directory.  Every query is run with and without the zone maps, and
+-- must return the same rows.
+--
+
+-- Zone maps are only written when enabled
+SET gp_appendonly_zone_maps = on;
+CREATE TABLE aocs_zone (id int, d date, ts timestamp, b bigint, t text)
+WITH (appendonly=true, orientation=column, blocksize=8192) DISTRIBUTED BY (id);
+
+-- Written before the block directory exists.  The index build records the
+-- zones of these blocks.
+INSERT INTO aocs_zone
+SELECT i, date '2000-01-01' + i / 10, timestamp '2000-01-01' + i * interval '1 minute',
+	   i::bigint * 3, 'row ' || i
+FROM generate_series(1, 20000) i;
+CREATE INDEX aocs_zone_id ON aocs_zone (id);
+
+-- Written with the block directory, and with blocks of nulls only
+INSERT INTO aocs_zone
+SELECT i, date '2000-01-01' + i / 10, timestamp '2000-01-01' + i * interval '1 minute',
+	   i::bigint * 3, 'row ' || i
+FROM generate_series(20001, 40000) i;
+INSERT INTO aocs_zone SELECT i, NULL, NULL, NULL, 'null ' || i
+FROM generate_series(40001, 41000) i;
+
+-- Same rows with RLE and delta encoded columns, and several blocks per
+-- block directory entry
+CREATE TABLE aocs_zone_rle (id int, d date, ts timestamp, b bigint, t text)
+WITH (appendonly=true, orientation=column, compresstype=rle_type, blocksize=8192)
+DISTRIBUTED BY (id);
+CREATE INDEX aocs_zone_rle_id ON aocs_zone_rle (id);
+SET gp_blockdirectory_entry_min_range = 65536;
+INSERT INTO aocs_zone_rle SELECT * FROM aocs_zone;
+RESET gp_blockdirectory_entry_min_range;
+
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+
+SET gp_appendonly_zone_maps = off;
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE d BETWEEN '2001-01-01' AND '2001-01-31';
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE ts >= '2000-01-20' AND ts < '2000-01-21';
+SELECT count(*), sum(b), min(t) FROM aocs_zone WHERE b > 119000;
+SELECT count(*), sum(id) FROM aocs_zone WHERE 20 >= id;
+SELECT count(*), sum(id) FROM aocs_zone WHERE d = '2009-01-01';
+SELECT count(*), sum(id) FROM aocs_zone WHERE id < 5::bigint;
+SELECT count(*), count(d) FROM aocs_zone WHERE d < '2000-02-01' OR d IS NULL;
+SELECT count(*) FROM aocs_zone WHERE d > '2099-01-01';
+SELECT count(*), min(id), max(id) FROM aocs_zone_rle WHERE d BETWEEN '2001-01-01' AND '2001-01-31';
+SELECT count(*), min(id), max(id) FROM aocs_zone_rle WHERE ts >= '2000-01-20' AND ts < '2000-01-21';
+SELECT count(*), sum(b), min(t) FROM aocs_zone_rle WHERE b > 119000;
+
+SET gp_appendonly_zone_maps = on;
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE d BETWEEN '2001-01-01' AND '2001-01-31';
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE ts >= '2000-01-20' AND ts < '2000-01-21';
+SELECT count(*), sum(b), min(t) FROM aocs_zone WHERE b > 119000;
+SELECT count(*), sum(id) FROM aocs_zone WHERE 20 >= id;
+SELECT count(*), sum(id) FROM aocs_zone WHERE d = '2009-01-01';
+SELECT count(*), sum(id) FROM aocs_zone WHERE id < 5::bigint;
+SELECT count(*), count(d) FROM aocs_zone WHERE d < '2000-02-01' OR d IS NULL;
+SELECT count(*) FROM aocs_zone WHERE d > '2099-01-01';
+SELECT count(*), min(id), max(id) FROM aocs_zone_rle WHERE d BETWEEN '2001-01-01' AND '2001-01-31';
+SELECT count(*), min(id), max(id) FROM aocs_zone_rle WHERE ts >= '2000-01-20' AND ts < '2000-01-21';
+SELECT count(*), sum(b), min(t) FROM aocs_zone_rle WHERE b > 119000;
+
+-- Deleted rows stay out
+DELETE FROM aocs_zone WHERE id BETWEEN 3700 AND 3709;
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE d BETWEEN '2001-01-01' AND '2001-01-31';
+
+-- Rows appended to a segment file after the zones of its last entry
+INSERT INTO aocs_zone VALUES (41001, '2001-01-15', '2000-01-20 12:00', 1, 'late');
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE d BETWEEN '2001-01-01' AND '2001-01-31';
+SELECT count(*), min(id), max(id) FROM aocs_zone WHERE ts >= '2000-01-20' AND ts < '2000-01-21';
+SELECT id, t FROM aocs_zone WHERE b < 3;
+
+RESET gp_appendonly_zone_maps;
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP TABLE aocs_zone;
+DROP TABLE aocs_zone_rle;
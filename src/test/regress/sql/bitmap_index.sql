@@ -322,3 +322,20 @@ SELECT * from bm_test_reindex where c2 = 32767;
 SELECT * from bm_test_reindex where c2 = 32768;
 SELECT * from bm_test_reindex where c2 = 32769;
 SELECT * from bm_test_reindex where c2 = 65536;
+
+-- With more distinct values than fit in maintenance_work_mem, the build
+-- writes out the buffered tid locations and sorts the rest.
+SET maintenance_work_mem = '1MB';
+REINDEX INDEX bm_test_reindex_idx;
+SELECT * from bm_test_reindex where c2 = 1;
+SELECT * from bm_test_reindex where c2 = 32768;
+SELECT * from bm_test_reindex where c2 = 65537;
+SELECT count(*) from bm_test_reindex where c2 in (2, 3000, 40000, 65535);
+CREATE TABLE bm_test_sortbuild(a int, b int) DISTRIBUTED BY (a);
+INSERT INTO bm_test_sortbuild SELECT i, i % 20000 FROM generate_series(1, 100000) i;
+CREATE INDEX bm_test_sortbuild_idx ON bm_test_sortbuild USING bitmap(b);
+SELECT count(*) FROM bm_test_sortbuild WHERE b = 0;
+SELECT count(*) FROM bm_test_sortbuild WHERE b IN (1, 19999);
+SELECT sum(a) FROM bm_test_sortbuild WHERE b = 7;
+RESET maintenance_work_mem;
+DROP TABLE bm_test_sortbuild;
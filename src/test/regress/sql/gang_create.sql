@@ -0,0 +1,36 @@
+--
+-- Tests for the creation of the gangs of a plan, whose QEs are all started
+-- at once. Readers are started once the writer of their segment is ready.
+-- Gang creation isn't retried, so a reader left waiting for its writer, like
+-- a segment in recovery, fails the query.
+--
+CREATE TABLE gang_create_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO gang_create_t SELECT i, i % 10 FROM generate_series(1, 100) i;
+CREATE TABLE gang_create_t2 (a int, b int) DISTRIBUTED BY (a);
+
+-- A new session has no QEs, the writer gang and the reader gangs of the
+-- query are created together
+\c
+SET gp_gang_creation_retry_count = 0;
+SELECT count(*) FROM gang_create_t t1
+  JOIN gang_create_t t2 ON t1.b = t2.b
+  JOIN gang_create_t t3 ON t2.b = t3.a;
+SELECT allocations, reused,
+	   started >= 2 * (SELECT count(*) FROM gp_segment_configuration
+					   WHERE role = 'p' AND content >= 0) AS several_gangs
+FROM gp_qe_pool_stats();
+
+-- The same with an explicit writer gang
+\c
+SET gp_gang_creation_retry_count = 0;
+SET gp_autostats_mode = none;
+INSERT INTO gang_create_t2 SELECT t1.a, t2.b FROM gang_create_t t1
+  JOIN gang_create_t t2 ON t1.b = t2.a;
+SELECT allocations, reused,
+	   started >= 2 * (SELECT count(*) FROM gp_segment_configuration
+					   WHERE role = 'p' AND content >= 0) AS several_gangs
+FROM gp_qe_pool_stats();
+SELECT count(*) FROM gang_create_t2;
+
+DROP TABLE gang_create_t;
+DROP TABLE gang_create_t2;
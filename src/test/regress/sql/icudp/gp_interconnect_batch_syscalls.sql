@@ -0,0 +1,63 @@
+-- 
+-- @description Interconnect batched syscalls (sendmmsg/recvmmsg) test case
+-- @tags executor
+
+-- Create a table
+CREATE TEMP TABLE small_table(dkey INT, jkey INT, rval REAL, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO small_table VALUES(generate_series(1, 5000), generate_series(5001, 10000), sqrt(generate_series(5001, 10000)));
+
+-- Functional tests
+-- Skew with gather+redistribute
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+-- Without batching, every packet takes a syscall of its own
+SELECT SUM(packets_sent) = SUM(send_calls) AS one_per_send,
+       SUM(datagrams_received) = SUM(receive_calls) AS one_per_receive
+  FROM gp_interconnect_syscall_stats
+  WHERE sess_id = current_setting('gp_session_id')::int;
+
+-- Batched send and receive, loss based flow control
+SET gp_interconnect_batch_syscalls = on;
+SET gp_interconnect_fc_method = loss;
+SHOW gp_interconnect_batch_syscalls;
+SELECT COALESCE(MAX(ic_id), 0) AS last_ic_id FROM gp_interconnect_syscall_stats
+  WHERE sess_id = current_setting('gp_session_id')::int \gset
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+-- sendmmsg() and recvmmsg() carried more than one packet per call
+SELECT SUM(packets_sent) > SUM(send_calls) AS batched_send,
+       SUM(datagrams_received) > SUM(receive_calls) AS batched_receive
+  FROM gp_interconnect_syscall_stats
+  WHERE sess_id = current_setting('gp_session_id')::int AND ic_id > :last_ic_id;
+
+-- Batched send and receive, capacity based flow control
+SET gp_interconnect_fc_method = capacity;
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+-- Send queues deeper than one batch
+SET gp_interconnect_snd_queue_depth = 64;
+SET gp_interconnect_queue_depth = 64;
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+RESET gp_interconnect_snd_queue_depth;
+RESET gp_interconnect_queue_depth;
+RESET gp_interconnect_fc_method;
+RESET gp_interconnect_batch_syscalls;
@@ -0,0 +1,51 @@
+-- 
+-- @description Interconnect compression test case
+-- @tags executor
+
+-- Create a table
+CREATE TEMP TABLE small_table(dkey INT, jkey INT, rval REAL, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO small_table VALUES(generate_series(1, 5000), generate_series(5001, 10000), sqrt(generate_series(5001, 10000)));
+
+-- Functional tests
+-- Skew with gather+redistribute
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+-- Nothing has been compressed yet
+SELECT COALESCE(SUM(packets_compressed), 0) AS packets_compressed
+  FROM gp_interconnect_conn_stats
+  WHERE sess_id = current_setting('gp_session_id')::int;
+
+-- Compressed data packets, loss based flow control
+SET gp_interconnect_compression = on;
+SET gp_interconnect_fc_method = loss;
+SHOW gp_interconnect_compression;
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+-- The senders' connections compressed packets, and saved bytes by it
+SELECT SUM(packets_compressed) > 0 AS compressed, SUM(bytes_saved) > 0 AS saved
+  FROM gp_interconnect_conn_stats
+  WHERE sess_id = current_setting('gp_session_id')::int;
+
+-- Compressed data packets, capacity based flow control
+SET gp_interconnect_fc_method = capacity;
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+
+-- Rows that don't compress well, so that connections back off
+SELECT COUNT(*), COUNT(DISTINCT m)
+  FROM (SELECT md5(t1.dkey::text || t2.dkey::text) AS m
+          FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000) foo;
+
+RESET gp_interconnect_fc_method;
+RESET gp_interconnect_compression;
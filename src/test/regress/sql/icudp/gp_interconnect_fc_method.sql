@@ -27,3 +27,18 @@ SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(len
     JOIN small_table USING(jkey)
   GROUP BY rval2
   ORDER BY rval2;
+
+-- BBR flow control, and the per-connection state it leaves behind
+SET gp_interconnect_fc_method = "bbr";
+SHOW gp_interconnect_fc_method;
+SELECT ROUND(foo.rval * foo.rval)::INT % 30 AS rval2, COUNT(*) AS count, SUM(length(foo.tval)) AS sum_len_tval
+  FROM (SELECT 5001 AS jkey, rval, tval FROM small_table ORDER BY dkey LIMIT 3000) foo
+    JOIN small_table USING(jkey)
+  GROUP BY rval2
+  ORDER BY rval2;
+SELECT fc_method, COUNT(*) > 0 AS has_conns, bool_and(cwnd >= 4) AS cwnd_ok, bool_and(srtt > 0) AS srtt_ok
+  FROM gp_interconnect_conn_stats
+  WHERE sess_id = current_setting('gp_session_id')::int AND fc_method = 'bbr'
+  GROUP BY fc_method;
+
+RESET gp_interconnect_fc_method;
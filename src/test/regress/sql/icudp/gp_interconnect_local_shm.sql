@@ -0,0 +1,40 @@
+-- 
+-- @description Interconnect shared memory transport test case
+-- @tags executor
+
+-- Create a table
+CREATE TEMP TABLE small_table(dkey INT, jkey INT, rval REAL, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO small_table VALUES(generate_series(1, 5000), generate_series(5001, 10000), sqrt(generate_series(5001, 10000)));
+
+-- Without it, all the connections use the socket
+SELECT COUNT(*), SUM(jkey) FROM (SELECT jkey FROM small_table ORDER BY dkey LIMIT 4000) foo;
+SELECT COUNT(*) AS shm_conns FROM gp_interconnect_conn_stats
+  WHERE sess_id = current_setting('gp_session_id')::int AND transport = 'shm';
+
+-- Connections between QEs on the same host use shared memory rings
+SET gp_interconnect_local_shm = on;
+SHOW gp_interconnect_local_shm;
+-- Merge gather, receives from a specific route
+SELECT COUNT(*), SUM(jkey) FROM (SELECT jkey FROM small_table ORDER BY dkey LIMIT 4000) foo;
+-- Redistribute, receives from any route
+SELECT COUNT(*), COUNT(DISTINCT t2.jkey)
+  FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000;
+-- Receiver stops the senders early
+SELECT COUNT(*) FROM (SELECT * FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000 LIMIT 10) foo;
+-- The receivers took up the rings the senders offered
+SELECT COUNT(*) > 0 AS used_shm FROM gp_interconnect_conn_stats
+  WHERE sess_id = current_setting('gp_session_id')::int AND transport = 'shm';
+
+-- Small rings make the senders wait for the receiver
+SET gp_interconnect_queue_depth = 1;
+SET gp_interconnect_snd_queue_depth = 1;
+SELECT COUNT(*), SUM(jkey) FROM (SELECT jkey FROM small_table ORDER BY dkey LIMIT 4000) foo;
+SELECT COUNT(*), COUNT(DISTINCT t2.jkey)
+  FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000;
+SELECT COUNT(*) FROM (SELECT * FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000 LIMIT 10) foo;
+
+RESET gp_interconnect_queue_depth;
+RESET gp_interconnect_snd_queue_depth;
+RESET gp_interconnect_local_shm;
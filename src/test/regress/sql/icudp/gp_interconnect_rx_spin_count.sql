@@ -0,0 +1,26 @@
+-- 
+-- @description Interconnect receiver spinning test case
+-- @tags executor
+
+-- Create a table
+CREATE TEMP TABLE small_table(dkey INT, jkey INT, rval REAL, tval TEXT default 'abcdefghijklmnopqrstuvwxyz') DISTRIBUTED BY (dkey);
+
+-- Generate some data
+INSERT INTO small_table VALUES(generate_series(1, 5000), generate_series(5001, 10000), sqrt(generate_series(5001, 10000)));
+
+-- Receiver sleeps as soon as its queues are empty
+SET gp_interconnect_rx_spin_count = 0;
+SHOW gp_interconnect_rx_spin_count;
+-- Merge gather, receives from a specific route
+SELECT COUNT(*), SUM(jkey) FROM (SELECT jkey FROM small_table ORDER BY dkey LIMIT 4000) foo;
+-- Redistribute, receives from any route
+SELECT COUNT(*), COUNT(DISTINCT t2.jkey)
+  FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000;
+
+-- Receiver spins for a long time before sleeping
+SET gp_interconnect_rx_spin_count = 100000;
+SELECT COUNT(*), SUM(jkey) FROM (SELECT jkey FROM small_table ORDER BY dkey LIMIT 4000) foo;
+SELECT COUNT(*), COUNT(DISTINCT t2.jkey)
+  FROM small_table t1 JOIN small_table t2 ON t1.dkey = t2.jkey - 5000;
+
+RESET gp_interconnect_rx_spin_count;
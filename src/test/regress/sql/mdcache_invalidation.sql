@@ -0,0 +1,68 @@
+--
+-- Tests for dropping only the changed objects from the ORCA metadata
+-- cache.  The counters are read with the planner, so that reading them
+-- doesn't use the cache.
+--
+CREATE TABLE mdc_a (a int, b int) DISTRIBUTED BY (a);
+CREATE TABLE mdc_b (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO mdc_a SELECT i, i % 10 FROM generate_series(1, 100) i;
+INSERT INTO mdc_b SELECT i, i % 5 FROM generate_series(1, 100) i;
+ANALYZE mdc_a;
+ANALYZE mdc_b;
+
+SET optimizer = on;
+SELECT count(*) FROM mdc_a JOIN mdc_b USING (a) WHERE mdc_a.b = 1;
+
+-- The same query again finds everything in the cache
+SET optimizer = off;
+SELECT hits AS hits0, misses AS misses0, invalidations AS inv0, resets AS resets0
+FROM gp_opt_mdcache_stats() \gset
+SET optimizer = on;
+SELECT count(*) FROM mdc_a JOIN mdc_b USING (a) WHERE mdc_a.b = 1;
+SET optimizer = off;
+SELECT hits > :hits0 AS more_hits, misses = :misses0 AS no_new_misses
+FROM gp_opt_mdcache_stats();
+
+-- ANALYZE drops the entries of the table, not the whole cache
+SELECT hits AS hits0, misses AS misses0, invalidations AS inv0, resets AS resets0
+FROM gp_opt_mdcache_stats() \gset
+ANALYZE mdc_a;
+SET optimizer = on;
+SELECT count(*) FROM mdc_a JOIN mdc_b USING (a) WHERE mdc_a.b = 1;
+SET optimizer = off;
+SELECT invalidations > :inv0 AS invalidated, resets = :resets0 AS no_reset,
+	   misses > :misses0 AS new_misses
+FROM gp_opt_mdcache_stats();
+
+-- The changed table is looked up again
+ALTER TABLE mdc_b ADD COLUMN c int DEFAULT 7;
+SET optimizer = on;
+SELECT count(*), sum(c) FROM mdc_a JOIN mdc_b USING (a) WHERE mdc_a.b = 1;
+SET optimizer = off;
+SELECT resets = :resets0 AS no_reset FROM gp_opt_mdcache_stats();
+
+SELECT entries > 0 AS has_entries, size_bytes > 0 AS has_size
+FROM gp_opt_mdcache_stats();
+
+-- A partitioned table and its index are only invalidated through the
+-- partitions.  With the index of one partition gone, the cached index of
+-- the table must not be used anymore.
+CREATE TABLE mdc_p (a int, b int) DISTRIBUTED BY (a)
+PARTITION BY RANGE (b) (START (0) END (10) EVERY (5));
+CREATE INDEX mdc_p1_a ON mdc_p_1_prt_1 (a);
+CREATE INDEX mdc_p2_a ON mdc_p_1_prt_2 (a);
+INSERT INTO mdc_p SELECT i, i % 10 FROM generate_series(1, 100) i;
+ANALYZE mdc_p;
+SET enable_seqscan = off;
+SET optimizer = on;
+SELECT count(*) FROM mdc_p WHERE a < 50;
+DROP INDEX mdc_p2_a;
+SELECT count(*) FROM mdc_p WHERE a < 50;
+DROP INDEX mdc_p1_a;
+SELECT count(*) FROM mdc_p WHERE a < 50;
+RESET enable_seqscan;
+
+RESET optimizer;
+DROP TABLE mdc_a;
+DROP TABLE mdc_b;
+DROP TABLE mdc_p;
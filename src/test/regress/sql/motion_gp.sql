@@ -98,3 +98,25 @@ $$) order by id;
 CREATE TABLE motion_noatts ();
 INSERT INTO motion_noatts SELECT;
 SELECT * FROM motion_noatts;
+
+-- Test columnar batches. They are used for Motions in which all the columns
+-- are fixed-width pass-by-value types.
+CREATE TABLE motion_batch (a int4, b int8, c int2, d float8, e bool, f date) DISTRIBUTED BY (a);
+INSERT INTO motion_batch
+  SELECT i, i * 1000000000::int8, (i % 100)::int2, i / 3.0, i % 2 = 0,
+         CASE WHEN i % 7 = 0 THEN NULL ELSE date '2020-01-01' + i END
+  FROM generate_series(1, 10000) i;
+SET gp_motion_batch_size = 100;
+-- Redistribute Motion. The last, partial, batch of each route is sent
+-- before the end-of-stream.
+SELECT count(*), count(t2.f), sum(t2.a), sum(t2.b), sum(t2.c),
+       round(sum(t2.d)::numeric, 2), sum(t2.e::int)
+FROM motion_batch t1 JOIN motion_batch t2 ON t1.b = t2.b;
+-- Gather Merge Motion, which must preserve the order within each batch.
+SELECT a, b, c, e, f - date '2020-01-01' AS days FROM motion_batch ORDER BY a LIMIT 8;
+SET gp_motion_batch_compression = on;
+SELECT count(*), count(t2.f), sum(t2.a), sum(t2.b), sum(t2.c),
+       round(sum(t2.d)::numeric, 2), sum(t2.e::int)
+FROM motion_batch t1 JOIN motion_batch t2 ON t1.b = t2.b;
+RESET gp_motion_batch_compression;
+RESET gp_motion_batch_size;
@@ -0,0 +1,112 @@
+--
+-- Tests for the cache of the plans produced by GPORCA. Every change below
+-- must be seen by the next query, rather than a cached plan. The counters of
+-- gp_opt_plan_cache_stats() tell a plan taken from the cache from a new one;
+-- they are read with the planner, to leave the cache alone.
+--
+SET optimizer = on;
+SET optimizer_plan_cache_size = '1MB';
+
+CREATE TABLE opc_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO opc_t SELECT i, i % 10 FROM generate_series(1, 100) i;
+ANALYZE opc_t;
+SET optimizer = off;
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+CREATE FUNCTION opc_f(int) RETURNS int AS 'SELECT $1 + 1' LANGUAGE sql IMMUTABLE;
+
+SELECT count(*), sum(opc_f(b)) FROM opc_t WHERE b < 5;
+SELECT count(*), sum(opc_f(b)) FROM opc_t WHERE b < 5;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+-- Different constants are different queries
+SELECT count(*), sum(opc_f(b)) FROM opc_t WHERE b < 3;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+-- A changed function
+CREATE OR REPLACE FUNCTION opc_f(int) RETURNS int AS 'SELECT $1 + 2' LANGUAGE sql IMMUTABLE;
+SELECT count(*), sum(opc_f(b)) FROM opc_t WHERE b < 5;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+-- A changed table
+ALTER TABLE opc_t ADD COLUMN c int DEFAULT 1;
+SELECT * FROM opc_t WHERE a = 1;
+SELECT * FROM opc_t WHERE a = 1;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+ALTER TABLE opc_t DROP COLUMN b;
+SELECT * FROM opc_t WHERE a = 1;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+-- A table dropped and created again under the same name
+DROP TABLE opc_t;
+CREATE TABLE opc_t (a int, b text) DISTRIBUTED BY (a);
+INSERT INTO opc_t VALUES (1, 'one');
+SET optimizer = off;
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+SELECT * FROM opc_t WHERE a = 1;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+-- A prepared statement
+PREPARE opc_p(int) AS SELECT b FROM opc_t WHERE a = $1;
+EXECUTE opc_p(1);
+EXECUTE opc_p(1);
+EXECUTE opc_p(2);
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+INSERT INTO opc_t VALUES (2, 'two');
+SET optimizer = off;
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+EXECUTE opc_p(2);
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+DEALLOCATE opc_p;
+
+-- Rolled back changes
+BEGIN;
+ALTER TABLE opc_t ADD COLUMN c int DEFAULT 3;
+SELECT * FROM opc_t WHERE a = 1;
+ROLLBACK;
+SELECT * FROM opc_t WHERE a = 1;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SET optimizer = on;
+
+-- Disabling the cache
+SET optimizer_plan_cache_size = 0;
+SELECT * FROM opc_t WHERE a = 1;
+SET optimizer = off;
+SELECT hits - :opc_hits AS hits, misses - :opc_misses AS misses FROM gp_opt_plan_cache_stats();
+SELECT hits AS opc_hits, misses AS opc_misses FROM gp_opt_plan_cache_stats() \gset
+SELECT entries FROM gp_opt_plan_cache_stats();
+SET optimizer = on;
+
+RESET optimizer_plan_cache_size;
+RESET optimizer;
+DROP TABLE opc_t;
+DROP FUNCTION opc_f(int);
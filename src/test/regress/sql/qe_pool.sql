@@ -0,0 +1,28 @@
+--
+-- Tests for the pool of idle QEs a session keeps with gp_qe_pool_size.
+--
+CREATE TABLE qe_pool_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO qe_pool_t SELECT i, i FROM generate_series(1, 100) i;
+
+-- Start from a session without QEs, so that what is started only depends on
+-- the queries below
+\c
+SET gp_qe_pool_size = 2;
+SELECT count(*) AS nsegs FROM gp_segment_configuration
+WHERE role = 'p' AND content >= 0 \gset
+
+-- The query needs one QE per segment, the writer. The two readers missing
+-- from the pool are started along with it, and are idle once it is done.
+SELECT count(*) FROM qe_pool_t;
+SELECT idle_qes = 3 * :nsegs AS pool_filled, prestarted = 2 * :nsegs AS prestarted,
+	   started = 3 * :nsegs AS started, reused, allocations
+FROM gp_qe_pool_stats();
+
+-- The next query takes them from the pool: a writer and a reader per segment
+SELECT count(*) FROM qe_pool_t t1 JOIN qe_pool_t t2 ON t1.a = t2.b;
+SELECT idle_qes = 3 * :nsegs AS pool_filled, started = 3 * :nsegs AS none_started,
+	   reused = 2 * :nsegs AS reused, allocations
+FROM gp_qe_pool_stats();
+
+RESET gp_qe_pool_size;
+DROP TABLE qe_pool_t;
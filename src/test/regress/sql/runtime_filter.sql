@@ -0,0 +1,165 @@
+--
+-- Tests for the runtime filters that hash joins push down to the scan on
+-- their outer side, or send to the senders of the Motion on their outer
+-- side.  Every query is run with and without the filters, and must return
+-- the same rows.
+--
+CREATE TABLE rf_dim (id int, grp int, name text) DISTRIBUTED BY (id);
+INSERT INTO rf_dim SELECT i, i % 10, 'dim ' || i FROM generate_series(1, 100) i;
+CREATE TABLE rf_dim8 (id bigint, label text) DISTRIBUTED BY (id);
+INSERT INTO rf_dim8 VALUES (2, 'two'), (5, 'five');
+CREATE TABLE rf_date (d date, holiday bool) DISTRIBUTED BY (d);
+INSERT INTO rf_date VALUES ('2000-01-01', true), ('2000-01-03', false), ('2000-01-05', true);
+
+CREATE TABLE rf_fact_heap (id int, dim_id int, amount int, d date) DISTRIBUTED BY (dim_id);
+INSERT INTO rf_fact_heap
+SELECT i, i % 100 + 1, i % 7, date '2000-01-01' + i % 10 FROM generate_series(1, 100000) i;
+INSERT INTO rf_fact_heap VALUES (100001, NULL, NULL, NULL);
+CREATE TABLE rf_fact_ao (LIKE rf_fact_heap)
+WITH (appendonly=true) DISTRIBUTED BY (dim_id);
+INSERT INTO rf_fact_ao SELECT * FROM rf_fact_heap;
+CREATE TABLE rf_fact_aocs (LIKE rf_fact_heap)
+WITH (appendonly=true, orientation=column) DISTRIBUTED BY (dim_id);
+CREATE INDEX rf_fact_aocs_id ON rf_fact_aocs (id);
+INSERT INTO rf_fact_aocs SELECT * FROM rf_fact_heap ORDER BY id;
+ANALYZE rf_dim;
+ANALYZE rf_dim8;
+ANALYZE rf_date;
+ANALYZE rf_fact_heap;
+ANALYZE rf_fact_ao;
+ANALYZE rf_fact_aocs;
+-- Joined on another column than the distribution key of rf_fact_heap
+CREATE TABLE rf_big (id int, v text) DISTRIBUTED BY (id);
+INSERT INTO rf_big SELECT i, 'big ' || i FROM generate_series(1, 20000) i;
+ANALYZE rf_big;
+
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+SET enable_indexscan = off;
+SET enable_bitmapscan = off;
+
+SET gp_enable_runtime_filter = off;
+SELECT count(*), sum(f.amount) FROM rf_fact_heap f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3;
+SELECT count(*), sum(f.amount) FROM rf_fact_ao f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3;
+SELECT count(*), sum(f.amount) FROM rf_fact_aocs f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3;
+SELECT count(*), sum(f.id) FROM rf_fact_aocs f WHERE f.dim_id IN (SELECT id FROM rf_dim WHERE grp = 5);
+SELECT count(*), sum(f.id) FROM rf_fact_aocs f JOIN rf_dim d ON f.dim_id = d.id AND f.amount = d.grp;
+SELECT d8.label, count(*) FROM rf_fact_ao f JOIN rf_dim8 d8 ON f.amount = d8.id GROUP BY 1 ORDER BY 1;
+SELECT count(*), sum(f.id) FROM rf_fact_aocs f JOIN rf_date dd ON f.d = dd.d WHERE dd.holiday;
+SELECT d8.label, d.grp, count(*) FROM rf_fact_heap f
+  JOIN rf_dim d ON f.dim_id = d.id
+  JOIN rf_dim8 d8 ON f.amount = d8.id
+WHERE d.grp < 2 GROUP BY 1, 2 ORDER BY 1, 2;
+SELECT count(*), count(d.id) FROM rf_fact_heap f RIGHT JOIN rf_dim d ON f.dim_id = d.id WHERE d.id > 98 OR d.id IS NULL;
+SELECT count(*), sum(f.amount) FROM rf_fact_aocs f JOIN rf_dim d ON f.id = d.id WHERE d.grp = 3;
+-- Filtered by the senders of the redistribute Motion
+SET gp_segments_for_planner = 1000;
+SELECT count(*), sum(f.amount) FROM rf_fact_heap f JOIN rf_big b ON f.id = b.id WHERE b.id % 10 = 3;
+SELECT count(*), sum(f.amount), sum(f.id) FROM rf_fact_heap f JOIN rf_big b ON f.id = b.id WHERE b.id % 1000 = 7;
+RESET gp_segments_for_planner;
+
+SET gp_enable_runtime_filter = on;
+SELECT count(*), sum(f.amount) FROM rf_fact_heap f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3;
+SELECT count(*), sum(f.amount) FROM rf_fact_ao f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3;
+SELECT count(*), sum(f.amount) FROM rf_fact_aocs f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3;
+SELECT count(*), sum(f.id) FROM rf_fact_aocs f WHERE f.dim_id IN (SELECT id FROM rf_dim WHERE grp = 5);
+SELECT count(*), sum(f.id) FROM rf_fact_aocs f JOIN rf_dim d ON f.dim_id = d.id AND f.amount = d.grp;
+SELECT d8.label, count(*) FROM rf_fact_ao f JOIN rf_dim8 d8 ON f.amount = d8.id GROUP BY 1 ORDER BY 1;
+SELECT count(*), sum(f.id) FROM rf_fact_aocs f JOIN rf_date dd ON f.d = dd.d WHERE dd.holiday;
+SELECT d8.label, d.grp, count(*) FROM rf_fact_heap f
+  JOIN rf_dim d ON f.dim_id = d.id
+  JOIN rf_dim8 d8 ON f.amount = d8.id
+WHERE d.grp < 2 GROUP BY 1, 2 ORDER BY 1, 2;
+SELECT count(*), count(d.id) FROM rf_fact_heap f RIGHT JOIN rf_dim d ON f.dim_id = d.id WHERE d.id > 98 OR d.id IS NULL;
+SELECT count(*), sum(f.amount) FROM rf_fact_aocs f JOIN rf_dim d ON f.id = d.id WHERE d.grp = 3;
+-- Filtered by the senders of the redistribute Motion
+SET gp_segments_for_planner = 1000;
+SELECT count(*), sum(f.amount) FROM rf_fact_heap f JOIN rf_big b ON f.id = b.id WHERE b.id % 10 = 3;
+SELECT count(*), sum(f.amount), sum(f.id) FROM rf_fact_heap f JOIN rf_big b ON f.id = b.id WHERE b.id % 1000 = 7;
+RESET gp_segments_for_planner;
+
+-- The scan, or the sender, reports the rows it rejected
+CREATE FUNCTION rf_explain(query text, pattern text) RETURNS boolean
+LANGUAGE plpgsql AS $$
+DECLARE
+	ln text;
+BEGIN
+	FOR ln IN EXECUTE 'EXPLAIN (ANALYZE) ' || query LOOP
+		IF ln ~ pattern THEN
+			RETURN true;
+		END IF;
+	END LOOP;
+	RETURN false;
+END
+$$;
+SELECT rf_explain('SELECT * FROM rf_fact_aocs f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3',
+				  'Runtime filter rejected [0-9]+ of [0-9]+ rows');
+SET gp_segments_for_planner = 1000;
+SELECT rf_explain('SELECT * FROM rf_fact_heap f JOIN rf_big b ON f.id = b.id WHERE b.id % 10 = 3',
+				  'Runtime filters from the receivers rejected [0-9]+ of [0-9]+ rows');
+RESET gp_segments_for_planner;
+SET gp_enable_runtime_filter = off;
+SELECT rf_explain('SELECT * FROM rf_fact_aocs f JOIN rf_dim d ON f.dim_id = d.id WHERE d.grp = 3',
+				  'Runtime filter rejected [0-9]+ of [0-9]+ rows');
+SET gp_segments_for_planner = 1000;
+SELECT rf_explain('SELECT * FROM rf_fact_heap f JOIN rf_big b ON f.id = b.id WHERE b.id % 10 = 3',
+				  'Runtime filters from the receivers rejected [0-9]+ of [0-9]+ rows');
+RESET gp_segments_for_planner;
+
+RESET gp_enable_runtime_filter;
+SHOW gp_enable_runtime_filter;
+RESET enable_nestloop;
+RESET enable_mergejoin;
+RESET enable_indexscan;
+RESET enable_bitmapscan;
+DROP FUNCTION rf_explain(text, text);
+DROP TABLE rf_dim;
+DROP TABLE rf_dim8;
+DROP TABLE rf_date;
+DROP TABLE rf_fact_heap;
+DROP TABLE rf_fact_ao;
+DROP TABLE rf_fact_aocs;
+DROP TABLE rf_big;
+
+-- With the TCP interconnect, the senders of the redistribute Motion below
+-- the join fill the socket buffers while the join builds its hash table,
+-- and are blocked sending when the filter arrives.  The receivers wait
+-- before they send it, for the senders to surely be blocked.
+\setenv PGOPTIONS '-c gp_interconnect_type=tcp'
+\c
+SHOW gp_interconnect_type;
+CREATE TABLE rf_tcp_inner (id int) DISTRIBUTED BY (id);
+INSERT INTO rf_tcp_inner SELECT i FROM generate_series(7, 20000, 1000) i;
+CREATE TABLE rf_tcp_outer (k int, id int, pad text) DISTRIBUTED BY (k);
+INSERT INTO rf_tcp_outer SELECT i, i % 20000 + 1, repeat('x', 200)
+FROM generate_series(1, 100000) i;
+ANALYZE rf_tcp_inner;
+ANALYZE rf_tcp_outer;
+
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+CREATE FUNCTION rf_tcp_blocked_filters() RETURNS int AS $$
+  SELECT sum(substring(gp_inject_fault('interconnect_tcp_filter_while_blocked', 'status', dbid)
+                       FROM 'num times hit:''(\d+)''')::int)::int
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1
+$$ LANGUAGE sql;
+SELECT gp_inject_fault('motion_send_runtime_filter', 'sleep', '', '', '', 1, -1, 1, dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+SELECT gp_inject_fault('interconnect_tcp_filter_while_blocked', 'skip', '', '', '', 1, -1, 0, dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+
+SET enable_nestloop = off;
+SET enable_mergejoin = off;
+SET gp_enable_runtime_filter = on;
+SET gp_segments_for_planner = 1000;
+SELECT count(*), sum(o.id) FROM rf_tcp_outer o JOIN rf_tcp_inner i ON o.id = i.id;
+SELECT rf_tcp_blocked_filters() > 0 AS blocked_sender_got_filter;
+
+SELECT gp_inject_fault('motion_send_runtime_filter', 'reset', dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+SELECT gp_inject_fault('interconnect_tcp_filter_while_blocked', 'reset', dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+DROP FUNCTION rf_tcp_blocked_filters();
+DROP TABLE rf_tcp_inner;
+DROP TABLE rf_tcp_outer;
+\unsetenv PGOPTIONS
+\c
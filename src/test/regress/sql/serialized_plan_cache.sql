@@ -0,0 +1,35 @@
+--
+-- Tests for the cache of compressed plans dispatched by this session. Only
+-- the plans kept for reuse, like those of prepared statements, go to the
+-- cache; the plans of one-off queries are compressed each time.
+--
+SET gp_serialized_plan_cache_size = '1MB';
+
+CREATE TABLE spc_t (a int, b int) DISTRIBUTED BY (a);
+INSERT INTO spc_t SELECT i, i % 10 FROM generate_series(1, 100) i;
+
+SELECT hits AS spc_hits, misses AS spc_misses FROM gp_serialized_plan_cache_stats() \gset
+
+-- One-off queries leave the cache alone
+SELECT count(*) FROM spc_t WHERE b < 5;
+SELECT count(*) FROM spc_t WHERE b < 5;
+SELECT hits - :spc_hits AS hits, misses - :spc_misses AS misses FROM gp_serialized_plan_cache_stats();
+
+-- The plan of a prepared statement is compressed once
+PREPARE spc_p AS SELECT count(*) FROM spc_t WHERE b < 5;
+EXECUTE spc_p;
+EXECUTE spc_p;
+EXECUTE spc_p;
+SELECT hits - :spc_hits AS hits, misses - :spc_misses AS misses FROM gp_serialized_plan_cache_stats();
+SELECT entries > 0 AS cached FROM gp_serialized_plan_cache_stats();
+DEALLOCATE spc_p;
+
+-- Disabling the cache empties it
+SET gp_serialized_plan_cache_size = 0;
+PREPARE spc_p AS SELECT count(*) FROM spc_t WHERE b < 5;
+EXECUTE spc_p;
+SELECT entries, size_bytes FROM gp_serialized_plan_cache_stats();
+DEALLOCATE spc_p;
+
+RESET gp_serialized_plan_cache_size;
+DROP TABLE spc_t;
@@ -0,0 +1,64 @@
+-- @Description Tests that compaction copies blocks without hidden rows verbatim
+
+CREATE TABLE uao_copy_blocks (a INT, b INT, c TEXT)
+  WITH (appendonly=true, compresstype=zlib, compresslevel=1, blocksize=8192) DISTRIBUTED BY (a);
+CREATE INDEX uao_copy_blocks_index ON uao_copy_blocks(b);
+INSERT INTO uao_copy_blocks SELECT i, i % 1000, repeat('row ' || i, 10) FROM generate_series(1, 20000) AS i;
+
+-- Counts the blocks of uao_copy_blocks that compaction copied on all segments.
+CREATE EXTENSION IF NOT EXISTS gp_inject_fault;
+CREATE FUNCTION uao_copy_blocks_copied() RETURNS int AS $$
+  SELECT sum(substring(gp_inject_fault('appendonly_compaction_copy_block', 'status', dbid)
+                       FROM 'num times hit:''(\d+)''')::int)::int
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1
+$$ LANGUAGE sql;
+SELECT gp_inject_fault('appendonly_compaction_copy_block', 'skip', '', '', 'uao_copy_blocks', 1, -1, 0, dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+
+-- Only a few blocks have hidden rows; the others are copied as they are.
+DELETE FROM uao_copy_blocks WHERE a BETWEEN 100 AND 110;
+VACUUM uao_copy_blocks;
+SELECT uao_copy_blocks_copied() > 0 AS blocks_copied;
+SELECT count(*), sum(a) FROM uao_copy_blocks;
+SELECT count(*) FROM uao_copy_blocks WHERE c <> repeat('row ' || a, 10);
+
+-- The index must point to the new location of the copied rows.
+SET enable_seqscan=false;
+SELECT count(*) FROM uao_copy_blocks WHERE b = 105;
+SELECT count(*) FROM uao_copy_blocks WHERE b = 500;
+RESET enable_seqscan;
+
+-- Same without copying blocks.
+SELECT gp_inject_fault('appendonly_compaction_copy_block', 'reset', dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+SELECT gp_inject_fault('appendonly_compaction_copy_block', 'skip', '', '', 'uao_copy_blocks', 1, -1, 0, dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+SET gp_appendonly_compaction_copy_blocks = off;
+DELETE FROM uao_copy_blocks WHERE a BETWEEN 200 AND 210;
+VACUUM uao_copy_blocks;
+RESET gp_appendonly_compaction_copy_blocks;
+SELECT uao_copy_blocks_copied() AS blocks_copied;
+SELECT count(*), sum(a) FROM uao_copy_blocks;
+SET enable_seqscan=false;
+SELECT count(*) FROM uao_copy_blocks WHERE b = 205;
+RESET enable_seqscan;
+
+-- Without indexes, the rows of copied blocks are not decoded at all.
+CREATE TABLE uao_copy_blocks_noindex (a INT, b INT, c TEXT)
+  WITH (appendonly=true, blocksize=8192) DISTRIBUTED BY (a);
+INSERT INTO uao_copy_blocks_noindex SELECT i, i % 1000, repeat('row ' || i, 10) FROM generate_series(1, 20000) AS i;
+DELETE FROM uao_copy_blocks_noindex WHERE a % 1000 = 7;
+VACUUM uao_copy_blocks_noindex;
+SELECT count(*), sum(a) FROM uao_copy_blocks_noindex;
+SELECT count(*) FROM uao_copy_blocks_noindex WHERE c <> repeat('row ' || a, 10);
+INSERT INTO uao_copy_blocks_noindex VALUES (0, 0, 'new');
+SELECT count(*) FROM uao_copy_blocks_noindex;
+
+-- Nothing is being compacted right now.
+SELECT count(*) FROM pg_stat_progress_ao_compaction;
+
+SELECT gp_inject_fault('appendonly_compaction_copy_block', 'reset', dbid)
+  FROM gp_segment_configuration WHERE role = 'p' AND content > -1;
+DROP FUNCTION uao_copy_blocks_copied();
+DROP TABLE uao_copy_blocks;
+DROP TABLE uao_copy_blocks_noindex;
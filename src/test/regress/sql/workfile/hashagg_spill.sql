@@ -77,6 +77,26 @@ return result
 $$
 language plpythonu;
 
+-- Returns whether the spill bytes in the EXPLAIN ANALYZE output are at
+-- least the bytes stored on disk. Without compression, they're the same.
+create or replace function hashagg_spill.spill_bytes_reported(explain_query text)
+returns setof bool as
+$$
+import re
+rv = plpy.execute(explain_query)
+result = []
+for i in range(len(rv)):
+    cur_line = rv[i]['QUERY PLAN']
+    p = re.compile('.+ (\d+)K bytes spilled( \((\d+)K bytes compressed\))?')
+    m = p.match(cur_line)
+    if m:
+      spilled = int(m.group(1))
+      ondisk = int(m.group(3)) if m.group(3) else spilled
+      result.append(spilled >= ondisk)
+return result
+$$
+language plpythonu;
+
 -- Test agg spilling scenarios
 create table aggspill (i int, j int, t text) distributed by (i);
 insert into aggspill select i, i*2, i::text from generate_series(1, 10000) i;
@@ -119,6 +139,8 @@ SELECT avg(col2) col2 FROM hashagg_spill GROUP BY col1 HAVING(sum(col1)) < 0;')
 SET gp_workfile_compression = ON;
 select overflows >= 1 from hashagg_spill.num_hashagg_overflows('explain analyze
 SELECT avg(col2) col2 FROM hashagg_spill GROUP BY col1 HAVING(sum(col1)) < 0;') overflows;
+select spilled from hashagg_spill.spill_bytes_reported('explain analyze
+SELECT avg(col2) col2 FROM hashagg_spill GROUP BY col1 HAVING(sum(col1)) < 0;') spilled limit 1;
 
 -- check spilling to a temp tablespace
 CREATE TABLE spill_temptblspace (a numeric) DISTRIBUTED BY (a);